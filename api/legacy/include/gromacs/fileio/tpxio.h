@@ -93,6 +93,17 @@ struct TpxFileHeader
        index. Eventually, should probably be a vector. MRS*/
     //! Size of the TPR body in chars (equal to number of bytes) during I/O.
     int64_t sizeOfTprBody = 0;
+    /*! \brief Offsets in bytes of the topology, coordinate and inputrec sections in the TPR body.
+     *
+     * These form the section table that allows reading only parts of the body.
+     * All are zero when the body has no section table, which is the case for
+     * older files and for the body communicated to other ranks.
+     */
+    int64_t topologyOffset = 0;
+    //! Offset of the coordinate section in the TPR body, see topologyOffset.
+    int64_t coordinatesOffset = 0;
+    //! Offset of the inputrec section in the TPR body, see topologyOffset.
+    int64_t inputrecOffset = 0;
     //! File version.
     int fileVersion = 0;
     //! File generation.
@@ -192,6 +203,19 @@ PbcType completeTprDeserialization(PartialDeserializedTprFile* partialDeserializ
 PartialDeserializedTprFile
 read_tpx_state(const std::filesystem::path& fn, t_inputrec* ir, t_state* state, gmx_mtop_t* mtop);
 
+/*! \brief
+ * Read only the simulation parameters and topology from a file and close it again.
+ *
+ * Used by ranks that read the input file of a simulation directly instead
+ * of receiving its contents from the main rank. Does not print to stderr,
+ * and does not read the coordinates when the file has a section table.
+ *
+ * \param[in] fn Input file name.
+ * \param[out] ir Input parameters to be set.
+ * \param[out] mtop Global simulation topology.
+ */
+void readTpxInputrecAndTopology(const std::filesystem::path& fn, t_inputrec* ir, gmx_mtop_t* mtop);
+
 /*! \brief
  * Read a file and close it again.
  *
@@ -203,7 +227,9 @@ read_tpx_state(const std::filesystem::path& fn, t_inputrec* ir, t_state* state,
  * \p mtop are passed as valid objects to the function, the total atom
  * number from \p mtop will be set in \p natoms. Otherwise \p natoms
  * will not be changed. If \p box is valid, the box will be set from
- * the information read in from the file.
+ * the information read in from the file. When \p x and \p v are both
+ * nullptr and the file has a section table, the coordinate section
+ * is skipped, and likewise the topology section when \p mtop is nullptr.
  *
  * \param[in] fn Input file name.
  * \param[out] ir Input parameters to be set, or nullptr.
@@ -177,7 +177,23 @@ struct t_fileio* trx_get_fileio(t_trxstatus* status);
 /* get a fileio from a trxstatus */
 
 float trx_get_time_of_final_frame(t_trxstatus* status);
-/* get time of final frame. Only supported for TNG and XTC */
+/* get time of final frame. Only supported for TNG and XTC,
+ * and for TRR when a frame index is available */
+
+int64_t trx_get_num_indexed_frames(t_trxstatus* status);
+/* Returns the number of frames in the frame index of an XTC or TRR
+ * trajectory opened with read_first_frame(), -1 when there is no index.
+ * The index is read from the sidecar file written by mdrun or built
+ * when the GMX_TRAJECTORY_INDEX environment variable is set.
+ */
+
+gmx_bool trx_seek_indexed_frame(t_trxstatus* status, int64_t frame);
+/* Uses the frame index to position the trajectory such that the next call
+ * of read_next_frame() reads frame number frame, counting from zero.
+ * Together with trx_get_num_indexed_frames(), this allows splitting a
+ * trajectory into chunks that are read independently.
+ * Returns FALSE when there is no index or no such frame.
+ */
 
 gmx_bool bRmod_fd(double a, double b, double c, gmx_bool bDouble);
 /* Returns TRUE when (a - b) MOD c = 0, using a margin which is slightly
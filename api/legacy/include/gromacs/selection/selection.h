@@ -227,6 +227,17 @@ public:
      * Called by SelectionEvaluator::evaluateFinal().
      */
     void restoreOriginalPositions(const gmx_mtop_t* top);
+    /*! \brief
+     * Copies state that callers set up after compilation from another selection.
+     *
+     * \param[in] rhs  Selection parsed and compiled from the same text.
+     *
+     * Copies the covered fraction type and the original IDs of positions
+     * (see Selection::setOriginalId()), so that a selection in a copied
+     * SelectionCollection evaluates identically to the original.
+     * Called by the SelectionCollection copy constructor.
+     */
+    void copyPostCompilationState(const SelectionData& rhs);
 
 private:
     //! Name of the selection.
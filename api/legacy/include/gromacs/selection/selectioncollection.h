@@ -402,6 +402,18 @@ public:
      * @return The selection with the given name, or nullopt if no such selection exists.
      */
     [[nodiscard]] std::optional<Selection> selection(std::string_view selName) const;
+    /*! \brief
+     * Retrieves the selection in this collection that corresponds to a given selection
+     *
+     * @param selection Selection from this collection, or from the collection
+     *     that this collection was copied from.
+     * @return \p selection if it belongs to this collection, its copy if it
+     *     belongs to the collection this one was copied from, or nullopt otherwise.
+     *
+     * This allows, e.g., using thread-local copies of a collection with
+     * selections obtained from the original collection.
+     */
+    [[nodiscard]] std::optional<Selection> correspondingSelection(const Selection& selection) const;
     /*! \brief
      * Prints a human-readable version of the internal selection element
      * tree.
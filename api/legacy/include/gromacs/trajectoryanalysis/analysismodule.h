@@ -360,11 +360,12 @@ public:
      * \p selection is the selection object that was obtained from
      * SelectionOption.  The return value is the corresponding selection
      * in the selection collection with which this data object was
-     * constructed with.
+     * constructed with.  For frame-parallel analysis, this is a
+     * thread-local copy of the global collection.
      *
      * Does not throw.
      */
-    static Selection parallelSelection(const Selection& selection);
+    Selection parallelSelection(const Selection& selection) const;
     /*! \brief
      * Returns a set of selection that corresponds to the given selections.
      *
@@ -374,7 +375,7 @@ public:
      *
      * \see parallelSelection()
      */
-    static SelectionList parallelSelections(const SelectionList& selections);
+    SelectionList parallelSelections(const SelectionList& selections) const;
 
 protected:
     /*! \brief
@@ -126,6 +126,18 @@ public:
          * \see setRmPBC()
          */
         efNoUserRmPBC = 1 << 5,
+        /*! \brief
+         * Allows the frames to be analyzed in parallel.
+         *
+         * If this flag is specified, a command-line option is provided for
+         * the user to set the number of threads used to analyze frames
+         * concurrently.  The analysis module must then only modify
+         * thread-local data (see TrajectoryAnalysisModule::startFrames())
+         * in TrajectoryAnalysisModule::analyzeFrame(), and access the
+         * selections only through
+         * TrajectoryAnalysisModuleData::parallelSelection().
+         */
+        efFrameParallel = 1 << 6,
     };
 
     //! Initializes default settings.
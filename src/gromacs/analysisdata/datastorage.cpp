@@ -46,6 +46,7 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "gromacs/analysisdata/abstractdata.h"
@@ -237,7 +238,7 @@ public:
      * There is always one unused frame in the buffer, which is initialized
      * such that when \a firstFrameLocation_ is incremented, it becomes
      * valid.  This makes it easier to rotate the buffer in concurrent
-     * access scenarions (which are not yet otherwise implemented).
+     * access scenarios.
      */
     FrameList frames_;
     //! Location of oldest frame in \a frames_.
@@ -262,6 +263,16 @@ public:
      * frame (see \a frames_).
      */
     int nextIndex_;
+    /*! \brief
+     * Protects the frame buffer and the notification state.
+     *
+     * Frames are built concurrently by several threads when the data is
+     * produced in parallel.  Building the values for a frame and adding point
+     * sets only touches frame-local data, but starting and finishing frames
+     * modifies \a frames_ and \a builders_ and calls the frame-level
+     * notifications, so those are serialized through this mutex.
+     */
+    std::mutex mutex_;
 };
 
 /********************************************************************
@@ -718,7 +729,9 @@ void AnalysisDataStorageFrame::finishPointSet()
 void AnalysisDataStorageFrame::finishFrame()
 {
     GMX_RELEASE_ASSERT(data_ != nullptr, "Invalid frame accessed");
-    data_->storageImpl().finishFrame(data_->frameIndex());
+    internal::AnalysisDataStorageImpl& storageImpl = data_->storageImpl();
+    std::lock_guard<std::mutex>        lock(storageImpl.mutex_);
+    storageImpl.finishFrame(data_->frameIndex());
 }
 
 
@@ -806,6 +819,7 @@ void AnalysisDataStorage::startParallelDataStorage(AbstractAnalysisData*
 AnalysisDataStorageFrame& AnalysisDataStorage::startFrame(const AnalysisDataFrameHeader& header)
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
+    std::lock_guard<std::mutex>             lock(impl_->mutex_);
     internal::AnalysisDataStorageFrameData* storedFrame = nullptr;
     if (impl_->storeAll())
     {
@@ -846,7 +860,8 @@ AnalysisDataStorageFrame& AnalysisDataStorage::startFrame(int index, real x, rea
 
 AnalysisDataStorageFrame& AnalysisDataStorage::currentFrame(int index)
 {
-    const int storageIndex = impl_->computeStorageLocation(index);
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    const int                   storageIndex = impl_->computeStorageLocation(index);
     GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
 
     internal::AnalysisDataStorageFrameData& storedFrame = *impl_->frames_[storageIndex];
@@ -861,6 +876,7 @@ AnalysisDataStorageFrame& AnalysisDataStorage::currentFrame(int index)
 
 void AnalysisDataStorage::finishFrame(int index)
 {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
     impl_->finishFrame(index);
 }
 
@@ -868,6 +884,7 @@ void AnalysisDataStorage::finishFrameSerial(int index)
 {
     if (impl_->pendingLimit_ > 1)
     {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
         impl_->finishFrameSerial(index);
     }
 }
@@ -252,8 +252,12 @@ private:
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * When startParallelDataStorage() is used, different frames can be built
+ * concurrently from different threads: values and point sets for a frame are
+ * frame-local, and starting and finishing frames is internally serialized.
+ * The caller is responsible for calling finishFrameSerial() in order from a
+ * single thread, and for respecting the parallelization factor (see
+ * startFrame()).
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
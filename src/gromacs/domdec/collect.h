@@ -60,6 +60,14 @@ void dd_collect_vec(gmx_domdec_t*                  dd,
                     gmx::ArrayRef<const gmx::RVec> localVector,
                     gmx::ArrayRef<gmx::RVec>       globalVector);
 
+/*! \brief Copies the non per-atom entries of \p localState to \p globalState on the main rank
+ *
+ * The per-atom entries, such as coordinates and velocities, are left untouched.
+ */
+void dd_collect_state_global_entries(const gmx_domdec_t* dd,
+                                     const t_state*      localState,
+                                     t_state*            globalState);
+
 /*! \brief Gathers state \p localState to \p globalState on the main rank */
 void dd_collect_state(gmx_domdec_t* dd, const t_state* localState, t_state* globalState);
 
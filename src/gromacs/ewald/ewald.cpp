@@ -54,21 +54,59 @@
 
 #include "gromacs/ewald/ewald_utils.h"
 #include "gromacs/math/functions.h"
-#include "gromacs/math/gmxcomplex.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
-#include "gromacs/utility/smalloc.h"
 
-using cvec = std::array<t_complex, DIM>;
+#if GMX_SIMD_HAVE_REAL
+//! The SIMD type used in the k-space sum, or real without SIMD support
+using EwaldSimdReal = gmx::SimdReal;
+//! The number of atoms processed per SIMD instruction
+constexpr int c_simdWidth = GMX_SIMD_REAL_WIDTH;
+#else
+//! The SIMD type used in the k-space sum, or real without SIMD support
+using EwaldSimdReal = real;
+//! The number of atoms processed per SIMD instruction
+constexpr int c_simdWidth = 1;
+#endif
+
+/*! \brief The number of blocks the (kx,ky) pairs are divided into in do_ewald()
+ *
+ * This is independent of the number of threads, so the reduction over the blocks
+ * is done in the same order and the results do not depend on the thread count.
+ * It also limits the number of threads that can be used.
+ */
+constexpr int c_numKSpaceBlocks = 32;
+
+//! Work buffers and reduction output for one block of (kx,ky) pairs in do_ewald()
+struct EwaldBlockWork
+{
+    //! Product of the x and y structure factors of the current (kx,ky) pair, real part
+    std::vector<real, gmx::AlignedAllocator<real>> tabXYRe;
+    //! Product of the x and y structure factors of the current (kx,ky) pair, imaginary part
+    std::vector<real, gmx::AlignedAllocator<real>> tabXYIm;
+    //! The charge times the structure factor of the current k-vector, real part
+    std::vector<real, gmx::AlignedAllocator<real>> tabQRe;
+    //! The charge times the structure factor of the current k-vector, imaginary part
+    std::vector<real, gmx::AlignedAllocator<real>> tabQIm;
+    //! Force buffer, one padded array per dimension
+    std::vector<real, gmx::AlignedAllocator<real>> force[DIM];
+    //! The unscaled energies for state A and B
+    real energy[2];
+    //! The unscaled virial contribution
+    matrix virial;
+};
 
 gmx_ewald_tab_t::gmx_ewald_tab_t(const t_inputrec& ir, FILE* fp)
 {
@@ -93,35 +131,200 @@ static void calc_lll(const rvec box, rvec lll)
     lll[ZZ] = 2.0 * M_PI / box[ZZ];
 }
 
-//! Make tables for the structure factor parts
-static void tabulateStructureFactors(int natom, gmx::ArrayRef<const gmx::RVec> x, int kmax, cvec** eir, const rvec lll)
+/*! \brief Make tables for the structure factor parts for atoms \p atomStart to \p atomEnd
+ *
+ * Also copies the charges to the padded buffers. The padding atoms get
+ * unit structure factors and zero charge, so they do not contribute.
+ * \p atomStart should be a multiple of the SIMD width.
+ */
+static void tabulateStructureFactors(gmx_ewald_tab_t*               et,
+                                     int                            atomStart,
+                                     int                            atomEnd,
+                                     int                            natoms,
+                                     gmx::ArrayRef<const gmx::RVec> x,
+                                     gmx::ArrayRef<const real>      chargeA,
+                                     gmx::ArrayRef<const real>      chargeB,
+                                     bool                           haveFreeEnergy,
+                                     const rvec                     lll)
 {
-    int i, j, m;
+    const int stride = et->numAtomsPadded;
+    real*     eirRe  = et->eirRe.data();
+    real*     eirIm  = et->eirIm.data();
 
-    if (kmax < 1)
+    for (int n = atomStart; n < atomEnd; n++)
     {
-        printf("Go away! kmax = %d\n", kmax);
-        exit(1);
+        const bool isRealAtom = (n < natoms);
+
+        et->charges[0][n] = isRealAtom ? chargeA[n] : 0;
+        if (haveFreeEnergy)
+        {
+            et->charges[1][n] = isRealAtom ? chargeB[n] : 0;
+        }
+
+        for (int m = 0; m < DIM; m++)
+        {
+            eirRe[m * stride + n]         = 1;
+            eirIm[m * stride + n]         = 0;
+            eirRe[(DIM + m) * stride + n] = isRealAtom ? std::cos(x[n][m] * lll[m]) : 1;
+            eirIm[(DIM + m) * stride + n] = isRealAtom ? std::sin(x[n][m] * lll[m]) : 0;
+        }
     }
 
-    for (i = 0; (i < natom); i++)
+    for (int k = 2; k < et->kmax; k++)
     {
-        for (m = 0; (m < 3); m++)
+        for (int m = 0; m < DIM; m++)
         {
-            eir[0][i][m].re = 1;
-            eir[0][i][m].im = 0;
+            const real* prevRe = eirRe + ((k - 1) * DIM + m) * stride;
+            const real* prevIm = eirIm + ((k - 1) * DIM + m) * stride;
+            const real* oneRe  = eirRe + (DIM + m) * stride;
+            const real* oneIm  = eirIm + (DIM + m) * stride;
+            real*       curRe  = eirRe + (k * DIM + m) * stride;
+            real*       curIm  = eirIm + (k * DIM + m) * stride;
+            for (int n = atomStart; n < atomEnd; n += c_simdWidth)
+            {
+                const EwaldSimdReal pRe = gmx::load<EwaldSimdReal>(prevRe + n);
+                const EwaldSimdReal pIm = gmx::load<EwaldSimdReal>(prevIm + n);
+                const EwaldSimdReal oRe = gmx::load<EwaldSimdReal>(oneRe + n);
+                const EwaldSimdReal oIm = gmx::load<EwaldSimdReal>(oneIm + n);
+                gmx::store(curRe + n, pRe * oRe - pIm * oIm);
+                gmx::store(curIm + n, pRe * oIm + pIm * oRe);
+            }
         }
+    }
+}
 
-        for (m = 0; (m < 3); m++)
+/*! \brief Computes the k-space sum for the (kx,ky) pairs \p pairStart to \p pairEnd
+ *
+ * The pairs are ordered as kx=0 with ky=0..ny-1, followed by, for each
+ * kx>0, ky=1-ny..ny-1. For the (0,0) pair kz runs from 1, otherwise
+ * kz runs from 1-nz to nz-1. This is the same set of k-vectors, in the same
+ * order, as the original serial loop.
+ *
+ * Energies and the virial are accumulated into \p work without the
+ * reciprocal-space prefactor, forces into the padded per-block force
+ * buffers with the prefactor.
+ */
+static void sumKSpaceRange(const gmx_ewald_tab_t* et,
+                           EwaldBlockWork*        work,
+                           int                    pairStart,
+                           int                    pairEnd,
+                           int                    numChargeStates,
+                           real                   lambda,
+                           bool                   haveFreeEnergy,
+                           const rvec             lll,
+                           real                   factor,
+                           real                   scaleRecip)
+{
+    const int   stride = et->numAtomsPadded;
+    const real* eirRe  = et->eirRe.data();
+    const real* eirIm  = et->eirIm.data();
+    real*       xyRe   = work->tabXYRe.data();
+    real*       xyIm   = work->tabXYIm.data();
+    real*       qRe    = work->tabQRe.data();
+    real*       qIm    = work->tabQIm.data();
+
+    for (int pair = pairStart; pair < pairEnd; pair++)
+    {
+        int ix, iy;
+        if (pair < et->ny)
+        {
+            ix = 0;
+            iy = pair;
+        }
+        else
         {
-            eir[1][i][m].re = std::cos(x[i][m] * lll[m]);
-            eir[1][i][m].im = std::sin(x[i][m] * lll[m]);
+            ix = 1 + (pair - et->ny) / (2 * et->ny - 1);
+            iy = 1 - et->ny + (pair - et->ny) % (2 * et->ny - 1);
         }
-        for (j = 2; (j < kmax); j++)
+        /* The serial loop only lowered the kz start after having done
+         * at least one kz, which does not happen when nz=1.
+         */
+        const int lowiz = (pair == 0 || et->nz == 1) ? 1 : 1 - et->nz;
+
+        const real mx = ix * lll[XX];
+        const real my = iy * lll[YY];
+
+        const real*         xRe   = eirRe + (ix * DIM + XX) * stride;
+        const real*         xIm   = eirIm + (ix * DIM + XX) * stride;
+        const real*         yRe   = eirRe + (std::abs(iy) * DIM + YY) * stride;
+        const real*         yIm   = eirIm + (std::abs(iy) * DIM + YY) * stride;
+        const EwaldSimdReal signY(iy >= 0 ? real(1) : real(-1));
+        for (int n = 0; n < stride; n += c_simdWidth)
         {
-            for (m = 0; (m < 3); m++)
+            const EwaldSimdReal aRe = gmx::load<EwaldSimdReal>(xRe + n);
+            const EwaldSimdReal aIm = gmx::load<EwaldSimdReal>(xIm + n);
+            const EwaldSimdReal bRe = gmx::load<EwaldSimdReal>(yRe + n);
+            const EwaldSimdReal bIm = signY * gmx::load<EwaldSimdReal>(yIm + n);
+            gmx::store(xyRe + n, aRe * bRe - aIm * bIm);
+            gmx::store(xyIm + n, aRe * bIm + aIm * bRe);
+        }
+
+        for (int iz = lowiz; iz < et->nz; iz++)
+        {
+            const real mz  = iz * lll[ZZ];
+            const real m2  = mx * mx + my * my + mz * mz;
+            const real ak  = std::exp(m2 * factor) / m2;
+            const real akv = 2.0 * ak * (1.0 / m2 - factor);
+
+            const real*         zRe   = eirRe + (std::abs(iz) * DIM + ZZ) * stride;
+            const real*         zIm   = eirIm + (std::abs(iz) * DIM + ZZ) * stride;
+            const EwaldSimdReal signZ(iz >= 0 ? real(1) : real(-1));
+
+            for (int q = 0; q < numChargeStates; q++)
             {
-                eir[j][i][m] = cmul(eir[j - 1][i][m], eir[1][i][m]);
+                const real* charge = et->charges[q].data();
+
+                EwaldSimdReal csSum(real(0));
+                EwaldSimdReal ssSum(real(0));
+                for (int n = 0; n < stride; n += c_simdWidth)
+                {
+                    const EwaldSimdReal aRe = gmx::load<EwaldSimdReal>(xyRe + n);
+                    const EwaldSimdReal aIm = gmx::load<EwaldSimdReal>(xyIm + n);
+                    const EwaldSimdReal bRe = gmx::load<EwaldSimdReal>(zRe + n);
+                    const EwaldSimdReal bIm = signZ * gmx::load<EwaldSimdReal>(zIm + n);
+                    const EwaldSimdReal c   = gmx::load<EwaldSimdReal>(charge + n);
+                    const EwaldSimdReal re  = c * (aRe * bRe - aIm * bIm);
+                    const EwaldSimdReal im  = c * (aRe * bIm + aIm * bRe);
+                    gmx::store(qRe + n, re);
+                    gmx::store(qIm + n, im);
+                    csSum = csSum + re;
+                    ssSum = ssSum + im;
+                }
+                const real cs = gmx::reduce(csSum);
+                const real ss = gmx::reduce(ssSum);
+
+                real scale = 1;
+                if (haveFreeEnergy)
+                {
+                    scale = (q == 0 ? 1 - lambda : lambda);
+                }
+
+                work->energy[q] += ak * (cs * cs + ss * ss);
+                const real tmp = scale * akv * (cs * cs + ss * ss);
+                work->virial[XX][XX] -= tmp * mx * mx;
+                work->virial[XX][YY] -= tmp * mx * my;
+                work->virial[XX][ZZ] -= tmp * mx * mz;
+                work->virial[YY][YY] -= tmp * my * my;
+                work->virial[YY][ZZ] -= tmp * my * mz;
+                work->virial[ZZ][ZZ] -= tmp * mz * mz;
+
+                const real          forceScale = scale * ak * 2 * scaleRecip;
+                const EwaldSimdReal fmx        = forceScale * mx;
+                const EwaldSimdReal fmy        = forceScale * my;
+                const EwaldSimdReal fmz        = forceScale * mz;
+                const EwaldSimdReal csV        = cs;
+                const EwaldSimdReal ssV        = ss;
+                real*               fx         = work->force[XX].data();
+                real*               fy         = work->force[YY].data();
+                real*               fz         = work->force[ZZ].data();
+                for (int n = 0; n < stride; n += c_simdWidth)
+                {
+                    const EwaldSimdReal t = csV * gmx::load<EwaldSimdReal>(qIm + n)
+                                            - ssV * gmx::load<EwaldSimdReal>(qRe + n);
+                    gmx::store(fx + n, gmx::fma(t, fmx, gmx::load<EwaldSimdReal>(fx + n)));
+                    gmx::store(fy + n, gmx::fma(t, fmy, gmx::load<EwaldSimdReal>(fy + n)));
+                    gmx::store(fz + n, gmx::fma(t, fmz, gmx::load<EwaldSimdReal>(fz + n)));
+                }
             }
         }
     }
@@ -144,13 +347,9 @@ real do_ewald(bool                           havePbcXY2Walls,
               real*                          dvdlambda,
               gmx_ewald_tab_t*               et)
 {
-    real   factor = -1.0 / (4 * ewaldcoeff * ewaldcoeff);
-    real   energy_AB[2], energy;
-    rvec   lll;
-    int    lowiy, lowiz, ix, iy, iz, n, q;
-    real   tmp, cs, ss, ak, akv, mx, my, mz, m2, scale;
-    cvec** eir;
-    bool   bFreeEnergy;
+    real factor = -1.0 / (4 * ewaldcoeff * ewaldcoeff);
+    real energy_AB[2], energy;
+    rvec lll;
 
     if (commrec != nullptr)
     {
@@ -174,111 +373,99 @@ real do_ewald(bool                           havePbcXY2Walls,
     /* 1/(Vol*e0) */
     real scaleRecip = 4.0 * M_PI / (boxDiag[XX] * boxDiag[YY] * boxDiag[ZZ]) * gmx::c_one4PiEps0 / epsilonR;
 
-    snew(eir, et->kmax);
-    for (n = 0; n < et->kmax; n++)
+    const bool bFreeEnergy     = (freeEnergyPerturbationType != FreeEnergyPerturbationType::No);
+    const int  numChargeStates = (bFreeEnergy ? 2 : 1);
+
+    /* We always need the tables for k=0 and k=1 */
+    const int numKTables = std::max(et->kmax, 2);
+    const int nthreads   = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+
+    et->numAtomsPadded = (natoms + c_simdWidth - 1) / c_simdWidth * c_simdWidth;
+    et->eirRe.resize(numKTables * DIM * et->numAtomsPadded);
+    et->eirIm.resize(numKTables * DIM * et->numAtomsPadded);
+    for (int q = 0; q < numChargeStates; q++)
     {
-        snew(eir[n], natoms);
+        et->charges[q].resize(et->numAtomsPadded);
     }
-    et->tab_xy.resize(natoms);
-    et->tab_qxyz.resize(natoms);
-
-    bFreeEnergy = (freeEnergyPerturbationType != FreeEnergyPerturbationType::No);
+    et->blockWork.resize(c_numKSpaceBlocks);
 
     clear_mat(lrvir);
 
     calc_lll(boxDiag, lll);
-    tabulateStructureFactors(natoms, coords, et->kmax, eir, lll);
 
-    gmx::ArrayRef<const real> charge;
-    for (q = 0; q < (bFreeEnergy ? 2 : 1); q++)
+    const int numAtomBlocks = et->numAtomsPadded / c_simdWidth;
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+    for (int th = 0; th < nthreads; th++)
     {
-        if (!bFreeEnergy)
+        try
         {
-            charge = chargeA;
-            scale  = 1.0;
+            tabulateStructureFactors(et,
+                                     (numAtomBlocks * th) / nthreads * c_simdWidth,
+                                     (numAtomBlocks * (th + 1)) / nthreads * c_simdWidth,
+                                     natoms,
+                                     coords,
+                                     chargeA,
+                                     chargeB,
+                                     bFreeEnergy,
+                                     lll);
         }
-        else if (q == 0)
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    /* The number of (kx,ky) pairs, see sumKSpaceRange() for the ordering */
+    const int numPairs = et->ny + (et->nx - 1) * (2 * et->ny - 1);
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+    for (int block = 0; block < c_numKSpaceBlocks; block++)
+    {
+        try
         {
-            charge = chargeA;
-            scale  = 1.0 - lambda;
+            EwaldBlockWork& work = et->blockWork[block];
+            work.tabXYRe.resize(et->numAtomsPadded);
+            work.tabXYIm.resize(et->numAtomsPadded);
+            work.tabQRe.resize(et->numAtomsPadded);
+            work.tabQIm.resize(et->numAtomsPadded);
+            for (int d = 0; d < DIM; d++)
+            {
+                work.force[d].assign(et->numAtomsPadded, 0);
+            }
+            work.energy[0] = 0;
+            work.energy[1] = 0;
+            clear_mat(work.virial);
+
+            sumKSpaceRange(et,
+                           &work,
+                           (numPairs * block) / c_numKSpaceBlocks,
+                           (numPairs * (block + 1)) / c_numKSpaceBlocks,
+                           numChargeStates,
+                           lambda,
+                           bFreeEnergy,
+                           lll,
+                           factor,
+                           scaleRecip);
         }
-        else
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+    for (int n = 0; n < natoms; n++)
+    {
+        for (const EwaldBlockWork& work : et->blockWork)
         {
-            charge = chargeB;
-            scale  = lambda;
+            forces[n][XX] += work.force[XX][n];
+            forces[n][YY] += work.force[YY][n];
+            forces[n][ZZ] += work.force[ZZ][n];
         }
-        lowiy        = 0;
-        lowiz        = 1;
-        energy_AB[q] = 0;
-        for (ix = 0; ix < et->nx; ix++)
+    }
+
+    energy_AB[0] = 0;
+    energy_AB[1] = 0;
+    for (const EwaldBlockWork& work : et->blockWork)
+    {
+        for (int q = 0; q < numChargeStates; q++)
         {
-            mx = ix * lll[XX];
-            for (iy = lowiy; iy < et->ny; iy++)
-            {
-                my = iy * lll[YY];
-                if (iy >= 0)
-                {
-                    for (n = 0; n < natoms; n++)
-                    {
-                        et->tab_xy[n] = cmul(eir[ix][n][XX], eir[iy][n][YY]);
-                    }
-                }
-                else
-                {
-                    for (n = 0; n < natoms; n++)
-                    {
-                        et->tab_xy[n] = cmul(eir[ix][n][XX], conjugate(eir[-iy][n][YY]));
-                    }
-                }
-                for (iz = lowiz; iz < et->nz; iz++)
-                {
-                    mz  = iz * lll[ZZ];
-                    m2  = mx * mx + my * my + mz * mz;
-                    ak  = std::exp(m2 * factor) / m2;
-                    akv = 2.0 * ak * (1.0 / m2 - factor);
-                    if (iz >= 0)
-                    {
-                        for (n = 0; n < natoms; n++)
-                        {
-                            et->tab_qxyz[n] = rcmul(charge[n], cmul(et->tab_xy[n], eir[iz][n][ZZ]));
-                        }
-                    }
-                    else
-                    {
-                        for (n = 0; n < natoms; n++)
-                        {
-                            et->tab_qxyz[n] =
-                                    rcmul(charge[n], cmul(et->tab_xy[n], conjugate(eir[-iz][n][ZZ])));
-                        }
-                    }
-
-                    cs = ss = 0;
-                    for (n = 0; n < natoms; n++)
-                    {
-                        cs += et->tab_qxyz[n].re;
-                        ss += et->tab_qxyz[n].im;
-                    }
-                    energy_AB[q] += ak * (cs * cs + ss * ss);
-                    tmp = scale * akv * (cs * cs + ss * ss);
-                    lrvir[XX][XX] -= tmp * mx * mx;
-                    lrvir[XX][YY] -= tmp * mx * my;
-                    lrvir[XX][ZZ] -= tmp * mx * mz;
-                    lrvir[YY][YY] -= tmp * my * my;
-                    lrvir[YY][ZZ] -= tmp * my * mz;
-                    lrvir[ZZ][ZZ] -= tmp * mz * mz;
-                    for (n = 0; n < natoms; n++)
-                    {
-                        /*tmp=scale*ak*(cs*tab_qxyz[n].im-ss*tab_qxyz[n].re);*/
-                        tmp = scale * ak * (cs * et->tab_qxyz[n].im - ss * et->tab_qxyz[n].re);
-                        forces[n][XX] += tmp * mx * 2 * scaleRecip;
-                        forces[n][YY] += tmp * my * 2 * scaleRecip;
-                        forces[n][ZZ] += tmp * mz * 2 * scaleRecip;
-                    }
-                    lowiz = 1 - et->nz;
-                }
-                lowiy = 1 - et->ny;
-            }
+            energy_AB[q] += work.energy[q];
         }
+        m_add(lrvir, work.virial, lrvir);
     }
 
     if (!bFreeEnergy)
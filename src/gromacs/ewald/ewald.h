@@ -67,12 +67,12 @@
 #include <vector>
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/real.h"
 
 struct t_commrec;
 struct t_forcerec;
 struct t_inputrec;
-struct t_complex;
 enum class FreeEnergyPerturbationType : int;
 
 namespace gmx
@@ -81,6 +81,8 @@ template<typename>
 class ArrayRef;
 }
 
+struct EwaldBlockWork;
+
 struct gmx_ewald_tab_t
 {
     gmx_ewald_tab_t(const t_inputrec& ir, FILE* fp);
@@ -92,8 +94,16 @@ struct gmx_ewald_tab_t
     int nz;
     int kmax;
 
-    std::vector<t_complex> tab_xy;
-    std::vector<t_complex> tab_qxyz;
+    //! The number of atoms rounded up to a multiple of the SIMD width
+    int numAtomsPadded = 0;
+    //! Real parts of the structure factor tables, index (k*DIM + dim)*numAtomsPadded + atom
+    std::vector<real, gmx::AlignedAllocator<real>> eirRe;
+    //! Imaginary parts of the structure factor tables, same layout as \p eirRe
+    std::vector<real, gmx::AlignedAllocator<real>> eirIm;
+    //! The charges for state A and B, padded with zeros
+    std::vector<real, gmx::AlignedAllocator<real>> charges[2];
+    //! Work buffers and energy/virial output for each block of k-vectors
+    std::vector<EwaldBlockWork> blockWork;
 };
 
 /*! \brief Do the long-ranged part of an Ewald calculation */
@@ -77,6 +77,7 @@
 #include <cstring>
 
 #include <algorithm>
+#include <array>
 #include <list>
 
 #include "gromacs/domdec/domdec.h"
@@ -111,6 +112,7 @@
 #include "gromacs/utility/message_string_collector.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/threadpool.h"
 #include "gromacs/utility/unique_cptr.h"
 
 #include "calculate_spline_moduli.h"
@@ -963,6 +965,8 @@ gmx_pme_t* gmx_pme_init(const t_commrec*     cr,
         doSpread                 = false;
         pme->atc.emplace_back(pme->mpi_comm_d[1], pme->nthread, pme->pme_order, secondDimIndex, doSpread);
     }
+    /* The energy-only atom data is allocated on first use by each thread */
+    pme->atc_energy.resize(pme->nthread);
 
     // Initial check of validity of the input for running on the GPU
     if (pme->runMode != PmeRunMode::CPU)
@@ -1065,11 +1069,14 @@ real gmx_pme_calc_energy(gmx_pme_t* pme, gmx::ArrayRef<const gmx::RVec> x, gmx::
         gmx_incons("gmx_pme_calc_energy with free energy");
     }
 
-    if (!pme->atc_energy)
+    const int thread = gmx_omp_get_thread_num();
+    GMX_RELEASE_ASSERT(thread < gmx::ssize(pme->atc_energy),
+                       "gmx_pme_calc_energy should not be called with more threads than PME uses");
+    if (!pme->atc_energy[thread])
     {
-        pme->atc_energy = std::make_unique<PmeAtomComm>(MPI_COMM_NULL, 1, pme->pme_order, 0, true);
+        pme->atc_energy[thread] = std::make_unique<PmeAtomComm>(MPI_COMM_NULL, 1, pme->pme_order, 0, true);
     }
-    PmeAtomComm* atc = pme->atc_energy.get();
+    PmeAtomComm* atc = pme->atc_energy[thread].get();
     atc->setNumAtoms(x.ssize());
     atc->x           = x;
     atc->coefficient = q;
@@ -1135,6 +1142,9 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
     GMX_ASSERT(pme->runMode == PmeRunMode::CPU,
                "gmx_pme_do should not be called on the GPU PME run.");
 
+    // PME uses OpenMP
+    const gmx::ThreadPoolSpinSuspension threadPoolSpinSuspension;
+
     /* We could be passing lambda!=0 while no q or LJ is actually perturbed */
     if (!pme->bFEP_q)
     {
@@ -1199,6 +1209,10 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
 
     // There's no support for computing energy without virial, or vice versa
     const bool computeEnergyAndVirial = (stepWork.computeEnergy || stepWork.computeVirial);
+    /* With free-energy the forces of the A-state grid are gathered together
+     * with those of the B-state grid, these store the A-state data */
+    gmx::ArrayRef<const real> gatherCoefficientsA;
+    bool                      bClearFA = false;
     for (int grid_index = 0; grid_index < max_grid_index; ++grid_index)
     {
         /* Check if we should do calculations at this grid_index
@@ -1378,23 +1392,68 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
              */
             const real lambda  = grid_index < DO_Q ? lambda_q : lambda_lj;
             const bool bClearF = (bFirst && PAR(cr));
-#pragma omp parallel for num_threads(pme->nthread) schedule(static)
-            for (int thread = 0; thread < pme->nthread; thread++)
+            const bool haveBState =
+                    (grid_index % 2 == 0) && (grid_index < DO_Q ? pme->bFEP_q : pme->bFEP_lj);
+            if (haveBState)
             {
-                try
+                /* Defer the gather to the B-state grid, store the A-state
+                 * coefficients as they get overwritten by the redistribution */
+                if (pme->nnodes == 1)
                 {
-                    gather_f_bsplines(pme,
-                                      grid,
-                                      bClearF,
-                                      &atc,
-                                      &atc.spline[thread],
-                                      pme->bFEP ? (grid_index % 2 == 0 ? 1.0 - lambda : lambda) : 1.0);
+                    gatherCoefficientsA = coefficient;
                 }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                else
+                {
+                    pme->gatherCoefficients.assign(atc.coefficient.begin(), atc.coefficient.end());
+                    gatherCoefficientsA = pme->gatherCoefficients;
+                }
+                bClearFA = bClearF;
             }
+            else if (grid_index % 2 == 1)
+            {
+                /* Gather the A- and B-state forces in one pass */
+                const real* gridA = pme->pmegrid[grid_index - 1].grid.grid;
 
+                const std::array<PmeGatherGrid, 2> gatherGrids = {
+                    { { gridA, gatherCoefficientsA, 1 - lambda },
+                      { grid, atc.coefficient, lambda } }
+                };
+#pragma omp parallel for num_threads(pme->nthread) schedule(static)
+                for (int thread = 0; thread < pme->nthread; thread++)
+                {
+                    try
+                    {
+                        gather_f_bsplines_multigrid(
+                                pme, gatherGrids, bClearFA, &atc, &atc.spline[thread]);
+                    }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                }
+
+                inc_nrnb(nrnb,
+                         eNR_GATHERFBSP,
+                         2 * pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+            }
+            else
+            {
+#pragma omp parallel for num_threads(pme->nthread) schedule(static)
+                for (int thread = 0; thread < pme->nthread; thread++)
+                {
+                    try
+                    {
+                        gather_f_bsplines(pme,
+                                          grid,
+                                          bClearF,
+                                          &atc,
+                                          &atc.spline[thread],
+                                          pme->bFEP ? 1.0 - lambda : 1.0);
+                    }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                }
 
-            inc_nrnb(nrnb, eNR_GATHERFBSP, pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+                inc_nrnb(nrnb,
+                         eNR_GATHERFBSP,
+                         pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+            }
             /* Note: this wallcycle region is opened above inside an OpenMP
                region, so take care if refactoring code here. */
             wallcycle_stop(wcycle, WallCycleCounter::PmeGather);
@@ -1580,6 +1639,15 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
             }
 
             bFirst = !pme->doCoulomb;
+            /* The forces of the seven grids are gathered in one pass below,
+             * this stores the coefficients for each grid consecutively */
+            const int numAtoms = atc.numAtoms();
+            if (stepWork.computeForces)
+            {
+                pme->gatherCoefficients.resize(static_cast<size_t>(c_pmeMaxGatherGrids) * numAtoms);
+            }
+            std::array<PmeGatherGrid, c_pmeMaxGatherGrids> gatherGrids;
+            const real scale = pme->bFEP ? (fep_state < 1 ? 1.0 - lambda_lj : lambda_lj) : 1.0;
             calc_initial_lb_coeffs(coefficientBuffer, local_c6, local_sigma);
             for (int grid_index = 8; grid_index >= 2; --grid_index)
             {
@@ -1589,6 +1657,17 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
                 gmx_parallel_3dfft_t pfft_setup = pme->pfft_setup[grid_index];
                 real*                grid       = pmegrid->grid.grid;
                 calc_next_lb_coeffs(coefficientBuffer, local_sigma);
+                if (stepWork.computeForces)
+                {
+                    gmx::ArrayRef<real> gridCoefficients = gmx::arrayRefFromArray(
+                            pme->gatherCoefficients.data() + (grid_index - 2) * numAtoms, numAtoms);
+                    std::copy(coefficientBuffer.begin(),
+                              coefficientBuffer.end(),
+                              gridCoefficients.begin());
+                    gatherGrids[grid_index - 2] = {
+                        grid, gridCoefficients, scale * lb_scale_factor[grid_index - 2]
+                    };
+                }
 #pragma omp parallel num_threads(pme->nthread)
                 {
                     try
@@ -1627,34 +1706,33 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
                 }
 
                 unwrap_periodic_pmegrid(pme, grid);
+                wallcycle_stop(wcycle, WallCycleCounter::PmeGather);
+            } /* for (grid_index = 8; grid_index >= 2; --grid_index) */
 
-                if (stepWork.computeForces)
-                {
-                    /* interpolate forces for our local atoms */
-                    bool bClearF = (bFirst && PAR(cr));
-                    real scale   = pme->bFEP ? (fep_state < 1 ? 1.0 - lambda_lj : lambda_lj) : 1.0;
-                    scale *= lb_scale_factor[grid_index - 2];
+            if (stepWork.computeForces)
+            {
+                wallcycle_start(wcycle, WallCycleCounter::PmeGather);
+                /* interpolate forces for our local atoms from all seven grids */
+                const bool bClearF = (bFirst && PAR(cr));
 
 #pragma omp parallel for num_threads(pme->nthread) schedule(static)
-                    for (int thread = 0; thread < pme->nthread; thread++)
+                for (int thread = 0; thread < pme->nthread; thread++)
+                {
+                    try
                     {
-                        try
-                        {
-                            gather_f_bsplines(
-                                    pme, grid, bClearF, &pme->atc[0], &pme->atc[0].spline[thread], scale);
-                        }
-                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                        gather_f_bsplines_multigrid(
+                                pme, gatherGrids, bClearF, &atc, &atc.spline[thread]);
                     }
-
-
-                    inc_nrnb(nrnb,
-                             eNR_GATHERFBSP,
-                             pme->pme_order * pme->pme_order * pme->pme_order * pme->atc[0].numAtoms());
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
                 }
-                wallcycle_stop(wcycle, WallCycleCounter::PmeGather);
 
-                bFirst = false;
-            } /* for (grid_index = 8; grid_index >= 2; --grid_index) */
+                inc_nrnb(nrnb,
+                         eNR_GATHERFBSP,
+                         c_pmeMaxGatherGrids * pme->pme_order * pme->pme_order * pme->pme_order
+                                 * atc.numAtoms());
+                wallcycle_stop(wcycle, WallCycleCounter::PmeGather);
+            }
+            bFirst = false;
         }     /* for (fep_state = 0; fep_state < fep_states_lj; ++fep_state) */
     }         /* if (pme->doLJ && pme->ljpme_combination_rule == LongRangeVdW::LB) */
 
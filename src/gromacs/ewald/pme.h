@@ -265,7 +265,7 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
  * The potential (found in \p pme) must have been found already with a
  * call to gmx_pme_do(). Note that the charges are not spread on the grid in the
  * pme struct. Currently does not work in parallel or with free
- * energy.
+ * energy. Can be called concurrently from different OpenMP threads.
  */
 real gmx_pme_calc_energy(gmx_pme_t* pme, gmx::ArrayRef<const gmx::RVec> x, gmx::ArrayRef<const real> q);
 
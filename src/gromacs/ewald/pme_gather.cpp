@@ -36,6 +36,8 @@
 
 #include "pme_gather.h"
 
+#include <array>
+
 #include "gromacs/math/vec.h"
 #include "gromacs/simd/simd.h"
 #include "gromacs/utility/basedefinitions.h"
@@ -82,6 +84,56 @@ struct do_fspline
     {
     }
 
+    /* Gather from numGrids grids, the grid values are summed with weights gridWeights */
+    do_fspline(const gmx_pme_t*                 pme,
+               int                              numGrids,
+               const real* const*               grids,
+               const real*                      gridWeights,
+               const PmeAtomComm* gmx_restrict  atc,
+               const splinedata_t* gmx_restrict spline,
+               int                              nn) :
+        pme_(pme),
+        grid_(nullptr),
+        atc_(atc),
+        spline_(spline),
+        nn_(nn),
+        numGrids_(numGrids),
+        grids_(grids),
+        gridWeights_(gridWeights)
+    {
+    }
+
+    /* Returns the grid value at index, with multiple grids the weighted sum over the grids */
+    real gridValue(int index) const
+    {
+        if (grids_ == nullptr)
+        {
+            return grid_[index];
+        }
+        real gval = 0;
+        for (int g = 0; g < numGrids_; g++)
+        {
+            gval += gridWeights_[g] * grids_[g][index];
+        }
+        return gval;
+    }
+
+    /* SIMD version of gridValue(), load should load a SIMD register from a grid pointer */
+    template<typename SimdRealType, typename LoadFunction>
+    SimdRealType gridValues(int index, const LoadFunction& load) const
+    {
+        if (grids_ == nullptr)
+        {
+            return load(grid_ + index);
+        }
+        SimdRealType gval = SimdRealType(gridWeights_[0]) * load(grids_[0] + index);
+        for (int g = 1; g < numGrids_; g++)
+        {
+            gval = fma(SimdRealType(gridWeights_[g]), load(grids_[g] + index), gval);
+        }
+        return gval;
+    }
+
     template<typename Int>
     RVec operator()(Int order) const
     {
@@ -115,7 +167,7 @@ struct do_fspline
 
                 for (int ithz = 0; (ithz < order); ithz++)
                 {
-                    const real gval = grid_[index_xy + (idxZ + ithz)];
+                    const real gval = gridValue(index_xy + (idxZ + ithz));
                     fxy1 += thz[ithz] * gval;
                     fz1 += dthz[ithz] * gval;
                 }
@@ -149,6 +201,8 @@ struct do_fspline
         Simd4NReal fy_S = setZero();
         Simd4NReal fz_S = setZero();
 
+        const auto loadU4NGrid = [this](const real* p) { return loadU4NOffset(p, gridNZ); };
+
         /* With order 4 the z-spline is actually aligned */
         const Simd4NReal tz_S = load4DuplicateN(thz);
         const Simd4NReal dz_S = load4DuplicateN(dthz);
@@ -166,7 +220,7 @@ struct do_fspline
                 const Simd4NReal ty_S = loadUNDuplicate4(thy + ithy);
                 const Simd4NReal dy_S = loadUNDuplicate4(dthy + ithy);
 
-                const Simd4NReal gval_S = loadU4NOffset(grid_ + index_xy + idxZ, gridNZ);
+                const Simd4NReal gval_S = gridValues<Simd4NReal>(index_xy + idxZ, loadU4NGrid);
 
 
                 const Simd4NReal fxy1_S = tz_S * gval_S;
@@ -235,6 +289,8 @@ struct do_fspline
         Simd4Real fy_S = setZero();
         Simd4Real fz_S = setZero();
 
+        const auto load4Grid = [](const real* p) { return load4(p); };
+
         Simd4Real tz_S0, tz_S1, dz_S0, dz_S1;
         loadOrderU(thz, order, offset, &tz_S0, &tz_S1);
         loadOrderU(dthz, order, offset, &dz_S0, &dz_S1);
@@ -256,8 +312,10 @@ struct do_fspline
                 const Simd4Real ty_S     = Simd4Real(thy[ithy]);
                 const Simd4Real dy_S     = Simd4Real(dthy[ithy]);
 
-                const Simd4Real gval_S0 = load4(grid_ + index_xy + idxZ - offset);
-                const Simd4Real gval_S1 = load4(grid_ + index_xy + idxZ - offset + 4);
+                const int index_xyz = index_xy + idxZ - offset;
+
+                const Simd4Real gval_S0 = gridValues<Simd4Real>(index_xyz, load4Grid);
+                const Simd4Real gval_S1 = gridValues<Simd4Real>(index_xyz + 4, load4Grid);
 
                 const Simd4Real fxy1_S0 = tz_S0 * gval_S0;
                 const Simd4Real fz1_S0  = dz_S0 * gval_S0;
@@ -283,6 +341,11 @@ private:
     const splinedata_t* const gmx_restrict spline_;
     const int                              nn_;
 
+    /* With multiple grids, grid_ is nullptr and these are set */
+    const int                             numGrids_    = 1;
+    const real* const* const gmx_restrict grids_       = nullptr;
+    const real* const gmx_restrict        gridWeights_ = nullptr;
+
     const int gridNY = pme_->pmegrid_ny;
     const int gridNZ = pme_->pmegrid_nz;
 
@@ -292,6 +355,17 @@ private:
     const int        idxZ   = idxptr[ZZ];
 };
 
+/* Returns the spline interpolated grid gradient, dispatching to compile-time order 4 and 5 */
+static inline RVec interpolateGradient(const do_fspline& spline_func, int order)
+{
+    switch (order)
+    {
+        case 4: return spline_func(std::integral_constant<int, 4>());
+        case 5: return spline_func(std::integral_constant<int, 5>());
+        default: return spline_func(order);
+    }
+}
+
 
 void gather_f_bsplines(const gmx_pme_t*    pme,
                        const real*         grid,
@@ -333,15 +407,7 @@ void gather_f_bsplines(const gmx_pme_t*    pme,
         }
         if (coefficient != 0)
         {
-            RVec       f;
-            const auto spline_func = do_fspline(pme, grid, atc, spline, nn);
-
-            switch (order)
-            {
-                case 4: f = spline_func(std::integral_constant<int, 4>()); break;
-                case 5: f = spline_func(std::integral_constant<int, 5>()); break;
-                default: f = spline_func(order); break;
-            }
+            const RVec f = interpolateGradient(do_fspline(pme, grid, atc, spline, nn), order);
 
             force[n][XX] += -coefficient * (f[XX] * nx * rxx);
             force[n][YY] += -coefficient * (f[XX] * nx * ryx + f[YY] * ny * ryy);
@@ -359,6 +425,69 @@ void gather_f_bsplines(const gmx_pme_t*    pme,
      */
 }
 
+void gather_f_bsplines_multigrid(const gmx_pme_t*                   pme,
+                                 gmx::ArrayRef<const PmeGatherGrid> grids,
+                                 gmx_bool                           bClearF,
+                                 const PmeAtomComm*                 atc,
+                                 const splinedata_t*                spline)
+{
+    GMX_ASSERT(!grids.empty() && grids.ssize() <= c_pmeMaxGatherGrids,
+               "The number of grids should be between 1 and c_pmeMaxGatherGrids");
+
+    const int order    = pme->pme_order;
+    const int numGrids = grids.ssize();
+    const int nx       = pme->nkx;
+    const int ny       = pme->nky;
+    const int nz       = pme->nkz;
+
+    const real rxx = pme->recipbox[XX][XX];
+    const real ryx = pme->recipbox[YY][XX];
+    const real ryy = pme->recipbox[YY][YY];
+    const real rzx = pme->recipbox[ZZ][XX];
+    const real rzy = pme->recipbox[ZZ][YY];
+    const real rzz = pme->recipbox[ZZ][ZZ];
+
+    std::array<const real*, c_pmeMaxGatherGrids> gridPointers;
+    for (int g = 0; g < numGrids; g++)
+    {
+        gridPointers[g] = grids[g].grid;
+    }
+
+    /* Extract the buffer for force output */
+    rvec* gmx_restrict force = as_rvec_array(atc->f.data());
+
+    for (int nn = 0; nn < spline->n; nn++)
+    {
+        const int n = spline->ind[nn];
+
+        /* The scaled coefficients are the weights for summing the grids */
+        std::array<real, c_pmeMaxGatherGrids> gridWeights;
+        bool                                  haveNonZeroWeight = false;
+        for (int g = 0; g < numGrids; g++)
+        {
+            gridWeights[g]    = grids[g].scale * grids[g].coefficient[n];
+            haveNonZeroWeight = haveNonZeroWeight || (gridWeights[g] != 0);
+        }
+
+        if (bClearF)
+        {
+            force[n][XX] = 0;
+            force[n][YY] = 0;
+            force[n][ZZ] = 0;
+        }
+        if (haveNonZeroWeight)
+        {
+            const auto spline_func = do_fspline(
+                    pme, numGrids, gridPointers.data(), gridWeights.data(), atc, spline, nn);
+            const RVec f = interpolateGradient(spline_func, order);
+
+            force[n][XX] += -(f[XX] * nx * rxx);
+            force[n][YY] += -(f[XX] * nx * ryx + f[YY] * ny * ryy);
+            force[n][ZZ] += -(f[XX] * nx * rzx + f[YY] * ny * rzy + f[ZZ] * nz * rzz);
+        }
+    }
+}
+
 
 real gather_energy_bsplines(gmx_pme_t* pme, const real* grid, PmeAtomComm* atc)
 {
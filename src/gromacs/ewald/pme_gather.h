@@ -34,6 +34,7 @@
 #ifndef GMX_EWALD_PME_GATHER_H
 #define GMX_EWALD_PME_GATHER_H
 
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
@@ -41,6 +42,20 @@ class PmeAtomComm;
 struct gmx_pme_t;
 struct splinedata_t;
 
+//! The maximum number of grids that can be gathered from in one pass
+constexpr int c_pmeMaxGatherGrids = 7;
+
+//! A grid to gather forces from, with the local atom coefficients and a scale factor
+struct PmeGatherGrid
+{
+    //! The unwrapped real-space grid
+    const real* grid;
+    //! The coefficients, indexed by local atom
+    gmx::ArrayRef<const real> coefficient;
+    //! Scale factor for the forces from this grid
+    real scale;
+};
+
 void gather_f_bsplines(const struct gmx_pme_t* pme,
                        const real*             grid,
                        gmx_bool                bClearF,
@@ -48,6 +63,20 @@ void gather_f_bsplines(const struct gmx_pme_t* pme,
                        const splinedata_t*     spline,
                        real                    scale);
 
+/*! \brief Gathers the forces from several grids in a single pass over the atoms
+ *
+ * All grids should have the same layout and share the splines in \p spline.
+ * As the force is linear in the grid values, the grid values weighted with
+ * the scaled atom coefficients are summed before applying the splines.
+ * This gives the same result as calling gather_f_bsplines() for each grid,
+ * but loads the spline data and updates the forces only once per atom.
+ */
+void gather_f_bsplines_multigrid(const struct gmx_pme_t*            pme,
+                                 gmx::ArrayRef<const PmeGatherGrid> grids,
+                                 gmx_bool                           bClearF,
+                                 const PmeAtomComm*                 atc,
+                                 const splinedata_t*                spline);
+
 real gather_energy_bsplines(struct gmx_pme_t* pme, const real* grid, PmeAtomComm* atc);
 
 #endif
@@ -401,11 +401,16 @@ struct gmx_pme_t
      * and stores the sigma values for local atoms. */
     FastVector<real> lb_buf1;
     FastVector<real> lb_buf2;
+    /* Buffer with coefficients of local atoms for gathering forces from
+     * several grids in one pass: the A-state coefficients with free-energy
+     * (in parallel) or the coefficients of the seven L-B grids. */
+    FastVector<real> gatherCoefficients;
 
     std::array<pme_overlap_t, 2> overlap; /* Indexed on dimension, 0=x, 1=y */
 
-    /* Atom step for energy only calculation in gmx_pme_calc_energy() */
-    std::unique_ptr<PmeAtomComm> atc_energy;
+    /* Atom step for energy only calculation in gmx_pme_calc_energy(),
+     * one per OpenMP thread so the energy can be computed concurrently */
+    std::vector<std::unique_ptr<PmeAtomComm>> atc_energy;
 
     /* Communication buffers */
     rvec* bufv;       /* Communication buffer */
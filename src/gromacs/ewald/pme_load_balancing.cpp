@@ -46,8 +46,11 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 
 #include <algorithm>
+#include <string>
 
 #include "gromacs/domdec/dlb.h"
 #include "gromacs/domdec/domdec.h"
@@ -58,10 +61,13 @@
 #include "gromacs/ewald/pme.h"
 #include "gromacs/fft/calcgrid.h"
 #include "gromacs/gmxlib/network.h"
+#include "gromacs/hardware/cpuinfo.h"
+#include "gromacs/hardware/device_management.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
 #include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/inputrec.h"
@@ -80,8 +86,10 @@
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "pme_internal.h"
+#include "pme_load_balancing_cache.h"
 #include "pme_pp.h"
 
 /*! \brief Parameters and settings for one PP-PME setup */
@@ -196,8 +204,172 @@ struct pme_load_balancing_t
     int    cycles_n;  /**< step cycle counter cumulative count */
     double cycles_c;  /**< step cycle counter cumulative cycles */
     double startTime; /**< time stamp when the balancing was started on the main rank (relative to the UNIX epoch start).*/
+
+    bool        bBalancingDone; /**< did we complete at least one round of balancing? */
+    bool        bCacheMain;     /**< does this rank read and write the cache? */
+    std::string cacheFileName;  /**< the load balancing cache file, empty when not used */
+    std::string cacheKey;       /**< the key for this run in the cache */
 };
 
+/*! \brief Sets the pair-list cut-offs and Ewald coefficients of \p set
+ *
+ * \p set should have the grid, the grid spacing and the Coulomb cut-off set.
+ */
+static void setPairlistAndEwaldParameters(const pme_load_balancing_t& pme_lb, pme_setup_t* set)
+{
+    if (pme_lb.cutoff_scheme == CutoffScheme::Verlet)
+    {
+        /* Never decrease the Coulomb and VdW list buffers */
+        set->rlistOuter = std::max(set->rcut_coulomb + pme_lb.rbufOuter_coulomb,
+                                   pme_lb.rcut_vdw + pme_lb.rbufOuter_vdw);
+        set->rlistInner = std::max(set->rcut_coulomb + pme_lb.rbufInner_coulomb,
+                                   pme_lb.rcut_vdw + pme_lb.rbufInner_vdw);
+    }
+    else
+    {
+        /* TODO Remove these lines and pme_lb->cutoff_scheme */
+        real tmpr_coulomb = set->rcut_coulomb + pme_lb.rbufOuter_coulomb;
+        real tmpr_vdw     = pme_lb.rcut_vdw + pme_lb.rbufOuter_vdw;
+        /* Two (known) bugs with cutoff-scheme=group here:
+         * - This modification of rlist results in incorrect DD comunication.
+         * - We should set fr->bTwinRange = (fr->rlistlong > fr->rlist).
+         */
+        set->rlistOuter = std::min(tmpr_coulomb, tmpr_vdw);
+        set->rlistInner = set->rlistOuter;
+    }
+
+    /* The grid efficiency is the size wrt a grid with uniform x/y/z spacing */
+    set->grid_efficiency = 1;
+    for (int d = 0; d < DIM; d++)
+    {
+        set->grid_efficiency *= (set->grid[d] * set->spacing) / norm(pme_lb.box_start[d]);
+    }
+    /* The Ewald coefficient is inversly proportional to the cut-off */
+    set->ewaldcoeff_q =
+            pme_lb.setup[0].ewaldcoeff_q * pme_lb.setup[0].rcut_coulomb / set->rcut_coulomb;
+    /* We set ewaldcoeff_lj in set, even when LJ-PME is not used */
+    set->ewaldcoeff_lj =
+            pme_lb.setup[0].ewaldcoeff_lj * pme_lb.setup[0].rcut_coulomb / set->rcut_coulomb;
+
+    set->count  = 0;
+    set->cycles = 0;
+}
+
+/*! \brief Looks up the setup chosen by a previous run in the cache and prepares for validating it
+ *
+ * When a usable setup is found, the balancing only times the initial and the cached
+ * setup and picks the fastest. When the cached setup is the initial setup,
+ * balancing is turned off.
+ */
+static void useCachedSetup(pme_load_balancing_t*     pme_lb,
+                           t_commrec*                cr,
+                           const gmx::MDLogger&      mdlog,
+                           const t_inputrec&         ir,
+                           const matrix              box,
+                           const nonbonded_verlet_t& nbv,
+                           const int                 numAtomsTotal,
+                           const DeviceInformation*  deviceInfo)
+{
+    PmeLoadBalancingCacheEntry entry;
+    bool                       found = false;
+    if (pme_lb->bCacheMain)
+    {
+        PmeLoadBalancingCacheHardware hardware;
+        hardware.cpuBrand    = gmx::CpuInfo::detect().brandString();
+        hardware.gpuModel    = deviceInfo ? getDeviceInformationString(*deviceInfo) : "";
+        hardware.numRanks    = cr->nnodes;
+        hardware.numPmeRanks = cr->npmenodes;
+        hardware.numThreads  = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+        hardware.kernelName  = Nbnxm::lookup_kernel_name(nbv.kernelSetup().kernelType);
+        pme_lb->cacheKey = pmeLoadBalancingCacheKey(hardware, ir, box, numAtomsTotal);
+        found = readPmeLoadBalancingCache(pme_lb->cacheFileName, pme_lb->cacheKey, &entry);
+    }
+    if (haveDDAtomOrdering(*cr))
+    {
+        dd_bcast(cr->dd, sizeof(bool), &found);
+        dd_bcast(cr->dd, sizeof(entry), &entry);
+    }
+    if (!found)
+    {
+        GMX_LOG(mdlog.info)
+                .asParagraph()
+                .appendTextFormatted(
+                        "No PME load balancing setup found in cache %s, will scan setups",
+                        pme_lb->cacheFileName.c_str());
+        return;
+    }
+
+    if (entry.grid[XX] == pme_lb->setup[0].grid[XX] && entry.grid[YY] == pme_lb->setup[0].grid[YY]
+        && entry.grid[ZZ] == pme_lb->setup[0].grid[ZZ])
+    {
+        GMX_LOG(mdlog.info)
+                .asParagraph()
+                .appendText(
+                        "The cached PME load balancing setup is the initial setup, turning off PME "
+                        "load balancing");
+        pme_lb->bActive = false;
+        return;
+    }
+
+    pme_setup_t set;
+    set.pmedata = nullptr;
+    copy_ivec(entry.grid, set.grid);
+    set.spacing = getGridSpacingFromBox(pme_lb->box_start, set.grid);
+    /* The box might have changed, so we might need a longer cut-off for the accuracy */
+    set.rcut_coulomb = std::max({ entry.rcutCoulomb,
+                                  pme_lb->cut_spacing * set.spacing,
+                                  pme_lb->rcut_coulomb_start });
+    setPairlistAndEwaldParameters(*pme_lb, &set);
+
+    /* Check the same restrictions as when scanning setups, DD is checked when switching */
+    const NumPmeDomains numPmeDomains = getNumPmeDomains(cr->dd);
+    const bool          gridIsOk      = gmx_pme_check_restrictions(ir.pme_order,
+                                                         set.grid[XX],
+                                                         set.grid[YY],
+                                                         set.grid[ZZ],
+                                                         numPmeDomains.x,
+                                                         numPmeDomains.y,
+                                                         0,
+                                                         false,
+                                                         true,
+                                                         false);
+    const bool          cutoffIsOk    = (ir.pbcType == PbcType::No
+                              || gmx::square(set.rlistOuter) <= max_cutoff2(ir.pbcType, box));
+    if (!gridIsOk || !cutoffIsOk || set.spacing <= pme_lb->setup[0].spacing
+        || set.spacing > c_maxSpacingScaling * pme_lb->setup[0].spacing)
+    {
+        GMX_LOG(mdlog.info)
+                .asParagraph()
+                .appendText(
+                        "The cached PME load balancing setup can not be used, will scan setups");
+        return;
+    }
+
+    GMX_LOG(mdlog.info)
+            .asParagraph()
+            .appendTextFormatted(
+                    "Using cached PME load balancing setup with grid %d %d %d and coulomb cutoff "
+                    "%.3f (%.1f M-cycles in the previous run), will compare it with the initial "
+                    "setup",
+                    set.grid[XX],
+                    set.grid[YY],
+                    set.grid[ZZ],
+                    set.rcut_coulomb,
+                    entry.cycles * 1e-6);
+
+    /* Skip the scan (stage 0). Stage 1 times the initial setup and then
+     * the cached setup, stage 2 re-times the initial setup if it was not
+     * much slower. Then we pick the fastest.
+     */
+    pme_lb->setup.push_back(set);
+    pme_lb->stage  = 1;
+    pme_lb->nstage = 3;
+    pme_lb->start  = 0;
+    pme_lb->end    = 2;
+    /* Start balancing directly, also with separate PME ranks */
+    pme_lb->bBalance = true;
+}
+
 /* TODO The code in this file should call this getter, rather than
  * read bActive anywhere */
 bool pme_loadbal_is_active(const pme_load_balancing_t* pme_lb)
@@ -214,7 +386,9 @@ void pme_loadbal_init(pme_load_balancing_t**     pme_lb_p,
                       const interaction_const_t& ic,
                       const nonbonded_verlet_t&  nbv,
                       gmx_pme_t*                 pmedata,
-                      gmx_bool                   bUseGPU)
+                      gmx_bool                   bUseGPU,
+                      const int                  numAtomsTotal,
+                      const DeviceInformation*   deviceInfo)
 {
 
     pme_load_balancing_t* pme_lb;
@@ -319,6 +493,15 @@ void pme_loadbal_init(pme_load_balancing_t**     pme_lb_p,
      */
     pme_lb->bBalance = (pme_lb->bActive && (bUseGPU && !pme_lb->bSepPMERanks));
 
+    pme_lb->bBalancingDone = false;
+    pme_lb->bCacheMain     = MAIN(cr);
+    const char* cacheFileName = getenv("GMX_PME_LOADBAL_CACHE");
+    if (cacheFileName != nullptr && pme_lb->bActive)
+    {
+        pme_lb->cacheFileName = cacheFileName;
+        useCachedSetup(pme_lb, cr, mdlog, ir, box, nbv, numAtomsTotal, deviceInfo);
+    }
+
     pme_lb->step_rel_stop = PMETunePeriod * ir.nstlist;
 
     /* Delay DD load balancing when GPUs are used */
@@ -346,8 +529,6 @@ void pme_loadbal_init(pme_load_balancing_t**     pme_lb_p,
 static gmx_bool pme_loadbal_increase_cutoff(pme_load_balancing_t* pme_lb, int pme_order, const gmx_domdec_t* dd)
 {
     real fac, sp;
-    real tmpr_coulomb, tmpr_vdw;
-    int  d;
     bool grid_ok;
 
     /* Try to add a new setup with next larger cut-off to the list */
@@ -400,41 +581,8 @@ static gmx_bool pme_loadbal_increase_cutoff(pme_load_balancing_t* pme_lb, int pm
         set.rcut_coulomb = pme_lb->rcut_coulomb_start;
     }
 
-    if (pme_lb->cutoff_scheme == CutoffScheme::Verlet)
-    {
-        /* Never decrease the Coulomb and VdW list buffers */
-        set.rlistOuter = std::max(set.rcut_coulomb + pme_lb->rbufOuter_coulomb,
-                                  pme_lb->rcut_vdw + pme_lb->rbufOuter_vdw);
-        set.rlistInner = std::max(set.rcut_coulomb + pme_lb->rbufInner_coulomb,
-                                  pme_lb->rcut_vdw + pme_lb->rbufInner_vdw);
-    }
-    else
-    {
-        /* TODO Remove these lines and pme_lb->cutoff_scheme */
-        tmpr_coulomb = set.rcut_coulomb + pme_lb->rbufOuter_coulomb;
-        tmpr_vdw     = pme_lb->rcut_vdw + pme_lb->rbufOuter_vdw;
-        /* Two (known) bugs with cutoff-scheme=group here:
-         * - This modification of rlist results in incorrect DD comunication.
-         * - We should set fr->bTwinRange = (fr->rlistlong > fr->rlist).
-         */
-        set.rlistOuter = std::min(tmpr_coulomb, tmpr_vdw);
-        set.rlistInner = set.rlistOuter;
-    }
-
     set.spacing = sp;
-    /* The grid efficiency is the size wrt a grid with uniform x/y/z spacing */
-    set.grid_efficiency = 1;
-    for (d = 0; d < DIM; d++)
-    {
-        set.grid_efficiency *= (set.grid[d] * sp) / norm(pme_lb->box_start[d]);
-    }
-    /* The Ewald coefficient is inversly proportional to the cut-off */
-    set.ewaldcoeff_q = pme_lb->setup[0].ewaldcoeff_q * pme_lb->setup[0].rcut_coulomb / set.rcut_coulomb;
-    /* We set ewaldcoeff_lj in set, even when LJ-PME is not used */
-    set.ewaldcoeff_lj = pme_lb->setup[0].ewaldcoeff_lj * pme_lb->setup[0].rcut_coulomb / set.rcut_coulomb;
-
-    set.count  = 0;
-    set.cycles = 0;
+    setPairlistAndEwaldParameters(*pme_lb, &set);
 
     if (debug)
     {
@@ -894,6 +1042,8 @@ static void pme_load_balance(pme_load_balancing_t*          pme_lb,
     if (pme_lb->stage == pme_lb->nstage)
     {
         print_grid(fp_err, fp_log, "", "optimal", set, -1);
+
+        pme_lb->bBalancingDone = true;
     }
 }
 
@@ -1185,6 +1335,15 @@ void pme_loadbal_done(pme_load_balancing_t* pme_lb, FILE* fplog, const gmx::MDLo
     {
         print_pme_loadbal_settings(pme_lb, fplog, mdlog, bNonBondedOnGPU);
     }
+    if (!pme_lb->cacheFileName.empty() && pme_lb->bCacheMain && pme_lb->bBalancingDone)
+    {
+        const pme_setup_t&         fastest = pme_lb->setup[pme_lb->fastest];
+        PmeLoadBalancingCacheEntry entry;
+        entry.rcutCoulomb = fastest.rcut_coulomb;
+        copy_ivec(fastest.grid, entry.grid);
+        entry.cycles = fastest.cycles;
+        writePmeLoadBalancingCache(pme_lb->cacheFileName, pme_lb->cacheKey, entry);
+    }
     for (int i = 0; i < gmx::ssize(pme_lb->setup); i++)
     {
         // current element is stored in forcerec and free'd in Mdrunner::mdruner, together with shared data
@@ -48,6 +48,7 @@
 #include "gromacs/math/vectypes.h"
 #include "gromacs/timing/wallcycle.h"
 
+struct DeviceInformation;
 struct nonbonded_verlet_t;
 struct t_commrec;
 struct t_forcerec;
@@ -75,6 +76,13 @@ bool pme_loadbal_is_active(const pme_load_balancing_t* pme_lb);
  * The actual load balancing might start right away, later or never.
  * The PME grid in pmedata is reused for smaller grids to lower the memory
  * usage.
+ *
+ * When the environment variable GMX_PME_LOADBAL_CACHE is set to a file name,
+ * the setup chosen by a previous run with the same system, hardware and build
+ * is read from that file. Then only the cached and the initial setup are timed.
+ * The setup chosen by this run is written to the file in pme_loadbal_done().
+ * \p deviceInfo describes the GPU used by this rank, for the cache key,
+ * and should be nullptr when no GPU is used.
  */
 void pme_loadbal_init(pme_load_balancing_t**     pme_lb_p,
                       t_commrec*                 cr,
@@ -84,7 +92,9 @@ void pme_loadbal_init(pme_load_balancing_t**     pme_lb_p,
                       const interaction_const_t& ic,
                       const nonbonded_verlet_t&  nbv,
                       gmx_pme_t*                 pmedata,
-                      gmx_bool                   bUseGPU);
+                      gmx_bool                   bUseGPU,
+                      int                        numAtomsTotal,
+                      const DeviceInformation*   deviceInfo);
 
 /*! \brief Process cycles and PME load balance when necessary
  *
@@ -108,7 +118,10 @@ void pme_loadbal_do(pme_load_balancing_t*          pme_lb,
                     gmx_bool*                      bPrinting,
                     bool                           useGpuPmePpCommunication);
 
-/*! \brief Finish the PME load balancing and print the settings when fplog!=NULL */
+/*! \brief Finish the PME load balancing and print the settings when fplog!=NULL
+ *
+ * Also stores the chosen setup in the load balancing cache, when used.
+ */
 void pme_loadbal_done(pme_load_balancing_t* pme_lb, FILE* fplog, const gmx::MDLogger& mdlog, gmx_bool bNonBondedOnGPU);
 
 #endif
@@ -0,0 +1,235 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief Implements functions for the cache of PME load balancing setups
+ *
+ * \ingroup module_ewald
+ */
+
+#include "gmxpre.h"
+
+#include "pme_load_balancing_cache.h"
+
+#include "config.h"
+
+#include <fcntl.h>
+
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#if GMX_NATIVE_WINDOWS
+#    include <io.h>
+
+#    include <sys/locking.h>
+#endif
+
+#include <algorithm>
+#include <string>
+
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/utility/baseversion.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/sysinfo.h"
+#include "gromacs/utility/textreader.h"
+#include "gromacs/utility/textwriter.h"
+
+namespace
+{
+
+/*! \brief Exclusive lock on a lock file next to the cache file, released on destruction
+ *
+ * The lock is on a separate file, since the cache file itself is replaced
+ * by renaming. When locking is not supported, e.g. on some network file
+ * systems, the cache is written without a lock.
+ */
+class PmeLoadBalancingCacheLock
+{
+public:
+    //! Blocks until the lock for \p cacheFileName is obtained
+    explicit PmeLoadBalancingCacheLock(const std::string& cacheFileName) :
+        fp_(std::fopen((cacheFileName + ".lock").c_str(), "a"))
+    {
+        if (fp_ == nullptr)
+        {
+            return;
+        }
+#if GMX_NATIVE_WINDOWS
+        _locking(fileno(fp_), _LK_LOCK, LONG_MAX);
+#elif !defined __native_client__
+        // don't initialize here: the struct order is OS dependent!
+        struct flock fl;
+        fl.l_type   = F_WRLCK;
+        fl.l_whence = SEEK_SET;
+        fl.l_start  = 0;
+        fl.l_len    = 0;
+        fl.l_pid    = 0;
+        fcntl(fileno(fp_), F_SETLKW, &fl);
+#endif
+    }
+
+    ~PmeLoadBalancingCacheLock()
+    {
+        if (fp_ != nullptr)
+        {
+#if GMX_NATIVE_WINDOWS
+            _locking(fileno(fp_), _LK_UNLCK, LONG_MAX);
+#endif
+            // Closing the file releases the fcntl lock
+            std::fclose(fp_);
+        }
+    }
+
+    GMX_DISALLOW_COPY_AND_ASSIGN(PmeLoadBalancingCacheLock);
+
+private:
+    //! The lock file, nullptr when it could not be opened
+    FILE* fp_;
+};
+
+} // namespace
+
+std::string pmeLoadBalancingCacheKey(const PmeLoadBalancingCacheHardware& hardware,
+                                     const t_inputrec&                    ir,
+                                     const matrix                         box,
+                                     const int                            numAtomsTotal)
+{
+    std::string key = gmx::formatString(
+            "version=%s;double=%d;kernel=%s;cpu=%s;gpu=%s;ranks=%d;pmeranks=%d;threads=%d;"
+            "natoms=%d;box=%.1f,%.1f,%.1f;rcoulomb=%g;rvdw=%g;grid=%d,%d,%d;order=%d;nstlist=%d",
+            gmx_version(),
+            GMX_DOUBLE,
+            hardware.kernelName.c_str(),
+            hardware.cpuBrand.c_str(),
+            hardware.gpuModel.empty() ? "none" : hardware.gpuModel.c_str(),
+            hardware.numRanks,
+            hardware.numPmeRanks,
+            hardware.numThreads,
+            numAtomsTotal,
+            box[XX][XX],
+            box[YY][YY],
+            box[ZZ][ZZ],
+            ir.rcoulomb,
+            ir.rvdw,
+            ir.nkx,
+            ir.nky,
+            ir.nkz,
+            ir.pme_order,
+            ir.nstlist);
+    // The key should be a single word in the cache file
+    std::replace_if(
+            key.begin(), key.end(), [](const char c) { return std::isspace(c) != 0; }, '_');
+
+    return key;
+}
+
+bool readPmeLoadBalancingCache(const std::string&          fileName,
+                               const std::string&          key,
+                               PmeLoadBalancingCacheEntry* entry)
+{
+    if (!gmx_fexist(fileName))
+    {
+        return false;
+    }
+
+    for (const std::string& line : gmx::splitDelimitedString(
+                 gmx::TextReader::readFileToString(fileName), '\n'))
+    {
+        double rcut;
+        if (gmx::startsWith(line, key + " ")
+            && std::sscanf(line.c_str() + key.size(),
+                           "%lf %d %d %d %lf",
+                           &rcut,
+                           &entry->grid[XX],
+                           &entry->grid[YY],
+                           &entry->grid[ZZ],
+                           &entry->cycles)
+                       == 5)
+        {
+            entry->rcutCoulomb = rcut;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void writePmeLoadBalancingCache(const std::string&                fileName,
+                                const std::string&                key,
+                                const PmeLoadBalancingCacheEntry& entry)
+{
+    const PmeLoadBalancingCacheLock lock(fileName);
+
+    // Read the current contents under the lock, to merge with entries written by other runs
+    std::string contents;
+    if (gmx_fexist(fileName))
+    {
+        for (const std::string& line : gmx::splitDelimitedString(
+                     gmx::TextReader::readFileToString(fileName), '\n'))
+        {
+            if (!line.empty() && !gmx::startsWith(line, key + " "))
+            {
+                contents += line + "\n";
+            }
+        }
+    }
+    else
+    {
+        contents = "# GROMACS PME load balancing cache: key rcoulomb grid-x grid-y grid-z cycles\n";
+    }
+    contents += gmx::formatString("%s %.6f %d %d %d %.6g\n",
+                                  key.c_str(),
+                                  entry.rcutCoulomb,
+                                  entry.grid[XX],
+                                  entry.grid[YY],
+                                  entry.grid[ZZ],
+                                  entry.cycles);
+
+    // The temporary file name is unique per process, also on a shared file system
+    char hostName[256];
+    gmx_gethostname(hostName, sizeof(hostName));
+    const std::string tmpFileName =
+            gmx::formatString("%s.%s.%d.tmp", fileName.c_str(), hostName, gmx_getpid());
+    gmx::TextWriter::writeFileFromString(tmpFileName, contents);
+    if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        gmx_fatal(FARGS,
+                  "Could not rename %s to %s for the PME load balancing cache",
+                  tmpFileName.c_str(),
+                  fileName.c_str());
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief Declares functions for the cache of PME load balancing setups
+ *
+ * The cache is a text file with one line per entry, each starting with
+ * a key that identifies the system, hardware and build of a run.
+ *
+ * \ingroup module_ewald
+ */
+
+#ifndef GMX_EWALD_PME_LOAD_BALANCING_CACHE_H
+#define GMX_EWALD_PME_LOAD_BALANCING_CACHE_H
+
+#include <string>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+struct t_inputrec;
+
+/*! \brief The hardware, parallel setup and kernel a run uses, as stored in the cache key */
+struct PmeLoadBalancingCacheHardware
+{
+    std::string cpuBrand;    //!< The CPU brand string
+    std::string gpuModel;    //!< The description of the GPU, empty when no GPU is used
+    int         numRanks;    //!< The total number of ranks
+    int         numPmeRanks; //!< The number of separate PME ranks
+    int         numThreads;  //!< The number of OpenMP threads per rank
+    std::string kernelName;  //!< The name of the non-bonded kernel
+};
+
+/*! \brief A PME load balancing setup stored in the cache */
+struct PmeLoadBalancingCacheEntry
+{
+    real   rcutCoulomb; //!< The Coulomb cut-off
+    ivec   grid;        //!< The PME grid dimensions
+    double cycles;      //!< The cycles for nstlist steps with this setup
+};
+
+/*! \brief Returns the key identifying the system, hardware and build in the load balancing cache
+ *
+ * The box is included with low precision, so small changes in volume between
+ * continuation runs do not invalidate the cache; the cached setup is timed anyhow.
+ * The key does not contain whitespace.
+ */
+std::string pmeLoadBalancingCacheKey(const PmeLoadBalancingCacheHardware& hardware,
+                                     const t_inputrec&                    ir,
+                                     const matrix                         box,
+                                     int                                  numAtomsTotal);
+
+/*! \brief Looks up \p key in the load balancing cache file, returns whether it was found */
+bool readPmeLoadBalancingCache(const std::string&          fileName,
+                               const std::string&          key,
+                               PmeLoadBalancingCacheEntry* entry);
+
+/*! \brief Stores \p entry for \p key in the load balancing cache file
+ *
+ * Replaces a previous entry with the same key and keeps all other entries.
+ * Concurrent runs can share a cache file: the file is re-read and merged
+ * while holding a lock on a separate lock file, and the result is written
+ * to a temporary file, unique for this process, that is renamed to
+ * \p fileName, so readers never see a partial file.
+ */
+void writePmeLoadBalancingCache(const std::string&                fileName,
+                                const std::string&                key,
+                                const PmeLoadBalancingCacheEntry& entry);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements tests for the plain Ewald reciprocal-space sum.
+ *
+ * \ingroup module_ewald
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/ewald/ewald.h"
+
+#include "config.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/refdata.h"
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The output of a plain Ewald calculation
+struct EwaldOutput
+{
+    //! The reciprocal-space energy
+    real energy;
+    //! The reciprocal-space virial
+    matrix virial;
+    //! The reciprocal-space forces
+    std::vector<RVec> forces;
+};
+
+//! A small neutral system, with an atom count that is not a multiple of common SIMD widths
+const std::vector<RVec> c_coordinates = { { 0.12, 0.25, 0.31 }, { 0.35, 0.18, 0.52 },
+                                          { 1.55, 1.02, 0.21 }, { 0.91, 1.73, 1.40 },
+                                          { 1.88, 0.44, 2.17 }, { 0.63, 2.06, 0.95 },
+                                          { 1.27, 1.31, 1.86 } };
+//! The charges of the atoms in \p c_coordinates
+const std::vector<real> c_charges = { 0.8, -0.4, -0.4, 0.5, -0.5, 1.0, -1.0 };
+//! A triclinic box, plain Ewald only uses its diagonal
+const matrix c_box = { { 2.1, 0, 0 }, { 0.4, 2.3, 0 }, { -0.3, 0.5, 2.6 } };
+
+//! Computes the plain Ewald reciprocal-space sum for the test system using \p numThreads threads
+EwaldOutput computeEwald(int numThreads)
+{
+    t_inputrec ir;
+    ir.nkx = 5;
+    ir.nky = 4;
+    ir.nkz = 6;
+    gmx_ewald_tab_t ewaldTable(ir, nullptr);
+
+    const int numThreadsSaved = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+    gmx_omp_nthreads_set(ModuleMultiThread::Default, numThreads);
+
+    EwaldOutput output;
+    output.forces.assign(c_coordinates.size(), { 0, 0, 0 });
+    real dvdlambda = 0;
+    output.energy  = do_ewald(false,
+                             1.0,
+                             1.0,
+                             FreeEnergyPerturbationType::No,
+                             c_coordinates,
+                             output.forces,
+                             c_charges,
+                             {},
+                             c_box,
+                             nullptr,
+                             c_coordinates.size(),
+                             output.virial,
+                             3.0,
+                             0.0,
+                             &dvdlambda,
+                             &ewaldTable);
+
+    gmx_omp_nthreads_set(ModuleMultiThread::Default, numThreadsSaved);
+
+    return output;
+}
+
+TEST(EwaldTest, ReciprocalSumMatchesReferenceValues)
+{
+    const EwaldOutput output = computeEwald(1);
+
+    TestReferenceData    refData;
+    TestReferenceChecker checker(refData.rootChecker());
+    /* The reference values were generated with the serial implementation
+     * without SIMD. The summation order over atoms and k-vectors differs,
+     * which gives differences of the order of the float round-off times
+     * the number of terms.
+     */
+    checker.setDefaultTolerance(
+            relativeToleranceAsPrecisionDependentFloatingPoint(100.0, 1e-5, 1e-10));
+    checker.checkReal(output.energy, "Energy");
+    checker.checkVector(output.virial[XX], "VirialX");
+    checker.checkVector(output.virial[YY], "VirialY");
+    checker.checkVector(output.virial[ZZ], "VirialZ");
+    checker.checkSequence(output.forces.begin(), output.forces.end(), "Forces");
+}
+
+TEST(EwaldTest, ReciprocalSumDoesNotDependOnThreadCount)
+{
+    if (!GMX_OPENMP)
+    {
+        GTEST_SKIP() << "Needs OpenMP";
+    }
+
+    const EwaldOutput ref = computeEwald(1);
+    for (const int numThreads : { 2, 3, 8 })
+    {
+        SCOPED_TRACE(formatString("With %d threads", numThreads));
+        const EwaldOutput output = computeEwald(numThreads);
+
+        // The reduction order is fixed, so the results should be bitwise identical
+        EXPECT_EQ(ref.energy, output.energy);
+        for (int d1 = 0; d1 < DIM; d1++)
+        {
+            for (int d2 = 0; d2 < DIM; d2++)
+            {
+                EXPECT_EQ(ref.virial[d1][d2], output.virial[d1][d2]);
+            }
+        }
+        for (size_t a = 0; a < ref.forces.size(); a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_EQ(ref.forces[a][d], output.forces[a][d]);
+            }
+        }
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,230 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that gathering PME forces from several grids in one pass gives
+ * the same forces as gathering from each grid separately.
+ *
+ * \ingroup module_ewald
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/pme_gather.h"
+#include "gromacs/ewald/pme_internal.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+#include "pmetestcommon.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Coordinates of the atoms to gather forces for
+const CoordinatesVector c_coordinates = {
+    { 0.11, 0.42, 0.87 }, { 1.63, 0.28, 0.05 }, { 0.74, 1.91, 1.32 }, { 2.05, 1.14, 0.66 },
+    { 0.38, 0.97, 1.74 }, { 1.29, 2.36, 0.21 }, { 1.87, 0.63, 1.49 }, { 0.52, 1.48, 0.33 },
+    { 2.21, 2.02, 1.08 }, { 0.96, 0.15, 1.95 }, { 1.42, 1.67, 0.92 }, { 0.23, 2.24, 0.58 },
+    { 1.75, 1.33, 1.81 }
+};
+
+/*! \brief The grid scale factors for LJ-PME with Lorentz-Berthelot combination rules
+ *
+ * These are the binomial coefficients the seven grids are weighted with in gmx_pme_do().
+ */
+const std::vector<real> c_ljLorentzBerthelotScales = { 1.0 / 64, 6.0 / 64,  15.0 / 64, 20.0 / 64,
+                                                       15.0 / 64, 6.0 / 64, 1.0 / 64 };
+
+//! Returns deterministic, irregular values for grid \p gridIndex with \p size points
+std::vector<real> makeGridValues(int gridIndex, int size)
+{
+    std::vector<real> values(size);
+    for (int i = 0; i < size; i++)
+    {
+        values[i] = std::sin(0.37 * i + 1.3 * gridIndex) + 0.5 * std::cos(0.011 * i * i);
+    }
+    return values;
+}
+
+/*! \brief Returns the atom coefficients for grid \p gridIndex
+ *
+ * Atom 3 has zero coefficients on all grids and atom 5 on grid 0 only,
+ * to cover skipping atoms with all zero coefficients.
+ */
+std::vector<real> makeCoefficients(int gridIndex, int numAtoms)
+{
+    std::vector<real> coefficients(numAtoms);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        coefficients[a] = 0.6 * std::cos(0.9 * a + 0.7 * gridIndex) + 0.1 * gridIndex;
+    }
+    coefficients[3] = 0;
+    if (gridIndex == 0)
+    {
+        coefficients[5] = 0;
+    }
+    return coefficients;
+}
+
+//! Test parameters: box name, PME order, grid scales, whether to clear the forces
+using MultiGridGatherTestParams = std::tuple<std::string, int, std::vector<real>, bool>;
+
+//! Test fixture for gathering from multiple grids
+class PmeMultiGridGatherTest : public ::testing::TestWithParam<MultiGridGatherTestParams>
+{
+};
+
+TEST_P(PmeMultiGridGatherTest, GivesSameForcesAsGatheringPerGrid)
+{
+    const auto& [boxName, pmeOrder, scales, clearForces] = GetParam();
+    const int numGrids                                   = scales.size();
+    const int numAtoms                                   = c_coordinates.size();
+
+    t_inputrec inputRec;
+    inputRec.nkx         = 16;
+    inputRec.nky         = 12;
+    inputRec.nkz         = 14;
+    inputRec.pme_order   = pmeOrder;
+    inputRec.coulombtype = CoulombInteractionType::Pme;
+    inputRec.epsilon_r   = 1.0;
+
+    PmeSafePointer pmeSafe = pmeInitWrapper(
+            &inputRec, CodePath::CPU, nullptr, nullptr, nullptr, c_inputBoxes.at(boxName));
+    gmx_pme_t* pme = pmeSafe.get();
+
+    const ChargesVector unitCharges(numAtoms, 1.0);
+    pmeInitAtoms(pme, nullptr, CodePath::CPU, c_coordinates, unitCharges);
+    // Compute the splines and grid indices from the coordinates, without spreading
+    pmePerformSplineAndSpread(pme, CodePath::CPU, true, false);
+
+    PmeAtomComm*  atc    = &pme->atc[0];
+    splinedata_t* spline = &atc->spline[0];
+    // Normally done by the serial spline computation
+    spline->n = numAtoms;
+
+    const int gridSize = pme->pmegrid_nx * pme->pmegrid_ny * pme->pmegrid_nz;
+    std::vector<std::vector<real>> gridValues;
+    std::vector<std::vector<real>> coefficients;
+    for (int g = 0; g < numGrids; g++)
+    {
+        gridValues.push_back(makeGridValues(g, gridSize));
+        coefficients.push_back(makeCoefficients(g, numAtoms));
+    }
+
+    // Non-zero initial forces, to check accumulation without clearing
+    std::vector<RVec> initialForces(numAtoms);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        initialForces[a] = { 0.5_real * a, -1.0_real, 0.25_real * (a % 3) };
+    }
+
+    // The reference: one pass over the atoms per grid
+    std::vector<RVec> refForces = initialForces;
+    atc->f                      = refForces;
+    for (int g = 0; g < numGrids; g++)
+    {
+        atc->coefficient = coefficients[g];
+        gather_f_bsplines(pme, gridValues[g].data(), clearForces && g == 0, atc, spline, scales[g]);
+    }
+
+    std::vector<RVec> forces = initialForces;
+    atc->f                   = forces;
+    std::vector<PmeGatherGrid> grids;
+    for (int g = 0; g < numGrids; g++)
+    {
+        grids.push_back({ gridValues[g].data(), coefficients[g], scales[g] });
+    }
+    gather_f_bsplines_multigrid(pme, grids, clearForces, atc, spline);
+
+    real maxForce = 0;
+    for (const RVec& f : refForces)
+    {
+        maxForce = std::max(maxForce, norm(f));
+    }
+    ASSERT_GT(maxForce, 0);
+    // The grids are summed before the spline interpolation, which changes the summation order
+    const FloatingPointTolerance tolerance =
+            relativeToleranceAsPrecisionDependentUlp(maxForce, 100 * numGrids, 1000 * numGrids);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        SCOPED_TRACE(formatString("Atom %d", a));
+        EXPECT_REAL_EQ_TOL(refForces[a][XX], forces[a][XX], tolerance);
+        EXPECT_REAL_EQ_TOL(refForces[a][YY], forces[a][YY], tolerance);
+        EXPECT_REAL_EQ_TOL(refForces[a][ZZ], forces[a][ZZ], tolerance);
+    }
+    // Atom 3 has zero coefficients, so its force should be untouched or cleared
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_EQ(clearForces ? 0 : initialForces[3][d], forces[3][d]);
+    }
+}
+
+//! Grid scale factors for free-energy perturbation with lambda=0.3: the A and B state grids
+const std::vector<real> c_freeEnergyScales = { 0.7, 0.3 };
+
+INSTANTIATE_TEST_SUITE_P(FreeEnergyTwoGrids,
+                         PmeMultiGridGatherTest,
+                         ::testing::Combine(::testing::Values("rect", "tric"),
+                                            ::testing::Values(4, 5),
+                                            ::testing::Values(c_freeEnergyScales),
+                                            ::testing::Bool()));
+
+INSTANTIATE_TEST_SUITE_P(LJPmeLorentzBerthelotSevenGrids,
+                         PmeMultiGridGatherTest,
+                         ::testing::Combine(::testing::Values("rect", "tric"),
+                                            ::testing::Values(4, 5),
+                                            ::testing::Values(c_ljLorentzBerthelotScales),
+                                            ::testing::Bool()));
+
+} // namespace
+} // namespace test
+} // namespace gmx
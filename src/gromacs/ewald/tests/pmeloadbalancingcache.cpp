@@ -0,0 +1,233 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the cache of PME load balancing setups.
+ *
+ * \ingroup module_ewald
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/ewald/pme_load_balancing_cache.h"
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns a hardware description of a run with a GPU
+PmeLoadBalancingCacheHardware gpuHardware()
+{
+    PmeLoadBalancingCacheHardware hardware;
+    hardware.cpuBrand    = "Some CPU @ 3.00GHz";
+    hardware.gpuModel    = "#0: NVIDIA Some GPU, compute cap.: 8.0, ECC: yes, stat: compatible";
+    hardware.numRanks    = 4;
+    hardware.numPmeRanks = 1;
+    hardware.numThreads  = 8;
+    hardware.kernelName  = "plain-C";
+    return hardware;
+}
+
+//! Sets the cut-off and PME parameters of \p ir
+void setPmeParameters(t_inputrec* ir)
+{
+    ir->rcoulomb  = 1.0;
+    ir->rvdw      = 1.0;
+    ir->nkx       = 32;
+    ir->nky       = 32;
+    ir->nkz       = 48;
+    ir->pme_order = 4;
+    ir->nstlist   = 100;
+}
+
+//! Returns a cache entry with values depending on \p i
+PmeLoadBalancingCacheEntry cacheEntry(int i)
+{
+    PmeLoadBalancingCacheEntry entry;
+    entry.rcutCoulomb = 1.0 + 0.125 * i;
+    entry.grid[XX]    = 32 - i;
+    entry.grid[YY]    = 28 - i;
+    entry.grid[ZZ]    = 40 - i;
+    entry.cycles      = (1 + 0.25 * i) * 1e9;
+    return entry;
+}
+
+//! Expects that \p entry equals \p refEntry up to the precision in the cache file
+void expectEntryEqual(const PmeLoadBalancingCacheEntry& refEntry,
+                      const PmeLoadBalancingCacheEntry& entry)
+{
+    EXPECT_FLOAT_EQ(refEntry.rcutCoulomb, entry.rcutCoulomb);
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_EQ(refEntry.grid[d], entry.grid[d]);
+    }
+    EXPECT_DOUBLE_EQ(refEntry.cycles, entry.cycles);
+}
+
+//! A rectangular box
+const matrix c_box = { { 5.0, 0, 0 }, { 0, 5.0, 0 }, { 0, 0, 7.0 } };
+
+TEST(PmeLoadBalancingCacheTest, KeyIsOneWordAndDescribesTheRun)
+{
+    t_inputrec ir;
+    setPmeParameters(&ir);
+    const std::string key = pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3000);
+
+    EXPECT_EQ(key, pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3000));
+    EXPECT_EQ(std::string::npos, key.find_first_of(" \t\n"));
+    EXPECT_NE(std::string::npos, key.find("cpu=Some_CPU_@_3.00GHz"));
+    EXPECT_NE(std::string::npos, key.find("gpu=#0:_NVIDIA_Some_GPU"));
+    EXPECT_NE(std::string::npos, key.find("natoms=3000"));
+}
+
+TEST(PmeLoadBalancingCacheTest, KeyDependsOnGpuModel)
+{
+    t_inputrec ir;
+    setPmeParameters(&ir);
+
+    PmeLoadBalancingCacheHardware otherGpu = gpuHardware();
+    otherGpu.gpuModel = "#0: NVIDIA Other GPU, compute cap.: 9.0, ECC: yes, stat: compatible";
+    PmeLoadBalancingCacheHardware noGpu = gpuHardware();
+    noGpu.gpuModel                      = "";
+
+    const std::string key = pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3000);
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(otherGpu, ir, c_box, 3000));
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(noGpu, ir, c_box, 3000));
+    EXPECT_NE(std::string::npos, pmeLoadBalancingCacheKey(noGpu, ir, c_box, 3000).find("gpu=none"));
+}
+
+TEST(PmeLoadBalancingCacheTest, KeyDependsOnSystemAndSetup)
+{
+    t_inputrec ir;
+    setPmeParameters(&ir);
+    const std::string key = pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3000);
+
+    // Small volume fluctuations between continuation runs keep the key
+    matrix box;
+    copy_mat(c_box, box);
+    box[XX][XX] += 0.01;
+    EXPECT_EQ(key, pmeLoadBalancingCacheKey(gpuHardware(), ir, box, 3000));
+    box[XX][XX] += 0.5;
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(gpuHardware(), ir, box, 3000));
+
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3001));
+
+    t_inputrec otherIr;
+    setPmeParameters(&otherIr);
+    otherIr.nkz = 52;
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(gpuHardware(), otherIr, c_box, 3000));
+
+    PmeLoadBalancingCacheHardware otherRanks = gpuHardware();
+    otherRanks.numPmeRanks                   = 0;
+    EXPECT_NE(key, pmeLoadBalancingCacheKey(otherRanks, ir, c_box, 3000));
+}
+
+TEST(PmeLoadBalancingCacheTest, ReadFindsNoEntryWithoutFile)
+{
+    TestFileManager            fileManager;
+    const std::string          fileName = fileManager.getTemporaryFilePath("pme.cache").string();
+    PmeLoadBalancingCacheEntry entry;
+    EXPECT_FALSE(readPmeLoadBalancingCache(fileName, "key", &entry));
+}
+
+TEST(PmeLoadBalancingCacheTest, ReadsWrittenEntry)
+{
+    TestFileManager   fileManager;
+    const std::string fileName = fileManager.getTemporaryFilePath("pme.cache").string();
+    // Let the file manager remove the lock file
+    fileManager.getTemporaryFilePath("pme.cache.lock");
+    t_inputrec        ir;
+    setPmeParameters(&ir);
+    const std::string key = pmeLoadBalancingCacheKey(gpuHardware(), ir, c_box, 3000);
+
+    writePmeLoadBalancingCache(fileName, key, cacheEntry(1));
+
+    PmeLoadBalancingCacheEntry entry;
+    ASSERT_TRUE(readPmeLoadBalancingCache(fileName, key, &entry));
+    expectEntryEqual(cacheEntry(1), entry);
+    EXPECT_FALSE(readPmeLoadBalancingCache(fileName, key + "x", &entry));
+}
+
+TEST(PmeLoadBalancingCacheTest, WriteReplacesEntryWithSameKeyAndKeepsOthers)
+{
+    TestFileManager   fileManager;
+    const std::string fileName = fileManager.getTemporaryFilePath("pme.cache").string();
+    // Let the file manager remove the lock file
+    fileManager.getTemporaryFilePath("pme.cache.lock");
+
+    writePmeLoadBalancingCache(fileName, "keyA", cacheEntry(1));
+    writePmeLoadBalancingCache(fileName, "keyB", cacheEntry(2));
+    writePmeLoadBalancingCache(fileName, "keyA", cacheEntry(3));
+
+    PmeLoadBalancingCacheEntry entry;
+    ASSERT_TRUE(readPmeLoadBalancingCache(fileName, "keyA", &entry));
+    expectEntryEqual(cacheEntry(3), entry);
+    ASSERT_TRUE(readPmeLoadBalancingCache(fileName, "keyB", &entry));
+    expectEntryEqual(cacheEntry(2), entry);
+
+    // The header line and one line per key
+    const auto lines = splitDelimitedString(TextReader::readFileToString(fileName), '\n');
+    int        numNonEmptyLines = 0;
+    for (const auto& line : lines)
+    {
+        numNonEmptyLines += (line.empty() ? 0 : 1);
+    }
+    EXPECT_EQ(3, numNonEmptyLines);
+
+    // No temporary files are left behind
+    for (const auto& dirEntry : std::filesystem::directory_iterator(
+                 std::filesystem::path(fileName).parent_path()))
+    {
+        EXPECT_NE(".tmp", dirEntry.path().extension().string()) << dirEntry.path();
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -136,6 +136,13 @@ static int vmax(const int* a, int s)
     return max;
 }
 
+/* Returns the first 1D FFT line (index y+z*pM) of chunk for step s,
+   with K divided over numChunks chunks */
+static int chunkLineStart(const fft5d_plan plan, int s, int chunk, int numChunks)
+{
+    return std::min(chunk * plan->K[s] / numChunks, plan->pK[s]) * plan->pM[s];
+}
+
 
 /* NxMxK the size of the data
  * comm communicator to use for fft5d
@@ -153,7 +160,8 @@ fft5d_plan fft5d_plan_3d(int                NG,
                          t_complex**        rlout2,
                          t_complex**        rlout3,
                          int                nthreads,
-                         gmx::PinningPolicy realGridAllocationPinningPolicy)
+                         gmx::PinningPolicy realGridAllocationPinningPolicy,
+                         int                numPipelineChunks)
 {
 
     int  P[2], prank[2], i;
@@ -436,9 +444,10 @@ fft5d_plan fft5d_plan_3d(int                NG,
             snew_aligned(lin, lsize, 32);
         }
         snew_aligned(lout, lsize, 32);
-        if (nthreads > 1)
+        if (nthreads > 1 || numPipelineChunks > 1)
         {
-            /* We need extra transpose buffers to avoid OpenMP barriers */
+            /* We need extra transpose buffers to avoid OpenMP barriers
+             * and to keep the input of later chunks intact with pipelining */
             snew_aligned(lout2, lsize, 32);
             snew_aligned(lout3, lsize, 32);
         }
@@ -453,7 +462,7 @@ fft5d_plan fft5d_plan_3d(int                NG,
     {
         lin  = *rlin;
         lout = *rlout;
-        if (nthreads > 1)
+        if (nthreads > 1 || numPipelineChunks > 1)
         {
             lout2 = *rlout2;
             lout3 = *rlout3;
@@ -705,6 +714,79 @@ fft5d_plan fft5d_plan_3d(int                NG,
         plan->coor[s] = prank[s];
     }
 
+    /* Set up pipelining of the parallel transposes. This requires non-blocking
+       collectives, which thread-MPI does not support. The chunks are divided
+       along K, the outer dimension of the transpose blocks, and all ranks in
+       the communicator have blocks of the same size N*M*K. */
+    for (s = 0; s < 2; s++)
+    {
+        plan->numPipelineChunks[s] = 1;
+#if GMX_LIB_MPI
+        if (GMX_PARALLEL_ENV_INITIALIZED && plan->cart[s] != MPI_COMM_NULL && nP[s] > 1)
+        {
+            plan->numPipelineChunks[s] = std::max(1, std::min(numPipelineChunks, K[s]));
+        }
+#endif
+        const int numChunks = plan->numPipelineChunks[s];
+        if (numChunks == 1)
+        {
+            continue;
+        }
+
+        const int sliceSize = N[s] * M[s] * sizeof(t_complex) / sizeof(real);
+        plan->pipelineCounts[s] = static_cast<int*>(malloc(sizeof(int) * numChunks * nP[s]));
+        plan->pipelineDispls[s] = static_cast<int*>(malloc(sizeof(int) * numChunks * nP[s]));
+        for (int chunk = 0; chunk < numChunks; chunk++)
+        {
+            const int zStart = chunk * K[s] / numChunks;
+            const int zEnd   = (chunk + 1) * K[s] / numChunks;
+            for (i = 0; i < nP[s]; i++)
+            {
+                plan->pipelineCounts[s][chunk * nP[s] + i] = (zEnd - zStart) * sliceSize;
+                plan->pipelineDispls[s][chunk * nP[s] + i] = (i * K[s] + zStart) * sliceSize;
+            }
+        }
+
+        plan->p1dChunk[s] =
+                static_cast<gmx_fft_t*>(malloc(sizeof(gmx_fft_t) * numChunks * nthreads));
+#pragma omp parallel for num_threads(nthreads) schedule(static) ordered
+        for (int t = 0; t < nthreads; t++)
+        {
+#pragma omp ordered
+            {
+                try
+                {
+                    const gmx_fft_flag fftFlags =
+                            (flags & FFT5D_NOMEASURE) ? GMX_FFT_FLAG_CONSERVATIVE : 0;
+                    for (int chunk = 0; chunk < numChunks; chunk++)
+                    {
+                        const int chunkStart = chunkLineStart(plan, s, chunk, numChunks);
+                        const int chunkEnd   = chunkLineStart(plan, s, chunk + 1, numChunks);
+                        const int tsize      = ((t + 1) * (chunkEnd - chunkStart) / nthreads)
+                                          - (t * (chunkEnd - chunkStart) / nthreads);
+                        gmx_fft_t* p1d = &plan->p1dChunk[s][chunk * nthreads + t];
+
+                        if ((flags & FFT5D_REALCOMPLEX) && !(flags & FFT5D_BACKWARD) && s == 0)
+                        {
+                            gmx_fft_init_many_1d_real(p1d, rC[s], tsize, fftFlags);
+                        }
+                        else
+                        {
+                            gmx_fft_init_many_1d(p1d, C[s], tsize, fftFlags);
+                        }
+                    }
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            }
+        }
+    }
+    if (plan->numPipelineChunks[0] > 1 || plan->numPipelineChunks[1] > 1)
+    {
+        const int maxNumChunks = std::max(plan->numPipelineChunks[0], plan->numPipelineChunks[1]);
+        plan->pipelineRequests =
+                static_cast<MPI_Request*>(malloc(sizeof(MPI_Request) * maxNumChunks));
+    }
+
     /*    plan->fftorder=fftorder;
         plan->direction=direction;
         plan->realcomplex=realcomplex;
@@ -1148,14 +1230,6 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             bParallelDim = 0;
         }
 
-        /* ---------- START FFT ------------ */
-#ifdef NOGMX
-        if (times != 0 && thread == 0)
-        {
-            time = MPI_Wtime();
-        }
-#endif
-
         if (bParallelDim || plan->nthreads == 1)
         {
             fftout = lout;
@@ -1172,122 +1246,184 @@ void fft5d_execute(fft5d_plan plan, int thread, fft5d_time times)
             }
         }
 
-        tstart = (thread * pM[s] * pK[s] / plan->nthreads) * C[s];
-        if ((plan->flags & FFT5D_REALCOMPLEX) && !(plan->flags & FFT5D_BACKWARD) && s == 0)
+        /* With pipelining, thread 0 starts the exchange of each chunk without waiting
+           for it to complete, so it overlaps with the FFT and split of the next chunk */
+        const int numChunks = bParallelDim ? plan->numPipelineChunks[s] : 1;
+        for (int chunk = 0; chunk < numChunks; chunk++)
         {
-            gmx_fft_many_1d_real(p1d[s][thread],
-                                 (plan->flags & FFT5D_BACKWARD) ? GMX_FFT_COMPLEX_TO_REAL
-                                                                : GMX_FFT_REAL_TO_COMPLEX,
-                                 lin + tstart,
-                                 fftout + tstart);
-        }
-        else
-        {
-            gmx_fft_many_1d(p1d[s][thread],
-                            (plan->flags & FFT5D_BACKWARD) ? GMX_FFT_BACKWARD : GMX_FFT_FORWARD,
-                            lin + tstart,
-                            fftout + tstart);
-        }
-
-#ifdef NOGMX
-        if (times != NULL && thread == 0)
-        {
-            time_fft += MPI_Wtime() - time;
-        }
+#if GMX_LIB_MPI
+            /* Most MPI libraries only progress non-blocking collectives inside MPI calls,
+               so test the exchanges of the previous chunks before computing the next one */
+            if (numChunks > 1 && chunk > 0 && thread == 0)
+            {
+                for (int prevChunk = 0; prevChunk < chunk; prevChunk++)
+                {
+                    int completed;
+                    MPI_Test(&plan->pipelineRequests[prevChunk], &completed, MPI_STATUS_IGNORE);
+                }
+            }
 #endif
-        if ((plan->flags & FFT5D_DEBUG) && thread == 0)
-        {
-            print_localdata(lout, "%d %d: FFT\n", s, plan);
-        }
-        /* ---------- END FFT ------------ */
 
-        /* ---------- START SPLIT + TRANSPOSE------------ (if parallel in in this dimension)*/
-        if (bParallelDim)
-        {
+            /* ---------- START FFT ------------ */
 #ifdef NOGMX
-            if (times != NULL && thread == 0)
+            if (times != 0 && thread == 0)
             {
                 time = MPI_Wtime();
             }
 #endif
-            /*prepare for A
-               llToAll
-               1. (most outer) axes (x) is split into P[s] parts of size N[s]
-               for sending*/
-            if (pM[s] > 0)
+
+            /* The range of the 1D FFTs (index y+z*pM) of this thread within this chunk */
+            const int chunkStart = chunkLineStart(plan, s, chunk, numChunks);
+            const int chunkEnd   = chunkLineStart(plan, s, chunk + 1, numChunks);
+            const int chunkSize  = chunkEnd - chunkStart;
+            const int lineStart  = chunkStart + thread * chunkSize / plan->nthreads;
+            const int lineEnd    = chunkStart + (thread + 1) * chunkSize / plan->nthreads;
+            gmx_fft_t fftPlan    = (numChunks == 1)
+                                           ? p1d[s][thread]
+                                           : plan->p1dChunk[s][chunk * plan->nthreads + thread];
+
+            tstart = lineStart * C[s];
+            if ((plan->flags & FFT5D_REALCOMPLEX) && !(plan->flags & FFT5D_BACKWARD) && s == 0)
             {
-                tend = ((thread + 1) * pM[s] * pK[s] / plan->nthreads);
-                tstart /= C[s];
-                splitaxes(lout2,
-                          lout,
-                          N[s],
-                          M[s],
-                          K[s],
-                          pM[s],
-                          P[s],
-                          C[s],
-                          iNout[s],
-                          oNout[s],
-                          tstart % pM[s],
-                          tstart / pM[s],
-                          tend % pM[s],
-                          tend / pM[s]);
+                gmx_fft_many_1d_real(fftPlan,
+                                     (plan->flags & FFT5D_BACKWARD) ? GMX_FFT_COMPLEX_TO_REAL
+                                                                    : GMX_FFT_REAL_TO_COMPLEX,
+                                     lin + tstart,
+                                     fftout + tstart);
             }
-#pragma omp barrier /*barrier required before AllToAll (all input has to be their) - before timing to make timing more acurate*/
+            else
+            {
+                gmx_fft_many_1d(fftPlan,
+                                (plan->flags & FFT5D_BACKWARD) ? GMX_FFT_BACKWARD : GMX_FFT_FORWARD,
+                                lin + tstart,
+                                fftout + tstart);
+            }
+
 #ifdef NOGMX
             if (times != NULL && thread == 0)
             {
-                time_local += MPI_Wtime() - time;
+                time_fft += MPI_Wtime() - time;
             }
 #endif
+            if ((plan->flags & FFT5D_DEBUG) && thread == 0 && chunk == numChunks - 1)
+            {
+                print_localdata(lout, "%d %d: FFT\n", s, plan);
+            }
+            /* ---------- END FFT ------------ */
 
-            /* ---------- END SPLIT , START TRANSPOSE------------ */
-
-            if (thread == 0)
+            /* ---------- START SPLIT + TRANSPOSE------------ (if parallel in in this dimension)*/
+            if (bParallelDim)
             {
 #ifdef NOGMX
-                if (times != 0)
+                if (times != NULL && thread == 0)
                 {
                     time = MPI_Wtime();
                 }
-#else
-                wallcycle_start(times, WallCycleCounter::PmeFftComm);
 #endif
-#if GMX_MPI
-                if ((s == 0 && !(plan->flags & FFT5D_ORDER_YZ))
-                    || (s == 1 && (plan->flags & FFT5D_ORDER_YZ)))
+                /*prepare for A
+                   llToAll
+                   1. (most outer) axes (x) is split into P[s] parts of size N[s]
+                   for sending*/
+                if (pM[s] > 0)
                 {
-                    MPI_Alltoall(reinterpret_cast<real*>(lout2),
-                                 N[s] * pM[s] * K[s] * sizeof(t_complex) / sizeof(real),
-                                 GMX_MPI_REAL,
-                                 reinterpret_cast<real*>(lout3),
-                                 N[s] * pM[s] * K[s] * sizeof(t_complex) / sizeof(real),
-                                 GMX_MPI_REAL,
-                                 cart[s]);
+                    splitaxes(lout2,
+                              lout,
+                              N[s],
+                              M[s],
+                              K[s],
+                              pM[s],
+                              P[s],
+                              C[s],
+                              iNout[s],
+                              oNout[s],
+                              lineStart % pM[s],
+                              lineStart / pM[s],
+                              lineEnd % pM[s],
+                              lineEnd / pM[s]);
                 }
-                else
+#pragma omp barrier /*barrier required before AllToAll (all input has to be their) - before timing to make timing more acurate*/
+#ifdef NOGMX
+                if (times != NULL && thread == 0)
                 {
-                    MPI_Alltoall(reinterpret_cast<real*>(lout2),
-                                 N[s] * M[s] * pK[s] * sizeof(t_complex) / sizeof(real),
-                                 GMX_MPI_REAL,
-                                 reinterpret_cast<real*>(lout3),
-                                 N[s] * M[s] * pK[s] * sizeof(t_complex) / sizeof(real),
-                                 GMX_MPI_REAL,
-                                 cart[s]);
+                    time_local += MPI_Wtime() - time;
                 }
+#endif
+
+                /* ---------- END SPLIT , START TRANSPOSE------------ */
+
+                if (thread == 0)
+                {
+#ifdef NOGMX
+                    if (times != 0)
+                    {
+                        time = MPI_Wtime();
+                    }
+#else
+                    wallcycle_start(times, WallCycleCounter::PmeFftComm);
+#endif
+#if GMX_MPI
+                    if (numChunks > 1)
+                    {
+#    if GMX_LIB_MPI
+                        MPI_Ialltoallv(reinterpret_cast<real*>(lout2),
+                                       plan->pipelineCounts[s] + chunk * P[s],
+                                       plan->pipelineDispls[s] + chunk * P[s],
+                                       GMX_MPI_REAL,
+                                       reinterpret_cast<real*>(lout3),
+                                       plan->pipelineCounts[s] + chunk * P[s],
+                                       plan->pipelineDispls[s] + chunk * P[s],
+                                       GMX_MPI_REAL,
+                                       cart[s],
+                                       &plan->pipelineRequests[chunk]);
+#    endif
+                    }
+                    else if ((s == 0 && !(plan->flags & FFT5D_ORDER_YZ))
+                             || (s == 1 && (plan->flags & FFT5D_ORDER_YZ)))
+                    {
+                        MPI_Alltoall(reinterpret_cast<real*>(lout2),
+                                     N[s] * pM[s] * K[s] * sizeof(t_complex) / sizeof(real),
+                                     GMX_MPI_REAL,
+                                     reinterpret_cast<real*>(lout3),
+                                     N[s] * pM[s] * K[s] * sizeof(t_complex) / sizeof(real),
+                                     GMX_MPI_REAL,
+                                     cart[s]);
+                    }
+                    else
+                    {
+                        MPI_Alltoall(reinterpret_cast<real*>(lout2),
+                                     N[s] * M[s] * pK[s] * sizeof(t_complex) / sizeof(real),
+                                     GMX_MPI_REAL,
+                                     reinterpret_cast<real*>(lout3),
+                                     N[s] * M[s] * pK[s] * sizeof(t_complex) / sizeof(real),
+                                     GMX_MPI_REAL,
+                                     cart[s]);
+                    }
 #else
-                GMX_RELEASE_ASSERT(false, "Invalid call to fft5d_execute");
+                    GMX_RELEASE_ASSERT(false, "Invalid call to fft5d_execute");
 #endif /*GMX_MPI*/
 #ifdef NOGMX
-                if (times != 0)
-                {
-                    time_mpi[s] = MPI_Wtime() - time;
-                }
+                    if (times != 0)
+                    {
+                        time_mpi[s] += MPI_Wtime() - time;
+                    }
 #else
-                wallcycle_stop(times, WallCycleCounter::PmeFftComm);
+                    wallcycle_stop(times, WallCycleCounter::PmeFftComm);
+#endif
+                } /*main*/
+            }     /* bPrallelDim */
+        }         /* chunk loop */
+#if GMX_LIB_MPI
+        if (numChunks > 1 && thread == 0)
+        {
+#    ifndef NOGMX
+            wallcycle_start(times, WallCycleCounter::PmeFftComm);
+#    endif
+            MPI_Waitall(numChunks, plan->pipelineRequests, MPI_STATUSES_IGNORE);
+#    ifndef NOGMX
+            wallcycle_stop(times, WallCycleCounter::PmeFftComm);
+#    endif
+        }
 #endif
-            }       /*main*/
-        }           /* bPrallelDim */
 #pragma omp barrier /*both needed for parallel and non-parallel dimension (either have to wait on data from AlltoAll or from last FFT*/
 
         /* ---------- END SPLIT + TRANSPOSE------------ */
@@ -1432,6 +1568,16 @@ void fft5d_destroy(fft5d_plan plan)
             }
             free(plan->p1d[s]);
         }
+        if (s < 2 && plan->p1dChunk[s])
+        {
+            for (t = 0; t < plan->numPipelineChunks[s] * plan->nthreads; t++)
+            {
+                gmx_many_fft_destroy(plan->p1dChunk[s][t]);
+            }
+            free(plan->p1dChunk[s]);
+            free(plan->pipelineCounts[s]);
+            free(plan->pipelineDispls[s]);
+        }
         if (plan->iNin[s])
         {
             free(plan->iNin[s]);
@@ -1479,7 +1625,7 @@ void fft5d_destroy(fft5d_plan plan)
             sfree_aligned(plan->lin);
         }
         sfree_aligned(plan->lout);
-        if (plan->nthreads > 1)
+        if (plan->lout2 != plan->lin) /* separate buffers with threads or pipelining */
         {
             sfree_aligned(plan->lout2);
             sfree_aligned(plan->lout3);
@@ -1492,5 +1638,6 @@ void fft5d_destroy(fft5d_plan plan)
 #    endif
 #endif
 
+    free(plan->pipelineRequests);
     free(plan);
 }
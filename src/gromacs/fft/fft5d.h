@@ -119,6 +119,13 @@ struct fft5d_plan_t
     int                coor[2];
     int                nthreads;
     gmx::PinningPolicy pinningPolicy;
+    /* Pipelining of the transposes of the first two steps: the exchange of a chunk
+       overlaps with the 1D FFTs and the split of the next chunk */
+    int          numPipelineChunks[2]; /*number of chunks along K, 1 means no pipelining*/
+    gmx_fft_t*   p1dChunk[2];          /*1D plans for each chunk and thread*/
+    int*         pipelineCounts[2];    /*MPI counts for each chunk and rank*/
+    int*         pipelineDispls[2];    /*MPI displacements for each chunk and rank*/
+    MPI_Request* pipelineRequests;     /*MPI requests for each chunk*/
 };
 
 typedef struct fft5d_plan_t* fft5d_plan;
@@ -134,7 +141,8 @@ fft5d_plan fft5d_plan_3d(int         N,
                          t_complex** lout2,
                          t_complex** lout3,
                          int         nthreads,
-                         gmx::PinningPolicy realGridAllocationPinningPolicy = gmx::PinningPolicy::CannotBePinned);
+                         gmx::PinningPolicy realGridAllocationPinningPolicy = gmx::PinningPolicy::CannotBePinned,
+                         int numPipelineChunks = 1);
 void       fft5d_destroy(fft5d_plan plan);
 
 #endif
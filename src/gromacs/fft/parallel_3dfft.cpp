@@ -39,6 +39,8 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+
 #include "gromacs/fft/fft.h"
 #include "gromacs/fft/fft5d.h"
 #include "gromacs/math/gmxcomplex.h"
@@ -72,6 +74,22 @@ int gmx_parallel_3dfft_init(gmx_parallel_3dfft_t* pfft_setup,
         flags |= FFT5D_NOMEASURE;
     }
 
+    /* Optionally split the transposes in chunks to overlap communication with the 1D FFTs */
+    int         numPipelineChunks = 1;
+    const char* envChunks         = getenv("GMX_PME_FFT_PIPELINE_CHUNKS");
+    if (envChunks != nullptr)
+    {
+        char* end         = nullptr;
+        numPipelineChunks = static_cast<int>(strtol(envChunks, &end, 10));
+        if (!end || (*end != 0) || numPipelineChunks < 1)
+        {
+            gmx_fatal(FARGS,
+                      "Invalid value passed in GMX_PME_FFT_PIPELINE_CHUNKS=%s, positive integer "
+                      "required",
+                      envChunks);
+        }
+    }
+
     if (!(flags & FFT5D_ORDER_YZ))
     {
         Nb = M;
@@ -85,8 +103,18 @@ int gmx_parallel_3dfft_init(gmx_parallel_3dfft_t* pfft_setup,
         Kb = M; /* currently always true because ORDER_YZ always set */
     }
 
-    (*pfft_setup)->p1 = fft5d_plan_3d(
-            rN, M, K, rcomm, flags, reinterpret_cast<t_complex**>(real_data), complex_data, &buf1, &buf2, nthreads, realGridAllocation);
+    (*pfft_setup)->p1 = fft5d_plan_3d(rN,
+                                      M,
+                                      K,
+                                      rcomm,
+                                      flags,
+                                      reinterpret_cast<t_complex**>(real_data),
+                                      complex_data,
+                                      &buf1,
+                                      &buf2,
+                                      nthreads,
+                                      realGridAllocation,
+                                      numPipelineChunks);
 
     (*pfft_setup)->p2 = fft5d_plan_3d(Nb,
                                       Mb,
@@ -97,7 +125,9 @@ int gmx_parallel_3dfft_init(gmx_parallel_3dfft_t* pfft_setup,
                                       reinterpret_cast<t_complex**>(real_data),
                                       &buf1,
                                       &buf2,
-                                      nthreads);
+                                      nthreads,
+                                      gmx::PinningPolicy::CannotBePinned,
+                                      numPipelineChunks);
 
     return static_cast<int>((*pfft_setup)->p1 != nullptr && (*pfft_setup)->p2 != nullptr);
 }
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that pipelining the transposes of the parallel CPU 3D FFT
+ * does not change its results.
+ *
+ * \ingroup module_fft
+ */
+#include "gmxpre.h"
+
+#include "config.h"
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fft/fft5d.h"
+#include "gromacs/math/gmxcomplex.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of ranks along the first and second decomposition dimensions
+using Fft5dDecomposition = std::tuple<int, int>;
+
+/*! \brief Returns the local output of a forward real-to-complex 3D FFT
+ *
+ * The input is generated from \p seed, so it only depends on the rank
+ * and not on \p numPipelineChunks. */
+std::vector<t_complex> forwardTransform(MPI_Comm  comm[2],
+                                        const int numPipelineChunks,
+                                        const int seed)
+{
+    // Grid dimensions real Z, Y and X, chosen such that the ranks get unequal slabs
+    const int rN = 14, M = 11, K = 10;
+
+    MPI_Comm   rcomm[] = { comm[1], comm[0] };
+    t_complex *realData, *complexData, *buf1, *buf2;
+    fft5d_plan plan = fft5d_plan_3d(rN,
+                                    M,
+                                    K,
+                                    rcomm,
+                                    FFT5D_REALCOMPLEX | FFT5D_ORDER_YZ | FFT5D_NOMEASURE,
+                                    &realData,
+                                    &complexData,
+                                    &buf1,
+                                    &buf2,
+                                    1,
+                                    PinningPolicy::CannotBePinned,
+                                    numPipelineChunks);
+
+    real* input     = reinterpret_cast<real*>(realData);
+    int   inputSize = 2 * plan->C[0] * plan->pM[0] * plan->pK[0];
+
+    std::minstd_rand                     generator(seed);
+    std::uniform_real_distribution<real> distribution(-1.0_real, 1.0_real);
+    for (int i = 0; i < inputSize; i++)
+    {
+        input[i] = distribution(generator);
+    }
+
+    fft5d_execute(plan, 0, nullptr);
+
+    const int              outputSize = plan->C[2] * plan->pM[2] * plan->pK[2];
+    std::vector<t_complex> output(complexData, complexData + outputSize);
+
+    fft5d_destroy(plan);
+
+    return output;
+}
+
+class Fft5dPipelineTest : public ::testing::TestWithParam<Fft5dDecomposition>
+{
+};
+
+/* Pipelining is only active with a library MPI, with thread-MPI this
+ * checks that the requested chunks are ignored. */
+TEST_P(Fft5dPipelineTest, ChunkedTransposesMatchBlockingTransposes)
+{
+    GMX_MPI_TEST(RequireRankCount<4>);
+
+    const int numRanksX = std::get<0>(GetParam());
+    const int numRanksY = std::get<1>(GetParam());
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    MPI_Comm comm[2];
+    MPI_Comm_split(MPI_COMM_WORLD, rank % numRanksY, rank / numRanksY, &comm[0]);
+    MPI_Comm_split(MPI_COMM_WORLD, rank / numRanksY, rank % numRanksY, &comm[1]);
+    ASSERT_EQ(numRanksX * numRanksY, 4);
+
+    const std::vector<t_complex> reference = forwardTransform(comm, 1, rank);
+
+    for (const int numPipelineChunks : { 2, 3 })
+    {
+        SCOPED_TRACE(formatString("With %d pipeline chunks", numPipelineChunks));
+
+        const std::vector<t_complex> output = forwardTransform(comm, numPipelineChunks, rank);
+
+        ASSERT_EQ(reference.size(), output.size());
+        const auto tolerance = relativeToleranceAsFloatingPoint(100.0, 1e-6);
+        for (size_t i = 0; i < output.size(); i++)
+        {
+            EXPECT_REAL_EQ_TOL(reference[i].re, output[i].re, tolerance) << "element " << i;
+            EXPECT_REAL_EQ_TOL(reference[i].im, output[i].im, tolerance) << "element " << i;
+        }
+    }
+
+    MPI_Comm_free(&comm[0]);
+    MPI_Comm_free(&comm[1]);
+}
+
+INSTANTIATE_TEST_SUITE_P(Decompositions,
+                         Fft5dPipelineTest,
+                         ::testing::Values(Fft5dDecomposition{ 4, 1 }, Fft5dDecomposition{ 2, 2 }));
+
+} // namespace
+} // namespace test
+} // namespace gmx
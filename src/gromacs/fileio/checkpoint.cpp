@@ -92,6 +92,7 @@
 
 #define CPT_MAGIC1 171817
 #define CPT_MAGIC2 171819
+#define CPT_MAGIC3 171821
 
 namespace gmx
 {
@@ -1289,6 +1290,28 @@ static void do_cpt_header(XDR* xd, gmx_bool bRead, FILE* list, CheckpointHeaderC
     {
         contents->isModularSimulatorCheckpoint = false;
     }
+
+    if (contents->file_version >= CheckPointVersion::DistributedAtomBlocks)
+    {
+        do_cpt_int_err(xd, "#atom blocks", &contents->numAtomBlocks, list);
+    }
+    else
+    {
+        contents->numAtomBlocks = 0;
+    }
+
+    if (contents->file_version >= CheckPointVersion::IncrementalAwhHistory)
+    {
+        do_cpt_step_err(xd, "AWH reference step", &contents->awhReferenceStep, list);
+        if (contents->awhReferenceStep >= 0)
+        {
+            do_cpt_string_err(xd, "AWH reference file", contents->awhReferenceFile, list);
+        }
+    }
+    else
+    {
+        contents->awhReferenceStep = -1;
+    }
 }
 
 static int do_cpt_footer(XDR* xd, CheckPointVersion file_version)
@@ -1313,6 +1336,234 @@ static int do_cpt_footer(XDR* xd, CheckPointVersion file_version)
     return 0;
 }
 
+/*! \brief Returns the flags of the state entries that are stored in the state part of the file
+ *
+ * With atom blocks, the coordinates and velocities are stored in the blocks instead.
+ */
+static int stateSectionFlags(int stateFlags, int numAtomBlocks)
+{
+    if (numAtomBlocks > 0)
+    {
+        stateFlags &= ~(enumValueToBitMask(StateEntry::X) | enumValueToBitMask(StateEntry::V));
+    }
+    return stateFlags;
+}
+
+//! Returns the number of per-atom vectors stored in atom blocks for state flags \p stateFlags
+static int numAtomBlockVectors(int stateFlags)
+{
+    return ((stateFlags & enumValueToBitMask(StateEntry::X)) ? 1 : 0)
+           + ((stateFlags & enumValueToBitMask(StateEntry::V)) ? 1 : 0);
+}
+
+//! Returns the size in bytes of an atom block with \p numAtoms atoms and \p numVectors vectors
+static int64_t atomBlockSize(int numAtoms, int numVectors, bool isDouble)
+{
+    const int64_t realSize = isDouble ? sizeof(double) : sizeof(float);
+    return numAtoms * (sizeof(int) + numVectors * DIM * realSize);
+}
+
+/*! \brief Reads/writes the table with the number of atoms and file offset of each atom block
+ *
+ * The table follows the footer, the blocks follow the table.
+ */
+static int do_cpt_atom_block_table(XDR*                  xd,
+                                   std::vector<int>*     blockNumAtoms,
+                                   std::vector<int64_t>* blockOffsets,
+                                   FILE*                 list)
+{
+    int magic = CPT_MAGIC3;
+    if (xdr_int(xd, &magic) == 0 || magic != CPT_MAGIC3)
+    {
+        return -1;
+    }
+    int numBlocks = blockNumAtoms->size();
+    if (do_cpt_int(xd, "#atom blocks", &numBlocks, list) < 0 || numBlocks < 0)
+    {
+        return -1;
+    }
+    blockNumAtoms->resize(numBlocks);
+    blockOffsets->resize(numBlocks);
+    for (int b = 0; b < numBlocks; b++)
+    {
+        if (xdr_int(xd, &(*blockNumAtoms)[b]) == 0 || xdr_int64(xd, &(*blockOffsets)[b]) == 0)
+        {
+            return -1;
+        }
+        if (list)
+        {
+            fprintf(list,
+                    "atom block %d: %d atoms at offset %" PRId64 "\n",
+                    b,
+                    (*blockNumAtoms)[b],
+                    (*blockOffsets)[b]);
+        }
+    }
+    return 0;
+}
+
+//! Reads \p n reals stored with precision \p isDoubleInFile into \p values
+static bool_t readRealsWithPrecision(XDR* xd, int n, bool isDoubleInFile, real* values)
+{
+    if (isDoubleInFile == bool(GMX_DOUBLE))
+    {
+        return xdr_vector(
+                xd, reinterpret_cast<char*>(values), n, sizeof(real), xdrProc(xdr_type<real>::value));
+    }
+    const XdrDataType xdrTypeInTheFile = isDoubleInFile ? XdrDataType::Double : XdrDataType::Float;
+    std::vector<char> buffer(static_cast<size_t>(n) * sizeOfXdrType(xdrTypeInTheFile));
+    const bool_t      res = xdr_vector(
+            xd, buffer.data(), n, sizeOfXdrType(xdrTypeInTheFile), xdrProc(xdrTypeInTheFile));
+    convertArrayRealPrecision(buffer.data(), values, n);
+    return res;
+}
+
+/*! \brief Reads the atom blocks into the coordinates and velocities of \p state
+ *
+ * Checks that each atom occurs in exactly one block. With \p list,
+ * also lists the block table and the coordinates and velocities.
+ * All blocks are read by the calling rank into the global state,
+ * since the decomposition at restart need not match the one that
+ * wrote the blocks; the state is then distributed as usual.
+ */
+static int do_cpt_read_atom_blocks(t_fileio*                       fp,
+                                   const CheckpointHeaderContents& headerContents,
+                                   t_state*                        state,
+                                   FILE*                           list)
+{
+    XDR*                 xd = gmx_fio_getxdr(fp);
+    std::vector<int>     blockNumAtoms;
+    std::vector<int64_t> blockOffsets;
+    if (do_cpt_atom_block_table(xd, &blockNumAtoms, &blockOffsets, list) < 0
+        || gmx::ssize(blockNumAtoms) != headerContents.numAtomBlocks)
+    {
+        return -1;
+    }
+
+    const int  numAtoms = headerContents.natoms;
+    const bool haveX    = (headerContents.flags_state & enumValueToBitMask(StateEntry::X)) != 0;
+    const bool haveV    = (headerContents.flags_state & enumValueToBitMask(StateEntry::V)) != 0;
+    const bool isDouble = (headerContents.double_prec != 0);
+    if (haveX && gmx::ssize(state->x) < numAtoms)
+    {
+        state->x.resizeWithPadding(numAtoms);
+    }
+    if (haveV && gmx::ssize(state->v) < numAtoms)
+    {
+        state->v.resizeWithPadding(numAtoms);
+    }
+
+    std::vector<bool>      haveAtom(numAtoms, false);
+    int                    numAtomsRead = 0;
+    std::vector<int>       globalAtomIndices;
+    std::vector<gmx::RVec> vectors;
+    for (gmx::Index b = 0; b < gmx::ssize(blockNumAtoms); b++)
+    {
+        const int blockSize = blockNumAtoms[b];
+        if (blockSize < 0 || gmx_fio_seek(fp, blockOffsets[b]) != 0)
+        {
+            return -1;
+        }
+        globalAtomIndices.resize(blockSize);
+        if (xdr_vector(xd,
+                       reinterpret_cast<char*>(globalAtomIndices.data()),
+                       blockSize,
+                       sizeof(int),
+                       xdrProc(XdrDataType::Int))
+            == 0)
+        {
+            return -1;
+        }
+        for (const int globalAtom : globalAtomIndices)
+        {
+            if (globalAtom < 0 || globalAtom >= numAtoms || haveAtom[globalAtom])
+            {
+                return -1;
+            }
+            haveAtom[globalAtom] = true;
+        }
+        numAtomsRead += blockSize;
+
+        vectors.resize(blockSize);
+        for (const auto entry : { StateEntry::X, StateEntry::V })
+        {
+            if (!(entry == StateEntry::X ? haveX : haveV))
+            {
+                continue;
+            }
+            if (readRealsWithPrecision(xd, blockSize * DIM, isDouble, vectors.data()->as_vec()) == 0)
+            {
+                return -1;
+            }
+            gmx::ArrayRef<gmx::RVec> stateVectors =
+                    (entry == StateEntry::X) ? gmx::makeArrayRef(state->x) : gmx::makeArrayRef(state->v);
+            for (int i = 0; i < blockSize; i++)
+            {
+                stateVectors[globalAtomIndices[i]] = vectors[i];
+            }
+        }
+    }
+    if (numAtomsRead != numAtoms)
+    {
+        return -1;
+    }
+
+    if (list)
+    {
+        if (haveX)
+        {
+            pr_rvecs(list, 0, enumValueToString(StateEntry::X), state->x.rvec_array(), numAtoms);
+        }
+        if (haveV)
+        {
+            pr_rvecs(list, 0, enumValueToString(StateEntry::V), state->v.rvec_array(), numAtoms);
+        }
+    }
+
+    return 0;
+}
+
+void write_checkpoint_atom_block(const std::filesystem::path&   fn,
+                                 int64_t                        offset,
+                                 gmx::ArrayRef<const int>       globalAtomIndices,
+                                 gmx::ArrayRef<const gmx::RVec> x,
+                                 gmx::ArrayRef<const gmx::RVec> v)
+{
+    GMX_RELEASE_ASSERT(x.size() == globalAtomIndices.size()
+                               && (v.empty() || v.size() == globalAtomIndices.size()),
+                       "An atom block needs the vectors of all its atoms");
+
+    FILE* fp = gmx_ffopen(fn, "r+b");
+    if (gmx_fseek(fp, offset, SEEK_SET) != 0)
+    {
+        gmx_file("Cannot seek to atom block in checkpoint file");
+    }
+    XDR xd;
+    xdrstdio_create(&xd, fp, XDR_ENCODE);
+    const int numAtoms = globalAtomIndices.ssize();
+    bool_t    res      = xdr_vector(&xd,
+                            reinterpret_cast<char*>(const_cast<int*>(globalAtomIndices.data())),
+                            numAtoms,
+                            sizeof(int),
+                            xdrProc(XdrDataType::Int));
+    for (const auto vectors : { x, v })
+    {
+        if (res != 0 && !vectors.empty())
+        {
+            res = xdr_vector(&xd,
+                             reinterpret_cast<char*>(const_cast<real*>(vectors.data()->as_vec())),
+                             numAtoms * DIM,
+                             sizeof(real),
+                             xdrProc(xdr_type<real>::value));
+        }
+    }
+    xdr_destroy(&xd);
+    if (res == 0 || gmx_fsync(fp) != 0 || gmx_ffclose(fp) != 0)
+    {
+        gmx_file("Cannot write atom block to checkpoint; maybe you are out of disk space?");
+    }
+}
+
 static int do_cpt_state(XDR* xd, int fflags, t_state* state, FILE* list)
 {
     GMX_RELEASE_ASSERT(static_cast<unsigned int>(state->numAtoms())
@@ -2037,12 +2288,136 @@ static int do_cpt_EDstate(XDR* xd, gmx_bool bRead, int nED, edsamhistory_t* EDst
     return 0;
 }
 
-static int do_cpt_correlation_grid(XDR*                         xd,
-                                   gmx_bool                     bRead,
-                                   gmx_unused int               fflags,
-                                   gmx::CorrelationGridHistory* corrGrid,
-                                   FILE*                        list,
-                                   StateAwhEntry                eawhh)
+static void do_cpt_correlation_block_data(XDR*                              xd,
+                                          const char*                       desc,
+                                          gmx::CorrelationBlockDataHistory* blockData,
+                                          FILE*                             list)
+{
+    do_cpt_double_err(xd, desc, &(blockData->blockSumWeight), list);
+    do_cpt_double_err(xd, desc, &(blockData->blockSumSquareWeight), list);
+    do_cpt_double_err(xd, desc, &(blockData->blockSumWeightX), list);
+    do_cpt_double_err(xd, desc, &(blockData->blockSumWeightY), list);
+    do_cpt_double_err(xd, desc, &(blockData->sumOverBlocksSquareBlockWeight), list);
+    do_cpt_double_err(xd, desc, &(blockData->sumOverBlocksBlockSquareWeight), list);
+    do_cpt_double_err(xd, desc, &(blockData->sumOverBlocksBlockWeightBlockWeightX), list);
+    do_cpt_double_err(xd, desc, &(blockData->sumOverBlocksBlockWeightBlockWeightY), list);
+    do_cpt_double_err(xd, desc, &(blockData->blockLength), list);
+    do_cpt_int_err(xd, desc, &(blockData->previousBlockIndex), list);
+    do_cpt_double_err(xd, desc, &(blockData->correlationIntegral), list);
+}
+
+static bool correlationBlockDataDiffers(const gmx::CorrelationBlockDataHistory& a,
+                                        const gmx::CorrelationBlockDataHistory& b)
+{
+    return a.blockSumWeight != b.blockSumWeight || a.blockSumSquareWeight != b.blockSumSquareWeight
+           || a.blockSumWeightX != b.blockSumWeightX || a.blockSumWeightY != b.blockSumWeightY
+           || a.sumOverBlocksSquareBlockWeight != b.sumOverBlocksSquareBlockWeight
+           || a.sumOverBlocksBlockSquareWeight != b.sumOverBlocksBlockSquareWeight
+           || a.sumOverBlocksBlockWeightBlockWeightX != b.sumOverBlocksBlockWeightBlockWeightX
+           || a.sumOverBlocksBlockWeightBlockWeightY != b.sumOverBlocksBlockWeightBlockWeightY
+           || a.blockLength != b.blockLength || a.previousBlockIndex != b.previousBlockIndex
+           || a.correlationIntegral != b.correlationIntegral;
+}
+
+static void do_cpt_awh_point(XDR*                       xd,
+                             const char*                desc,
+                             gmx::AwhPointStateHistory* psh,
+                             FILE*                      list,
+                             const CheckPointVersion    fileVersion)
+{
+    do_cpt_double_err(xd, desc, &psh->target, list);
+    do_cpt_double_err(xd, desc, &psh->free_energy, list);
+    do_cpt_double_err(xd, desc, &psh->bias, list);
+    do_cpt_double_err(xd, desc, &psh->weightsum_iteration, list);
+    do_cpt_double_err(xd, desc, &psh->weightsum_covering, list);
+    do_cpt_double_err(xd, desc, &psh->weightsum_tot, list);
+    do_cpt_double_err(xd, desc, &psh->weightsum_ref, list);
+    do_cpt_step_err(xd, desc, &psh->last_update_index, list);
+    do_cpt_double_err(xd, desc, &psh->log_pmfsum, list);
+    do_cpt_double_err(xd, desc, &psh->visits_iteration, list);
+    do_cpt_double_err(xd, desc, &psh->visits_tot, list);
+    if (fileVersion >= CheckPointVersion::AwhLocalWeightSum)
+    {
+        do_cpt_double_err(xd, desc, &psh->localWeightSum, list);
+    }
+    else
+    {
+        psh->localWeightSum = 0;
+    }
+}
+
+static bool awhPointStateDiffers(const gmx::AwhPointStateHistory& a,
+                                 const gmx::AwhPointStateHistory& b)
+{
+    return a.bias != b.bias || a.free_energy != b.free_energy || a.target != b.target
+           || a.weightsum_iteration != b.weightsum_iteration
+           || a.weightsum_covering != b.weightsum_covering || a.weightsum_tot != b.weightsum_tot
+           || a.weightsum_ref != b.weightsum_ref || a.last_update_index != b.last_update_index
+           || a.log_pmfsum != b.log_pmfsum || a.visits_iteration != b.visits_iteration
+           || a.visits_tot != b.visits_tot || a.localWeightSum != b.localWeightSum;
+}
+
+/*! \brief Reads/writes the entries of \p entries that differ from \p reference
+ *
+ * Stores the number of changed entries followed by the index and contents,
+ * using \p doEntry, of each changed entry. \p reference is only used for
+ * writing. When reading, \p entries should already contain the reference values.
+ */
+template<typename T, typename Differs, typename DoEntry>
+static int do_cpt_changed_entries(XDR*                xd,
+                                  gmx_bool            bRead,
+                                  const char*         desc,
+                                  gmx::ArrayRef<T>    entries,
+                                  gmx::ArrayRef<const T> reference,
+                                  Differs             differs,
+                                  DoEntry             doEntry,
+                                  FILE*               list)
+{
+    std::vector<int> changedIndices;
+    if (!bRead)
+    {
+        for (gmx::Index i = 0; i < entries.ssize(); i++)
+        {
+            if (differs(entries[i], reference[i]))
+            {
+                changedIndices.push_back(i);
+            }
+        }
+    }
+    int numChanged = changedIndices.size();
+    do_cpt_int_err(xd, desc, &numChanged, list);
+    if (numChanged < 0 || numChanged > entries.ssize())
+    {
+        return -1;
+    }
+    changedIndices.resize(numChanged);
+    const std::string indexDesc = std::string(desc) + " index";
+    for (int& index : changedIndices)
+    {
+        do_cpt_int_err(xd, indexDesc.c_str(), &index, list);
+        if (index < 0 || index >= entries.ssize())
+        {
+            return -1;
+        }
+        doEntry(&entries[index]);
+    }
+    return 0;
+}
+
+/*! \brief Reads/writes a force correlation grid
+ *
+ * With \p isIncremental, only the block data that differs from \p reference
+ * is stored. When listing, \p reference can be nullptr, the unchanged block
+ * data is then left at its initial values.
+ */
+static int do_cpt_correlation_grid(XDR*                               xd,
+                                   gmx_bool                           bRead,
+                                   gmx_unused int                     fflags,
+                                   gmx::CorrelationGridHistory*       corrGrid,
+                                   bool                               isIncremental,
+                                   const gmx::CorrelationGridHistory* reference,
+                                   FILE*                              list,
+                                   StateAwhEntry                      eawhh)
 {
     int ret = 0;
 
@@ -2056,32 +2431,57 @@ static int do_cpt_correlation_grid(XDR*                         xd,
                 corrGrid, corrGrid->numCorrelationTensors, corrGrid->tensorSize, corrGrid->blockDataListSize);
     }
 
-    for (gmx::CorrelationBlockDataHistory& blockData : corrGrid->blockDataBuffer)
+    if (!isIncremental)
     {
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.blockSumWeight), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.blockSumSquareWeight), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.blockSumWeightX), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.blockSumWeightY), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.sumOverBlocksSquareBlockWeight), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.sumOverBlocksBlockSquareWeight), list);
-        do_cpt_double_err(
-                xd, enumValueToString(eawhh), &(blockData.sumOverBlocksBlockWeightBlockWeightX), list);
-        do_cpt_double_err(
-                xd, enumValueToString(eawhh), &(blockData.sumOverBlocksBlockWeightBlockWeightY), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.blockLength), list);
-        do_cpt_int_err(xd, enumValueToString(eawhh), &(blockData.previousBlockIndex), list);
-        do_cpt_double_err(xd, enumValueToString(eawhh), &(blockData.correlationIntegral), list);
+        for (gmx::CorrelationBlockDataHistory& blockData : corrGrid->blockDataBuffer)
+        {
+            do_cpt_correlation_block_data(xd, enumValueToString(eawhh), &blockData, list);
+        }
+    }
+    else
+    {
+        /* Only the block data that differs from the reference is stored */
+        const bool haveReference =
+                (reference != nullptr
+                 && reference->blockDataBuffer.size() == corrGrid->blockDataBuffer.size());
+        if (!bRead && !haveReference)
+        {
+            return -1;
+        }
+        if (bRead && haveReference)
+        {
+            corrGrid->blockDataBuffer = reference->blockDataBuffer;
+        }
+        ret = do_cpt_changed_entries(
+                xd,
+                bRead,
+                "awh changed correlation blocks",
+                gmx::makeArrayRef(corrGrid->blockDataBuffer),
+                haveReference ? gmx::makeConstArrayRef(reference->blockDataBuffer)
+                              : gmx::ArrayRef<const gmx::CorrelationBlockDataHistory>(),
+                correlationBlockDataDiffers,
+                [xd, eawhh, list](gmx::CorrelationBlockDataHistory* blockData)
+                { do_cpt_correlation_block_data(xd, enumValueToString(eawhh), blockData, list); },
+                list);
     }
 
     return ret;
 }
 
-static int do_cpt_awh_bias(XDR*                    xd,
-                           gmx_bool                bRead,
-                           int                     fflags,
-                           gmx::AwhBiasHistory*    biasHistory,
-                           FILE*                   list,
-                           const CheckPointVersion fileVersion)
+/*! \brief Reads/writes the history of an AWH bias
+ *
+ * With \p isIncremental, only the point states and force correlation data
+ * that differ from \p reference are stored. When listing an incremental
+ * checkpoint, \p reference can be nullptr, only the changed data is then set.
+ */
+static int do_cpt_awh_bias(XDR*                       xd,
+                           gmx_bool                   bRead,
+                           int                        fflags,
+                           gmx::AwhBiasHistory*       biasHistory,
+                           bool                       isIncremental,
+                           const gmx::AwhBiasHistory* reference,
+                           FILE*                      list,
+                           const CheckPointVersion    fileVersion)
 {
     int ret = 0;
 
@@ -2117,27 +2517,46 @@ static int do_cpt_awh_bias(XDR*                    xd,
                 }
                 break;
                 case StateAwhEntry::CoordPoint:
-                    for (auto& psh : biasHistory->pointState)
+                    if (!isIncremental)
+                    {
+                        for (auto& psh : biasHistory->pointState)
+                        {
+                            do_cpt_awh_point(xd, enumValueToString(*i), &psh, list, fileVersion);
+                        }
+                    }
+                    else
                     {
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.target, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.free_energy, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.bias, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.weightsum_iteration, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.weightsum_covering, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.weightsum_tot, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.weightsum_ref, list);
-                        do_cpt_step_err(xd, enumValueToString(*i), &psh.last_update_index, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.log_pmfsum, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.visits_iteration, list);
-                        do_cpt_double_err(xd, enumValueToString(*i), &psh.visits_tot, list);
-                        if (fileVersion >= CheckPointVersion::AwhLocalWeightSum)
+                        const bool haveReference =
+                                (reference != nullptr
+                                 && reference->pointState.size() == biasHistory->pointState.size());
+                        if (!bRead && !haveReference)
                         {
-                            do_cpt_double_err(xd, enumValueToString(*i), &psh.localWeightSum, list);
+                            return -1;
                         }
-                        else
+                        if (bRead)
                         {
-                            psh.localWeightSum = 0;
+                            if (haveReference)
+                            {
+                                biasHistory->pointState = reference->pointState;
+                            }
+                            else
+                            {
+                                std::fill(biasHistory->pointState.begin(),
+                                          biasHistory->pointState.end(),
+                                          gmx::AwhPointStateHistory{});
+                            }
                         }
+                        ret = do_cpt_changed_entries(
+                                xd,
+                                bRead,
+                                "awh changed points",
+                                gmx::makeArrayRef(biasHistory->pointState),
+                                haveReference ? gmx::makeConstArrayRef(reference->pointState)
+                                              : gmx::ArrayRef<const gmx::AwhPointStateHistory>(),
+                                awhPointStateDiffers,
+                                [xd, i, list, fileVersion](gmx::AwhPointStateHistory* psh)
+                                { do_cpt_awh_point(xd, enumValueToString(*i), psh, list, fileVersion); },
+                                list);
                     }
                     break;
                 case StateAwhEntry::UmbrellaGridPoint:
@@ -2156,7 +2575,14 @@ static int do_cpt_awh_bias(XDR*                    xd,
                     break;
                 case StateAwhEntry::ForceCorrelationGrid:
                     ret = do_cpt_correlation_grid(
-                            xd, bRead, fflags, &biasHistory->forceCorrelationGrid, list, *i);
+                            xd,
+                            bRead,
+                            fflags,
+                            &biasHistory->forceCorrelationGrid,
+                            isIncremental,
+                            reference ? &reference->forceCorrelationGrid : nullptr,
+                            list,
+                            *i);
                     break;
                 default: gmx_fatal(FARGS, "Unknown awh history entry %d\n", enumValueToBitMask(*i));
             }
@@ -2166,7 +2592,38 @@ static int do_cpt_awh_bias(XDR*                    xd,
     return ret;
 }
 
-static int do_cpt_awh(XDR* xd, gmx_bool bRead, int fflags, gmx::AwhHistory* awhHistory, FILE* list, const CheckPointVersion fileVersion)
+//! Returns whether AWH histories \p a and \p b have the same numbers of biases, points and correlation data
+static bool awhHistoryLayoutMatches(const gmx::AwhHistory& a, const gmx::AwhHistory& b)
+{
+    if (a.bias.size() != b.bias.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.bias.size(); i++)
+    {
+        if (a.bias[i].pointState.size() != b.bias[i].pointState.size()
+            || a.bias[i].forceCorrelationGrid.blockDataBuffer.size()
+                       != b.bias[i].forceCorrelationGrid.blockDataBuffer.size())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief Reads/writes the AWH history
+ *
+ * With \p isIncremental, only the data that differs from \p reference is
+ * stored, see do_cpt_awh_bias().
+ */
+static int do_cpt_awh(XDR*                    xd,
+                      gmx_bool                bRead,
+                      int                     fflags,
+                      gmx::AwhHistory*        awhHistory,
+                      bool                    isIncremental,
+                      const gmx::AwhHistory*  reference,
+                      FILE*                   list,
+                      const CheckPointVersion fileVersion)
 {
     int ret = 0;
 
@@ -2204,9 +2661,20 @@ static int do_cpt_awh(XDR* xd, gmx_bool bRead, int fflags, gmx::AwhHistory* awhH
         {
             awhHistory->bias.resize(numBias);
         }
-        for (auto& bias : awhHistory->bias)
+        if (reference != nullptr && reference->bias.size() != awhHistory->bias.size())
+        {
+            reference = nullptr;
+        }
+        for (size_t b = 0; b < awhHistory->bias.size(); b++)
         {
-            ret = do_cpt_awh_bias(xd, bRead, fflags, &bias, list, fileVersion);
+            ret = do_cpt_awh_bias(xd,
+                                  bRead,
+                                  fflags,
+                                  &awhHistory->bias[b],
+                                  isIncremental,
+                                  reference ? &reference->bias[b] : nullptr,
+                                  list,
+                                  fileVersion);
             if (ret)
             {
                 return ret;
@@ -2326,16 +2794,20 @@ static int do_cpt_files(XDR*                              xd,
     return 0;
 }
 
-void write_checkpoint_data(t_fileio*                         fp,
-                           CheckpointHeaderContents          headerContents,
-                           gmx_bool                          bExpanded,
-                           LambdaWeightCalculation           elamstats,
-                           t_state*                          state,
-                           ObservablesHistory*               observablesHistory,
-                           const gmx::MDModulesNotifiers&    mdModulesNotifiers,
-                           std::vector<gmx_file_position_t>* outputfiles,
-                           gmx::WriteCheckpointDataHolder*   modularSimulatorCheckpointData)
+std::vector<int64_t> write_checkpoint_data(t_fileio*                         fp,
+                                           CheckpointHeaderContents          headerContents,
+                                           gmx_bool                          bExpanded,
+                                           LambdaWeightCalculation           elamstats,
+                                           t_state*                          state,
+                                           ObservablesHistory*               observablesHistory,
+                                           const gmx::MDModulesNotifiers&    mdModulesNotifiers,
+                                           std::vector<gmx_file_position_t>* outputfiles,
+                                           gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
+                                           gmx::ArrayRef<const int>        atomBlockNumAtoms,
+                                           const CheckpointAwhReference*   awhReference)
 {
+    headerContents.numAtomBlocks = atomBlockNumAtoms.ssize();
+
     headerContents.flags_eks = 0;
     if (state->ekinstate.bUpToDate)
     {
@@ -2430,9 +2902,22 @@ void write_checkpoint_data(t_fileio*                         fp,
                                       | enumValueToBitMask(StateAwhEntry::ForceCorrelationGrid));
     }
 
+    headerContents.awhReferenceStep = -1;
+    if (headerContents.flags_awhh != 0 && awhReference != nullptr
+        && awhHistoryLayoutMatches(*state->awhHistory, awhReference->awhHistory))
+    {
+        headerContents.awhReferenceStep = awhReference->step;
+        std::strncpy(
+                headerContents.awhReferenceFile, awhReference->fileName.c_str(), CPTSTRLEN - 1);
+    }
+
     do_cpt_header(gmx_fio_getxdr(fp), FALSE, nullptr, &headerContents);
 
-    if ((do_cpt_state(gmx_fio_getxdr(fp), state->flags(), state, nullptr) < 0)
+    if ((do_cpt_state(gmx_fio_getxdr(fp),
+                      stateSectionFlags(state->flags(), headerContents.numAtomBlocks),
+                      state,
+                      nullptr)
+         < 0)
         || (do_cpt_ekinstate(gmx_fio_getxdr(fp), headerContents.flags_eks, &state->ekinstate, nullptr) < 0)
         || (do_cpt_enerhist(gmx_fio_getxdr(fp), FALSE, headerContents.flags_enh, enerhist, nullptr) < 0)
         || (doCptPullHist(gmx_fio_getxdr(fp), FALSE, headerContents.flagsPullHistory, pullHist, nullptr) < 0)
@@ -2441,7 +2926,14 @@ void write_checkpoint_data(t_fileio*                         fp,
         || (do_cpt_EDstate(
                     gmx_fio_getxdr(fp), FALSE, headerContents.nED, observablesHistory->edsamHistory.get(), nullptr)
             < 0)
-        || (do_cpt_awh(gmx_fio_getxdr(fp), FALSE, headerContents.flags_awhh, state->awhHistory.get(), nullptr, CheckPointVersion::CurrentVersion)
+        || (do_cpt_awh(gmx_fio_getxdr(fp),
+                       FALSE,
+                       headerContents.flags_awhh,
+                       state->awhHistory.get(),
+                       headerContents.awhReferenceStep >= 0,
+                       awhReference ? &awhReference->awhHistory : nullptr,
+                       nullptr,
+                       CheckPointVersion::CurrentVersion)
             < 0)
         || (do_cpt_swapstate(gmx_fio_getxdr(fp),
                              FALSE,
@@ -2471,6 +2963,28 @@ void write_checkpoint_data(t_fileio*                         fp,
     }
 
     do_cpt_footer(gmx_fio_getxdr(fp), headerContents.file_version);
+
+    std::vector<int64_t> atomBlockOffsets;
+    if (!atomBlockNumAtoms.empty())
+    {
+        /* The blocks are stored contiguously after the table */
+        const int numVectors = numAtomBlockVectors(state->flags());
+        const int numBlocks  = atomBlockNumAtoms.ssize();
+        int64_t   offset     = gmx_fio_ftell(fp) + 2 * sizeof(int)
+                         + numBlocks * (sizeof(int) + sizeof(int64_t));
+        for (const int numAtoms : atomBlockNumAtoms)
+        {
+            atomBlockOffsets.push_back(offset);
+            offset += atomBlockSize(numAtoms, numVectors, GMX_DOUBLE);
+        }
+        std::vector<int> blockNumAtoms(atomBlockNumAtoms.begin(), atomBlockNumAtoms.end());
+        if (do_cpt_atom_block_table(gmx_fio_getxdr(fp), &blockNumAtoms, &atomBlockOffsets, nullptr)
+            < 0)
+        {
+            gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk "
+                     "space?");
+        }
+    }
 #if GMX_FAHCORE
     /* Always FAH checkpoint immediately after a Gromacs checkpoint.
      *
@@ -2487,6 +3001,8 @@ void write_checkpoint_data(t_fileio*                         fp,
      */
     fcCheckpoint();
 #endif
+
+    return atomBlockOffsets;
 }
 
 static void check_int(FILE* fplog, const char* type, int p, int f, gmx_bool* mm)
@@ -2628,6 +3144,9 @@ static void check_match(FILE*                           fplog,
     }
 }
 
+static std::unique_ptr<gmx::AwhHistory> readAwhReference(const std::filesystem::path&    fn,
+                                                         const CheckpointHeaderContents& headerContents);
+
 static void read_checkpoint(const std::filesystem::path&   fn,
                             t_fileio*                      logfio,
                             const t_commrec*               cr,
@@ -2750,7 +3269,10 @@ static void read_checkpoint(const std::filesystem::path&   fn,
         check_match(fplog, cr, dd_nc, *headerContents, reproducibilityRequested);
     }
 
-    ret             = do_cpt_state(gmx_fio_getxdr(fp), headerContents->flags_state, state, nullptr);
+    ret = do_cpt_state(gmx_fio_getxdr(fp),
+                       stateSectionFlags(headerContents->flags_state, headerContents->numAtomBlocks),
+                       state,
+                       nullptr);
     *init_fep_state = state->fep_state; /* there should be a better way to do this than setting it
                                            here. Investigate for 5.0. */
     if (ret)
@@ -2827,10 +3349,28 @@ static void read_checkpoint(const std::filesystem::path&   fn,
     {
         state->awhHistory = std::make_shared<gmx::AwhHistory>();
     }
+    std::unique_ptr<gmx::AwhHistory> awhReference;
+    if (headerContents->flags_awhh != 0 && headerContents->awhReferenceStep >= 0)
+    {
+        awhReference = readAwhReference(fn, *headerContents);
+        if (!awhReference)
+        {
+            gmx_fatal(FARGS,
+                      "Checkpoint file '%s' stores the AWH history relative to the checkpoint of "
+                      "step %" PRId64
+                      " in file '%s', but that file could not be found next to it or is of "
+                      "another step",
+                      fn.string().c_str(),
+                      headerContents->awhReferenceStep,
+                      headerContents->awhReferenceFile);
+        }
+    }
     ret = do_cpt_awh(gmx_fio_getxdr(fp),
                      TRUE,
                      headerContents->flags_awhh,
                      state->awhHistory.get(),
+                     headerContents->awhReferenceStep >= 0,
+                     awhReference.get(),
                      nullptr,
                      headerContents->file_version);
     if (ret)
@@ -2866,6 +3406,11 @@ static void read_checkpoint(const std::filesystem::path&   fn,
     {
         cp_error();
     }
+    if (headerContents->numAtomBlocks > 0
+        && do_cpt_read_atom_blocks(fp, *headerContents, state, nullptr) != 0)
+    {
+        cp_error();
+    }
     if (gmx_fio_close(fp) != 0)
     {
         gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
@@ -2960,10 +3505,14 @@ void read_checkpoint_part_and_step(const std::filesystem::path& filename, int* s
     *step            = headerContents.step;
 }
 
+/* Reads all data in the checkpoint, with readAtomBlocks also the coordinates
+ * and velocities when these are stored in atom blocks. When the AWH history is
+ * stored relative to a reference checkpoint, only the changed AWH data is set. */
 static CheckpointHeaderContents read_checkpoint_data(t_fileio*                         fp,
                                                      t_state*                          state,
                                                      std::vector<gmx_file_position_t>* outputfiles,
-                                                     gmx::ReadCheckpointDataHolder* modularSimulatorCheckpointData)
+                                                     gmx::ReadCheckpointDataHolder* modularSimulatorCheckpointData,
+                                                     bool readAtomBlocks)
 {
     CheckpointHeaderContents headerContents;
     do_cpt_header(gmx_fio_getxdr(fp), TRUE, nullptr, &headerContents);
@@ -2972,7 +3521,10 @@ static CheckpointHeaderContents read_checkpoint_data(t_fileio*
     state->nnhpres       = headerContents.nnhpres;
     state->nhchainlength = headerContents.nhchainlength;
     state->setFlags(headerContents.flags_state);
-    int ret = do_cpt_state(gmx_fio_getxdr(fp), state->flags(), state, nullptr);
+    int ret = do_cpt_state(gmx_fio_getxdr(fp),
+                           stateSectionFlags(state->flags(), headerContents.numAtomBlocks),
+                           state,
+                           nullptr);
     if (ret)
     {
         cp_error();
@@ -3014,6 +3566,8 @@ static CheckpointHeaderContents read_checkpoint_data(t_fileio*
                      TRUE,
                      headerContents.flags_awhh,
                      state->awhHistory.get(),
+                     headerContents.awhReferenceStep >= 0,
+                     nullptr,
                      nullptr,
                      headerContents.file_version);
     if (ret)
@@ -3047,16 +3601,53 @@ static CheckpointHeaderContents read_checkpoint_data(t_fileio*
     {
         cp_error();
     }
+    if (readAtomBlocks && headerContents.numAtomBlocks > 0
+        && do_cpt_read_atom_blocks(fp, headerContents, state, nullptr) != 0)
+    {
+        cp_error();
+    }
     return headerContents;
 }
 
+/*! \brief Returns the AWH history of the reference checkpoint of checkpoint \p fn
+ *
+ * The reference file is looked for in the directory of \p fn.
+ * Returns nullptr when the file is not found or is not the full
+ * checkpoint of the reference step.
+ */
+static std::unique_ptr<gmx::AwhHistory> readAwhReference(const std::filesystem::path&    fn,
+                                                         const CheckpointHeaderContents& headerContents)
+{
+    const std::filesystem::path reference = fn.parent_path() / headerContents.awhReferenceFile;
+    if (!gmx_fexist(reference))
+    {
+        return nullptr;
+    }
+
+    t_state                          state;
+    std::vector<gmx_file_position_t> outputfiles;
+    gmx::ReadCheckpointDataHolder    modularSimulatorCheckpointData;
+    state.awhHistory                                 = std::make_shared<gmx::AwhHistory>();
+    t_fileio*                      fp                = gmx_fio_open(reference, "r");
+    const CheckpointHeaderContents referenceContents = read_checkpoint_data(
+            fp, &state, &outputfiles, &modularSimulatorCheckpointData, false);
+    gmx_fio_close(fp);
+    if (referenceContents.step != headerContents.awhReferenceStep
+        || referenceContents.awhReferenceStep >= 0 || referenceContents.flags_awhh == 0)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<gmx::AwhHistory>(*state.awhHistory);
+}
+
 void read_checkpoint_trxframe(t_fileio* fp, t_trxframe* fr)
 {
     t_state                          state;
     std::vector<gmx_file_position_t> outputfiles;
     gmx::ReadCheckpointDataHolder    modularSimulatorCheckpointData;
     CheckpointHeaderContents         headerContents =
-            read_checkpoint_data(fp, &state, &outputfiles, &modularSimulatorCheckpointData);
+            read_checkpoint_data(fp, &state, &outputfiles, &modularSimulatorCheckpointData, true);
     if (headerContents.isModularSimulatorCheckpoint)
     {
         gmx::ModularSimulator::readCheckpointToTrxFrame(fr, &modularSimulatorCheckpointData, headerContents);
@@ -3105,7 +3696,10 @@ void list_checkpoint(const std::filesystem::path& fn, FILE* out)
     state.nnhpres       = headerContents.nnhpres;
     state.nhchainlength = headerContents.nhchainlength;
     state.setFlags(headerContents.flags_state);
-    ret = do_cpt_state(gmx_fio_getxdr(fp), state.flags(), &state, out);
+    ret = do_cpt_state(gmx_fio_getxdr(fp),
+                       stateSectionFlags(state.flags(), headerContents.numAtomBlocks),
+                       &state,
+                       out);
     if (ret)
     {
         cp_error();
@@ -3139,10 +3733,23 @@ void list_checkpoint(const std::filesystem::path& fn, FILE* out)
 
     if (ret == 0)
     {
+        std::unique_ptr<gmx::AwhHistory> awhReference;
+        if (headerContents.flags_awhh != 0 && headerContents.awhReferenceStep >= 0)
+        {
+            awhReference = readAwhReference(fn, headerContents);
+            if (!awhReference)
+            {
+                fprintf(out,
+                        "\nThe AWH reference checkpoint is not available, only the AWH data that "
+                        "changed since the reference is listed\n\n");
+            }
+        }
         ret = do_cpt_awh(gmx_fio_getxdr(fp),
                          TRUE,
                          headerContents.flags_awhh,
                          state.awhHistory.get(),
+                         headerContents.awhReferenceStep >= 0,
+                         awhReference.get(),
                          out,
                          headerContents.file_version);
     }
@@ -3173,6 +3780,11 @@ void list_checkpoint(const std::filesystem::path& fn, FILE* out)
         ret = do_cpt_footer(gmx_fio_getxdr(fp), headerContents.file_version);
     }
 
+    if (ret == 0 && headerContents.numAtomBlocks > 0)
+    {
+        ret = do_cpt_read_atom_blocks(fp, headerContents, &state, out);
+    }
+
     if (ret)
     {
         cp_warning(out);
@@ -3190,7 +3802,7 @@ CheckpointHeaderContents read_checkpoint_simulation_part_and_filenames(t_fileio*
     t_state                       state;
     gmx::ReadCheckpointDataHolder modularSimulatorCheckpointData;
     CheckpointHeaderContents      headerContents =
-            read_checkpoint_data(fp, &state, outputfiles, &modularSimulatorCheckpointData);
+            read_checkpoint_data(fp, &state, outputfiles, &modularSimulatorCheckpointData, false);
     if (gmx_fio_close(fp) != 0)
     {
         gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
@@ -39,10 +39,13 @@
 
 #include <filesystem>
 #include <limits>
+#include <string>
 #include <vector>
 
 #include "gromacs/compat/pointers.h"
 #include "gromacs/math/vectypes.h"
+#include "gromacs/mdtypes/awh_history.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/keyvaluetreebuilder.h"
@@ -221,6 +224,10 @@ enum class CheckPointVersion : int
     ModularSimulator,
     //! Added local (per walker) weight contribution to each point in AWH.
     AwhLocalWeightSum,
+    //! Added storing coordinates and velocities in blocks written by each domain.
+    DistributedAtomBlocks,
+    //! Added storing AWH history as the difference with a reference checkpoint.
+    IncrementalAwhHistory,
     //! The total number of checkpoint versions.
     Count,
     //! Current version
@@ -305,18 +312,71 @@ struct CheckpointHeaderContents
     SwapType eSwapCoords;
     //! Whether the checkpoint was written by modular simulator.
     bool isModularSimulatorCheckpoint = false;
+    //! Number of atom blocks after the footer, with 0 the coordinates and velocities are in the state.
+    int numAtomBlocks = 0;
+    //! Step of the reference checkpoint for the AWH history, -1 when the history is stored in full.
+    int64_t awhReferenceStep = -1;
+    //! File name, without directory, of the reference checkpoint for the AWH history.
+    char awhReferenceFile[CPTSTRLEN] = { 0 };
 };
 
-/*! \brief Low-level checkpoint writing function */
-void write_checkpoint_data(t_fileio*                         fp,
-                           CheckpointHeaderContents          headerContents,
-                           gmx_bool                          bExpanded,
-                           LambdaWeightCalculation           elamstats,
-                           t_state*                          state,
-                           ObservablesHistory*               observablesHistory,
-                           const gmx::MDModulesNotifiers&    mdModulesNotifiers,
-                           std::vector<gmx_file_position_t>* outputfiles,
-                           gmx::WriteCheckpointDataHolder*   modularSimulatorCheckpointData);
+/*! \brief The AWH history stored in full in a reference checkpoint
+ *
+ * An incremental checkpoint only stores the AWH grid point and force
+ * correlation data that differs from the reference. Reading such a
+ * checkpoint requires the reference checkpoint file.
+ */
+struct CheckpointAwhReference
+{
+    //! The step of the reference checkpoint.
+    int64_t step = -1;
+    //! The name of the reference checkpoint file, without directory.
+    std::string fileName;
+    //! The AWH history stored in the reference checkpoint.
+    gmx::AwhHistory awhHistory;
+};
+
+/*! \brief Low-level checkpoint writing function
+ *
+ * When \p atomBlockNumAtoms is not empty, the coordinates and velocities
+ * are not written with the state. Instead a table of atom blocks with
+ * the given numbers of atoms is written after the footer, and the file
+ * offsets of the blocks are returned. The blocks should then be written
+ * with write_checkpoint_atom_block(), before the file is used.
+ *
+ * When \p awhReference is not nullptr and matches the layout of the AWH
+ * history in \p state, only the differences with the reference are
+ * written for the AWH grid points and force correlation data.
+ */
+std::vector<int64_t> write_checkpoint_data(t_fileio*                         fp,
+                                           CheckpointHeaderContents          headerContents,
+                                           gmx_bool                          bExpanded,
+                                           LambdaWeightCalculation           elamstats,
+                                           t_state*                          state,
+                                           ObservablesHistory*               observablesHistory,
+                                           const gmx::MDModulesNotifiers&    mdModulesNotifiers,
+                                           std::vector<gmx_file_position_t>* outputfiles,
+                                           gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
+                                           gmx::ArrayRef<const int>        atomBlockNumAtoms = {},
+                                           const CheckpointAwhReference*   awhReference = nullptr);
+
+/*! \brief Writes an atom block of a checkpoint in file \p fn at \p offset
+ *
+ * The block contains the global indices, coordinates and, when \p v is
+ * not empty, velocities of a set of atoms. Atom blocks are written
+ * independently by the ranks owning the atoms, to avoid collecting all
+ * atoms on the main rank. The file should have been written with
+ * write_checkpoint_data(), which returns the offsets of the blocks.
+ *
+ * Only writing is distributed. When reading the checkpoint, the main
+ * rank reads all blocks and assembles the global state, which is then
+ * distributed over the ranks as for a checkpoint without atom blocks.
+ */
+void write_checkpoint_atom_block(const std::filesystem::path&   fn,
+                                 int64_t                        offset,
+                                 gmx::ArrayRef<const int>       globalAtomIndices,
+                                 gmx::ArrayRef<const gmx::RVec> x,
+                                 gmx::ArrayRef<const gmx::RVec> v);
 
 /* Loads a checkpoint from fn for run continuation.
  * Generates a fatal error on system size mismatch.
@@ -40,10 +40,12 @@
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/fileio/xdr_datatype.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/utility/enumerationhelpers.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/futil.h"
 
 /* This is just for clarity - it can never be anything but 4! */
@@ -92,6 +94,11 @@ static const int magicints[] = {
 /* note that magicints[FIRSTIDX-1] == 0 */
 #define LASTIDX static_cast<int>((sizeof(magicints) / sizeof(*magicints)))
 
+/* Number of atoms per independently compressed block in chunked XTC frames.
+ * This sets the available parallelism, the compression ratio is hardly affected.
+ */
+static const int c_chunkedXtcAtomsPerBlock = 16384;
+
 
 struct DataBuffer
 {
@@ -383,472 +390,769 @@ static void receiveints(struct DataBuffer* buffer,
     nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
+/* Integer ranges and bit-packed data of a set of compressed coordinates.
+ * (De)compression only operates on this struct and not on the XDR stream,
+ * so that the independent blocks of a chunked XTC frame can be processed
+ * concurrently, while they are read from or written to the file serially.
+ */
+struct CompressedCoordinates
+{
+    int                        minint[3];
+    int                        maxint[3];
+    int                        smallidx;
+    std::vector<unsigned char> data;
+};
+
+/* Returns the number of bytes to allocate for compressing size3 integers */
+static std::size_t compressionBufferSize(std::size_t size3)
+{
+    return std::max(static_cast<std::size_t>(size3 * 1.2), static_cast<std::size_t>(3 * 20))
+           * XDR_INT_SIZE;
+}
+
 /*____________________________________________________________________________
  |
- | xdr3dfcoord - read or write compressed 3d coordinates to xdr file.
+ | compressCoordinates - compress size 3d coordinates in fp into cc
  |
- | this routine reads or writes (depending on how you opened the file with
- | xdropen() ) a large number of 3d coordinates (stored in *fp).
- | The number of coordinates triplets to write is given by *size. On
- | read this number may be zero, in which case it reads as many as were written
- | or it may specify the number if triplets to read (which should match the
- | number written).
- | Compression is achieved by first converting all floating numbers to integer
- | using multiplication by *precision and rounding to the nearest integer.
- | Then the minimum and maximum value are calculated to determine the range.
- | The limited range of integers so found, is used to compress the coordinates.
- | In addition the differences between succesive coordinates is calculated.
- | If the difference happens to be 'small' then only the difference is saved,
- | compressing the data even more. The notion of 'small' is changed dynamically
- | and is enlarged or reduced whenever needed or possible.
- | Extra compression is achieved in the case of GROMOS and coordinates of
- | water molecules. GROMOS first writes out the Oxygen position, followed by
- | the two hydrogens. In order to make the differences smaller (and thereby
- | compression the data better) the order is changed into first one hydrogen
- | then the oxygen, followed by the other hydrogen. This is rather special, but
- | it shouldn't harm in the general case.
+ | ip should have room for 3*size integers. Returns 0 when the coordinates
+ | can not be represented as integers with the given precision, 1 otherwise.
+ | See xdr3dfcoord() for a description of the compression algorithm.
  |
  */
 
-int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int magic_number)
+static int compressCoordinates(const float*           fp,
+                               int                    size,
+                               float                  precision,
+                               int*                   ip,
+                               CompressedCoordinates* cc)
 {
-    int*     ip = nullptr;
-    gmx_bool bRead;
-
-    /* preallocate a small buffer and ip on the stack - if we need more
-       we can always malloc(). This is faster for small values of size: */
-    std::size_t prealloc_size = 3 * 16;
-    int         prealloc_ip[3 * 16], prealloc_buf[3 * 20];
-    int         we_should_free = 0;
-
     int          minint[3], maxint[3], mindiff, *lip, diff;
     int          lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
     int          minidx, maxidx;
     unsigned     sizeint[3], sizesmall[3], bitsizeint[3], *luip;
-    int          flag, k;
+    int          k;
     int          smallnum, smaller, larger, i, is_small, is_smaller, run, prevrun;
-    float *      lfp, lf;
+    const float* lfp;
+    float        lf;
     int          tmp, *thiscoord, prevcoord[3];
     unsigned int tmpcoord[30];
-
-    std::size_t  size3, bufsize;
-    int          lsize;
+    std::size_t  size3;
     unsigned int bitsize;
-    float        inv_precision;
     int          errval = 1;
-    int          rc;
-    std::size_t  offset, remain, batchsize;
-    unsigned int uint_batchsize;
 
-    bRead         = (xdrs->x_op == XDR_DECODE);
     bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
     prevcoord[0] = prevcoord[1] = prevcoord[2] = 0;
 
-    if (magic_number != XTC_MAGIC && magic_number != XTC_NEW_MAGIC)
-    {
-        fprintf(stderr,
-                "Invalid magic number (%d) requested (should be %d or %d).\n",
-                magic_number,
-                XTC_MAGIC,
-                XTC_NEW_MAGIC);
-        exit(1);
-    }
-
-    if (*size > XTC_1995_MAX_NATOMS && magic_number != XTC_NEW_MAGIC)
-    {
-        fprintf(stderr,
-                "Inconsistent input or file format. Cannot read/write a system\n"
-                "with %d atoms in a frame without using the new XTC magic number (%d).\n",
-                *size,
-                XTC_NEW_MAGIC);
-        exit(1);
-    }
+    size3 = static_cast<std::size_t>(size) * 3;
+    cc->data.resize(compressionBufferSize(size3));
 
     struct DataBuffer buffer;
 
-    // The static analyzer warns about garbage values for thiscoord[] further
-    // down. It might be thrown off by all the reinterpret_casts, but we might
-    // as well make sure the small preallocated buffer is zero-initialized.
-    for (i = 0; i < static_cast<int>(prealloc_size); i++)
-    {
-        prealloc_ip[i] = 0;
-    }
-
-    if (!bRead)
+    buffer.data     = cc->data.data();
+    buffer.index    = 0;
+    buffer.lastbits = 0;
+    buffer.lastbyte = 0;
+    minint[0] = minint[1] = minint[2] = INT_MAX;
+    maxint[0] = maxint[1] = maxint[2] = INT_MIN;
+    prevrun                           = -1;
+    lfp                               = fp;
+    lip                               = ip;
+    mindiff                           = INT_MAX;
+    oldlint1 = oldlint2 = oldlint3 = 0;
+    while (lfp < fp + size3)
     {
-        /* xdrs is open for writing */
-
-        if (xdr_int(xdrs, size) == 0)
+        /* find nearest integer */
+        if (*lfp >= 0.0)
         {
-            return 0;
+            lf = *lfp * precision + 0.5;
         }
-        size3 = static_cast<std::size_t>(*size) * 3;
-        /* when the number of coordinates is small, don't try to compress; just
-         * write them as floats using xdr_vector
-         */
-        if (*size <= 9)
+        else
         {
-            return (xdr_vector(xdrs,
-                               reinterpret_cast<char*>(fp),
-                               static_cast<unsigned int>(size3),
-                               static_cast<unsigned int>(sizeof(*fp)),
-                               reinterpret_cast<xdrproc_t>(xdr_float)));
+            lf = *lfp * precision - 0.5;
         }
-
-        if (xdr_float(xdrs, precision) == 0)
+        if (std::fabs(lf) > maxAbsoluteInt)
         {
-            return 0;
+            /* scaling would cause overflow */
+            errval = 0;
         }
-
-        if (size3 <= prealloc_size)
+        lint1 = static_cast<int>(lf);
+        if (lint1 < minint[0])
         {
-            ip          = prealloc_ip;
-            buffer.data = reinterpret_cast<unsigned char*>(prealloc_buf);
+            minint[0] = lint1;
+        }
+        if (lint1 > maxint[0])
+        {
+            maxint[0] = lint1;
+        }
+        *lip++ = lint1;
+        lfp++;
+        if (*lfp >= 0.0)
+        {
+            lf = *lfp * precision + 0.5;
         }
         else
         {
-            we_should_free = 1;
-            bufsize        = size3 * 1.2;
-            ip             = reinterpret_cast<int*>(malloc(size3 * sizeof(*ip)));
-            buffer.data    = reinterpret_cast<unsigned char*>(malloc(bufsize * XDR_INT_SIZE));
-            if (ip == nullptr || buffer.data == nullptr)
-            {
-                fprintf(stderr, "malloc failed\n");
-                exit(1);
-            }
+            lf = *lfp * precision - 0.5;
         }
-
-        buffer.index    = 0;
-        buffer.lastbits = 0;
-        buffer.lastbyte = 0;
-        minint[0] = minint[1] = minint[2] = INT_MAX;
-        maxint[0] = maxint[1] = maxint[2] = INT_MIN;
-        prevrun                           = -1;
-        lfp                               = fp;
-        lip                               = ip;
-        mindiff                           = INT_MAX;
-        oldlint1 = oldlint2 = oldlint3 = 0;
-        while (lfp < fp + size3)
-        {
-            /* find nearest integer */
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (std::fabs(lf) > maxAbsoluteInt)
-            {
-                /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint1 = static_cast<int>(lf);
-            if (lint1 < minint[0])
-            {
-                minint[0] = lint1;
-            }
-            if (lint1 > maxint[0])
-            {
-                maxint[0] = lint1;
-            }
-            *lip++ = lint1;
-            lfp++;
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (std::fabs(lf) > maxAbsoluteInt)
-            {
-                /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint2 = static_cast<int>(lf);
-            if (lint2 < minint[1])
-            {
-                minint[1] = lint2;
-            }
-            if (lint2 > maxint[1])
-            {
-                maxint[1] = lint2;
-            }
-            *lip++ = lint2;
-            lfp++;
-            if (*lfp >= 0.0)
-            {
-                lf = *lfp * *precision + 0.5;
-            }
-            else
-            {
-                lf = *lfp * *precision - 0.5;
-            }
-            if (std::abs(lf) > maxAbsoluteInt)
-            {
-                /* scaling would cause overflow */
-                errval = 0;
-            }
-            lint3 = static_cast<int>(lf);
-            if (lint3 < minint[2])
-            {
-                minint[2] = lint3;
-            }
-            if (lint3 > maxint[2])
-            {
-                maxint[2] = lint3;
-            }
-            *lip++ = lint3;
-            lfp++;
-            diff = std::abs(oldlint1 - lint1) + std::abs(oldlint2 - lint2) + std::abs(oldlint3 - lint3);
-            if (diff < mindiff && lfp > fp + 3)
-            {
-                mindiff = diff;
-            }
-            oldlint1 = lint1;
-            oldlint2 = lint2;
-            oldlint3 = lint3;
+        if (std::fabs(lf) > maxAbsoluteInt)
+        {
+            /* scaling would cause overflow */
+            errval = 0;
         }
-        if ((xdr_int(xdrs, &(minint[0])) == 0) || (xdr_int(xdrs, &(minint[1])) == 0)
-            || (xdr_int(xdrs, &(minint[2])) == 0) || (xdr_int(xdrs, &(maxint[0])) == 0)
-            || (xdr_int(xdrs, &(maxint[1])) == 0) || (xdr_int(xdrs, &(maxint[2])) == 0))
+        lint2 = static_cast<int>(lf);
+        if (lint2 < minint[1])
         {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
-            return 0;
+            minint[1] = lint2;
         }
-
-        if (static_cast<float>(maxint[0]) - static_cast<float>(minint[0]) >= maxAbsoluteInt
-            || static_cast<float>(maxint[1]) - static_cast<float>(minint[1]) >= maxAbsoluteInt
-            || static_cast<float>(maxint[2]) - static_cast<float>(minint[2]) >= maxAbsoluteInt)
+        if (lint2 > maxint[1])
+        {
+            maxint[1] = lint2;
+        }
+        *lip++ = lint2;
+        lfp++;
+        if (*lfp >= 0.0)
+        {
+            lf = *lfp * precision + 0.5;
+        }
+        else
         {
-            /* turning value in unsigned by subtracting minint
-             * would cause overflow
-             */
+            lf = *lfp * precision - 0.5;
+        }
+        if (std::abs(lf) > maxAbsoluteInt)
+        {
+            /* scaling would cause overflow */
             errval = 0;
         }
-        sizeint[0] = maxint[0] - minint[0] + 1;
-        sizeint[1] = maxint[1] - minint[1] + 1;
-        sizeint[2] = maxint[2] - minint[2] + 1;
+        lint3 = static_cast<int>(lf);
+        if (lint3 < minint[2])
+        {
+            minint[2] = lint3;
+        }
+        if (lint3 > maxint[2])
+        {
+            maxint[2] = lint3;
+        }
+        *lip++ = lint3;
+        lfp++;
+        diff = std::abs(oldlint1 - lint1) + std::abs(oldlint2 - lint2) + std::abs(oldlint3 - lint3);
+        if (diff < mindiff && lfp > fp + 3)
+        {
+            mindiff = diff;
+        }
+        oldlint1 = lint1;
+        oldlint2 = lint2;
+        oldlint3 = lint3;
+    }
+
+    if (static_cast<float>(maxint[0]) - static_cast<float>(minint[0]) >= maxAbsoluteInt
+        || static_cast<float>(maxint[1]) - static_cast<float>(minint[1]) >= maxAbsoluteInt
+        || static_cast<float>(maxint[2]) - static_cast<float>(minint[2]) >= maxAbsoluteInt)
+    {
+        /* turning value in unsigned by subtracting minint
+         * would cause overflow
+         */
+        errval = 0;
+    }
+    sizeint[0] = maxint[0] - minint[0] + 1;
+    sizeint[1] = maxint[1] - minint[1] + 1;
+    sizeint[2] = maxint[2] - minint[2] + 1;
+
+    /* check if one of the sizes is to big to be multiplied */
+    if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff)
+    {
+        bitsizeint[0] = sizeofint(sizeint[0]);
+        bitsizeint[1] = sizeofint(sizeint[1]);
+        bitsizeint[2] = sizeofint(sizeint[2]);
+        bitsize       = 0; /* flag the use of large sizes */
+    }
+    else
+    {
+        bitsize = sizeofints(3, sizeint);
+    }
+    luip     = reinterpret_cast<unsigned int*>(ip);
+    smallidx = FIRSTIDX;
+    while (smallidx < LASTIDX && magicints[smallidx] < mindiff)
+    {
+        smallidx++;
+    }
+    for (k = 0; k < 3; k++)
+    {
+        cc->minint[k] = minint[k];
+        cc->maxint[k] = maxint[k];
+    }
+    cc->smallidx = smallidx;
 
-        /* check if one of the sizes is to big to be multiplied */
-        if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff)
+    maxidx       = std::min(LASTIDX, smallidx + 8);
+    minidx       = maxidx - 8; /* often this equal smallidx */
+    smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+    smallnum     = magicints[smallidx] / 2;
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    larger                                     = magicints[maxidx] / 2;
+    i                                          = 0;
+    while (i < size)
+    {
+        is_small  = 0;
+        thiscoord = reinterpret_cast<int*>(luip) + static_cast<std::size_t>(i) * 3;
+        if (smallidx < maxidx && i >= 1 && std::abs(thiscoord[0] - prevcoord[0]) < larger
+            && std::abs(thiscoord[1] - prevcoord[1]) < larger
+            && std::abs(thiscoord[2] - prevcoord[2]) < larger)
         {
-            bitsizeint[0] = sizeofint(sizeint[0]);
-            bitsizeint[1] = sizeofint(sizeint[1]);
-            bitsizeint[2] = sizeofint(sizeint[2]);
-            bitsize       = 0; /* flag the use of large sizes */
+            is_smaller = 1;
         }
-        else
+        else if (smallidx > minidx)
         {
-            bitsize = sizeofints(3, sizeint);
+            is_smaller = -1;
         }
-        luip     = reinterpret_cast<unsigned int*>(ip);
-        smallidx = FIRSTIDX;
-        while (smallidx < LASTIDX && magicints[smallidx] < mindiff)
+        else
         {
-            smallidx++;
+            is_smaller = 0;
         }
-        if (xdr_int(xdrs, &smallidx) == 0)
+        if (i + 1 < size)
         {
-            if (we_should_free)
+            if (std::abs(thiscoord[0] - thiscoord[3]) < smallnum
+                && std::abs(thiscoord[1] - thiscoord[4]) < smallnum
+                && std::abs(thiscoord[2] - thiscoord[5]) < smallnum)
             {
-                free(ip);
-                free(buffer.data);
+                /* interchange first with second atom for better
+                 * compression of water molecules
+                 */
+                tmp          = thiscoord[0];
+                thiscoord[0] = thiscoord[3];
+                thiscoord[3] = tmp;
+                tmp          = thiscoord[1];
+                thiscoord[1] = thiscoord[4];
+                thiscoord[4] = tmp;
+                tmp          = thiscoord[2];
+                thiscoord[2] = thiscoord[5];
+                thiscoord[5] = tmp;
+                is_small     = 1;
             }
-            return 0;
         }
+        tmpcoord[0] = thiscoord[0] - minint[0];
+        tmpcoord[1] = thiscoord[1] - minint[1];
+        tmpcoord[2] = thiscoord[2] - minint[2];
+        if (bitsize == 0)
+        {
+            sendbits(&buffer, bitsizeint[0], tmpcoord[0]);
+            sendbits(&buffer, bitsizeint[1], tmpcoord[1]);
+            sendbits(&buffer, bitsizeint[2], tmpcoord[2]);
+        }
+        else
+        {
+            sendints(&buffer, 3, bitsize, sizeint, tmpcoord);
+        }
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+        thiscoord    = thiscoord + 3;
+        i++;
 
-        maxidx       = std::min(LASTIDX, smallidx + 8);
-        minidx       = maxidx - 8; /* often this equal smallidx */
-        smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-        larger                                     = magicints[maxidx] / 2;
-        i                                          = 0;
-        while (i < *size)
+        run = 0;
+        if (is_small == 0 && is_smaller == -1)
         {
+            is_smaller = 0;
+        }
+        while (is_small && run < 8 * 3)
+        {
+            if (is_smaller == -1
+                && (SQR(thiscoord[0] - prevcoord[0]) + SQR(thiscoord[1] - prevcoord[1])
+                            + SQR(thiscoord[2] - prevcoord[2])
+                    >= smaller * smaller))
+            {
+                is_smaller = 0;
+            }
+
+            tmpcoord[run++] = thiscoord[0] - prevcoord[0] + smallnum;
+            tmpcoord[run++] = thiscoord[1] - prevcoord[1] + smallnum;
+            tmpcoord[run++] = thiscoord[2] - prevcoord[2] + smallnum;
+
+            prevcoord[0] = thiscoord[0];
+            prevcoord[1] = thiscoord[1];
+            prevcoord[2] = thiscoord[2];
+
+            i++;
+            thiscoord = thiscoord + 3;
             is_small  = 0;
-            thiscoord = reinterpret_cast<int*>(luip) + static_cast<std::size_t>(i) * 3;
-            if (smallidx < maxidx && i >= 1 && std::abs(thiscoord[0] - prevcoord[0]) < larger
-                && std::abs(thiscoord[1] - prevcoord[1]) < larger
-                && std::abs(thiscoord[2] - prevcoord[2]) < larger)
+            if (i < size && abs(thiscoord[0] - prevcoord[0]) < smallnum
+                && abs(thiscoord[1] - prevcoord[1]) < smallnum
+                && abs(thiscoord[2] - prevcoord[2]) < smallnum)
             {
-                is_smaller = 1;
+                is_small = 1;
             }
-            else if (smallidx > minidx)
+        }
+        if (run != prevrun || is_smaller != 0)
+        {
+            prevrun = run;
+            sendbits(&buffer, 1, 1); /* flag the change in run-length */
+            sendbits(&buffer, 5, run + is_smaller + 1);
+        }
+        else
+        {
+            sendbits(&buffer, 1, 0); /* flag the fact that runlength did not change */
+        }
+        for (k = 0; k < run; k += 3)
+        {
+            sendints(&buffer, 3, smallidx, sizesmall, &tmpcoord[k]);
+        }
+        if (is_smaller != 0)
+        {
+            smallidx += is_smaller;
+            if (is_smaller < 0)
             {
-                is_smaller = -1;
+                smallnum = smaller;
+                smaller  = magicints[smallidx - 1] / 2;
             }
             else
             {
-                is_smaller = 0;
+                smaller  = smallnum;
+                smallnum = magicints[smallidx] / 2;
             }
-            if (i + 1 < *size)
+            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+        }
+    }
+    if (buffer.lastbits != 0)
+    {
+        buffer.index++;
+    }
+    cc->data.resize(buffer.index);
+
+    return errval;
+}
+
+/*____________________________________________________________________________
+ |
+ | decompressCoordinates - decompress size 3d coordinates from cc into fp
+ |
+ | ip should have room for 3*size integers.
+ |
+ */
+
+static void decompressCoordinates(const CompressedCoordinates& cc,
+                                  int                          size,
+                                  float                        precision,
+                                  int*                         ip,
+                                  float*                       fp)
+{
+    int          minint[3], maxint[3], *lip;
+    int          smallidx;
+    unsigned     sizeint[3], sizesmall[3], bitsizeint[3];
+    int          flag, k;
+    int          smallnum, smaller, i, is_smaller, run;
+    float*       lfp;
+    int          tmp, *thiscoord, prevcoord[3];
+    unsigned int bitsize;
+    float        inv_precision;
+
+    bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
+    prevcoord[0] = prevcoord[1] = prevcoord[2] = 0;
+
+    for (k = 0; k < 3; k++)
+    {
+        minint[k] = cc.minint[k];
+        maxint[k] = cc.maxint[k];
+    }
+    smallidx = cc.smallidx;
+
+    sizeint[0] = maxint[0] - minint[0] + 1;
+    sizeint[1] = maxint[1] - minint[1] + 1;
+    sizeint[2] = maxint[2] - minint[2] + 1;
+
+    /* check if one of the sizes is to big to be multiplied */
+    if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff)
+    {
+        bitsizeint[0] = sizeofint(sizeint[0]);
+        bitsizeint[1] = sizeofint(sizeint[1]);
+        bitsizeint[2] = sizeofint(sizeint[2]);
+        bitsize       = 0; /* flag the use of large sizes */
+    }
+    else
+    {
+        bitsize = sizeofints(3, sizeint);
+    }
+
+    smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+    smallnum     = magicints[smallidx] / 2;
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+
+    struct DataBuffer buffer;
+
+    // The bit-unpacking routines only read from the buffer
+    buffer.data     = const_cast<unsigned char*>(cc.data.data());
+    buffer.index    = 0;
+    buffer.lastbits = 0;
+    buffer.lastbyte = 0;
+
+    lfp           = fp;
+    inv_precision = 1.0 / precision;
+    run           = 0;
+    i             = 0;
+    lip           = ip;
+    while (i < size)
+    {
+        thiscoord = reinterpret_cast<int*>(lip) + static_cast<std::size_t>(i) * 3;
+
+        if (bitsize == 0)
+        {
+            thiscoord[0] = receivebits(&buffer, bitsizeint[0]);
+            thiscoord[1] = receivebits(&buffer, bitsizeint[1]);
+            thiscoord[2] = receivebits(&buffer, bitsizeint[2]);
+        }
+        else
+        {
+            receiveints(&buffer, 3, bitsize, sizeint, thiscoord);
+        }
+
+        i++;
+        thiscoord[0] += minint[0];
+        thiscoord[1] += minint[1];
+        thiscoord[2] += minint[2];
+
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+
+
+        flag       = receivebits(&buffer, 1);
+        is_smaller = 0;
+        if (flag == 1)
+        {
+            run        = receivebits(&buffer, 5);
+            is_smaller = run % 3;
+            run -= is_smaller;
+            is_smaller--;
+        }
+        if (run > 0)
+        {
+            thiscoord += 3;
+            for (k = 0; k < run; k += 3)
             {
-                if (std::abs(thiscoord[0] - thiscoord[3]) < smallnum
-                    && std::abs(thiscoord[1] - thiscoord[4]) < smallnum
-                    && std::abs(thiscoord[2] - thiscoord[5]) < smallnum)
+                receiveints(&buffer, 3, smallidx, sizesmall, thiscoord);
+                i++;
+                thiscoord[0] += prevcoord[0] - smallnum;
+                thiscoord[1] += prevcoord[1] - smallnum;
+                thiscoord[2] += prevcoord[2] - smallnum;
+                if (k == 0)
                 {
                     /* interchange first with second atom for better
                      * compression of water molecules
                      */
                     tmp          = thiscoord[0];
-                    thiscoord[0] = thiscoord[3];
-                    thiscoord[3] = tmp;
+                    thiscoord[0] = prevcoord[0];
+                    prevcoord[0] = tmp;
                     tmp          = thiscoord[1];
-                    thiscoord[1] = thiscoord[4];
-                    thiscoord[4] = tmp;
+                    thiscoord[1] = prevcoord[1];
+                    prevcoord[1] = tmp;
                     tmp          = thiscoord[2];
-                    thiscoord[2] = thiscoord[5];
-                    thiscoord[5] = tmp;
-                    is_small     = 1;
+                    thiscoord[2] = prevcoord[2];
+                    prevcoord[2] = tmp;
+                    *lfp++       = prevcoord[0] * inv_precision;
+                    *lfp++       = prevcoord[1] * inv_precision;
+                    *lfp++       = prevcoord[2] * inv_precision;
+                }
+                else
+                {
+                    prevcoord[0] = thiscoord[0];
+                    prevcoord[1] = thiscoord[1];
+                    prevcoord[2] = thiscoord[2];
                 }
+                *lfp++ = thiscoord[0] * inv_precision;
+                *lfp++ = thiscoord[1] * inv_precision;
+                *lfp++ = thiscoord[2] * inv_precision;
             }
-            tmpcoord[0] = thiscoord[0] - minint[0];
-            tmpcoord[1] = thiscoord[1] - minint[1];
-            tmpcoord[2] = thiscoord[2] - minint[2];
-            if (bitsize == 0)
+        }
+        else
+        {
+            *lfp++ = thiscoord[0] * inv_precision;
+            *lfp++ = thiscoord[1] * inv_precision;
+            *lfp++ = thiscoord[2] * inv_precision;
+        }
+        smallidx += is_smaller;
+        if (is_smaller < 0)
+        {
+            smallnum = smaller;
+            if (smallidx > FIRSTIDX)
             {
-                sendbits(&buffer, bitsizeint[0], tmpcoord[0]);
-                sendbits(&buffer, bitsizeint[1], tmpcoord[1]);
-                sendbits(&buffer, bitsizeint[2], tmpcoord[2]);
+                smaller = magicints[smallidx - 1] / 2;
             }
             else
             {
-                sendints(&buffer, 3, bitsize, sizeint, tmpcoord);
+                smaller = 0;
             }
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
-            thiscoord    = thiscoord + 3;
-            i++;
+        }
+        else if (is_smaller > 0)
+        {
+            smaller  = smallnum;
+            smallnum = magicints[smallidx] / 2;
+        }
+        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    }
+}
 
-            run = 0;
-            if (is_small == 0 && is_smaller == -1)
-            {
-                is_smaller = 0;
-            }
-            while (is_small && run < 8 * 3)
-            {
-                if (is_smaller == -1
-                    && (SQR(thiscoord[0] - prevcoord[0]) + SQR(thiscoord[1] - prevcoord[1])
-                                + SQR(thiscoord[2] - prevcoord[2])
-                        >= smaller * smaller))
-                {
-                    is_smaller = 0;
-                }
+/*____________________________________________________________________________
+ |
+ | xdrCompressedCoordinates - read or write the integer ranges and the data
+ | of compressed coordinates
+ |
+ | With use64BitSize, the number of bytes is stored as a 64-bit integer.
+ | On read, size3 is the number of coordinates to decompress, which sets
+ | the minimum size of the buffer.
+ |
+ */
+
+static int xdrCompressedCoordinates(XDR*                   xdrs,
+                                    CompressedCoordinates* cc,
+                                    std::size_t            size3,
+                                    bool                   use64BitSize)
+{
+    std::size_t  numBytes, offset, remain, batchsize;
+    unsigned int uint_batchsize;
+    int          rc;
+
+    if ((xdr_int(xdrs, &(cc->minint[0])) == 0) || (xdr_int(xdrs, &(cc->minint[1])) == 0)
+        || (xdr_int(xdrs, &(cc->minint[2])) == 0) || (xdr_int(xdrs, &(cc->maxint[0])) == 0)
+        || (xdr_int(xdrs, &(cc->maxint[1])) == 0) || (xdr_int(xdrs, &(cc->maxint[2])) == 0))
+    {
+        return 0;
+    }
+    if (xdr_int(xdrs, &(cc->smallidx)) == 0)
+    {
+        return 0;
+    }
+
+    numBytes = cc->data.size();
+    if (use64BitSize)
+    {
+        int64_t numBytes64 = numBytes;
+        rc                 = xdr_int64(xdrs, &numBytes64);
+        numBytes           = numBytes64 >= 0 ? static_cast<std::size_t>(numBytes64) : 0;
+    }
+    else
+    {
+        int numBytes32 = static_cast<int>(numBytes);
+        rc             = xdr_int(xdrs, &numBytes32);
+        numBytes       = numBytes32 >= 0 ? static_cast<std::size_t>(numBytes32) : 0;
+    }
+    if (rc == 0)
+    {
+        return 0;
+    }
+
+    if (xdrs->x_op == XDR_DECODE)
+    {
+        cc->data.resize(std::max(numBytes, compressionBufferSize(size3)));
+    }
+
+    // Since this file is full of old code, and many signed-to-unsigned conversions, we
+    // read data in batches if the smallest number that is a multiple of 4 that
+    // fits in a signed integer to keep data access aligned if possible.
+    offset = 0;
+    remain = numBytes;
+
+    while (rc != 0 && remain > 0)
+    {
+        // Max batch size is largest 4-tuple that fits in signed 32-bit int
+        batchsize      = std::min(remain, static_cast<std::size_t>(2147483644));
+        uint_batchsize = static_cast<unsigned int>(batchsize);
+        rc = xdr_opaque(xdrs, reinterpret_cast<char*>(cc->data.data() + offset), uint_batchsize);
+        offset += batchsize;
+        remain -= batchsize;
+    }
+
+    return rc;
+}
+
+/*____________________________________________________________________________
+ |
+ | xdr3dfcoordChunked - read or write the compressed blocks of a chunked
+ | XTC frame
+ |
+ | The coordinates are split into numBlocks consecutive blocks of (nearly)
+ | equal size, which are compressed independently. The blocks are written
+ | one after another, each with its own integer ranges and a 64-bit data
+ | size. Compression and decompression of the blocks is done in parallel,
+ | the XDR input/output in order.
+ |
+ */
+
+static int xdr3dfcoordChunked(XDR* xdrs, float* fp, int size, float precision)
+{
+    const bool bRead     = (xdrs->x_op == XDR_DECODE);
+    int        numBlocks = std::max(1, size / c_chunkedXtcAtomsPerBlock);
+    int        rc;
+
+    if (xdr_int(xdrs, &numBlocks) == 0)
+    {
+        return 0;
+    }
+    /* Each block needs more than 9 atoms to be compressed */
+    if (numBlocks < 1 || size / numBlocks <= 9)
+    {
+        return 0;
+    }
 
-                tmpcoord[run++] = thiscoord[0] - prevcoord[0] + smallnum;
-                tmpcoord[run++] = thiscoord[1] - prevcoord[1] + smallnum;
-                tmpcoord[run++] = thiscoord[2] - prevcoord[2] + smallnum;
+    const auto blockStart = [size, numBlocks](int block) {
+        return static_cast<int>((static_cast<int64_t>(size) * block) / numBlocks);
+    };
 
-                prevcoord[0] = thiscoord[0];
-                prevcoord[1] = thiscoord[1];
-                prevcoord[2] = thiscoord[2];
+    std::vector<CompressedCoordinates> blocks(numBlocks);
+    std::vector<int>                   errval(numBlocks, 1);
 
-                i++;
-                thiscoord = thiscoord + 3;
-                is_small  = 0;
-                if (i < *size && abs(thiscoord[0] - prevcoord[0]) < smallnum
-                    && abs(thiscoord[1] - prevcoord[1]) < smallnum
-                    && abs(thiscoord[2] - prevcoord[2]) < smallnum)
-                {
-                    is_small = 1;
-                }
-            }
-            if (run != prevrun || is_smaller != 0)
-            {
-                prevrun = run;
-                sendbits(&buffer, 1, 1); /* flag the change in run-length */
-                sendbits(&buffer, 5, run + is_smaller + 1);
-            }
-            else
-            {
-                sendbits(&buffer, 1, 0); /* flag the fact that runlength did not change */
-            }
-            for (k = 0; k < run; k += 3)
-            {
-                sendints(&buffer, 3, smallidx, sizesmall, &tmpcoord[k]);
-            }
-            if (is_smaller != 0)
+    if (!bRead)
+    {
+#pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < numBlocks; b++)
+        {
+            try
             {
-                smallidx += is_smaller;
-                if (is_smaller < 0)
-                {
-                    smallnum = smaller;
-                    smaller  = magicints[smallidx - 1] / 2;
-                }
-                else
-                {
-                    smaller  = smallnum;
-                    smallnum = magicints[smallidx] / 2;
-                }
-                sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+                const int        start     = blockStart(b);
+                const int        blockSize = blockStart(b + 1) - start;
+                const float*     fpBlock   = fp + static_cast<std::size_t>(start) * 3;
+                std::vector<int> ip(static_cast<std::size_t>(blockSize) * 3);
+                errval[b] = compressCoordinates(
+                        fpBlock, blockSize, precision, ip.data(), &blocks[b]);
             }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
         }
-        if (buffer.lastbits != 0)
+    }
+
+    rc = 1;
+    for (int b = 0; b < numBlocks && rc != 0; b++)
+    {
+        const std::size_t blockSize = blockStart(b + 1) - blockStart(b);
+
+        rc = xdrCompressedCoordinates(xdrs, &blocks[b], blockSize * 3, true);
+    }
+    if (rc == 0)
+    {
+        return 0;
+    }
+
+    if (bRead)
+    {
+#pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < numBlocks; b++)
         {
-            buffer.index++;
+            try
+            {
+                const int        start     = blockStart(b);
+                const int        blockSize = blockStart(b + 1) - start;
+                std::vector<int> ip(static_cast<std::size_t>(blockSize) * 3);
+                decompressCoordinates(blocks[b],
+                                      blockSize,
+                                      precision,
+                                      ip.data(),
+                                      fp + static_cast<std::size_t>(start) * 3);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
         }
+    }
 
-        // Store the size of the buffer as 64-bit for the new XTC format.
-        // Since this only has advantages for gigantic (>300M atoms) systems,
-        // it is not used by default for smaller-size systems.
-        // This is mostly useful so we can test the new format without using
-        // gigantic files, but it also avoids potential inconsistencies by
-        // only having one indicator (the magic number) for the size of the data.
-        if (magic_number == XTC_NEW_MAGIC)
+    return *std::min_element(errval.begin(), errval.end());
+}
+
+/*____________________________________________________________________________
+ |
+ | xdr3dfcoord - read or write compressed 3d coordinates to xdr file.
+ |
+ | this routine reads or writes (depending on how you opened the file with
+ | xdropen() ) a large number of 3d coordinates (stored in *fp).
+ | The number of coordinates triplets to write is given by *size. On
+ | read this number may be zero, in which case it reads as many as were written
+ | or it may specify the number if triplets to read (which should match the
+ | number written).
+ | Compression is achieved by first converting all floating numbers to integer
+ | using multiplication by *precision and rounding to the nearest integer.
+ | Then the minimum and maximum value are calculated to determine the range.
+ | The limited range of integers so found, is used to compress the coordinates.
+ | In addition the differences between succesive coordinates is calculated.
+ | If the difference happens to be 'small' then only the difference is saved,
+ | compressing the data even more. The notion of 'small' is changed dynamically
+ | and is enlarged or reduced whenever needed or possible.
+ | Extra compression is achieved in the case of GROMOS and coordinates of
+ | water molecules. GROMOS first writes out the Oxygen position, followed by
+ | the two hydrogens. In order to make the differences smaller (and thereby
+ | compression the data better) the order is changed into first one hydrogen
+ | then the oxygen, followed by the other hydrogen. This is rather special, but
+ | it shouldn't harm in the general case.
+ |
+ */
+
+int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int magic_number)
+{
+    int                   lsize;
+    std::size_t           size3;
+    int                   errval, rc;
+    gmx_bool              bRead;
+    CompressedCoordinates compressed;
+    std::vector<int>      ip;
+
+    bRead = (xdrs->x_op == XDR_DECODE);
+
+    if (magic_number != XTC_MAGIC && magic_number != XTC_NEW_MAGIC
+        && magic_number != XTC_CHUNKED_MAGIC)
+    {
+        fprintf(stderr,
+                "Invalid magic number (%d) requested (should be %d, %d or %d).\n",
+                magic_number,
+                XTC_MAGIC,
+                XTC_NEW_MAGIC,
+                XTC_CHUNKED_MAGIC);
+        exit(1);
+    }
+
+    if (*size > XTC_1995_MAX_NATOMS && magic_number == XTC_MAGIC)
+    {
+        fprintf(stderr,
+                "Inconsistent input or file format. Cannot read/write a system\n"
+                "with %d atoms in a frame without using the new XTC magic number (%d).\n",
+                *size,
+                XTC_NEW_MAGIC);
+        exit(1);
+    }
+
+    if (!bRead)
+    {
+        /* xdrs is open for writing */
+
+        if (xdr_int(xdrs, size) == 0)
         {
-            rc = xdr_int64(xdrs, reinterpret_cast<int64_t*>(&buffer.index));
+            return 0;
         }
-        else
+        size3 = static_cast<std::size_t>(*size) * 3;
+        /* when the number of coordinates is small, don't try to compress; just
+         * write them as floats using xdr_vector
+         */
+        if (*size <= 9)
         {
-            // Plain old XTC format uses 32-bit sizing
-            i  = static_cast<int>(buffer.index);
-            rc = xdr_int(xdrs, &i);
+            return (xdr_vector(xdrs,
+                               reinterpret_cast<char*>(fp),
+                               static_cast<unsigned int>(size3),
+                               static_cast<unsigned int>(sizeof(*fp)),
+                               reinterpret_cast<xdrproc_t>(xdr_float)));
         }
 
-        if (rc == 0)
+        if (xdr_float(xdrs, precision) == 0)
         {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
             return 0;
         }
 
-        // Since this file is full of old code, and many signed-to-unsigned conversions, we
-        // read data in batches if the smallest number that is a multiple of 4 that
-        // fits in a signed integer to keep data access aligned if possible.
-        offset = 0;
-        remain = buffer.index;
-
-        do
+        if (magic_number == XTC_CHUNKED_MAGIC)
         {
-            // Max batch size is largest 4-tuple that fits in signed 32-bit int
-            batchsize      = std::min(remain, static_cast<std::size_t>(2147483644));
-            uint_batchsize = static_cast<unsigned int>(batchsize);
-            rc = xdr_opaque(xdrs, reinterpret_cast<char*>(buffer.data + offset), uint_batchsize);
-            offset += batchsize;
-            remain -= batchsize;
-        } while (rc != 0 && remain > 0);
+            return xdr3dfcoordChunked(xdrs, fp, *size, *precision);
+        }
 
-        rc = rc * errval;
+        ip.resize(size3);
+        errval = compressCoordinates(fp, *size, *precision, ip.data(), &compressed);
 
-        if (we_should_free)
-        {
-            free(ip);
-            free(buffer.data);
-        }
-        return rc;
+        // Store the size of the buffer as 64-bit for the new XTC format.
+        // Since this only has advantages for gigantic (>300M atoms) systems,
+        // it is not used by default for smaller-size systems.
+        // This is mostly useful so we can test the new format without using
+        // gigantic files, but it also avoids potential inconsistencies by
+        // only having one indicator (the magic number) for the size of the data.
+        rc = xdrCompressedCoordinates(xdrs, &compressed, size3, magic_number == XTC_NEW_MAGIC);
+
+        return rc * errval;
     }
     else
     {
@@ -883,230 +1187,21 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int magic_num
             return 0;
         }
 
-        if (size3 <= prealloc_size)
-        {
-            ip          = prealloc_ip;
-            buffer.data = reinterpret_cast<unsigned char*>(prealloc_buf);
-        }
-        else
-        {
-            we_should_free = 1;
-            bufsize        = size3 * 1.2;
-            ip             = reinterpret_cast<int*>(malloc(size3 * sizeof(*ip)));
-            buffer.data    = reinterpret_cast<unsigned char*>(malloc(bufsize * XDR_INT_SIZE));
-            if (ip == nullptr || buffer.data == nullptr)
-            {
-                fprintf(stderr, "malloc failed\n");
-                exit(1);
-            }
-        }
-
-        buffer.index    = 0;
-        buffer.lastbits = 0;
-        buffer.lastbyte = 0;
-
-        if ((xdr_int(xdrs, &(minint[0])) == 0) || (xdr_int(xdrs, &(minint[1])) == 0)
-            || (xdr_int(xdrs, &(minint[2])) == 0) || (xdr_int(xdrs, &(maxint[0])) == 0)
-            || (xdr_int(xdrs, &(maxint[1])) == 0) || (xdr_int(xdrs, &(maxint[2])) == 0))
-        {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
-            return 0;
-        }
-
-        sizeint[0] = maxint[0] - minint[0] + 1;
-        sizeint[1] = maxint[1] - minint[1] + 1;
-        sizeint[2] = maxint[2] - minint[2] + 1;
-
-        /* check if one of the sizes is to big to be multiplied */
-        if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff)
-        {
-            bitsizeint[0] = sizeofint(sizeint[0]);
-            bitsizeint[1] = sizeofint(sizeint[1]);
-            bitsizeint[2] = sizeofint(sizeint[2]);
-            bitsize       = 0; /* flag the use of large sizes */
-        }
-        else
-        {
-            bitsize = sizeofints(3, sizeint);
-        }
-
-        if (xdr_int(xdrs, &smallidx) == 0)
+        if (magic_number == XTC_CHUNKED_MAGIC)
         {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
-            return 0;
+            return xdr3dfcoordChunked(xdrs, fp, *size, *precision);
         }
 
-        smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-
         // Upon reading, we just adapt to whatever the magic number is in
         // the file - for the new magic number the data is always 64-bit,
         // no matter how large the system happens to be.
-        if (magic_number == XTC_NEW_MAGIC)
-        {
-            rc = xdr_int64(xdrs, reinterpret_cast<int64_t*>(&buffer.index));
-        }
-        else
-        {
-            rc           = xdr_int(xdrs, &i);
-            buffer.index = static_cast<std::size_t>(i);
-        }
-
-        if (rc == 0)
-        {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
-            return 0;
-        }
-
-        offset = 0;
-        remain = buffer.index;
-
-        do
+        if (xdrCompressedCoordinates(xdrs, &compressed, size3, magic_number == XTC_NEW_MAGIC) == 0)
         {
-            // Max batch size is largest 4-tuple that fits in signed 32-bit int
-            batchsize      = std::min(remain, static_cast<std::size_t>(2147483644));
-            uint_batchsize = static_cast<unsigned int>(batchsize);
-            rc = xdr_opaque(xdrs, reinterpret_cast<char*>(buffer.data + offset), uint_batchsize);
-            offset += batchsize;
-            remain -= batchsize;
-        } while (rc != 0 && remain > 0);
-
-        if (rc == 0)
-        {
-            if (we_should_free)
-            {
-                free(ip);
-                free(buffer.data);
-            }
             return 0;
         }
 
-        buffer.index    = 0;
-        buffer.lastbits = 0;
-        buffer.lastbyte = 0;
-
-        lfp           = fp;
-        inv_precision = 1.0 / *precision;
-        run           = 0;
-        i             = 0;
-        lip           = ip;
-        while (i < lsize)
-        {
-            thiscoord = reinterpret_cast<int*>(lip) + static_cast<std::size_t>(i) * 3;
-
-            if (bitsize == 0)
-            {
-                thiscoord[0] = receivebits(&buffer, bitsizeint[0]);
-                thiscoord[1] = receivebits(&buffer, bitsizeint[1]);
-                thiscoord[2] = receivebits(&buffer, bitsizeint[2]);
-            }
-            else
-            {
-                receiveints(&buffer, 3, bitsize, sizeint, thiscoord);
-            }
-
-            i++;
-            thiscoord[0] += minint[0];
-            thiscoord[1] += minint[1];
-            thiscoord[2] += minint[2];
-
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
-
-
-            flag       = receivebits(&buffer, 1);
-            is_smaller = 0;
-            if (flag == 1)
-            {
-                run        = receivebits(&buffer, 5);
-                is_smaller = run % 3;
-                run -= is_smaller;
-                is_smaller--;
-            }
-            if (run > 0)
-            {
-                thiscoord += 3;
-                for (k = 0; k < run; k += 3)
-                {
-                    receiveints(&buffer, 3, smallidx, sizesmall, thiscoord);
-                    i++;
-                    thiscoord[0] += prevcoord[0] - smallnum;
-                    thiscoord[1] += prevcoord[1] - smallnum;
-                    thiscoord[2] += prevcoord[2] - smallnum;
-                    if (k == 0)
-                    {
-                        /* interchange first with second atom for better
-                         * compression of water molecules
-                         */
-                        tmp          = thiscoord[0];
-                        thiscoord[0] = prevcoord[0];
-                        prevcoord[0] = tmp;
-                        tmp          = thiscoord[1];
-                        thiscoord[1] = prevcoord[1];
-                        prevcoord[1] = tmp;
-                        tmp          = thiscoord[2];
-                        thiscoord[2] = prevcoord[2];
-                        prevcoord[2] = tmp;
-                        *lfp++       = prevcoord[0] * inv_precision;
-                        *lfp++       = prevcoord[1] * inv_precision;
-                        *lfp++       = prevcoord[2] * inv_precision;
-                    }
-                    else
-                    {
-                        prevcoord[0] = thiscoord[0];
-                        prevcoord[1] = thiscoord[1];
-                        prevcoord[2] = thiscoord[2];
-                    }
-                    *lfp++ = thiscoord[0] * inv_precision;
-                    *lfp++ = thiscoord[1] * inv_precision;
-                    *lfp++ = thiscoord[2] * inv_precision;
-                }
-            }
-            else
-            {
-                *lfp++ = thiscoord[0] * inv_precision;
-                *lfp++ = thiscoord[1] * inv_precision;
-                *lfp++ = thiscoord[2] * inv_precision;
-            }
-            smallidx += is_smaller;
-            if (is_smaller < 0)
-            {
-                smallnum = smaller;
-                if (smallidx > FIRSTIDX)
-                {
-                    smaller = magicints[smallidx - 1] / 2;
-                }
-                else
-                {
-                    smaller = 0;
-                }
-            }
-            else if (is_smaller > 0)
-            {
-                smaller  = smallnum;
-                smallnum = magicints[smallidx] / 2;
-            }
-            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-        }
-    }
-    if (we_should_free)
-    {
-        free(ip);
-        free(buffer.data);
+        ip.resize(size3);
+        decompressCoordinates(compressed, *size, *precision, ip.data(), fp);
     }
     return 1;
 }
@@ -1119,7 +1214,7 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int magic_num
    the compressed coordinates of the files. Due to the
    compression 00 is not present in the coordinates.
    The first 4 bytes of the header are the magic numbers
-   1995 (0x000007CB) or 2023 (0x000007E7).
+   1995 (0x000007CB), 2023 (0x000007E7) or 2024 (0x000007E8).
    If we find one of these numbers we are guaranteed
    to be in the header, due to the presence of so many zeros.
    The second 4 bytes are the number of atoms in the frame, and is
@@ -1154,7 +1249,7 @@ static int xtc_at_header_start(FILE* fp, XDR* xdrs, int natoms, int* timestep, f
         }
     }
     /* quick return */
-    if (i_inp[0] != XTC_MAGIC && i_inp[0] != XTC_NEW_MAGIC)
+    if (i_inp[0] != XTC_MAGIC && i_inp[0] != XTC_NEW_MAGIC && i_inp[0] != XTC_CHUNKED_MAGIC)
     {
         if (gmx_fseek(fp, off + XDR_INT_SIZE, SEEK_SET))
         {
@@ -1740,3 +1835,78 @@ int xdr_xtc_get_last_frame_number(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK
 
     return frame;
 }
+
+/* Skip numBytes of XDR data, which is padded to a multiple of 4 bytes */
+static int xdr_skip_bytes(FILE* fp, int64_t numBytes)
+{
+    if (numBytes < 0)
+    {
+        return 0;
+    }
+    /* XDR pads opaque data to a multiple of four bytes */
+    const int64_t paddedBytes = (numBytes + XDR_INT_SIZE - 1) / XDR_INT_SIZE * XDR_INT_SIZE;
+    return gmx_fseek(fp, paddedBytes, SEEK_CUR) == 0;
+}
+
+int xdr_xtc_skip_frame_data(FILE* fp, XDR* xdrs, int magic_number)
+{
+    int     size, ranges[7], numBlocks, numBytes32;
+    float   precision;
+    int64_t numBytes;
+
+    /* box, 3x3 floats */
+    if (!xdr_skip_bytes(fp, 9 * XDR_INT_SIZE))
+    {
+        return 0;
+    }
+
+    if (xdr_int(xdrs, &size) == 0 || size < 0)
+    {
+        return 0;
+    }
+    if (size <= 9)
+    {
+        /* uncompressed floats */
+        return xdr_skip_bytes(fp, static_cast<int64_t>(size) * 3 * XDR_INT_SIZE);
+    }
+    if (xdr_float(xdrs, &precision) == 0)
+    {
+        return 0;
+    }
+
+    numBlocks = 1;
+    if (magic_number == XTC_CHUNKED_MAGIC && xdr_int(xdrs, &numBlocks) == 0)
+    {
+        return 0;
+    }
+    for (int b = 0; b < numBlocks; b++)
+    {
+        /* minint, maxint and smallidx */
+        for (int& range : ranges)
+        {
+            if (xdr_int(xdrs, &range) == 0)
+            {
+                return 0;
+            }
+        }
+        if (magic_number == XTC_MAGIC)
+        {
+            if (xdr_int(xdrs, &numBytes32) == 0)
+            {
+                return 0;
+            }
+            numBytes = numBytes32;
+        }
+        else if (xdr_int64(xdrs, &numBytes) == 0)
+        {
+            return 0;
+        }
+        if (!xdr_skip_bytes(fp, numBytes))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
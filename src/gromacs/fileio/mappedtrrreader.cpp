@@ -0,0 +1,435 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::MappedTrrReader.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "mappedtrrreader.h"
+
+#include "config.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <memory>
+#include <system_error>
+
+#include "gromacs/utility/fatalerror.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number at the start of each TRR frame
+constexpr int c_trrMagicNumber = 1993;
+
+//! Returns \p value with the byte order swapped
+inline std::uint32_t swapBytes(std::uint32_t value)
+{
+    return ((value & 0xFF000000U) >> 24) | ((value & 0x00FF0000U) >> 8)
+           | ((value & 0x0000FF00U) << 8) | ((value & 0x000000FFU) << 24);
+}
+
+//! Returns \p value with the byte order swapped
+inline std::uint64_t swapBytes(std::uint64_t value)
+{
+    return (static_cast<std::uint64_t>(swapBytes(static_cast<std::uint32_t>(value))) << 32)
+           | swapBytes(static_cast<std::uint32_t>(value >> 32));
+}
+
+/*! \brief Converts \p count big-endian values of type \p FloatType at \p source to real
+ *
+ * This is a single loop without branches or calls, so the compiler can
+ * vectorize the byte swapping and conversion.
+ */
+template<typename FloatType, typename IntType>
+void decodeBigEndian(const unsigned char* source, int count, real* destination)
+{
+    static_assert(sizeof(FloatType) == sizeof(IntType), "Need an integer type of the same size");
+    for (int i = 0; i < count; i++)
+    {
+        IntType bits;
+        std::memcpy(&bits, source + i * sizeof(IntType), sizeof(IntType));
+#if !GMX_INTEGER_BIG_ENDIAN
+        bits = swapBytes(bits);
+#endif
+        FloatType value;
+        std::memcpy(&value, &bits, sizeof(FloatType));
+        destination[i] = value;
+    }
+}
+
+//! Returns the size of the floating point values in the frame with \p header
+int floatSize(const gmx_trr_header_t& header)
+{
+    int size = 0;
+    if (header.box_size)
+    {
+        size = header.box_size / (DIM * DIM);
+    }
+    else if (header.x_size)
+    {
+        size = header.x_size / (static_cast<unsigned int>(header.natoms) * DIM);
+    }
+    else if (header.v_size)
+    {
+        size = header.v_size / (static_cast<unsigned int>(header.natoms) * DIM);
+    }
+    else if (header.f_size)
+    {
+        size = header.f_size / (static_cast<unsigned int>(header.natoms) * DIM);
+    }
+    else
+    {
+        gmx_file("Can not determine precision of trr file");
+    }
+    if (size != sizeof(float) && size != sizeof(double))
+    {
+        gmx_fatal(FARGS, "Float size %d. Maybe different CPU?", size);
+    }
+    return size;
+}
+
+} // namespace
+
+MappedTrrReader::MappedTrrReader(const std::filesystem::path& trrFile) :
+    path_(trrFile), file_(std::make_unique<MemoryMappedFile>(trrFile))
+{
+    file_->adviseSequentialAccess();
+}
+
+bool MappedTrrReader::remapIfFileGrew()
+{
+    std::error_code errorCode;
+    const auto      fileSize = std::filesystem::file_size(path_, errorCode);
+    if (errorCode || fileSize <= file_->size())
+    {
+        return false;
+    }
+    file_ = std::make_unique<MemoryMappedFile>(path_);
+    file_->adviseSequentialAccess();
+    return true;
+}
+
+bool MappedTrrReader::readInt(int* value)
+{
+    if (offset_ + static_cast<gmx_off_t>(sizeof(std::uint32_t))
+        > static_cast<gmx_off_t>(file_->size()))
+    {
+        return false;
+    }
+    std::uint32_t bits;
+    std::memcpy(&bits, file_->data().data() + offset_, sizeof(bits));
+#if !GMX_INTEGER_BIG_ENDIAN
+    bits = swapBytes(bits);
+#endif
+    std::memcpy(value, &bits, sizeof(*value));
+    offset_ += sizeof(bits);
+    return true;
+}
+
+bool MappedTrrReader::readReal(bool isDouble, real* value)
+{
+    const gmx_off_t size = isDouble ? sizeof(double) : sizeof(float);
+    if (offset_ + size > static_cast<gmx_off_t>(file_->size()))
+    {
+        return false;
+    }
+    const unsigned char* source = file_->data().data() + offset_;
+    if (isDouble)
+    {
+        decodeBigEndian<double, std::uint64_t>(source, 1, value);
+    }
+    else
+    {
+        decodeBigEndian<float, std::uint32_t>(source, 1, value);
+    }
+    offset_ += size;
+    return true;
+}
+
+bool MappedTrrReader::readVectors(int numVectors, bool isDouble, rvec* vectors)
+{
+    const gmx_off_t size = static_cast<gmx_off_t>(numVectors) * DIM
+                           * (isDouble ? sizeof(double) : sizeof(float));
+    if (offset_ + size > static_cast<gmx_off_t>(file_->size()))
+    {
+        return false;
+    }
+    if (vectors != nullptr)
+    {
+        const unsigned char* source = file_->data().data() + offset_;
+        if (isDouble)
+        {
+            decodeBigEndian<double, std::uint64_t>(source, numVectors * DIM, vectors[0]);
+        }
+        else
+        {
+            decodeBigEndian<float, std::uint32_t>(source, numVectors * DIM, vectors[0]);
+        }
+    }
+    offset_ += size;
+    return true;
+}
+
+bool MappedTrrReader::viewVectors(int                   numVectors,
+                                  bool                  isDouble,
+                                  std::vector<RVec>*    buffer,
+                                  ArrayRef<const RVec>* view)
+{
+#if GMX_INTEGER_BIG_ENDIAN
+    // The file data has the byte order and, with matching precision,
+    // the layout of RVec, so it can be used without a copy
+    const unsigned char* source = file_->data().data() + offset_;
+    if (isDouble == bool(GMX_DOUBLE) && reinterpret_cast<std::uintptr_t>(source) % alignof(RVec) == 0)
+    {
+        const gmx_off_t size = static_cast<gmx_off_t>(numVectors) * sizeof(RVec);
+        if (offset_ + size > static_cast<gmx_off_t>(file_->size()))
+        {
+            return false;
+        }
+        const RVec* vectors = reinterpret_cast<const RVec*>(source);
+        *view               = { vectors, vectors + numVectors };
+        offset_ += size;
+        return true;
+    }
+#endif
+    buffer->resize(numVectors);
+    if (!readVectors(numVectors, isDouble, as_rvec_array(buffer->data())))
+    {
+        return false;
+    }
+    *view = *buffer;
+    return true;
+}
+
+gmx_bool MappedTrrReader::readFrameHeader(gmx_trr_header_t* header, gmx_bool* bOK)
+{
+    const gmx_off_t frameOffset = offset_;
+    gmx_bool        haveHeader  = readFrameHeaderFromMapping(header, bOK);
+    if (!haveHeader && remapIfFileGrew())
+    {
+        offset_    = frameOffset;
+        haveHeader = readFrameHeaderFromMapping(header, bOK);
+    }
+    return haveHeader;
+}
+
+gmx_bool MappedTrrReader::readFrameData(const gmx_trr_header_t& header,
+                                        rvec*                   box,
+                                        rvec*                   x,
+                                        rvec*                   v,
+                                        rvec*                   f)
+{
+    const gmx_off_t dataOffset = offset_;
+    gmx_bool        haveData   = readFrameDataFromMapping(header, box, x, v, f);
+    if (!haveData && remapIfFileGrew())
+    {
+        offset_  = dataOffset;
+        haveData = readFrameDataFromMapping(header, box, x, v, f);
+    }
+    return haveData;
+}
+
+gmx_bool MappedTrrReader::readFrameData(const gmx_trr_header_t& header)
+{
+    const gmx_off_t dataOffset = offset_;
+    gmx_bool        haveData   = readFrameDataFromMapping(header);
+    if (!haveData && remapIfFileGrew())
+    {
+        offset_  = dataOffset;
+        haveData = readFrameDataFromMapping(header);
+    }
+    return haveData;
+}
+
+gmx_bool MappedTrrReader::readFrameHeaderFromMapping(gmx_trr_header_t* header, gmx_bool* bOK)
+{
+    *bOK = TRUE;
+
+    int magic;
+    if (!readInt(&magic))
+    {
+        // As with XDR reading, this is the normal end of the file
+        return FALSE;
+    }
+    if (magic != c_trrMagicNumber)
+    {
+        *bOK = FALSE;
+        gmx_fatal(FARGS,
+                  "Failed to find GROMACS magic number in trr frame header, so this is not a trr "
+                  "file!\n");
+    }
+
+    // The version string is stored as an XDR string preceded by its
+    // buffer size, the string data is padded to a multiple of four bytes
+    int bufferSize, stringLength;
+    if (!readInt(&bufferSize) || !readInt(&stringLength) || stringLength < 0)
+    {
+        *bOK = FALSE;
+        return FALSE;
+    }
+    const gmx_off_t paddedLength = (static_cast<gmx_off_t>(stringLength) + 3) / 4 * 4;
+    if (offset_ + paddedLength > static_cast<gmx_off_t>(file_->size()))
+    {
+        *bOK = FALSE;
+        return FALSE;
+    }
+    if (isFirstHeader_)
+    {
+        const char* version = reinterpret_cast<const char*>(file_->data().data() + offset_);
+        fprintf(stderr, "trr version: %.*s ", stringLength, version);
+    }
+    offset_ += paddedLength;
+
+    int xSize = 0, vSize = 0, fSize = 0;
+    *bOK = *bOK && readInt(&header->ir_size);
+    *bOK = *bOK && readInt(&header->e_size);
+    *bOK = *bOK && readInt(&header->box_size);
+    *bOK = *bOK && readInt(&header->vir_size);
+    *bOK = *bOK && readInt(&header->pres_size);
+    *bOK = *bOK && readInt(&header->top_size);
+    *bOK = *bOK && readInt(&header->sym_size);
+    *bOK = *bOK && readInt(&xSize);
+    *bOK = *bOK && readInt(&vSize);
+    *bOK = *bOK && readInt(&fSize);
+    *bOK = *bOK && readInt(&header->natoms);
+    if (!*bOK)
+    {
+        return *bOK;
+    }
+    header->x_size  = xSize;
+    header->v_size  = vSize;
+    header->f_size  = fSize;
+    header->bDouble = (floatSize(*header) == sizeof(double));
+
+    if (isFirstHeader_)
+    {
+        fprintf(stderr, "(%s precision)\n", header->bDouble ? "double" : "single");
+        isFirstHeader_ = false;
+    }
+
+    int intStep = 0;
+    *bOK        = *bOK && readInt(&intStep);
+    header->step = intStep;
+    *bOK         = *bOK && readInt(&header->nre);
+    *bOK         = *bOK && readReal(header->bDouble, &header->t);
+    *bOK         = *bOK && readReal(header->bDouble, &header->lambda);
+
+    return *bOK;
+}
+
+gmx_bool MappedTrrReader::readFrameDataFromMapping(const gmx_trr_header_t& header,
+                                                   rvec*                   box,
+                                                   rvec*                   x,
+                                                   rvec*                   v,
+                                                   rvec*                   f)
+{
+    const bool isDouble = header.bDouble;
+
+    gmx_bool bOK = TRUE;
+    if (header.box_size != 0)
+    {
+        bOK = bOK && readVectors(DIM, isDouble, box);
+    }
+    if (header.vir_size != 0)
+    {
+        bOK = bOK && readVectors(DIM, isDouble, nullptr);
+    }
+    if (header.pres_size != 0)
+    {
+        bOK = bOK && readVectors(DIM, isDouble, nullptr);
+    }
+    if (header.x_size != 0)
+    {
+        bOK = bOK && readVectors(header.natoms, isDouble, x);
+    }
+    if (header.v_size != 0)
+    {
+        bOK = bOK && readVectors(header.natoms, isDouble, v);
+    }
+    if (header.f_size != 0)
+    {
+        bOK = bOK && readVectors(header.natoms, isDouble, f);
+    }
+
+    return bOK;
+}
+
+gmx_bool MappedTrrReader::readFrameDataFromMapping(const gmx_trr_header_t& header)
+{
+    const bool isDouble = header.bDouble;
+
+    box_ = {};
+    x_   = {};
+    v_   = {};
+    f_   = {};
+
+    gmx_bool bOK = TRUE;
+    if (header.box_size != 0)
+    {
+        bOK = bOK && viewVectors(DIM, isDouble, &boxBuffer_, &box_);
+    }
+    if (header.vir_size != 0)
+    {
+        bOK = bOK && readVectors(DIM, isDouble, nullptr);
+    }
+    if (header.pres_size != 0)
+    {
+        bOK = bOK && readVectors(DIM, isDouble, nullptr);
+    }
+    if (header.x_size != 0)
+    {
+        bOK = bOK && viewVectors(header.natoms, isDouble, &xBuffer_, &x_);
+    }
+    if (header.v_size != 0)
+    {
+        bOK = bOK && viewVectors(header.natoms, isDouble, &vBuffer_, &v_);
+    }
+    if (header.f_size != 0)
+    {
+        bOK = bOK && viewVectors(header.natoms, isDouble, &fBuffer_, &f_);
+    }
+
+    return bOK;
+}
+
+} // namespace gmx
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::MappedTrrReader for reading TRR files through a memory mapping.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_MAPPEDTRRREADER_H
+#define GMX_FILEIO_MAPPEDTRRREADER_H
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "gromacs/fileio/memorymappedfile.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief Reads TRR frames from a memory-mapped file
+ *
+ * Reading TRR files through XDR converts every value with a separate
+ * call. This reader instead decodes each present vector array of a frame
+ * in a single byte-swapping pass, which the compiler vectorizes, directly
+ * from the mapped file. The frame header and data are returned with the
+ * same semantics as gmx_trr_read_frame_header() and
+ * gmx_trr_read_frame_data(), so the reader can replace those calls.
+ *
+ * The vector arrays can also be accessed as views. On big-endian
+ * hosts reading a file with the precision of real, the views refer
+ * directly to the mapped file without any copy.
+ *
+ * When a read reaches the end of the mapping and the file has grown
+ * since it was mapped, e.g. because mdrun is still writing to it,
+ * the file is mapped again and the read is retried.
+ */
+class MappedTrrReader
+{
+public:
+    /*! \brief Maps \p trrFile for reading
+     *
+     * \throws NotImplementedError if memory mapping is not supported.
+     * \throws FileIOError if the file can not be mapped.
+     */
+    explicit MappedTrrReader(const std::filesystem::path& trrFile);
+
+    //! Returns the byte offset of the next frame to read
+    gmx_off_t offset() const { return offset_; }
+    //! Sets the byte offset of the next frame to read to \p offset
+    void seek(gmx_off_t offset) { offset_ = offset; }
+
+    /*! \brief Reads the header of the next frame into \p header
+     *
+     * Returns whether a valid header was read. Upon return \p *bOK is
+     * false when the header is incomplete, but true at the end of the file.
+     */
+    gmx_bool readFrameHeader(gmx_trr_header_t* header, gmx_bool* bOK);
+    /*! \brief Reads the data of the frame with \p header into the arguments
+     *
+     * Any of \p box, \p x, \p v and \p f can be nullptr, then the data is
+     * skipped. Returns false when the frame data is incomplete.
+     */
+    gmx_bool readFrameData(const gmx_trr_header_t& header, rvec* box, rvec* x, rvec* v, rvec* f);
+    /*! \brief Reads the data of the frame with \p header for access as views
+     *
+     * Returns false when the frame data is incomplete. The views are
+     * valid until the next call of a read method.
+     */
+    gmx_bool readFrameData(const gmx_trr_header_t& header);
+
+    //! Returns the box of the last frame read with readFrameData(), empty when absent
+    ArrayRef<const RVec> box() const { return box_; }
+    //! Returns the coordinates of the last frame read with readFrameData(), empty when absent
+    ArrayRef<const RVec> x() const { return x_; }
+    //! Returns the velocities of the last frame read with readFrameData(), empty when absent
+    ArrayRef<const RVec> v() const { return v_; }
+    //! Returns the forces of the last frame read with readFrameData(), empty when absent
+    ArrayRef<const RVec> f() const { return f_; }
+
+private:
+    //! Maps the file again when it has grown since it was mapped, returns whether it was
+    bool remapIfFileGrew();
+    //! Reads the header of the next frame from the current mapping
+    gmx_bool readFrameHeaderFromMapping(gmx_trr_header_t* header, gmx_bool* bOK);
+    //! Reads the data of the frame with \p header from the current mapping
+    gmx_bool readFrameDataFromMapping(const gmx_trr_header_t& header,
+                                      rvec*                   box,
+                                      rvec*                   x,
+                                      rvec*                   v,
+                                      rvec*                   f);
+    //! Reads the data of the frame with \p header from the current mapping for access as views
+    gmx_bool readFrameDataFromMapping(const gmx_trr_header_t& header);
+    //! Reads a big-endian integer at the current offset into \p value
+    bool readInt(int* value);
+    //! Reads a big-endian real with the precision of the file into \p value
+    bool readReal(bool isDouble, real* value);
+    /*! \brief Decodes \p numVectors vectors at the current offset into \p vectors
+     *
+     * The data is skipped when \p vectors is nullptr.
+     */
+    bool readVectors(int numVectors, bool isDouble, rvec* vectors);
+    /*! \brief Sets \p view to \p numVectors vectors at the current offset
+     *
+     * Decodes into \p buffer unless the file data can be used directly.
+     */
+    bool viewVectors(int numVectors, bool isDouble, std::vector<RVec>* buffer, ArrayRef<const RVec>* view);
+
+    //! The path of the TRR file
+    std::filesystem::path path_;
+    //! The mapped TRR file
+    std::unique_ptr<MemoryMappedFile> file_;
+    //! Byte offset of the next value to read
+    gmx_off_t offset_ = 0;
+    //! Whether the header of the first frame has not been read yet
+    bool isFirstHeader_ = true;
+    //! Buffers for decoding the vector arrays, reused between frames
+    std::vector<RVec> boxBuffer_, xBuffer_, vBuffer_, fBuffer_;
+    //! Views of the vector arrays of the last frame read
+    ArrayRef<const RVec> box_, x_, v_, f_;
+};
+
+} // namespace gmx
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::MemoryMappedFile.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "memorymappedfile.h"
+
+#include "config.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if HAVE_SYS_MMAN_H
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+bool MemoryMappedFile::isSupported()
+{
+    return HAVE_SYS_MMAN_H;
+}
+
+MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path)
+{
+#if HAVE_SYS_MMAN_H
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        GMX_THROW(FileIOError(formatString(
+                "Could not open file '%s' for mapping: %s", path.u8string().c_str(), std::strerror(errno))));
+    }
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode))
+    {
+        close(fd);
+        GMX_THROW(FileIOError(
+                formatString("File '%s' is not a regular file and can not be mapped",
+                             path.u8string().c_str())));
+    }
+    size_ = fileStatus.st_size;
+    if (size_ > 0)
+    {
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            const int mapError = errno;
+            close(fd);
+            GMX_THROW(FileIOError(formatString(
+                    "Could not map file '%s': %s", path.u8string().c_str(), std::strerror(mapError))));
+        }
+        data_ = static_cast<const unsigned char*>(mapping);
+    }
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+#else
+    GMX_UNUSED_VALUE(path);
+    GMX_THROW(NotImplementedError("Memory mapping of files is not supported on this platform"));
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+#if HAVE_SYS_MMAN_H
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+}
+
+void MemoryMappedFile::adviseSequentialAccess() const
+{
+#if HAVE_SYS_MMAN_H
+    if (data_ != nullptr)
+    {
+        posix_madvise(const_cast<unsigned char*>(data_), size_, POSIX_MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+} // namespace gmx
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::MemoryMappedFile for read-only mapping of files.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_MEMORYMAPPEDFILE_H
+#define GMX_FILEIO_MEMORYMAPPEDFILE_H
+
+#include <cstddef>
+
+#include <filesystem>
+
+#include "gromacs/utility/arrayref.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief Read-only memory mapping of a whole file
+ *
+ * The contents are paged in by the operating system on access, so
+ * reading does not copy the data through stdio buffers. The mapping is
+ * released on destruction.
+ *
+ * Memory mapping is only supported on platforms with POSIX mmap(),
+ * callers should check isSupported() and otherwise use normal file I/O.
+ */
+class MemoryMappedFile
+{
+public:
+    //! Returns whether memory mapping is supported on this platform
+    static bool isSupported();
+
+    /*! \brief Maps the file \p path read-only
+     *
+     * \throws NotImplementedError if memory mapping is not supported.
+     * \throws FileIOError if the file can not be opened or mapped.
+     */
+    explicit MemoryMappedFile(const std::filesystem::path& path);
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    //! Returns the contents of the file
+    ArrayRef<const unsigned char> data() const { return { data_, data_ + size_ }; }
+    //! Returns the size of the file in bytes
+    std::size_t size() const { return size_; }
+
+    //! Hints the operating system that the file will be read sequentially
+    void adviseSequentialAccess() const;
+
+private:
+    //! Start of the mapping, nullptr for an empty file
+    const unsigned char* data_ = nullptr;
+    //! Size of the mapping in bytes
+    std::size_t size_ = 0;
+};
+
+} // namespace gmx
+
+#endif
@@ -42,11 +42,31 @@
 
 #include "gromacs/fileio/checkpoint.h"
 
+#include <filesystem>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/mdrunutility/mdmodulesnotifiers.h"
+#include "gromacs/mdtypes/awh_correlation_history.h"
+#include "gromacs/mdtypes/awh_history.h"
+#include "gromacs/mdtypes/checkpointdata.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/observableshistory.h"
+#include "gromacs/mdtypes/pullhistory.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/textreader.h"
 
 #include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
 
 namespace gmx
 {
@@ -55,6 +75,50 @@ namespace test
 namespace
 {
 
+//! Returns the header contents for writing a checkpoint of \p state at \p step
+CheckpointHeaderContents headerContentsForState(const t_state& state, int64_t step)
+{
+    CheckpointHeaderContents headerContents = {};
+    headerContents.double_prec              = GMX_DOUBLE;
+    headerContents.eIntegrator              = IntegrationAlgorithm::MD;
+    headerContents.step                     = step;
+    headerContents.nnodes                   = 2;
+    headerContents.natoms                   = state.numAtoms();
+    headerContents.flags_state              = state.flags();
+    headerContents.eSwapCoords              = SwapType::No;
+    return headerContents;
+}
+
+//! Writes the checkpoint data of \p state to \p filename, returns the atom block offsets
+std::vector<int64_t> writeCheckpoint(const std::filesystem::path&  filename,
+                                     t_state*                      state,
+                                     int64_t                       step,
+                                     ArrayRef<const int>           blockNumAtoms,
+                                     const CheckpointAwhReference* awhReference)
+{
+    ObservablesHistory observablesHistory;
+    // As in mdrun, there is always a pull history
+    observablesHistory.pullHistory = std::make_unique<PullHistory>();
+    MDModulesNotifiers               notifiers;
+    std::vector<gmx_file_position_t> outputFiles;
+    WriteCheckpointDataHolder        modularSimulatorCheckpointData;
+    t_fileio*                        fp = gmx_fio_open(filename, "w");
+    const std::vector<int64_t>       blockOffsets =
+            write_checkpoint_data(fp,
+                                  headerContentsForState(*state, step),
+                                  false,
+                                  LambdaWeightCalculation::No,
+                                  state,
+                                  &observablesHistory,
+                                  notifiers,
+                                  &outputFiles,
+                                  &modularSimulatorCheckpointData,
+                                  blockNumAtoms,
+                                  awhReference);
+    gmx_fio_close(fp);
+    return blockOffsets;
+}
+
 TEST(Checkpoint, ReadingThrowsWhenValueNotPresent)
 {
     KeyValueTreeObject kvtObject;
@@ -102,6 +166,240 @@ TEST(Checkpoint, KvtRoundTripReal)
     EXPECT_EQ(value, readValue);
 }
 
+//! Sets up \p state with five atoms with coordinates and velocities
+void initStateWithAtoms(t_state* state)
+{
+    const int numAtoms = 5;
+    state->changeNumAtoms(numAtoms);
+    state->setFlags(enumValueToBitMask(StateEntry::Box) | enumValueToBitMask(StateEntry::X)
+                    | enumValueToBitMask(StateEntry::V));
+    for (int a = 0; a < numAtoms; a++)
+    {
+        state->x[a] = { 1.0_real * a, 2.0_real, -0.5_real * a };
+        state->v[a] = { 0.1_real, -0.2_real * a, 0.3_real };
+    }
+}
+
+//! Writes a checkpoint of \p state with the atoms in two blocks, as two ranks would
+void writeCheckpointWithAtomBlocks(const std::filesystem::path& filename,
+                                   t_state*                     state,
+                                   int64_t                      step)
+{
+    /* Two blocks, as written by two ranks with interleaved atoms */
+    const std::vector<int> blockNumAtoms = { 2, 3 };
+    const std::vector<int> block0        = { 3, 0 };
+    const std::vector<int> block1        = { 1, 4, 2 };
+
+    const std::vector<int64_t> blockOffsets =
+            writeCheckpoint(filename, state, step, blockNumAtoms, nullptr);
+    ASSERT_EQ(blockNumAtoms.size(), blockOffsets.size());
+
+    for (size_t b = 0; b < blockOffsets.size(); b++)
+    {
+        const std::vector<int>& atoms = (b == 0 ? block0 : block1);
+        std::vector<RVec>       x;
+        std::vector<RVec>       v;
+        for (const int a : atoms)
+        {
+            x.push_back(state->x[a]);
+            v.push_back(state->v[a]);
+        }
+        write_checkpoint_atom_block(filename, blockOffsets[b], atoms, x, v);
+    }
+}
+
+/*! \brief Loads the checkpoint \p filename into \p state and \p ir, as mdrun -cpi does
+ *
+ * \p state should have the number of atoms and flags of the checkpointed state.
+ * The log output is written to \p logFileName.
+ */
+void loadCheckpointForRestart(const std::filesystem::path& filename,
+                              const std::filesystem::path& logFileName,
+                              t_state*                     state,
+                              t_inputrec*                  ir)
+{
+    ir->eI     = IntegrationAlgorithm::MD;
+    ir->nsteps = 100;
+    t_commrec                cr;
+    ObservablesHistory       observablesHistory;
+    MDModulesNotifiers       notifiers;
+    ReadCheckpointDataHolder modularSimulatorCheckpointData;
+    const ivec               ddCells = { 1, 1, 1 };
+    t_fileio* logFile = gmx_fio_open(logFileName, "w");
+    load_checkpoint(filename,
+                    logFile,
+                    &cr,
+                    ddCells,
+                    ir,
+                    state,
+                    &observablesHistory,
+                    false,
+                    notifiers,
+                    &modularSimulatorCheckpointData,
+                    false);
+    gmx_fio_close(logFile);
+}
+
+TEST(Checkpoint, AtomBlocksRoundTrip)
+{
+    t_state state;
+    initStateWithAtoms(&state);
+
+    TestFileManager fileManager;
+    const auto      filename = fileManager.getTemporaryFilePath("state.cpt");
+    writeCheckpointWithAtomBlocks(filename, &state, 10);
+
+    t_trxframe frame;
+    clear_trxframe(&frame, true);
+    t_fileio* fp = gmx_fio_open(filename, "r");
+    read_checkpoint_trxframe(fp, &frame);
+    gmx_fio_close(fp);
+
+    ASSERT_EQ(state.numAtoms(), frame.natoms);
+    ASSERT_TRUE(frame.bX);
+    ASSERT_TRUE(frame.bV);
+    for (int a = 0; a < state.numAtoms(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(state.x[a][d], frame.x[a][d]);
+            EXPECT_EQ(state.v[a][d], frame.v[a][d]);
+        }
+    }
+    sfree(frame.x);
+    sfree(frame.v);
+}
+
+TEST(Checkpoint, AtomBlocksRestartReconstructsState)
+{
+    t_state state;
+    initStateWithAtoms(&state);
+
+    TestFileManager fileManager;
+    const auto      filename = fileManager.getTemporaryFilePath("state.cpt");
+    writeCheckpointWithAtomBlocks(filename, &state, 10);
+
+    t_state restartState;
+    restartState.changeNumAtoms(state.numAtoms());
+    restartState.setFlags(state.flags());
+    t_inputrec ir;
+    loadCheckpointForRestart(
+            filename, fileManager.getTemporaryFilePath("md.log"), &restartState, &ir);
+
+    EXPECT_EQ(10, ir.init_step);
+    for (int a = 0; a < state.numAtoms(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(state.x[a][d], restartState.x[a][d]);
+            EXPECT_EQ(state.v[a][d], restartState.v[a][d]);
+        }
+    }
+}
+
+//! Sets up \p state with one atom and an AWH history with one bias of \p numPoints points
+void initStateWithAwhHistory(t_state* state, int numPoints)
+{
+    state->changeNumAtoms(1);
+    state->setFlags(enumValueToBitMask(StateEntry::Box) | enumValueToBitMask(StateEntry::X));
+    state->awhHistory = std::make_shared<AwhHistory>();
+    state->awhHistory->bias.resize(1);
+    AwhBiasHistory& bias = state->awhHistory->bias[0];
+    bias.pointState.resize(numPoints, AwhPointStateHistory{});
+    for (int i = 0; i < numPoints; i++)
+    {
+        bias.pointState[i].bias = 0.1 * i;
+    }
+    initCorrelationGridHistory(&bias.forceCorrelationGrid, numPoints, 1, 2);
+}
+
+TEST(Checkpoint, IncrementalAwhHistoryOnlyStoresChangedData)
+{
+    t_state state;
+    initStateWithAwhHistory(&state, 100);
+    AwhBiasHistory& bias = state.awhHistory->bias[0];
+
+    TestFileManager fileManager;
+    const auto      referenceFilename = fileManager.getTemporaryFilePath("state_ref_step10.cpt");
+    const auto      filename          = fileManager.getTemporaryFilePath("state.cpt");
+    writeCheckpoint(referenceFilename, &state, 10, {}, nullptr);
+
+    CheckpointAwhReference reference;
+    reference.step       = 10;
+    reference.fileName   = referenceFilename.filename().string();
+    reference.awhHistory = *state.awhHistory;
+
+    bias.pointState[42].visits_tot                           = 3;
+    bias.forceCorrelationGrid.blockDataBuffer[7].blockLength = 2;
+    writeCheckpoint(filename, &state, 20, {}, &reference);
+
+    EXPECT_LT(std::filesystem::file_size(filename), std::filesystem::file_size(referenceFilename));
+
+    const auto listFilename = fileManager.getTemporaryFilePath("list.txt");
+    FILE*      listFile     = std::fopen(listFilename.string().c_str(), "w");
+    list_checkpoint(filename, listFile);
+    std::fclose(listFile);
+    const std::string listing = TextReader::readFileToString(listFilename.string());
+    EXPECT_NE(std::string::npos, listing.find("AWH reference step = 10"));
+    EXPECT_NE(std::string::npos, listing.find("awh changed points = 1\n"));
+    EXPECT_NE(std::string::npos, listing.find("awh changed points index = 42\n"));
+    EXPECT_NE(std::string::npos, listing.find("awh changed correlation blocks = 1\n"));
+    EXPECT_NE(std::string::npos, listing.find("awh changed correlation blocks index = 7\n"));
+    EXPECT_EQ(std::string::npos, listing.find("WARNING"));
+}
+
+TEST(Checkpoint, IncrementalAwhHistoryRestartReconstructsState)
+{
+    t_state state;
+    initStateWithAwhHistory(&state, 100);
+    AwhBiasHistory& bias = state.awhHistory->bias[0];
+
+    TestFileManager fileManager;
+    const auto      referenceFilename = fileManager.getTemporaryFilePath("state_ref_step10.cpt");
+    const auto      filename          = fileManager.getTemporaryFilePath("state.cpt");
+    writeCheckpoint(referenceFilename, &state, 10, {}, nullptr);
+
+    CheckpointAwhReference reference;
+    reference.step       = 10;
+    reference.fileName   = referenceFilename.filename().string();
+    reference.awhHistory = *state.awhHistory;
+
+    bias.pointState[3].bias                                     = -2.5;
+    bias.pointState[42].visits_tot                              = 3;
+    bias.pointState[99].log_pmfsum                              = 1.5;
+    bias.forceCorrelationGrid.blockDataBuffer[7].blockLength    = 2;
+    bias.forceCorrelationGrid.blockDataBuffer[8].blockSumWeight = 0.5;
+    writeCheckpoint(filename, &state, 20, {}, &reference);
+
+    // Restart from the incremental checkpoint
+    t_state restartState;
+    restartState.changeNumAtoms(state.numAtoms());
+    restartState.setFlags(state.flags());
+    t_inputrec ir;
+    loadCheckpointForRestart(
+            filename, fileManager.getTemporaryFilePath("md.log"), &restartState, &ir);
+
+    EXPECT_EQ(20, ir.init_step);
+    ASSERT_NE(nullptr, restartState.awhHistory);
+    ASSERT_EQ(1U, restartState.awhHistory->bias.size());
+    const AwhBiasHistory& restartBias = restartState.awhHistory->bias[0];
+    ASSERT_EQ(bias.pointState.size(), restartBias.pointState.size());
+    for (size_t i = 0; i < bias.pointState.size(); i++)
+    {
+        EXPECT_EQ(bias.pointState[i].bias, restartBias.pointState[i].bias);
+        EXPECT_EQ(bias.pointState[i].visits_tot, restartBias.pointState[i].visits_tot);
+        EXPECT_EQ(bias.pointState[i].log_pmfsum, restartBias.pointState[i].log_pmfsum);
+    }
+    const auto& blockData        = bias.forceCorrelationGrid.blockDataBuffer;
+    const auto& restartBlockData = restartBias.forceCorrelationGrid.blockDataBuffer;
+    ASSERT_EQ(blockData.size(), restartBlockData.size());
+    for (size_t i = 0; i < blockData.size(); i++)
+    {
+        EXPECT_EQ(blockData[i].blockLength, restartBlockData[i].blockLength);
+        EXPECT_EQ(blockData[i].blockSumWeight, restartBlockData[i].blockSumWeight);
+    }
+}
+
 
 } // namespace
 } // namespace test
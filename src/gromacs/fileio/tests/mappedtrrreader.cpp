@@ -0,0 +1,301 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading TRR files through a memory mapping.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/fileio/mappedtrrreader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/memorymappedfile.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/math/vectypes.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of frames written to the test trajectory
+constexpr int c_numFrames = 5;
+//! Number of atoms in the test trajectory
+constexpr int c_numAtoms = 31;
+
+//! Returns vectors that differ between frames and between the kinds of data in \p kind
+std::vector<RVec> generateVectors(int frame, int kind)
+{
+    std::vector<RVec> vectors(c_numAtoms);
+    for (int i = 0; i < c_numAtoms; i++)
+    {
+        vectors[i] = { 0.1_real * i + kind, -0.2_real * frame, 0.01_real * i * frame - kind };
+    }
+    return vectors;
+}
+
+//! Returns whether \p frame of the test trajectory contains velocities
+bool frameHasVelocities(int frame)
+{
+    return frame % 2 == 0;
+}
+
+class MappedTrrReaderTest : public ::testing::Test
+{
+public:
+    MappedTrrReaderTest() : filename_(fileManager_.getTemporaryFilePath("frames.trr"))
+    {
+        t_fileio* fio = gmx_trr_open(filename_, "w");
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            const auto x = generateVectors(frame, 0);
+            const auto v = generateVectors(frame, 1);
+            const auto f = generateVectors(frame, 2);
+            offsets_.push_back(gmx_fio_ftell(fio));
+            gmx_trr_write_frame(fio,
+                                10 * frame,
+                                0.5 * frame,
+                                0.25 * frame,
+                                box_,
+                                c_numAtoms,
+                                as_rvec_array(x.data()),
+                                frameHasVelocities(frame) ? as_rvec_array(v.data()) : nullptr,
+                                as_rvec_array(f.data()));
+        }
+        gmx_trr_close(fio);
+    }
+
+    //! Checks that \p actual matches the vectors of \p kind in \p frame
+    static void checkVectors(ArrayRef<const RVec> actual, int frame, int kind)
+    {
+        const auto expected = generateVectors(frame, kind);
+        ASSERT_EQ(actual.ssize(), c_numAtoms);
+        for (int i = 0; i < c_numAtoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(expected[i][d], actual[i][d], defaultRealTolerance());
+            }
+        }
+    }
+
+    TestFileManager        fileManager_;
+    std::filesystem::path  filename_;
+    std::vector<gmx_off_t> offsets_;
+    matrix                 box_ = { { 3, 0, 0 }, { 0.5, 4, 0 }, { 0, 0.5, 5 } };
+};
+
+TEST_F(MappedTrrReaderTest, ReadsFramesLikeXdrReading)
+{
+    if (!MemoryMappedFile::isSupported())
+    {
+        GTEST_SKIP() << "Memory mapping is not supported on this platform";
+    }
+    MappedTrrReader reader(filename_);
+    t_fileio*       fio = gmx_trr_open(filename_, "r");
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        EXPECT_EQ(reader.offset(), offsets_[frame]);
+
+        gmx_trr_header_t expectedHeader, header;
+        gmx_bool         bOK;
+        ASSERT_TRUE(gmx_trr_read_frame_header(fio, &expectedHeader, &bOK));
+        ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+        EXPECT_TRUE(bOK);
+        EXPECT_EQ(header.bDouble, expectedHeader.bDouble);
+        EXPECT_EQ(header.box_size, expectedHeader.box_size);
+        EXPECT_EQ(header.x_size, expectedHeader.x_size);
+        EXPECT_EQ(header.v_size, expectedHeader.v_size);
+        EXPECT_EQ(header.f_size, expectedHeader.f_size);
+        EXPECT_EQ(header.natoms, c_numAtoms);
+        EXPECT_EQ(header.step, 10 * frame);
+        EXPECT_REAL_EQ(header.t, expectedHeader.t);
+        EXPECT_REAL_EQ(header.lambda, expectedHeader.lambda);
+
+        std::vector<RVec> expectedX(c_numAtoms), expectedV(c_numAtoms), expectedF(c_numAtoms);
+        std::vector<RVec> x(c_numAtoms), v(c_numAtoms), f(c_numAtoms);
+        matrix            expectedBox, box;
+        ASSERT_TRUE(gmx_trr_read_frame_data(fio,
+                                            &expectedHeader,
+                                            expectedBox,
+                                            as_rvec_array(expectedX.data()),
+                                            as_rvec_array(expectedV.data()),
+                                            as_rvec_array(expectedF.data())));
+        ASSERT_TRUE(reader.readFrameData(
+                header, box, as_rvec_array(x.data()), as_rvec_array(v.data()), as_rvec_array(f.data())));
+        for (int i = 0; i < c_numAtoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_EQ(x[i][d], expectedX[i][d]);
+                EXPECT_EQ(f[i][d], expectedF[i][d]);
+                if (frameHasVelocities(frame))
+                {
+                    EXPECT_EQ(v[i][d], expectedV[i][d]);
+                }
+            }
+        }
+        for (int d = 0; d < DIM; d++)
+        {
+            for (int e = 0; e < DIM; e++)
+            {
+                EXPECT_EQ(box[d][e], expectedBox[d][e]);
+            }
+        }
+    }
+    gmx_trr_close(fio);
+
+    gmx_trr_header_t header;
+    gmx_bool         bOK;
+    EXPECT_FALSE(reader.readFrameHeader(&header, &bOK));
+    EXPECT_TRUE(bOK);
+}
+
+TEST_F(MappedTrrReaderTest, ProvidesViewsAfterSeeking)
+{
+    if (!MemoryMappedFile::isSupported())
+    {
+        GTEST_SKIP() << "Memory mapping is not supported on this platform";
+    }
+    MappedTrrReader reader(filename_);
+    // Read the frames backwards, so each read needs a seek
+    for (int frame = c_numFrames - 1; frame >= 0; frame--)
+    {
+        reader.seek(offsets_[frame]);
+        gmx_trr_header_t header;
+        gmx_bool         bOK;
+        ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+        ASSERT_TRUE(reader.readFrameData(header));
+
+        ASSERT_EQ(reader.box().ssize(), DIM);
+        EXPECT_REAL_EQ(reader.box()[YY][XX], box_[YY][XX]);
+        EXPECT_REAL_EQ(reader.box()[ZZ][ZZ], box_[ZZ][ZZ]);
+        checkVectors(reader.x(), frame, 0);
+        if (frameHasVelocities(frame))
+        {
+            checkVectors(reader.v(), frame, 1);
+        }
+        else
+        {
+            EXPECT_TRUE(reader.v().empty());
+        }
+        checkVectors(reader.f(), frame, 2);
+    }
+}
+
+TEST_F(MappedTrrReaderTest, DetectsIncompleteFrame)
+{
+    if (!MemoryMappedFile::isSupported())
+    {
+        GTEST_SKIP() << "Memory mapping is not supported on this platform";
+    }
+    const auto truncatedFilename = fileManager_.getTemporaryFilePath("truncated.trr");
+    std::filesystem::copy_file(filename_, truncatedFilename);
+    std::filesystem::resize_file(truncatedFilename, offsets_[1] - 4);
+
+    MappedTrrReader  reader(truncatedFilename);
+    gmx_trr_header_t header;
+    gmx_bool         bOK;
+    ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+    EXPECT_FALSE(reader.readFrameData(header));
+}
+
+TEST_F(MappedTrrReaderTest, ReadsFramesAppendedAfterMapping)
+{
+    if (!MemoryMappedFile::isSupported())
+    {
+        GTEST_SKIP() << "Memory mapping is not supported on this platform";
+    }
+    // Start with the first two frames and half of the third frame
+    const auto growingFilename = fileManager_.getTemporaryFilePath("growing.trr");
+
+    std::ifstream           original(filename_, std::ios::binary);
+    const std::vector<char> contents{ std::istreambuf_iterator<char>(original),
+                                      std::istreambuf_iterator<char>() };
+    const gmx_off_t         partialSize = (offsets_[2] + offsets_[3]) / 2;
+    {
+        std::ofstream growing(growingFilename, std::ios::binary);
+        growing.write(contents.data(), partialSize);
+    }
+
+    MappedTrrReader  reader(growingFilename);
+    gmx_trr_header_t header;
+    gmx_bool         bOK;
+    for (int frame = 0; frame < 2; frame++)
+    {
+        ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+        ASSERT_TRUE(reader.readFrameData(header));
+    }
+    ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+    EXPECT_EQ(header.step, 20);
+    EXPECT_FALSE(reader.readFrameData(header));
+
+    // Complete the file, as a running simulation would
+    {
+        std::ofstream growing(growingFilename, std::ios::binary | std::ios::app);
+        growing.write(contents.data() + partialSize, contents.size() - partialSize);
+    }
+
+    // Reading the incomplete frame again now succeeds, as do the following frames
+    reader.seek(offsets_[2]);
+    for (int frame = 2; frame < c_numFrames; frame++)
+    {
+        ASSERT_TRUE(reader.readFrameHeader(&header, &bOK));
+        EXPECT_EQ(header.step, 10 * frame);
+        ASSERT_TRUE(reader.readFrameData(header));
+        checkVectors(reader.x(), frame, 0);
+        checkVectors(reader.f(), frame, 2);
+    }
+    EXPECT_FALSE(reader.readFrameHeader(&header, &bOK));
+    EXPECT_TRUE(bOK);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the section table of TPR files.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/fileio/tpxio.h"
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/topology/topology.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/tprfilegenerator.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Test fixture providing a TPR file written by grompp
+class TpxIOTest : public ::testing::Test
+{
+protected:
+    TpxIOTest() : tprFileHandle_("lysozyme") {}
+
+    //! Storage for opened file handles.
+    TprAndFileManager tprFileHandle_;
+};
+
+TEST_F(TpxIOTest, WritesSectionTable)
+{
+    const TpxFileHeader header = readTpxHeader(tprFileHandle_.tprName(), false);
+
+    EXPECT_GT(header.topologyOffset, 0);
+    EXPECT_LT(header.topologyOffset, header.coordinatesOffset);
+    EXPECT_LT(header.coordinatesOffset, header.inputrecOffset);
+    EXPECT_LT(header.inputrecOffset, header.sizeOfTprBody);
+}
+
+TEST_F(TpxIOTest, ReadsInputrecAndTopologyWithoutState)
+{
+    t_inputrec ir;
+    t_state    state;
+    gmx_mtop_t mtop;
+    read_tpx_state(tprFileHandle_.tprName(), &ir, &state, &mtop);
+
+    t_inputrec irWithoutState;
+    gmx_mtop_t mtopWithoutState;
+    readTpxInputrecAndTopology(tprFileHandle_.tprName(), &irWithoutState, &mtopWithoutState);
+
+    EXPECT_EQ(mtop.natoms, mtopWithoutState.natoms);
+    EXPECT_EQ(mtop.moltype.size(), mtopWithoutState.moltype.size());
+    EXPECT_EQ(mtop.molblock.size(), mtopWithoutState.molblock.size());
+    EXPECT_EQ(ir.nsteps, irWithoutState.nsteps);
+    EXPECT_EQ(ir.pbcType, irWithoutState.pbcType);
+    EXPECT_REAL_EQ(ir.rlist, irWithoutState.rlist);
+}
+
+TEST_F(TpxIOTest, ReadsTopologyWithoutCoordinates)
+{
+    t_inputrec ir;
+    t_state    state;
+    gmx_mtop_t mtop;
+    read_tpx_state(tprFileHandle_.tprName(), &ir, &state, &mtop);
+
+    gmx_mtop_t mtopWithoutCoordinates;
+    matrix     box;
+    int        natoms = 0;
+    PbcType    pbcType =
+            read_tpx(tprFileHandle_.tprName(), nullptr, box, &natoms, nullptr, nullptr, &mtopWithoutCoordinates);
+
+    EXPECT_EQ(ir.pbcType, pbcType);
+    EXPECT_EQ(mtop.natoms, natoms);
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_REAL_EQ(state.box[d][XX], box[d][XX]);
+        EXPECT_REAL_EQ(state.box[d][YY], box[d][YY]);
+        EXPECT_REAL_EQ(state.box[d][ZZ], box[d][ZZ]);
+    }
+}
+
+TEST_F(TpxIOTest, WrittenFileRoundTrips)
+{
+    t_inputrec ir;
+    t_state    state;
+    gmx_mtop_t mtop;
+    read_tpx_state(tprFileHandle_.tprName(), &ir, &state, &mtop);
+
+    TestFileManager   fileManager;
+    const std::string fileName = fileManager.getTemporaryFilePath("rewritten.tpr").u8string();
+    write_tpx_state(fileName, &ir, &state, mtop);
+
+    t_inputrec irAfter;
+    t_state    stateAfter;
+    gmx_mtop_t mtopAfter;
+    read_tpx_state(fileName, &irAfter, &stateAfter, &mtopAfter);
+
+    EXPECT_EQ(ir.nsteps, irAfter.nsteps);
+    EXPECT_EQ(mtop.natoms, mtopAfter.natoms);
+    ASSERT_EQ(state.numAtoms(), stateAfter.numAtoms());
+    for (int i = 0; i < state.numAtoms(); i++)
+    {
+        EXPECT_REAL_EQ(state.x[i][XX], stateAfter.x[i][XX]);
+        EXPECT_REAL_EQ(state.x[i][YY], stateAfter.x[i][YY]);
+        EXPECT_REAL_EQ(state.x[i][ZZ], stateAfter.x[i][ZZ]);
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,223 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the trajectory frame index.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trajectoryframeindex.h"
+
+#include <filesystem>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vectypes.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of frames written to the test trajectories
+constexpr int c_numFrames = 7;
+//! Number of atoms in the test trajectories
+constexpr int c_numAtoms = 23;
+
+//! Returns coordinates that differ between frames
+std::vector<RVec> generateCoordinates(int frame)
+{
+    std::vector<RVec> x(c_numAtoms);
+    for (int i = 0; i < c_numAtoms; i++)
+    {
+        x[i] = { 0.1_real * i, 0.2_real * frame, 0.01_real * i * frame };
+    }
+    return x;
+}
+
+class TrajectoryFrameIndexTest : public ::testing::Test
+{
+public:
+    //! Checks that the index of the trajectory in \p filename matches the written frames
+    void checkIndex(const TrajectoryFrameIndex& index, const std::filesystem::path& filename)
+    {
+        ASSERT_EQ(index.numFrames(), c_numFrames);
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            const auto& entry = index.frames()[frame];
+            EXPECT_EQ(entry.offset, offsets_[frame]);
+            EXPECT_EQ(entry.step, 10 * frame);
+            EXPECT_FLOAT_EQ(entry.time, 0.5 * frame);
+            EXPECT_EQ(entry.natoms, c_numAtoms);
+            EXPECT_EQ(index.frameAtOffset(entry.offset), frame);
+        }
+        EXPECT_EQ(index.indexedSize(), std::filesystem::file_size(filename));
+        EXPECT_EQ(index.frameAtOffset(offsets_[1] + 1), -1);
+    }
+
+    TestFileManager fileManager_;
+    //! Byte offsets of the written frames
+    std::vector<gmx_off_t> offsets_;
+    //! The box written in all frames
+    matrix box_ = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+};
+
+TEST_F(TrajectoryFrameIndexTest, IndexesXtcFrames)
+{
+    const auto filename = fileManager_.getTemporaryFilePath("frames.xtc");
+    t_fileio*  fio      = open_xtc(filename, "w");
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        const auto x = generateCoordinates(frame);
+        offsets_.push_back(gmx_fio_ftell(fio));
+        write_xtc(fio, c_numAtoms, 10 * frame, 0.5 * frame, box_, as_rvec_array(x.data()), 1000);
+    }
+    close_xtc(fio);
+
+    checkIndex(TrajectoryFrameIndex::build(filename), filename);
+}
+
+TEST_F(TrajectoryFrameIndexTest, IndexesTrrFrames)
+{
+    const auto filename = fileManager_.getTemporaryFilePath("frames.trr");
+    t_fileio*  fio      = gmx_trr_open(filename, "w");
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        const auto x = generateCoordinates(frame);
+        offsets_.push_back(gmx_fio_ftell(fio));
+        // Only write velocities in some frames, to vary the frame sizes
+        gmx_trr_write_frame(fio,
+                            10 * frame,
+                            0.5 * frame,
+                            0,
+                            box_,
+                            c_numAtoms,
+                            as_rvec_array(x.data()),
+                            frame % 2 == 0 ? as_rvec_array(x.data()) : nullptr,
+                            nullptr);
+    }
+    gmx_trr_close(fio);
+
+    checkIndex(TrajectoryFrameIndex::build(filename), filename);
+}
+
+TEST_F(TrajectoryFrameIndexTest, SidecarFileRoundTrips)
+{
+    const auto filename = fileManager_.getTemporaryFilePath("sidecar.xtc");
+    t_fileio*  fio      = open_xtc(filename, "w");
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        const auto x = generateCoordinates(frame);
+        offsets_.push_back(gmx_fio_ftell(fio));
+        write_xtc(fio, c_numAtoms, 10 * frame, 0.5 * frame, box_, as_rvec_array(x.data()), 1000);
+    }
+    close_xtc(fio);
+
+    EXPECT_EQ(TrajectoryFrameIndex::read(filename), nullptr);
+    ASSERT_TRUE(TrajectoryFrameIndex::build(filename).write());
+    fileManager_.manageGeneratedOutputFile(TrajectoryFrameIndex::sidecarFileName(filename));
+    const auto index = TrajectoryFrameIndex::read(filename);
+    ASSERT_NE(index, nullptr);
+    checkIndex(*index, filename);
+
+    const auto chunks = index->splitIntoChunks(3);
+    ASSERT_EQ(chunks.size(), 3);
+    EXPECT_EQ(chunks.front().first, 0);
+    EXPECT_EQ(chunks.back().second, c_numFrames);
+    for (size_t c = 1; c < chunks.size(); c++)
+    {
+        EXPECT_EQ(chunks[c].first, chunks[c - 1].second);
+    }
+
+    // Appending to the trajectory makes the index stale
+    fio = open_xtc(filename, "a");
+    write_xtc(fio, c_numAtoms, 0, 0, box_, as_rvec_array(generateCoordinates(0).data()), 1000);
+    close_xtc(fio);
+    EXPECT_EQ(TrajectoryFrameIndex::read(filename), nullptr);
+}
+
+TEST_F(TrajectoryFrameIndexTest, AppendedFramesMatchScannedIndex)
+{
+    const auto filename = fileManager_.getTemporaryFilePath("appended.xtc");
+    fileManager_.manageGeneratedOutputFile(TrajectoryFrameIndex::sidecarFileName(filename));
+
+    // Write the frames in two parts, as in a run that is continued with appending
+    const int numFramesFirstPart = 3;
+    const std::vector<std::tuple<const char*, int, int>> parts = {
+        { "w", 0, numFramesFirstPart }, { "a", numFramesFirstPart, c_numFrames }
+    };
+    for (const auto& [mode, frameBegin, frameEnd] : parts)
+    {
+        TrajectoryFrameIndex index = TrajectoryFrameIndex::forAppending(filename);
+        EXPECT_EQ(index.numFrames(), frameBegin);
+
+        t_fileio* fio = open_xtc(filename, mode);
+        for (int frame = frameBegin; frame < frameEnd; frame++)
+        {
+            const auto x    = generateCoordinates(frame);
+            const real time = 0.5 * frame;
+            write_xtc(fio, c_numAtoms, 10 * frame, time, box_, as_rvec_array(x.data()), 1000);
+            index.appendFrame(10 * frame, time, c_numAtoms, gmx_fio_ftell(fio));
+        }
+        close_xtc(fio);
+
+        ASSERT_TRUE(index.writeForAppendedFrames());
+    }
+
+    // The offsets recorded while writing should match those found by scanning
+    const TrajectoryFrameIndex scannedIndex = TrajectoryFrameIndex::build(filename);
+    for (const auto& frame : scannedIndex.frames())
+    {
+        offsets_.push_back(frame.offset);
+    }
+    const auto index = TrajectoryFrameIndex::read(filename);
+    ASSERT_NE(index, nullptr);
+    checkIndex(*index, filename);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
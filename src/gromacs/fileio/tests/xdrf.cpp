@@ -0,0 +1,166 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading and writing compressed XTC coordinates.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <filesystem>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/xdrf.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Precision used for compressing the coordinates
+constexpr float c_precision = 1000.0F;
+
+/*! \brief Returns coordinates of \p numAtoms atoms in water-like triplets
+ *
+ * Consecutive atoms are close, to exercise the run-length and small-difference
+ * paths of the compression, while the triplets are spread over a 10 nm box.
+ */
+std::vector<float> generateCoordinates(int numAtoms)
+{
+    std::vector<float> x(3 * numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const int molecule = i / 3;
+        for (int d = 0; d < 3; d++)
+        {
+            x[3 * i + d] = std::fmod(0.731F * molecule * (d + 1) + 0.1F * d, 10.0F)
+                           + 0.1F * (i % 3) + 0.0123F * d;
+        }
+    }
+    return x;
+}
+
+class XdrCompressedCoordinatesTest : public ::testing::TestWithParam<std::tuple<int, int>>
+{
+public:
+    //! Writes \p x with \p magicNumber and returns what was read back
+    std::vector<float> writeAndRead(const std::vector<float>& x, int magicNumber, float* precision)
+    {
+        int                numAtoms     = x.size() / 3;
+        float              precisionOut = c_precision;
+        std::vector<float> xOut         = x;
+
+        t_fileio* file = gmx_fio_open(filename_, "w");
+        XDR*      xd   = gmx_fio_getxdr(file);
+        EXPECT_NE(xdr3dfcoord(xd, xOut.data(), &numAtoms, &precisionOut, magicNumber), 0);
+        gmx_fio_close(file);
+
+        std::vector<float> xIn(x.size());
+        int                numAtomsIn = 0;
+        file                          = gmx_fio_open(filename_, "r");
+        xd                            = gmx_fio_getxdr(file);
+        EXPECT_NE(xdr3dfcoord(xd, xIn.data(), &numAtomsIn, precision, magicNumber), 0);
+        gmx_fio_close(file);
+        EXPECT_EQ(numAtomsIn, numAtoms);
+
+        return xIn;
+    }
+
+    TestFileManager fileManager_;
+    //! Name of the file to write to, with an extension gmx_fio_open opens as XDR
+    std::filesystem::path filename_ = fileManager_.getTemporaryFilePath("coordinates.xtc");
+};
+
+TEST_P(XdrCompressedCoordinatesTest, RoundTripsWithinPrecision)
+{
+    const int          numAtoms    = std::get<0>(GetParam());
+    const int          magicNumber = std::get<1>(GetParam());
+    std::vector<float> x           = generateCoordinates(numAtoms);
+
+    float              precision = 0;
+    std::vector<float> xIn       = writeAndRead(x, magicNumber, &precision);
+
+    if (numAtoms <= 9)
+    {
+        // Small sets of coordinates are stored uncompressed
+        EXPECT_EQ(precision, -1);
+        EXPECT_EQ(xIn, x);
+    }
+    else
+    {
+        EXPECT_EQ(precision, c_precision);
+        for (std::size_t i = 0; i < x.size(); i++)
+        {
+            EXPECT_NEAR(xIn[i], x[i], 0.5F / c_precision + 1e-6F) << "coordinate index " << i;
+        }
+    }
+}
+
+TEST_P(XdrCompressedCoordinatesTest, ChunkedFormatReadsIdenticalCoordinates)
+{
+    const int          numAtoms = std::get<0>(GetParam());
+    std::vector<float> x        = generateCoordinates(numAtoms);
+
+    float precision = 0;
+    // The chunked format uses the same quantization as the plain format,
+    // so decompressing should give bit-identical coordinates.
+    std::vector<float> xPlain   = writeAndRead(x, XTC_MAGIC, &precision);
+    std::vector<float> xChunked = writeAndRead(x, XTC_CHUNKED_MAGIC, &precision);
+    EXPECT_EQ(xChunked, xPlain);
+}
+
+// The largest size is split into several blocks in the chunked format
+INSTANTIATE_TEST_SUITE_P(WithDifferentSizesAndFormats,
+                         XdrCompressedCoordinatesTest,
+                         ::testing::Combine(::testing::Values(5, 10, 1000, 70001),
+                                            ::testing::Values(XTC_MAGIC,
+                                                              XTC_NEW_MAGIC,
+                                                              XTC_CHUNKED_MAGIC)));
+
+} // namespace
+} // namespace test
+} // namespace gmx
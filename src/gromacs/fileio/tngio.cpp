@@ -57,6 +57,7 @@
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/baseversion.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -896,7 +897,8 @@ void gmx_fwrite_tng(gmx_tng_trajectory_t gmx_tng,
                        compression)
             != TNG_SUCCESS)
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            GMX_THROW(gmx::FileIOError(
+                    "Cannot write TNG trajectory frame; maybe you are out of disk space?"));
         }
     }
 
@@ -913,7 +915,8 @@ void gmx_fwrite_tng(gmx_tng_trajectory_t gmx_tng,
                        compression)
             != TNG_SUCCESS)
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            GMX_THROW(gmx::FileIOError(
+                    "Cannot write TNG trajectory frame; maybe you are out of disk space?"));
         }
     }
 
@@ -932,7 +935,8 @@ void gmx_fwrite_tng(gmx_tng_trajectory_t gmx_tng,
                        TNG_GZIP_COMPRESSION)
             != TNG_SUCCESS)
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            GMX_THROW(gmx::FileIOError(
+                    "Cannot write TNG trajectory frame; maybe you are out of disk space?"));
         }
     }
 
@@ -951,7 +955,8 @@ void gmx_fwrite_tng(gmx_tng_trajectory_t gmx_tng,
                        TNG_GZIP_COMPRESSION)
             != TNG_SUCCESS)
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            GMX_THROW(gmx::FileIOError(
+                    "Cannot write TNG trajectory frame; maybe you are out of disk space?"));
         }
     }
 
@@ -970,7 +975,8 @@ void gmx_fwrite_tng(gmx_tng_trajectory_t gmx_tng,
                        TNG_GZIP_COMPRESSION)
             != TNG_SUCCESS)
         {
-            gmx_file("Cannot write TNG trajectory frame; maybe you are out of disk space?");
+            GMX_THROW(gmx::FileIOError(
+                    "Cannot write TNG trajectory frame; maybe you are out of disk space?"));
         }
     }
 
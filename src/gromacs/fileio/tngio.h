@@ -113,7 +113,9 @@ void gmx_tng_prepare_low_prec_writing(gmx_tng_trajectory_t tng, const gmx_mtop_t
  * \param f                    Vector of forces
  *
  * The pointers tng, x, v, f may be NULL, which triggers not writing
- * (that component). box can only be NULL if x is also NULL. */
+ * (that component). box can only be NULL if x is also NULL.
+ *
+ * \throws FileIOError when the data can not be written. */
 void gmx_fwrite_tng(gmx_tng_trajectory_t tng,
                     gmx_bool             bUseLossyCompression,
                     int64_t              step,
@@ -47,6 +47,7 @@
 #include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/memorymappedfile.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
@@ -68,6 +69,7 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/baseversion.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -143,6 +145,7 @@ enum tpxv
     tpxv_MassRepartitioning,          /**< Add mass repartitioning */
     tpxv_AwhTargetMetricScaling,      /**< Add AWH friction optimized target distribution */
     tpxv_VerletBufferPressureTol,     /**< Add Verlet buffer pressure tolerance */
+    tpxv_BodySectionTable,            /**< Add offsets of the sections in the tpr body */
     tpxv_Count                        /**< the total number of tpxv versions */
 };
 
@@ -2742,12 +2745,14 @@ static void do_mtop(gmx::ISerializer* serializer, gmx_mtop_t* mtop, int file_ver
  * \param[in]     filename The name of the file being read/written
  * \param[in,out] fio File handle.
  * \param[in] TopOnlyOK If not reading \p ir is fine or not.
+ * \param[in] reportReading Whether to print the file name and version to stderr when reading.
  */
 static void do_tpxheader(gmx::FileIOXdrSerializer*    serializer,
                          TpxFileHeader*               tpx,
                          const std::filesystem::path& filename,
                          t_fileio*                    fio,
-                         bool                         TopOnlyOK)
+                         bool                         TopOnlyOK,
+                         bool                         reportReading = true)
 {
     int  precision;
     int  idum = 0;
@@ -2787,11 +2792,14 @@ static void do_tpxheader(gmx::FileIOXdrSerializer*    serializer,
                       sizeof(double));
         }
         gmx_fio_setprecision(fio, tpx->isDouble);
-        fprintf(stderr,
-                "Reading file %s, %s (%s precision)\n",
-                filename.u8string().c_str(),
-                buf.c_str(),
-                tpx->isDouble ? "double" : "single");
+        if (reportReading)
+        {
+            fprintf(stderr,
+                    "Reading file %s, %s (%s precision)\n",
+                    filename.u8string().c_str(),
+                    buf.c_str(),
+                    tpx->isDouble ? "double" : "single");
+        }
     }
     else
     {
@@ -2890,6 +2898,12 @@ static void do_tpxheader(gmx::FileIOXdrSerializer*    serializer,
         }
         serializer->doInt64(&tpx->sizeOfTprBody);
     }
+    if (tpx->fileVersion >= tpxv_BodySectionTable)
+    {
+        serializer->doInt64(&tpx->topologyOffset);
+        serializer->doInt64(&tpx->coordinatesOffset);
+        serializer->doInt64(&tpx->inputrecOffset);
+    }
 
     if ((tpx->fileGeneration > tpx_generation))
     {
@@ -3296,69 +3310,208 @@ static void doTpxBodyBuffer(gmx::ISerializer* serializer, gmx::ArrayRef<char> bu
     serializer->doOpaque(buffer.data(), buffer.size());
 }
 
+/*! \brief
+ * Serializes the TPR body together with its section table.
+ *
+ * The sections are serialized separately in the order documented for
+ * do_tpx_body and then concatenated, so that the body is identical to
+ * one serialized in a single pass. The offsets of the sections are
+ * stored in \p tpx so that readers can skip the sections they do not need.
+ *
+ * \param[in,out] tpx The file header, the section table and body size are set.
+ * \param[in] ir Datastructures with simulation parameters.
+ * \param[in] state Global state data.
+ * \param[in] mtop Global topology.
+ * \returns The serialized TPR body.
+ */
+static std::vector<char> serializeTpxBody(TpxFileHeader* tpx, t_inputrec* ir, t_state* state, gmx_mtop_t* mtop)
+{
+    // Long-term we should move to use little endian in files to avoid extra byte swapping,
+    // but since we just used the default XDR format (which is big endian) for the TPR
+    // header it would cause third-party libraries reading our raw data to tear their hair
+    // if we swap the endian in the middle of the file, so we stick to big endian in the
+    // TPR file for now - and thus we ask the serializer to swap if this host is little endian.
+    gmx::InMemorySerializer stateSerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_state_first(&stateSerializer, tpx, state);
+    gmx::InMemorySerializer topologySerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_mtop(&topologySerializer, tpx, mtop);
+    gmx::InMemorySerializer coordinatesSerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_state_second(&coordinatesSerializer, tpx, state, nullptr, nullptr);
+    gmx::InMemorySerializer inputrecSerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_ir(&inputrecSerializer, tpx, ir);
+
+    std::vector<char> body          = stateSerializer.finishAndGetBuffer();
+    const auto        appendSection = [&body](gmx::InMemorySerializer* sectionSerializer)
+    {
+        const std::vector<char> section = sectionSerializer->finishAndGetBuffer();
+        body.insert(body.end(), section.begin(), section.end());
+    };
+    tpx->topologyOffset = body.size();
+    appendSection(&topologySerializer);
+    tpx->coordinatesOffset = body.size();
+    appendSection(&coordinatesSerializer);
+    tpx->inputrecOffset = body.size();
+    appendSection(&inputrecSerializer);
+    tpx->sizeOfTprBody = body.size();
+
+    return body;
+}
+
+//! Returns whether the TPR body described by \p tpx has a section table.
+static bool hasTpxBodySectionTable(const TpxFileHeader& tpx)
+{
+    return tpx.inputrecOffset > 0;
+}
+
+/*! \brief
+ * Deserializes the TPR body in \p body into the simulation datastructures.
+ *
+ * When the header \p tpx contains a section table, each section is
+ * deserialized from its own part of \p body and sections that are not
+ * needed are skipped: the topology when \p mtop is nullptr and the
+ * coordinates when \p readCoordinates is false. As the body is usually
+ * memory mapped, skipped sections are then never read from disk.
+ * Without a section table the whole body is deserialized in order.
+ *
+ * \param[in] body The serialized TPR body.
+ * \param[in] tpx The file header.
+ * \param[out] ir Input rec to populate.
+ * \param[out] state State vectors to populate, or nullptr.
+ * \param[out] x Coordinates to populate if needed.
+ * \param[out] v Velocities to populate if needed.
+ * \param[out] mtop Global topology to populate, or nullptr.
+ * \param[in] readCoordinates Whether the coordinate section is needed.
+ * \returns PBC flag.
+ */
+static PbcType deserializeTpxBody(gmx::ArrayRef<const char> body,
+                                  TpxFileHeader*            tpx,
+                                  t_inputrec*               ir,
+                                  t_state*                  state,
+                                  rvec*                     x,
+                                  rvec*                     v,
+                                  gmx_mtop_t*               mtop,
+                                  bool                      readCoordinates)
+{
+    // The body is big endian, see serializeTpxBody().
+    constexpr gmx::EndianSwapBehavior endianSwap = gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian;
+
+    if (!hasTpxBodySectionTable(*tpx))
+    {
+        gmx::InMemoryDeserializer tprBodyDeserializer(body, tpx->isDouble, endianSwap);
+        return do_tpx_body(&tprBodyDeserializer, tpx, ir, state, x, v, mtop);
+    }
+
+    if (!(0 <= tpx->topologyOffset && tpx->topologyOffset <= tpx->coordinatesOffset && tpx->coordinatesOffset <= tpx->inputrecOffset
+          && tpx->inputrecOffset <= gmx::ssize(body)))
+    {
+        gmx_fatal(FARGS, "The section table of the tpr file is inconsistent, the file is corrupted");
+    }
+    if (state)
+    {
+        gmx::InMemoryDeserializer stateDeserializer(
+                body.subArray(0, tpx->topologyOffset), tpx->isDouble, endianSwap);
+        do_tpx_state_first(&stateDeserializer, tpx, state);
+    }
+    if (mtop)
+    {
+        gmx::InMemoryDeserializer topologyDeserializer(
+                body.subArray(tpx->topologyOffset, tpx->coordinatesOffset - tpx->topologyOffset),
+                tpx->isDouble,
+                endianSwap);
+        do_tpx_mtop(&topologyDeserializer, tpx, mtop);
+    }
+    if (state && readCoordinates)
+    {
+        gmx::InMemoryDeserializer coordinatesDeserializer(
+                body.subArray(tpx->coordinatesOffset, tpx->inputrecOffset - tpx->coordinatesOffset),
+                tpx->isDouble,
+                endianSwap);
+        do_tpx_state_second(&coordinatesDeserializer, tpx, state, x, v);
+    }
+    gmx::InMemoryDeserializer inputrecDeserializer(
+            body.subArray(tpx->inputrecOffset, body.size() - tpx->inputrecOffset), tpx->isDouble, endianSwap);
+    PbcType pbcType = do_tpx_ir(&inputrecDeserializer, tpx, ir);
+    do_tpx_finalize(tpx, ir, state, mtop);
+
+    return pbcType;
+}
+
+/*! \brief
+ * Returns a read-only memory mapping of the TPR file \p fn.
+ *
+ * Returns nullptr when memory mapping is not supported, is disabled
+ * with GMX_TPR_NO_MMAP, or fails. The body is then read with normal
+ * file I/O instead.
+ */
+static std::unique_ptr<gmx::MemoryMappedFile> mapTprFile(const std::filesystem::path& fn)
+{
+    if (!gmx::MemoryMappedFile::isSupported() || std::getenv("GMX_TPR_NO_MMAP") != nullptr)
+    {
+        return nullptr;
+    }
+    try
+    {
+        return std::make_unique<gmx::MemoryMappedFile>(fn);
+    }
+    catch (const gmx::FileIOError&)
+    {
+        return nullptr;
+    }
+}
+
 /*! \brief
  * Populates simulation datastructures.
  *
  * Here the information from the serialization interface \p serializer
- * is used to first populate the datastructures containing the simulation
+ * is used to populate the datastructures containing the simulation
  * information. Depending on the version found in the header \p tpx,
- * this is done using the new reading of the data as one block from disk,
- * followed by complete deserialization of the information read from there.
- * Otherwise, the datastructures are populated as before one by one from disk.
- * The second version is the default for the legacy tools that read the
- * coordinates and velocities separate from the state.
- *
- * After reading in the data, a separate buffer is populated from them
- * containing only \p ir and \p mtop that can be communicated directly
- * to nodes needing the information to set up a simulation.
+ * this is done by deserializing the body as one block, which is accessed
+ * through a memory mapping of the file when possible and otherwise read
+ * from disk in one go. For older files, the datastructures are populated
+ * as before one by one from disk.
  *
  * \param[in] tpx The file header.
+ * \param[in] fio The file handle, positioned at the start of the body.
  * \param[in] serializer The Serialization interface used to read the TPR.
  * \param[out] ir Input rec to populate.
  * \param[out] state State vectors to populate.
  * \param[out] x Coordinates to populate if needed.
  * \param[out] v Velocities to populate if needed.
  * \param[out] mtop Global topology to populate.
+ * \param[in] readCoordinates Whether the coordinates are needed, see deserializeTpxBody().
  *
- * \returns Partial de-serialized TPR used for communication to nodes.
+ * \returns PBC flag.
  */
-static PartialDeserializedTprFile readTpxBody(TpxFileHeader*    tpx,
-                                              gmx::ISerializer* serializer,
-                                              t_inputrec*       ir,
-                                              t_state*          state,
-                                              rvec*             x,
-                                              rvec*             v,
-                                              gmx_mtop_t*       mtop)
+static PbcType readTpxBody(TpxFileHeader*    tpx,
+                           t_fileio*         fio,
+                           gmx::ISerializer* serializer,
+                           t_inputrec*       ir,
+                           t_state*          state,
+                           rvec*             x,
+                           rvec*             v,
+                           gmx_mtop_t*       mtop,
+                           bool              readCoordinates)
 {
-    PartialDeserializedTprFile partialDeserializedTpr;
     if (tpx->fileVersion >= tpxv_AddSizeField && tpx->fileGeneration >= 27)
     {
-        partialDeserializedTpr.body.resize(tpx->sizeOfTprBody);
-        partialDeserializedTpr.header = *tpx;
-        doTpxBodyBuffer(serializer, partialDeserializedTpr.body);
+        const gmx_off_t                        bodyOffset = gmx_fio_ftell(fio);
+        std::unique_ptr<gmx::MemoryMappedFile> mappedTpr  = mapTprFile(gmx_fio_getname(fio));
+        if (mappedTpr && bodyOffset >= 0
+            && static_cast<std::size_t>(bodyOffset + tpx->sizeOfTprBody) <= mappedTpr->size())
+        {
+            const char* bodyBegin = reinterpret_cast<const char*>(mappedTpr->data().data()) + bodyOffset;
+            return deserializeTpxBody(
+                    { bodyBegin, bodyBegin + tpx->sizeOfTprBody }, tpx, ir, state, x, v, mtop, readCoordinates);
+        }
 
-        partialDeserializedTpr.pbcType =
-                completeTprDeserialization(&partialDeserializedTpr, ir, state, x, v, mtop);
+        std::vector<char> body(tpx->sizeOfTprBody);
+        doTpxBodyBuffer(serializer, body);
+        return deserializeTpxBody(body, tpx, ir, state, x, v, mtop, readCoordinates);
     }
     else
     {
-        partialDeserializedTpr.pbcType = do_tpx_body(serializer, tpx, ir, state, x, v, mtop);
+        return do_tpx_body(serializer, tpx, ir, state, x, v, mtop);
     }
-    // Update header to system info for communication to nodes.
-    // As we only need to communicate the inputrec and mtop to other nodes,
-    // we prepare a new char buffer with the information we have already read
-    // in on main.
-    partialDeserializedTpr.header = populateTpxHeader(*state, ir, mtop);
-    // Long-term we should move to use little endian in files to avoid extra byte swapping,
-    // but since we just used the default XDR format (which is big endian) for the TPR
-    // header it would cause third-party libraries reading our raw data to tear their hair
-    // if we swap the endian in the middle of the file, so we stick to big endian in the
-    // TPR file for now - and thus we ask the serializer to swap if this host is little endian.
-    gmx::InMemorySerializer tprBodySerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
-    do_tpx_body(&tprBodySerializer, &partialDeserializedTpr.header, ir, mtop);
-    partialDeserializedTpr.body = tprBodySerializer.finishAndGetBuffer();
-
-    return partialDeserializedTpr;
 }
 
 /************************************************************
@@ -3393,24 +3546,11 @@ void write_tpx_state(const std::filesystem::path& fn,
 
     t_fileio* fio;
 
-    TpxFileHeader tpx = populateTpxHeader(*state, ir, &mtop);
-    // Long-term we should move to use little endian in files to avoid extra byte swapping,
-    // but since we just used the default XDR format (which is big endian) for the TPR
-    // header it would cause third-party libraries reading our raw data to tear their hair
-    // if we swap the endian in the middle of the file, so we stick to big endian in the
-    // TPR file for now - and thus we ask the serializer to swap if this host is little endian.
-    gmx::InMemorySerializer tprBodySerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
-
-    do_tpx_body(&tprBodySerializer,
-                &tpx,
-                const_cast<t_inputrec*>(ir),
-                const_cast<t_state*>(state),
-                nullptr,
-                nullptr,
-                const_cast<gmx_mtop_t*>(&mtop));
-
-    std::vector<char> tprBody = tprBodySerializer.finishAndGetBuffer();
-    tpx.sizeOfTprBody         = tprBody.size();
+    TpxFileHeader     tpx     = populateTpxHeader(*state, ir, &mtop);
+    std::vector<char> tprBody = serializeTpxBody(&tpx,
+                                                 const_cast<t_inputrec*>(ir),
+                                                 const_cast<t_state*>(state),
+                                                 const_cast<gmx_mtop_t*>(&mtop));
 
     fio = open_tpx(fn, "w");
     gmx::FileIOXdrSerializer serializer(fio);
@@ -3427,15 +3567,8 @@ PbcType completeTprDeserialization(PartialDeserializedTprFile* partialDeserializ
                                    rvec*                       v,
                                    gmx_mtop_t*                 mtop)
 {
-    // Long-term we should move to use little endian in files to avoid extra byte swapping,
-    // but since we just used the default XDR format (which is big endian) for the TPR
-    // header it would cause third-party libraries reading our raw data to tear their hair
-    // if we swap the endian in the middle of the file, so we stick to big endian in the
-    // TPR file for now - and thus we ask the serializer to swap if this host is little endian.
-    gmx::InMemoryDeserializer tprBodyDeserializer(partialDeserializedTpr->body,
-                                                  partialDeserializedTpr->header.isDouble,
-                                                  gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
-    return do_tpx_body(&tprBodyDeserializer, &partialDeserializedTpr->header, ir, state, x, v, mtop);
+    return deserializeTpxBody(
+            partialDeserializedTpr->body, &partialDeserializedTpr->header, ir, state, x, v, mtop, true);
 }
 
 PbcType completeTprDeserialization(PartialDeserializedTprFile* partialDeserializedTpr,
@@ -3453,12 +3586,36 @@ read_tpx_state(const std::filesystem::path& fn, t_inputrec* ir, t_state* state,
     gmx::FileIOXdrSerializer   serializer(fio);
     PartialDeserializedTprFile partialDeserializedTpr;
     do_tpxheader(&serializer, &partialDeserializedTpr.header, fn, fio, ir == nullptr);
-    partialDeserializedTpr =
-            readTpxBody(&partialDeserializedTpr.header, &serializer, ir, state, nullptr, nullptr, mtop);
+    partialDeserializedTpr.pbcType = readTpxBody(
+            &partialDeserializedTpr.header, fio, &serializer, ir, state, nullptr, nullptr, mtop, true);
     close_tpx(fio);
+
+    // Update header to system info for communication to nodes.
+    // As we only need to communicate the inputrec and mtop to other nodes,
+    // we prepare a new char buffer with the information we have already read
+    // in on main.
+    partialDeserializedTpr.header = populateTpxHeader(*state, ir, mtop);
+    // The body is big endian, see serializeTpxBody().
+    gmx::InMemorySerializer tprBodySerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_body(&tprBodySerializer, &partialDeserializedTpr.header, ir, mtop);
+    partialDeserializedTpr.body = tprBodySerializer.finishAndGetBuffer();
+
     return partialDeserializedTpr;
 }
 
+void readTpxInputrecAndTopology(const std::filesystem::path& fn, t_inputrec* ir, gmx_mtop_t* mtop)
+{
+    // The state is only needed to deserialize files without section table,
+    // where the body has to be read in order.
+    t_state   state;
+    t_fileio* fio = open_tpx(fn, "r");
+    gmx::FileIOXdrSerializer serializer(fio);
+    TpxFileHeader            tpx;
+    do_tpxheader(&serializer, &tpx, fn, fio, false, false);
+    readTpxBody(&tpx, fio, &serializer, ir, &state, nullptr, nullptr, mtop, false);
+    close_tpx(fio);
+}
+
 PbcType read_tpx(const std::filesystem::path& fn, t_inputrec* ir, matrix box, int* natoms, rvec* x, rvec* v, gmx_mtop_t* mtop)
 {
     t_fileio* fio;
@@ -3468,8 +3625,7 @@ PbcType read_tpx(const std::filesystem::path& fn, t_inputrec* ir, matrix box, in
     fio = open_tpx(fn, "r");
     gmx::FileIOXdrSerializer serializer(fio);
     do_tpxheader(&serializer, &tpx, fn, fio, ir == nullptr);
-    PartialDeserializedTprFile partialDeserializedTpr =
-            readTpxBody(&tpx, &serializer, ir, &state, x, v, mtop);
+    PbcType pbcType = readTpxBody(&tpx, fio, &serializer, ir, &state, x, v, mtop, x != nullptr || v != nullptr);
     close_tpx(fio);
     if (mtop != nullptr && natoms != nullptr)
     {
@@ -3479,7 +3635,7 @@ PbcType read_tpx(const std::filesystem::path& fn, t_inputrec* ir, matrix box, in
     {
         copy_mat(state.box, box);
     }
-    return partialDeserializedTpr.pbcType;
+    return pbcType;
 }
 
 PbcType read_tpx_top(const std::filesystem::path& fn,
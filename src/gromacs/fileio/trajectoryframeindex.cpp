@@ -0,0 +1,370 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the index of the frames in XTC and TRR trajectories.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "trajectoryframeindex.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <system_error>
+#include <tuple>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number at the start of frame index files
+constexpr int c_frameIndexMagic = 0x58444e49;
+//! Version of the frame index file format
+constexpr int c_frameIndexVersion = 1;
+
+/*! \brief Returns the size and the modification time of \p file
+ *
+ * \throws FileIOError if the file can not be accessed.
+ */
+std::pair<gmx_off_t, int64_t> sizeAndModificationTime(const std::filesystem::path& file)
+{
+    std::error_code sizeError;
+    std::error_code timeError;
+    const auto      size = std::filesystem::file_size(file, sizeError);
+    const auto      time = std::filesystem::last_write_time(file, timeError);
+    if (sizeError || timeError)
+    {
+        GMX_THROW(FileIOError(formatString("Could not access trajectory file %s",
+                                           file.u8string().c_str())));
+    }
+    return { static_cast<gmx_off_t>(size), static_cast<int64_t>(time.time_since_epoch().count()) };
+}
+
+//! Reads or writes the frame index contents, returns false on error
+bool serializeFrameIndex(XDR*                                    xd,
+                         gmx_off_t*                              trajectorySize,
+                         int64_t*                                trajectoryModificationTime,
+                         gmx_off_t*                              indexedSize,
+                         std::vector<TrajectoryFrameIndexEntry>* frames)
+{
+    const bool bRead   = (xd->x_op == XDR_DECODE);
+    int        magic   = c_frameIndexMagic;
+    int        version = c_frameIndexVersion;
+    if (xdr_int(xd, &magic) == 0 || magic != c_frameIndexMagic || xdr_int(xd, &version) == 0
+        || version != c_frameIndexVersion)
+    {
+        return false;
+    }
+    int64_t numFrames = frames->size();
+    if (xdr_int64(xd, trajectorySize) == 0 || xdr_int64(xd, trajectoryModificationTime) == 0
+        || xdr_int64(xd, indexedSize) == 0 || xdr_int64(xd, &numFrames) == 0)
+    {
+        return false;
+    }
+    if (bRead)
+    {
+        // Each frame takes at least the 16 bytes of an XTC header
+        if (numFrames < 0 || *indexedSize > *trajectorySize || numFrames > *indexedSize / 16)
+        {
+            return false;
+        }
+        frames->resize(numFrames);
+    }
+    for (TrajectoryFrameIndexEntry& frame : *frames)
+    {
+        if (xdr_int64(xd, &frame.offset) == 0 || xdr_int64(xd, &frame.step) == 0
+            || xdr_double(xd, &frame.time) == 0 || xdr_int(xd, &frame.natoms) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TrajectoryFrameIndex TrajectoryFrameIndex::build(const std::filesystem::path& trajectoryFile)
+{
+    const int ftp = fn2ftp(trajectoryFile);
+    if (ftp != efXTC && ftp != efTRR)
+    {
+        GMX_THROW(InvalidInputError(formatString("Can only index XTC and TRR trajectories, not %s",
+                                                 trajectoryFile.u8string().c_str())));
+    }
+
+    TrajectoryFrameIndex index;
+    index.trajectoryFile_ = trajectoryFile;
+    std::tie(index.trajectorySize_, index.trajectoryModificationTime_) =
+            sizeAndModificationTime(trajectoryFile);
+
+    t_fileio* fio = gmx_fio_open(trajectoryFile, "r");
+    while (true)
+    {
+        TrajectoryFrameIndexEntry frame;
+        gmx_bool                  bOK;
+
+        frame.offset = gmx_fio_ftell(fio);
+        if (ftp == efXTC)
+        {
+            real time;
+            if (!skip_next_xtc(fio, &frame.natoms, &frame.step, &time, &bOK))
+            {
+                break;
+            }
+            frame.time = time;
+        }
+        else
+        {
+            gmx_trr_header_t header;
+            if (!gmx_trr_read_frame_header(fio, &header, &bOK))
+            {
+                break;
+            }
+            frame.natoms = header.natoms;
+            frame.step   = header.step;
+            frame.time   = header.t;
+            // The header contains the sizes in bytes of all data blocks in the frame
+            const gmx_off_t dataSize = static_cast<gmx_off_t>(header.box_size) + header.vir_size
+                                       + header.pres_size + header.x_size + header.v_size
+                                       + header.f_size;
+            if (gmx_fio_seek(fio, gmx_fio_ftell(fio) + dataSize) != 0)
+            {
+                break;
+            }
+        }
+        // Seeking does not detect the end of the file, so check for an incomplete frame
+        const gmx_off_t frameEnd = gmx_fio_ftell(fio);
+        if (frameEnd > index.trajectorySize_)
+        {
+            break;
+        }
+        index.frames_.push_back(frame);
+        index.indexedSize_ = frameEnd;
+    }
+    gmx_fio_close(fio);
+
+    return index;
+}
+
+std::unique_ptr<TrajectoryFrameIndex>
+TrajectoryFrameIndex::read(const std::filesystem::path& trajectoryFile)
+{
+    const std::filesystem::path sidecar = sidecarFileName(trajectoryFile);
+    std::error_code             error;
+    if (!std::filesystem::exists(sidecar, error))
+    {
+        return nullptr;
+    }
+    FILE* fp = std::fopen(sidecar.u8string().c_str(), "rb");
+    if (fp == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<TrajectoryFrameIndex> index(new TrajectoryFrameIndex);
+    index->trajectoryFile_ = trajectoryFile;
+
+    XDR xd;
+    xdrstdio_create(&xd, fp, XDR_DECODE);
+    const bool readOK = serializeFrameIndex(&xd,
+                                            &index->trajectorySize_,
+                                            &index->trajectoryModificationTime_,
+                                            &index->indexedSize_,
+                                            &index->frames_);
+    xdr_destroy(&xd);
+    std::fclose(fp);
+
+    // Only use the index when the trajectory has not been modified since indexing
+    if (!readOK
+        || std::make_pair(index->trajectorySize_, index->trajectoryModificationTime_)
+                   != sizeAndModificationTime(trajectoryFile))
+    {
+        return nullptr;
+    }
+
+    return index;
+}
+
+std::unique_ptr<TrajectoryFrameIndex>
+TrajectoryFrameIndex::readOrBuild(const std::filesystem::path& trajectoryFile)
+{
+    std::unique_ptr<TrajectoryFrameIndex> index = read(trajectoryFile);
+    if (index == nullptr && isRequested())
+    {
+        index.reset(new TrajectoryFrameIndex(build(trajectoryFile)));
+        index->write();
+    }
+    return index;
+}
+
+TrajectoryFrameIndex TrajectoryFrameIndex::forAppending(const std::filesystem::path& trajectoryFile)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(trajectoryFile, error)
+        || std::filesystem::is_empty(trajectoryFile, error))
+    {
+        TrajectoryFrameIndex index;
+        index.trajectoryFile_ = trajectoryFile;
+        return index;
+    }
+    std::unique_ptr<TrajectoryFrameIndex> index = read(trajectoryFile);
+    if (index != nullptr)
+    {
+        return std::move(*index);
+    }
+    return build(trajectoryFile);
+}
+
+bool TrajectoryFrameIndex::isRequested()
+{
+    return std::getenv("GMX_TRAJECTORY_INDEX") != nullptr;
+}
+
+std::filesystem::path
+TrajectoryFrameIndex::sidecarFileName(const std::filesystem::path& trajectoryFile)
+{
+    std::filesystem::path sidecar = trajectoryFile;
+    sidecar += ".gmxidx";
+    return sidecar;
+}
+
+bool TrajectoryFrameIndex::write() const
+{
+    const std::filesystem::path sidecar = sidecarFileName(trajectoryFile_);
+    // Write to a temporary file first, so readers never see a partial index
+    std::filesystem::path temporary = sidecar;
+    temporary += ".tmp";
+    FILE* fp = std::fopen(temporary.u8string().c_str(), "wb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    gmx_off_t trajectorySize             = trajectorySize_;
+    int64_t   trajectoryModificationTime = trajectoryModificationTime_;
+    gmx_off_t indexedSize                = indexedSize_;
+    // Writing does not modify the frames
+    auto* frames = const_cast<std::vector<TrajectoryFrameIndexEntry>*>(&frames_);
+
+    XDR xd;
+    xdrstdio_create(&xd, fp, XDR_ENCODE);
+    bool writeOK = serializeFrameIndex(
+            &xd, &trajectorySize, &trajectoryModificationTime, &indexedSize, frames);
+    xdr_destroy(&xd);
+    writeOK = (std::fclose(fp) == 0) && writeOK;
+
+    std::error_code error;
+    if (writeOK)
+    {
+        std::filesystem::rename(temporary, sidecar, error);
+    }
+    if (!writeOK || error)
+    {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+void TrajectoryFrameIndex::appendFrame(const int64_t   step,
+                                       const double    time,
+                                       const int       natoms,
+                                       const gmx_off_t frameEnd)
+{
+    GMX_ASSERT(frameEnd > indexedSize_, "Frames should be appended after the indexed frames");
+
+    frames_.push_back({ indexedSize_, step, time, natoms });
+    indexedSize_ = frameEnd;
+}
+
+bool TrajectoryFrameIndex::writeForAppendedFrames()
+{
+    try
+    {
+        std::tie(trajectorySize_, trajectoryModificationTime_) =
+                sizeAndModificationTime(trajectoryFile_);
+    }
+    catch (const FileIOError&)
+    {
+        return false;
+    }
+    // Anything else than complete frames in the file makes the index invalid
+    if (trajectorySize_ != indexedSize_)
+    {
+        return false;
+    }
+    return write();
+}
+
+int64_t TrajectoryFrameIndex::frameAtOffset(gmx_off_t offset) const
+{
+    const auto startsBefore = [](const TrajectoryFrameIndexEntry& frame, gmx_off_t value) {
+        return frame.offset < value;
+    };
+    const auto frame = std::lower_bound(frames_.begin(), frames_.end(), offset, startsBefore);
+    if (frame == frames_.end() || frame->offset != offset)
+    {
+        return -1;
+    }
+    return frame - frames_.begin();
+}
+
+std::vector<std::pair<int64_t, int64_t>> TrajectoryFrameIndex::splitIntoChunks(int numChunks) const
+{
+    GMX_RELEASE_ASSERT(numChunks > 0, "Need at least one chunk");
+
+    std::vector<std::pair<int64_t, int64_t>> chunks;
+    for (int c = 0; c < numChunks; c++)
+    {
+        chunks.emplace_back(numFrames() * c / numChunks, numFrames() * (c + 1) / numChunks);
+    }
+    return chunks;
+}
+
+} // namespace gmx
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares an index of the frames in XTC and TRR trajectories.
+ *
+ * The index stores the byte offset, step, time and number of atoms of
+ * every frame, so that frames can be accessed directly instead of by
+ * reading or scanning all preceding frames. It is stored in a sidecar
+ * file next to the trajectory and is only used while the trajectory is
+ * unchanged since the index was built.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+#define GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+
+#include <cstdint>
+
+#include <filesystem>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/futil.h"
+
+namespace gmx
+{
+
+//! \libinternal \brief Location and identification of a trajectory frame
+struct TrajectoryFrameIndexEntry
+{
+    //! Byte offset of the start of the frame in the trajectory file
+    gmx_off_t offset;
+    //! MD step of the frame
+    int64_t step;
+    //! Time of the frame in ps
+    double time;
+    //! Number of atoms in the frame
+    int natoms;
+};
+
+/*! \libinternal \brief Index of the frames in an XTC or TRR trajectory file
+ *
+ * Building the index only reads the frame headers and seeks over the
+ * frame data, so it is much faster than reading the trajectory.
+ */
+class TrajectoryFrameIndex
+{
+public:
+    /*! \brief Builds the index by scanning \p trajectoryFile
+     *
+     * An incomplete last frame is not indexed.
+     *
+     * \throws InvalidInputError if the file is not an XTC or TRR file.
+     * \throws FileIOError if the file can not be read.
+     */
+    static TrajectoryFrameIndex build(const std::filesystem::path& trajectoryFile);
+    /*! \brief Reads the index of \p trajectoryFile from its sidecar file
+     *
+     * Returns nullptr when there is no sidecar file, when it can not be
+     * read, or when the trajectory was modified after the index was built.
+     */
+    static std::unique_ptr<TrajectoryFrameIndex> read(const std::filesystem::path& trajectoryFile);
+    /*! \brief Returns the index for reading \p trajectoryFile, or nullptr
+     *
+     * Uses an up-to-date sidecar file when present. Otherwise, when the
+     * GMX_TRAJECTORY_INDEX environment variable is set, builds the index
+     * and tries to write the sidecar file for later use.
+     */
+    static std::unique_ptr<TrajectoryFrameIndex>
+    readOrBuild(const std::filesystem::path& trajectoryFile);
+    /*! \brief Returns an index to extend while frames are appended to \p trajectoryFile
+     *
+     * Returns an empty index when the file does not exist or is empty. For an
+     * existing trajectory, e.g. when appending to the output of a previous run,
+     * uses an up-to-date sidecar file or otherwise builds the index once.
+     */
+    static TrajectoryFrameIndex forAppending(const std::filesystem::path& trajectoryFile);
+    //! Returns whether GMX_TRAJECTORY_INDEX requests building and writing indices
+    static bool isRequested();
+    //! Returns the name of the sidecar file for \p trajectoryFile
+    static std::filesystem::path sidecarFileName(const std::filesystem::path& trajectoryFile);
+
+    /*! \brief Writes the index to the sidecar file of the trajectory
+     *
+     * Returns false when the file could not be written, e.g. because the
+     * directory is not writable.
+     */
+    bool write() const;
+    /*! \brief Adds a frame written after the last indexed frame
+     *
+     * \param[in] step      MD step of the frame
+     * \param[in] time      Time of the frame in ps
+     * \param[in] natoms    Number of atoms in the frame
+     * \param[in] frameEnd  The byte offset just past the frame in the trajectory file
+     */
+    void appendFrame(int64_t step, double time, int natoms, gmx_off_t frameEnd);
+    /*! \brief Writes the index of a trajectory that was extended with appendFrame()
+     *
+     * Should be called after the trajectory has been closed, as the index
+     * is marked as up to date with the current size and modification time
+     * of the trajectory. Returns false when the trajectory size does not match
+     * the indexed frames or the file could not be written.
+     */
+    bool writeForAppendedFrames();
+
+    //! Returns the trajectory file this is the index of
+    const std::filesystem::path& trajectoryFile() const { return trajectoryFile_; }
+    //! Returns the indexed frames in file order
+    ArrayRef<const TrajectoryFrameIndexEntry> frames() const { return frames_; }
+    //! Returns the number of indexed frames
+    int64_t numFrames() const { return frames_.size(); }
+    //! Returns the byte offset just past the last indexed frame
+    gmx_off_t indexedSize() const { return indexedSize_; }
+    /*! \brief Returns the index of the frame that starts at byte \p offset
+     *
+     * Returns -1 when no indexed frame starts at \p offset.
+     */
+    int64_t frameAtOffset(gmx_off_t offset) const;
+    /*! \brief Splits the frames into \p numChunks contiguous ranges
+     *
+     * Returns pairs of the first frame and one past the last frame of each
+     * range. The ranges differ at most one frame in size, so they can be
+     * processed independently, e.g. by different ranks or threads.
+     */
+    std::vector<std::pair<int64_t, int64_t>> splitIntoChunks(int numChunks) const;
+
+private:
+    TrajectoryFrameIndex() = default;
+
+    //! The trajectory file this is the index of
+    std::filesystem::path trajectoryFile_;
+    //! The size of the trajectory file when it was indexed
+    gmx_off_t trajectorySize_ = 0;
+    //! The modification time of the trajectory file when it was indexed
+    int64_t trajectoryModificationTime_ = 0;
+    //! The byte offset just past the last complete frame
+    gmx_off_t indexedSize_ = 0;
+    //! The indexed frames
+    std::vector<TrajectoryFrameIndexEntry> frames_;
+};
+
+} // namespace gmx
+
+#endif
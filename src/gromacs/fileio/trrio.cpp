@@ -40,6 +40,7 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -345,7 +346,8 @@ void gmx_trr_write_frame(t_fileio*   fio,
                       const_cast<rvec*>(v),
                       const_cast<rvec*>(f)))
     {
-        gmx_file("Cannot write trajectory frame; maybe you are out of disk space?");
+        GMX_THROW(gmx::FileIOError(
+                "Cannot write trajectory frame; maybe you are out of disk space?"));
     }
 }
 
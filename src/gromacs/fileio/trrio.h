@@ -135,7 +135,9 @@ void gmx_trr_write_frame(struct t_fileio* fio,
                          const rvec*      x,
                          const rvec*      v,
                          const rvec*      f);
-/* Write a trr frame to file fp, box, x, v, f may be NULL */
+/* Write a trr frame to file fp, box, x, v, f may be NULL
+ * Throws gmx::FileIOError when the frame can not be written.
+ */
 
 void gmx_trr_read_single_header(const std::filesystem::path& fn, gmx_trr_header_t* header);
 /* Read the header of a trr file from fn, and close the file afterwards.
@@ -38,7 +38,9 @@
 #include "config.h"
 
 #include <cassert>
+#include <cinttypes>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #include "gromacs/fileio/checkpoint.h"
@@ -48,11 +50,14 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/fileio/groio.h"
+#include "gromacs/fileio/mappedtrrreader.h"
+#include "gromacs/fileio/memorymappedfile.h"
 #include "gromacs/fileio/oenv.h"
 #include "gromacs/fileio/pdbio.h"
 #include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/tpxio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/fileio/xtcio.h"
@@ -62,6 +67,7 @@
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -88,6 +94,9 @@ struct t_trxstatus
     gmx_tng_trajectory_t tng;
     int                  natoms;
     char*                persistent_line; /* Persistent line for reading g96 trajectories */
+
+    gmx::TrajectoryFrameIndex* frameIndex; /* Index of the XTC or TRR frames, when available */
+    gmx::MappedTrrReader*      mappedTrr;  /* Reader for a memory-mapped TRR file, when used */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t* vmdplugin;
 #endif
@@ -171,6 +180,8 @@ static void status_init(t_trxstatus* status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->frameIndex      = nullptr;
+    status->mappedTrr       = nullptr;
 }
 
 
@@ -249,7 +260,11 @@ float trx_get_time_of_final_frame(t_trxstatus* status)
     gmx_bool  bOK;
     float     lasttime = -1;
 
-    if (filetype == efXTC)
+    if (status->frameIndex && status->frameIndex->numFrames() > 0)
+    {
+        lasttime = status->frameIndex->frames().back().time;
+    }
+    else if (filetype == efXTC)
     {
         lasttime = xdr_xtc_get_last_frame_time(
                 gmx_fio_getfp(stfio), gmx_fio_getxdr(stfio), status->natoms, &bOK);
@@ -645,6 +660,8 @@ void close_trx(t_trxstatus* status)
         gmx_fio_close(status->fio);
     }
     sfree(status->persistent_line);
+    delete status->frameIndex;
+    delete status->mappedTrr;
 #if GMX_USE_PLUGINS
     delete status->vmdplugin;
 #endif
@@ -683,7 +700,9 @@ static gmx_bool gmx_next_frame(t_trxstatus* status, t_trxframe* fr)
 
     bRet = FALSE;
 
-    if (gmx_trr_read_frame_header(status->fio, &sh, &bOK))
+    gmx::MappedTrrReader* mappedTrr = status->mappedTrr;
+    if (mappedTrr ? mappedTrr->readFrameHeader(&sh, &bOK)
+                  : gmx_trr_read_frame_header(status->fio, &sh, &bOK))
     {
         fr->bDouble   = sh.bDouble;
         fr->natoms    = sh.natoms;
@@ -719,7 +738,8 @@ static gmx_bool gmx_next_frame(t_trxstatus* status, t_trxframe* fr)
             }
             fr->bF = sh.f_size > 0;
         }
-        if (gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
+        if (mappedTrr ? mappedTrr->readFrameData(sh, fr->box, fr->x, fr->v, fr->f)
+                      : gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
         {
             bRet = TRUE;
         }
@@ -817,6 +837,80 @@ static int pdb_first_x(t_trxstatus* status, FILE* fp, t_trxframe* fr)
     return fr->natoms;
 }
 
+/* Returns the offset of the next frame to read */
+static gmx_off_t trx_tell(t_trxstatus* status)
+{
+    return status->mappedTrr ? status->mappedTrr->offset() : gmx_fio_ftell(status->fio);
+}
+
+/* Positions the file such that the next frame is read from offset,
+ * returns 0 on success */
+static int trx_seek(t_trxstatus* status, gmx_off_t offset)
+{
+    if (status->mappedTrr)
+    {
+        status->mappedTrr->seek(offset);
+        return 0;
+    }
+    return gmx_fio_seek(status->fio, offset);
+}
+
+/* Uses the frame index to seek directly to the next frame that is not
+ * skipped because of the begin time or the time interval set by the user.
+ * Returns whether the file is positioned at the start of an indexed frame.
+ */
+static bool seekNextFrameWithIndex(t_trxstatus* status, gmx_bool bDouble)
+{
+    const gmx::TrajectoryFrameIndex& index = *status->frameIndex;
+
+    int64_t frame = index.frameAtOffset(trx_tell(status));
+    if (frame < 0 || (status->flags & TRX_DONT_SKIP))
+    {
+        return false;
+    }
+
+    const int64_t currentFrame = frame;
+    while (frame < index.numFrames()
+           && check_times2(index.frames()[frame].time, status->t0, bDouble) < 0)
+    {
+        frame++;
+    }
+    if (frame != currentFrame)
+    {
+        /* Continue after the indexed frames when all of them are skipped */
+        const gmx_off_t offset =
+                (frame < index.numFrames()) ? index.frames()[frame].offset : index.indexedSize();
+        if (trx_seek(status, offset) != 0)
+        {
+            gmx_fatal(FARGS,
+                      "Could not seek to frame %" PRId64 " in %s",
+                      frame,
+                      gmx_fio_getname(status->fio).u8string().c_str());
+        }
+    }
+    return true;
+}
+
+/* Returns a reader for the memory-mapped TRR file fn, or nullptr when
+ * memory mapping is not supported, is disabled with GMX_TRR_NO_MMAP,
+ * or fails. The TRR data is then read through XDR instead.
+ */
+static gmx::MappedTrrReader* openMappedTrr(const std::filesystem::path& fn)
+{
+    if (!gmx::MemoryMappedFile::isSupported() || std::getenv("GMX_TRR_NO_MMAP") != nullptr)
+    {
+        return nullptr;
+    }
+    try
+    {
+        return new gmx::MappedTrrReader(fn);
+    }
+    catch (const gmx::FileIOError&)
+    {
+        return nullptr;
+    }
+}
+
 bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxframe* fr)
 {
     real     pt;
@@ -840,6 +934,11 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
         {
             ftp = gmx_fio_getftp(status->fio);
         }
+        bool seekedWithIndex = false;
+        if (status->frameIndex && (ftp == efXTC || ftp == efTRR))
+        {
+            seekedWithIndex = seekNextFrameWithIndex(status, fr->bDouble);
+        }
         auto startTime = timeValue(TimeControl::Begin);
         switch (ftp)
         {
@@ -855,7 +954,7 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                 break;
             }
             case efXTC:
-                if (startTime.has_value() && (status->tf < startTime.value()))
+                if (startTime.has_value() && (status->tf < startTime.value()) && !seekedWithIndex)
                 {
                     if (xtc_seek_time(status->fio, startTime.value(), fr->natoms, TRUE))
                     {
@@ -964,9 +1063,13 @@ bool read_first_frame(const gmx_output_env_t*      oenv,
     {
         fio = (*status)->fio = gmx_fio_open(fn, "r");
     }
+    if (ftp == efXTC || ftp == efTRR)
+    {
+        (*status)->frameIndex = gmx::TrajectoryFrameIndex::readOrBuild(fn).release();
+    }
     switch (ftp)
     {
-        case efTRR: break;
+        case efTRR: (*status)->mappedTrr = openMappedTrr(fn); break;
         case efCPT:
             read_checkpoint_trxframe(fio, fr);
             bFirst = FALSE;
@@ -1135,10 +1238,28 @@ gmx_bool read_next_x(const gmx_output_env_t* oenv, t_trxstatus* status, real* t,
     return bRet;
 }
 
+int64_t trx_get_num_indexed_frames(t_trxstatus* status)
+{
+    return status->frameIndex ? status->frameIndex->numFrames() : -1;
+}
+
+gmx_bool trx_seek_indexed_frame(t_trxstatus* status, int64_t frame)
+{
+    if (status->frameIndex == nullptr || frame < 0 || frame >= status->frameIndex->numFrames())
+    {
+        return FALSE;
+    }
+    return trx_seek(status, status->frameIndex->frames()[frame].offset) == 0;
+}
+
 void rewind_trj(t_trxstatus* status)
 {
     initcount(status);
 
+    if (status->mappedTrr)
+    {
+        status->mappedTrr->seek(0);
+    }
     gmx_fio_rewind(status->fio);
 }
 
@@ -56,6 +56,8 @@
 #define XTC_MAGIC 1995
 // New magic number used for (very) large XTC files with 64-bit data buffer size
 #define XTC_NEW_MAGIC 2023
+// Magic number used for chunked XTC frames with independently compressed blocks of atoms
+#define XTC_CHUNKED_MAGIC 2024
 
 /* Until june 2023, the old XDR format could only store up to ~300M atoms.
  * To handle larger systems, we use a newer magic number (2023 instead of 1995).
@@ -77,6 +79,14 @@
  */
 #define XTC_1995_MAX_NATOMS 298261617
 
+/* Frames with the chunked magic number (2024) split the coordinates into
+ * consecutive blocks of atoms that are compressed independently, each with
+ * its own integer ranges and 64-bit data size. This allows compressing and
+ * decompressing a frame using all OpenMP threads. Such frames can not be read
+ * by software that only knows the two other magic numbers, so they are only
+ * written on request.
+ */
+
 /* Read or write reduced precision *float* coordinates */
 int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int magic_number);
 
@@ -106,4 +116,10 @@ float xdr_xtc_get_last_frame_time(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK
 
 int xdr_xtc_get_last_frame_number(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK);
 
+/* Skip the box and compressed coordinates of an XTC frame, after its header
+ * with magic number magic_number has been read. Only the sizes of the data
+ * are read, the coordinates are not decompressed. Returns 0 on error.
+ */
+int xdr_xtc_skip_frame_data(FILE* fp, XDR* xdrs, int magic_number);
+
 #endif
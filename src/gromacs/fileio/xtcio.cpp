@@ -35,6 +35,7 @@
 
 #include "xtcio.h"
 
+#include <cstdlib>
 #include <cstring>
 
 #include "gromacs/fileio/gmxfio.h"
@@ -80,9 +81,14 @@ void close_xtc(t_fileio* fio)
 
 static void check_xtc_magic(int magic)
 {
-    if (magic != XTC_MAGIC && magic != XTC_NEW_MAGIC)
+    if (magic != XTC_MAGIC && magic != XTC_NEW_MAGIC && magic != XTC_CHUNKED_MAGIC)
     {
-        gmx_fatal(FARGS, "Magic Number Error in XTC file (read %d, should be %d or %d)", magic, XTC_MAGIC, XTC_NEW_MAGIC);
+        gmx_fatal(FARGS,
+                  "Magic Number Error in XTC file (read %d, should be %d, %d or %d)",
+                  magic,
+                  XTC_MAGIC,
+                  XTC_NEW_MAGIC,
+                  XTC_CHUNKED_MAGIC);
     }
 }
 
@@ -204,6 +210,14 @@ int write_xtc(t_fileio* fio, int natoms, int64_t step, real time, const rvec* bo
     gmx_bool bDum;
     int      bOK;
 
+    // The chunked format, which can be (de)compressed in parallel, is only written
+    // on request, since other software can not read it.
+    static const bool useChunkedFormat = (std::getenv("GMX_XTC_CHUNKED") != nullptr);
+    if (useChunkedFormat)
+    {
+        magic_number = XTC_CHUNKED_MAGIC;
+    }
+
     if (!fio)
     {
         /* This means the fio object is not being used, e.g. because
@@ -283,3 +297,26 @@ int read_next_xtc(t_fileio* fio, int natoms, int64_t* step, real* time, matrix b
 
     return static_cast<int>(*bOK);
 }
+
+int skip_next_xtc(t_fileio* fio, int* natoms, int64_t* step, real* time, gmx_bool* bOK)
+{
+    int  magic;
+    XDR* xd;
+
+    *bOK = TRUE;
+    xd   = gmx_fio_getxdr(fio);
+
+    /* read header */
+    if (!xtc_header(xd, &magic, natoms, step, time, TRUE, bOK))
+    {
+        return 0;
+    }
+
+    /* Check magic number */
+    check_xtc_magic(magic);
+
+    *bOK = (xdr_xtc_skip_frame_data(gmx_fio_getfp(fio), xd, magic) != 0);
+
+    return static_cast<int>(*bOK);
+}
+
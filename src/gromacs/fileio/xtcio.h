@@ -73,6 +73,10 @@ int read_first_xtc(struct t_fileio* fio,
 int read_next_xtc(struct t_fileio* fio, int natoms, int64_t* step, real* time, matrix box, rvec* x, real* prec, gmx_bool* bOK);
 /* Read subsequent frames */
 
+int skip_next_xtc(struct t_fileio* fio, int* natoms, int64_t* step, real* time, gmx_bool* bOK);
+/* Read the header of the next frame and skip over its coordinates
+ * without decompressing them, e.g. for indexing the frames */
+
 int write_xtc(struct t_fileio* fio, int natoms, int64_t step, real time, const rvec* box, const rvec* x, real prec);
 /* Write a frame to xtc file */
 
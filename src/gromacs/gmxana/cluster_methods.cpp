@@ -35,12 +35,22 @@
 
 #include "cluster_methods.h"
 
+#include <cinttypes>
+#include <cmath>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/cmat.h"
+#include "gromacs/math/do_fit.h"
+#include "gromacs/math/vec.h"
 #include "gromacs/random/threefry.h"
 #include "gromacs/random/uniformintdistribution.h"
 #include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
@@ -602,3 +612,175 @@ void gromos(int n1, real** mat, real rmsdcut, t_clusters* clust)
 
     clust->ncl = k - 1;
 }
+
+/*! \brief Computes the intra-frame distances of \p nind atoms
+ *
+ * The distances are stored in \p d as the upper triangle of the distance
+ * matrix, row by row.
+ */
+static void calc_dist(int nind, const rvec x[], real* d)
+{
+    int  i, j, k;
+    rvec dx;
+
+    k = 0;
+    for (i = 0; (i < nind - 1); i++)
+    {
+        for (j = i + 1; (j < nind); j++)
+        {
+            /* Should use pbc_dx when analysing multiple molecueles,
+             * but the box is not stored for every frame.
+             */
+            rvec_sub(x[i], x[j], dx);
+            d[k++] = norm(dx);
+        }
+    }
+}
+
+//! Returns the RMS difference between two sets of \p npairs distances
+static real rms_dist(int npairs, const real* d, const real* d_r)
+{
+    int  k;
+    real r, r2;
+
+    r2 = 0.0;
+    for (k = 0; (k < npairs); k++)
+    {
+        r = d[k] - d_r[k];
+        r2 += r * r;
+    }
+    r2 /= npairs;
+
+    return std::sqrt(r2);
+}
+
+//! The maximum number of frames in a tile of the RMSD matrix
+static constexpr int c_rmsdTileMaxFrames = 64;
+
+//! The size in bytes the intra-frame distances of two tiles should fit in
+static constexpr size_t c_rmsdTileDistanceBytes = 2 * 1024 * 1024;
+
+void calc_rms_matrix(t_mat* rms,
+                     int    nf,
+                     rvec** xx,
+                     int    isize,
+                     real*  mass,
+                     bool   bFit,
+                     bool   bRMSdist,
+                     int    nthreads,
+                     int    tileSize)
+{
+    const int npairs = isize * (isize - 1) / 2;
+
+    if (tileSize <= 0)
+    {
+        tileSize = c_rmsdTileMaxFrames;
+        if (bRMSdist)
+        {
+            const size_t tileBytes = 2 * sizeof(real) * std::max(npairs, 1);
+            tileSize = static_cast<int>(std::clamp<size_t>(
+                    c_rmsdTileDistanceBytes / tileBytes, 1, c_rmsdTileMaxFrames));
+        }
+    }
+    const int numTiles = (nf + tileSize - 1) / tileSize;
+
+    std::vector<std::pair<int, int>> tilePairs;
+    for (int ti = 0; ti < numTiles; ti++)
+    {
+        for (int tj = ti; tj < numTiles; tj++)
+        {
+            tilePairs.emplace_back(ti, tj);
+        }
+    }
+
+    int64_t nrms = (static_cast<int64_t>(nf) * static_cast<int64_t>(nf - 1)) / 2;
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            std::vector<gmx::RVec> x1;
+            std::vector<real>      dTileI, dTileJ;
+            if (bRMSdist)
+            {
+                dTileI.resize(static_cast<size_t>(tileSize) * npairs);
+                dTileJ.resize(static_cast<size_t>(tileSize) * npairs);
+            }
+            else
+            {
+                x1.resize(isize);
+            }
+
+#pragma omp for schedule(dynamic)
+            for (int t = 0; t < gmx::ssize(tilePairs); t++)
+            {
+                const int i0 = tilePairs[t].first * tileSize;
+                const int i1 = std::min(i0 + tileSize, nf);
+                const int j0 = tilePairs[t].second * tileSize;
+                const int j1 = std::min(j0 + tileSize, nf);
+
+                if (bRMSdist)
+                {
+                    for (int i = i0; i < i1; i++)
+                    {
+                        calc_dist(isize,
+                                  xx[i],
+                                  dTileI.data() + static_cast<size_t>(i - i0) * npairs);
+                    }
+                    for (int j = j0; j < j1 && j0 != i0; j++)
+                    {
+                        calc_dist(isize,
+                                  xx[j],
+                                  dTileJ.data() + static_cast<size_t>(j - j0) * npairs);
+                    }
+                }
+                const real* dJ = (j0 == i0 ? dTileI.data() : dTileJ.data());
+
+                int64_t numComputed = 0;
+                for (int i = i0; i < i1; i++)
+                {
+                    for (int j = std::max(j0, i + 1); j < j1; j++)
+                    {
+                        real value;
+                        if (bRMSdist)
+                        {
+                            value = rms_dist(npairs,
+                                             dTileI.data() + static_cast<size_t>(i - i0) * npairs,
+                                             dJ + static_cast<size_t>(j - j0) * npairs);
+                        }
+                        else
+                        {
+                            std::copy(xx[i], xx[i] + isize, x1.begin());
+                            if (bFit)
+                            {
+                                do_fit(isize, mass, xx[j], as_rvec_array(x1.data()));
+                            }
+                            value = rmsdev(isize, mass, xx[j], as_rvec_array(x1.data()));
+                        }
+                        rms->mat[i][j] = value;
+                        numComputed++;
+                    }
+                }
+
+#pragma omp critical
+                {
+                    nrms -= numComputed;
+                    fprintf(stderr,
+                            "\r# RMSD calculations left: "
+                            "%" PRId64 "   ",
+                            nrms);
+                    fflush(stderr);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    for (int i = 0; i < nf; i++)
+    {
+        for (int j = i + 1; j < nf; j++)
+        {
+            set_mat_entry(rms, i, j, rms->mat[i][j]);
+        }
+    }
+}
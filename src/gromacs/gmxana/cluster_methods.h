@@ -37,6 +37,7 @@
 
 #include <cstdio>
 
+#include "gromacs/math/vectypes.h"
 #include "gromacs/utility/real.h"
 
 struct gmx_output_env_t;
@@ -71,4 +72,25 @@ void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clusters*
 
 void gromos(int n1, real** mat, real rmsdcut, t_clusters* clust);
 
+/*! \brief Computes the RMS deviation or RMS distance deviation matrix
+ *
+ * The upper triangle of the matrix is divided in tiles of \p tileSize
+ * frames which are distributed dynamically over \p nthreads OpenMP
+ * threads. With \p bRMSdist, the distances within each frame of a tile
+ * are computed once per tile instead of once per pair of frames.
+ * With \p tileSize <= 0 the tile size is chosen such that the distances
+ * of two tiles fit in cache. The matrix statistics are accumulated in
+ * frame order afterwards, so the results depend neither on the number
+ * of threads nor on the tile size.
+ */
+void calc_rms_matrix(t_mat* rms,
+                     int    nf,
+                     rvec** xx,
+                     int    isize,
+                     real*  mass,
+                     bool   bFit,
+                     bool   bRMSdist,
+                     int    nthreads,
+                     int    tileSize);
+
 #endif
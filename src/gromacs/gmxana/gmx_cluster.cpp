@@ -33,11 +33,15 @@
  */
 #include "gmxpre.h"
 
+#include "config.h"
+
+#include <climits>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -62,6 +66,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -120,45 +125,6 @@ static inline void ffprintf_ss(FILE* fp1, FILE* fp2, char* buf, const char* fmt,
     lo_ffprintf(fp1, fp2, buf);
 }
 
-static void calc_dist(int nind, rvec x[], real** d)
-{
-    int   i, j;
-    real* xi;
-    rvec  dx;
-
-    for (i = 0; (i < nind - 1); i++)
-    {
-        xi = x[i];
-        for (j = i + 1; (j < nind); j++)
-        {
-            /* Should use pbc_dx when analysing multiple molecueles,
-             * but the box is not stored for every frame.
-             */
-            rvec_sub(xi, x[j], dx);
-            d[i][j] = norm(dx);
-        }
-    }
-}
-
-static real rms_dist(int isize, real** d, real** d_r)
-{
-    int  i, j;
-    real r, r2;
-
-    r2 = 0.0;
-    for (i = 0; (i < isize - 1); i++)
-    {
-        for (j = i + 1; (j < isize); j++)
-        {
-            r = d[i][j] - d_r[i][j];
-            r2 += r * r;
-        }
-    }
-    r2 /= gmx::exactDiv(isize * (isize - 1), 2);
-
-    return std::sqrt(r2);
-}
-
 static rvec** read_whole_trj(const char*             fn,
                              int                     isize,
                              const int               index[],
@@ -808,7 +774,9 @@ int gmx_cluster(int argc, char* argv[])
         "Distances between structures can be determined from a trajectory",
         "or read from an [REF].xpm[ref] matrix file with the [TT]-dm[tt] option.",
         "RMS deviation after fitting or RMS deviation of atom-pair distances",
-        "can be used to define the distance between structures.[PAR]",
+        "can be used to define the distance between structures.",
+        "The matrix is computed in tiles of frames, which are distributed",
+        "over OpenMP threads, see [TT]-nthreads[tt].[PAR]",
 
         "single linkage: add a structure to a cluster when its distance to any",
         "element of the cluster is less than [TT]cutoff[tt].[PAR]",
@@ -881,12 +849,11 @@ int gmx_cluster(int argc, char* argv[])
     };
 
     FILE *  fp, *log;
-    int     nf   = 0, i, i1, i2, j;
-    int64_t nrms = 0;
+    int nf = 0, i, i1, i2, j;
 
     matrix      box;
     matrix*     boxes = nullptr;
-    rvec *      xtps, *usextps, *x1, **xx = nullptr;
+    rvec *      xtps, *usextps, **xx = nullptr;
     const char *fn, *trx_out_fn;
     t_clusters  clust;
     t_mat *     rms, *orig = nullptr;
@@ -899,7 +866,7 @@ int gmx_cluster(int argc, char* argv[])
     int      isize = 0, ifsize = 0, iosize = 0;
     int *    index = nullptr, *fitidx = nullptr, *outidx = nullptr, *frameindices = nullptr;
     char*    grpname;
-    real     rmsd, **d1, **d2, *time = nullptr, time_invfac, *mass = nullptr;
+    real     *time = nullptr, time_invfac, *mass = nullptr;
     char     buf[STRLEN], buf1[80];
     gmx_bool bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bPBC = TRUE;
 
@@ -928,6 +895,7 @@ int gmx_cluster(int argc, char* argv[])
     static int   niter = 10000, nrandom = 0, seed = 0, write_ncl = 0, write_nst = 1, minstruct = 1;
     static real  kT = 1e-3;
     static int   M = 10, P = 3;
+    int          nthreads = 0;
     gmx_output_env_t* oenv;
     gmx_rmpbc_t       gpbc = nullptr;
 
@@ -1006,7 +974,15 @@ int gmx_cluster(int argc, char* argv[])
           { &kT },
           "Boltzmann weighting factor for Monte Carlo optimization "
           "(zero turns off uphill steps)" },
-        { "-pbc", FALSE, etBOOL, { &bPBC }, "PBC check" }
+        { "-pbc", FALSE, etBOOL, { &bPBC }, "PBC check" },
+#if GMX_OPENMP
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nthreads },
+          "Number of OpenMP threads used for computing the RMSD matrix, "
+          "0 means the maximum number of threads" },
+#endif
     };
     t_filenm fnm[] = {
         { efTRX, "-f", nullptr, ffOPTRD },         { efTPS, "-s", nullptr, ffREAD },
@@ -1254,73 +1230,17 @@ int gmx_cluster(int argc, char* argv[])
     }
     else /* !bReadMat */
     {
-        rms  = init_mat(nf, method == m_diagonalize);
-        nrms = (static_cast<int64_t>(nf) * static_cast<int64_t>(nf - 1)) / 2;
-        if (!bRMSdist)
-        {
-            fprintf(stderr, "Computing %dx%d RMS deviation matrix\n", nf, nf);
-            /* Initialize work array */
-            snew(x1, isize);
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                for (i2 = i1 + 1; i2 < nf; i2++)
-                {
-                    for (i = 0; i < isize; i++)
-                    {
-                        copy_rvec(xx[i1][i], x1[i]);
-                    }
-                    if (bFit)
-                    {
-                        do_fit(isize, mass, xx[i2], x1);
-                    }
-                    rmsd = rmsdev(isize, mass, xx[i2], x1);
-                    set_mat_entry(rms, i1, i2, rmsd);
-                }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            sfree(x1);
-        }
-        else /* bRMSdist */
-        {
-            fprintf(stderr, "Computing %dx%d RMS distance deviation matrix\n", nf, nf);
-
-            /* Initiate work arrays */
-            snew(d1, isize);
-            snew(d2, isize);
-            for (i = 0; (i < isize); i++)
-            {
-                snew(d1[i], isize);
-                snew(d2[i], isize);
-            }
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                calc_dist(isize, xx[i1], d1);
-                for (i2 = i1 + 1; (i2 < nf); i2++)
-                {
-                    calc_dist(isize, xx[i2], d2);
-                    set_mat_entry(rms, i1, i2, rms_dist(isize, d1, d2));
-                }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            /* Clean up work arrays */
-            for (i = 0; (i < isize); i++)
-            {
-                sfree(d1[i]);
-                sfree(d2[i]);
-            }
-            sfree(d1);
-            sfree(d2);
-        }
+        rms = init_mat(nf, method == m_diagonalize);
+        const int numThreads =
+                std::min((nthreads <= 0) ? INT_MAX : nthreads, gmx_omp_get_max_threads());
+        fprintf(stderr,
+                "Computing %dx%d RMS %sdeviation matrix using %d thread%s\n",
+                nf,
+                nf,
+                bRMSdist ? "distance " : "",
+                numThreads,
+                numThreads > 1 ? "s" : "");
+        calc_rms_matrix(rms, nf, xx, isize, mass, bFit, bRMSdist, numThreads, 0);
         fprintf(stderr, "\n\n");
     }
     ffprintf_gg(stderr, log, buf, "The RMSD ranges from %g to %g nm\n", rms->minrms, rms->maxrms);
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the tiled RMSD matrix computation of gmx cluster
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/cluster_methods.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxana/cmat.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Test fixture holding random frames for the RMSD matrix computation
+class ClusterRmsMatrixTest : public ::testing::Test
+{
+protected:
+    //! The number of frames, not a multiple of the tile sizes tested
+    static constexpr int c_numFrames = 45;
+    //! The number of atoms per frame
+    static constexpr int c_numAtoms = 12;
+
+    ClusterRmsMatrixTest() : frames_(c_numFrames), mass_(c_numAtoms, 1.0_real)
+    {
+        DefaultRandomEngine           rng(1234);
+        UniformRealDistribution<real> dist(-1.0, 1.0);
+        for (auto& frame : frames_)
+        {
+            frame.resize(c_numAtoms);
+            for (auto& x : frame)
+            {
+                x = { dist(rng), dist(rng), dist(rng) };
+            }
+            xx_.push_back(as_rvec_array(frame.data()));
+        }
+    }
+
+    //! Checks that tiled and threaded matrices equal the matrix computed as a single tile
+    void checkTilingDoesNotChangeMatrix(bool bFit, bool bRMSdist)
+    {
+        t_mat* reference = init_mat(c_numFrames, false);
+        calc_rms_matrix(reference,
+                        c_numFrames,
+                        xx_.data(),
+                        c_numAtoms,
+                        mass_.data(),
+                        bFit,
+                        bRMSdist,
+                        1,
+                        c_numFrames);
+
+        for (int numThreads : { 1, 2 })
+        {
+            // A tile size of 0 selects the automatic tile size
+            for (int tileSize : { 0, 1, 7 })
+            {
+                SCOPED_TRACE(formatString("%d threads, tile size %d", numThreads, tileSize));
+
+                t_mat* rms = init_mat(c_numFrames, false);
+                calc_rms_matrix(rms,
+                                c_numFrames,
+                                xx_.data(),
+                                c_numAtoms,
+                                mass_.data(),
+                                bFit,
+                                bRMSdist,
+                                numThreads,
+                                tileSize);
+
+                // Every matrix element is computed with the same operations in
+                // every tiling, so the results should be identical
+                for (int i = 0; i < c_numFrames; i++)
+                {
+                    for (int j = i + 1; j < c_numFrames; j++)
+                    {
+                        EXPECT_EQ(reference->mat[i][j], rms->mat[i][j]) << "i " << i << " j " << j;
+                    }
+                }
+                EXPECT_EQ(reference->minrms, rms->minrms);
+                EXPECT_EQ(reference->maxrms, rms->maxrms);
+                EXPECT_EQ(reference->sumrms, rms->sumrms);
+
+                done_mat(&rms);
+            }
+        }
+
+        done_mat(&reference);
+    }
+
+private:
+    //! The coordinates of all frames
+    std::vector<std::vector<RVec>> frames_;
+    //! Pointers to the coordinates of each frame
+    std::vector<rvec*> xx_;
+    //! The atom masses
+    std::vector<real> mass_;
+};
+
+TEST_F(ClusterRmsMatrixTest, TiledRmsDeviationEqualsUntiled)
+{
+    checkTilingDoesNotChangeMatrix(false, false);
+}
+
+TEST_F(ClusterRmsMatrixTest, TiledFittedRmsDeviationEqualsUntiled)
+{
+    checkTilingDoesNotChangeMatrix(true, false);
+}
+
+TEST_F(ClusterRmsMatrixTest, TiledRmsDistanceDeviationEqualsUntiled)
+{
+    checkTilingDoesNotChangeMatrix(false, true);
+}
+
+} // namespace
+
+} // namespace gmx
@@ -85,6 +85,7 @@
 #include "gromacs/mdrunutility/mdmodulesnotifiers.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/mdtypes/nblist.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/pbcutil/boxutilities.h"
@@ -1757,6 +1758,54 @@ static void set_verlet_buffer(const gmx_mtop_t*              mtop,
     }
 }
 
+/* Reports an estimate of the error in the long-range electrostatic force due to MTS */
+static void reportMtsLongRangeForceError(const gmx_mtop_t&              mtop,
+                                         const t_inputrec&              ir,
+                                         real                           temperature,
+                                         gmx::ArrayRef<const gmx::RVec> coordinates,
+                                         const matrix                   box,
+                                         WarningHandler*                wi,
+                                         const gmx::MDLogger&           logger)
+{
+    if (!(usingPme(ir.coulombtype) || ir.coulombtype == CoulombInteractionType::Ewald)
+        || gmx::forceGroupMtsLevel(ir.mtsLevels, gmx::MtsForceGroups::LongrangeNonbonded) == 0)
+    {
+        return;
+    }
+
+    const real effectiveAtomDensity = computeEffectiveAtomDensity(
+            coordinates, box, std::max(ir.rcoulomb, ir.rvdw), MPI_COMM_NULL);
+
+    const int mtsFactor = ir.mtsLevels.back().stepFactor;
+
+    const MtsLongRangeForceError error =
+            mtsLongRangeForceError(mtop, effectiveAtomDensity, ir, mtsFactor, temperature);
+
+    GMX_LOG(logger.info)
+            .asParagraph()
+            .appendTextFormatted(
+                    "Estimated RMS error in the long-range electrostatic force due to MTS with "
+                    "mts-level2-factor = %d: %.3g kJ/mol/nm, %.2g%% of the long-range force",
+                    mtsFactor,
+                    error.rmsForceError,
+                    100 * error.relativeForceError);
+
+    if (mtsFactor > 2)
+    {
+        const MtsLongRangeForceError errorFactor2 =
+                mtsLongRangeForceError(mtop, effectiveAtomDensity, ir, 2, temperature);
+
+        wi->addNote(gmx::formatString(
+                "With mts-level2-factor = %d the estimated RMS error in the long-range "
+                "electrostatic force is %.2g%% of the long-range force, compared to %.2g%% with "
+                "mts-level2-factor = 2. Note that MTS can also affect the stability and energy "
+                "conservation through resonances, so check the energy drift of your system.",
+                mtsFactor,
+                100 * error.relativeForceError,
+                100 * errorFactor2.relativeForceError));
+    }
+}
+
 // Computes and returns that largest distance between non-perturbed excluded atom pairs
 static std::tuple<real, int, int> maxNonPerturbedExclusionDistance(const gmx_mtop_t& mtop,
                                                                    const bool        useFep,
@@ -2496,6 +2545,12 @@ int gmx_grompp(int argc, char* argv[])
                 }
 
                 set_verlet_buffer(&sys, ir, buffer_temp, state.x, state.box, &wi, logger);
+
+                if (ir->useMts)
+                {
+                    reportMtsLongRangeForceError(
+                            sys, *ir, buffer_temp, state.x, state.box, &wi, logger);
+                }
             }
         }
     }
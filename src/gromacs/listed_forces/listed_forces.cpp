@@ -71,6 +71,7 @@
 #include "gromacs/utility/enumerationhelpers.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "listed_internal.h"
 #include "manage_threading.h"
@@ -384,9 +385,7 @@ static void calcBondedForces(const InteractionDefinitions&       idef,
                              const gmx::StepWorkload&            stepWork,
                              int*                                global_atom_index)
 {
-#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
-    for (int thread = 0; thread < bt->nthreads; thread++)
-    {
+    auto calcThreadForces = [&](int thread) {
         try
         {
             auto& threadBuffer = bt->threadedForceBuffer.threadForceBuffer(thread);
@@ -453,7 +452,8 @@ static void calcBondedForces(const InteractionDefinitions&       idef,
             }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-    }
+    };
+    gmx::parallelForOnThreads(bt->nthreads, bt->nthreads, calcThreadForces);
 }
 
 bool ListedForces::haveRestraints(const t_fcdata& fcdata) const
@@ -1547,6 +1547,114 @@ real verletBufferPressureError(const gmx_mtop_t&         mtop,
                          effectiveAtomDensity);
 }
 
+/* Returns the integrals over space, in units of the Ewald coefficient beta,
+ * of the squared force and of the squared force derivative of the
+ * long-range Ewald potential w(u) = erf(u)/u between two unit charges.
+ *
+ * The force derivative is the Hessian of w, which has eigenvalues w'' and,
+ * twice, w'/u. The first integral scales with beta, the second with beta^3.
+ */
+static std::pair<double, double> ewaldLongRangeForceIntegrals()
+{
+    // We integrate numerically up to uMax and use the 1/u asymptote for the tail
+    const double uMax      = 12;
+    const int    numPoints = 12000;
+    const double du        = uMax / numPoints;
+
+    double forceIntegral      = 0;
+    double derivativeIntegral = 0;
+    for (int i = 0; i < numPoints; i++)
+    {
+        // Use the midpoint rule to avoid the (removable) singularity at u=0
+        const double u     = (i + 0.5) * du;
+        const double erfu  = std::erf(u);
+        const double expu  = M_2_SQRTPI * std::exp(-u * u);
+        const double md1   = erfu / (u * u) - expu / u;
+        const double d2    = 2 * erfu / (u * u * u) - expu * (2 + 2 / (u * u));
+        const double shell = 4 * M_PI * u * u * du;
+
+        forceIntegral += shell * md1 * md1;
+        derivativeIntegral += shell * (d2 * d2 + 2 * gmx::square(md1 / u));
+    }
+    // The tail with w' = -1/u^2 and w'' = 2/u^3
+    forceIntegral += 4 * M_PI / uMax;
+    derivativeIntegral += 8 * M_PI / gmx::power3(uMax);
+
+    return { forceIntegral, derivativeIntegral };
+}
+
+MtsLongRangeForceError mtsLongRangeForceError(const gmx_mtop_t& mtop,
+                                              const real        effectiveAtomDensity,
+                                              const t_inputrec& ir,
+                                              const int         mtsFactor,
+                                              const real        ensembleTemperature)
+{
+    GMX_RELEASE_ASSERT(usingPme(ir.coulombtype) || ir.coulombtype == CoulombInteractionType::Ewald,
+                       "The MTS force error estimate is only implemented for Ewald electrostatics");
+
+    MtsLongRangeForceError error = { 0, 0 };
+
+    if (ensembleTemperature <= 0 || mtsFactor <= 1 || ir.epsilon_r == 0)
+    {
+        return error;
+    }
+
+    const auto att =
+            getVerletBufferAtomtypes(mtop, false, ir.efep != FreeEnergyPerturbationType::No);
+    GMX_ASSERT(!att.empty(), "We expect at least one type");
+
+    /* The force is evaluated at step 0 of the interval and used for steps
+     * 0 to mtsFactor-1, the mean squared time difference is thus
+     * dt^2 (mtsFactor - 1) (2 mtsFactor - 1) / 6.
+     */
+    const real timePeriod = ir.delta_t * std::sqrt((mtsFactor - 1) * (2 * mtsFactor - 1) / 6.0);
+    const real kT_fac = displacementVariance(ir, ensembleTemperature, timePeriod);
+
+    /* Average q^2 and q^2 times the displacement variance per dimension */
+    double numAtoms                     = 0;
+    double sumChargeSquared             = 0;
+    double sumChargeSquaredDispVariance = 0;
+    for (const VerletbufAtomtype& atomType : att)
+    {
+        real sigma2_2d, sigma2_3d;
+        get_atom_sigma2(kT_fac, atomType.prop, &sigma2_2d, &sigma2_3d);
+
+        const double q2 = gmx::square(atomType.prop.charge());
+        numAtoms += atomType.n;
+        sumChargeSquared += atomType.n * q2;
+        /* For constrained atoms we (over)estimate the displacement per
+         * dimension by adding the 2D rotational variance to the COM variance.
+         */
+        sumChargeSquaredDispVariance += atomType.n * q2 * (sigma2_2d + sigma2_3d);
+    }
+    const double chargeSquared             = sumChargeSquared / numAtoms;
+    const double chargeSquaredDispVariance = sumChargeSquaredDispVariance / numAtoms;
+
+    if (chargeSquared == 0)
+    {
+        return error;
+    }
+
+    const double beta  = calc_ewaldcoeff_q(ir.rcoulomb, ir.ewald_rtol);
+    const double elfac = gmx::c_one4PiEps0 / ir.epsilon_r;
+
+    const auto [forceIntegral, derivativeIntegral] = ewaldLongRangeForceIntegrals();
+
+    /* The variance of the relative displacement of atoms i and j is the sum
+     * of their variances, which gives a factor 2 after averaging over i and j.
+     */
+    const double forceErrorSquared = gmx::square(elfac) * effectiveAtomDensity * gmx::power3(beta)
+                                     * derivativeIntegral * 2 * chargeSquared
+                                     * chargeSquaredDispVariance;
+    const double forceSquared = gmx::square(elfac) * effectiveAtomDensity * beta * forceIntegral
+                                * gmx::square(chargeSquared);
+
+    error.rmsForceError      = std::sqrt(forceErrorSquared);
+    error.relativeForceError = std::sqrt(forceErrorSquared / forceSquared);
+
+    return error;
+}
+
 /* Returns the pairlist buffer size for use as a minimum buffer size
  *
  * Note that this is a rather crude estimate. It is ok for a buffer
@@ -186,6 +186,38 @@ real verletBufferPressureError(const gmx_mtop_t&         mtop,
                                real                      rlist,
                                const VerletbufListSetup& listSetup);
 
+//! Estimates of the error due to evaluating the long-range electrostatic force with MTS
+struct MtsLongRangeForceError
+{
+    //! The RMS error in the long-range force per atom in kJ/mol/nm
+    real rmsForceError;
+    //! The RMS error relative to the RMS long-range force per atom
+    real relativeForceError;
+};
+
+/* Returns an (over)estimate of the error in the long-range electrostatic force with MTS
+ *
+ * With multiple time stepping the long-range Ewald force is computed every
+ * \p mtsFactor steps. This estimates the RMS difference, averaged over
+ * the steps in an MTS interval, between the long-range force computed at
+ * the start of the interval and the force at the current coordinates,
+ * due to the displacement of the atoms. As for the Verlet buffer estimate,
+ * the atoms are assumed to move ballistically with a Gaussian velocity
+ * distribution. Contributions of different atom pairs are assumed to be
+ * uncorrelated, which overestimates the error for neutral molecules.
+ *
+ * \param[in] mtop       The system topology
+ * \param[in] effectiveAtomDensity  The effective atom density, use computeEffectiveAtomDensity()
+ * \param[in] inputrec   The input record, should use Ewald-type electrostatics
+ * \param[in] mtsFactor  The MTS step factor for the long-range force, not taken from \p inputrec
+ * \param[in] ensembleTemperature  The reference temperature for the ensemble
+ */
+MtsLongRangeForceError mtsLongRangeForceError(const gmx_mtop_t& mtop,
+                                              real              effectiveAtomDensity,
+                                              const t_inputrec& inputrec,
+                                              int               mtsFactor,
+                                              real              ensembleTemperature);
+
 /* Convenience type */
 using PartitioningPerMoltype = gmx::ArrayRef<const gmx::RangePartitioning>;
 
@@ -78,6 +78,7 @@
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/listoflists.h"
 #include "gromacs/utility/pleasecite.h"
+#include "gromacs/utility/threadpool.h"
 #include "gromacs/utility/txtdump.h"
 
 namespace gmx
@@ -370,6 +371,9 @@ bool Constraints::apply(bool                      bLog,
                         tensor                    constraintsVirial,
                         ConstraintVariable        econq)
 {
+    // The constraint algorithms use OpenMP
+    const ThreadPoolSpinSuspension threadPoolSpinSuspension;
+
     return impl_->apply(bLog,
                         bEner,
                         step,
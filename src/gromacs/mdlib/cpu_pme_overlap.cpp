@@ -0,0 +1,402 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::CpuPmeOverlap.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "cpu_pme_overlap.h"
+
+#include "config.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if HAVE_SCHED_AFFINITY
+#    include <sched.h>
+#endif
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/force.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/logger.h"
+
+namespace gmx
+{
+
+int cpuPmeOverlapNumThreads(const MDLogger&           mdlog,
+                            const t_commrec*          cr,
+                            const t_inputrec&         ir,
+                            const SimulationWorkload& simulationWork,
+                            const int                 numThreadsOnRank)
+{
+    const char* env = std::getenv("GMX_PME_OVERLAP_THREADS");
+    if (env == nullptr)
+    {
+        return 0;
+    }
+
+    char*     end        = nullptr;
+    const int numThreads = std::strtol(env, &end, 10);
+    if (!end || (*end != 0) || numThreads < 1)
+    {
+        gmx_fatal(FARGS,
+                  "Invalid value passed in GMX_PME_OVERLAP_THREADS=%s, positive integer required",
+                  env);
+    }
+
+    const char* reason = nullptr;
+    if (!(usingPme(ir.coulombtype) || usingLJPme(ir.vdwtype)) || !simulationWork.useCpuPme)
+    {
+        reason = "PME is not computed on the CPU";
+    }
+    else if (!simulationWork.useCpuNonbonded)
+    {
+        reason = "the non-bonded interactions are not computed on the CPU";
+    }
+    else if (PAR(cr))
+    {
+        reason = "it is only supported with a single rank";
+    }
+    else if (EI_TPI(ir.eI) || haveEwaldSurfaceContribution(ir))
+    {
+        reason = "it is not supported with test-particle insertion or Ewald surface terms";
+    }
+    else if (!GMX_OPENMP || numThreads >= numThreadsOnRank)
+    {
+        reason = "fewer PME threads than OpenMP threads are required";
+    }
+
+    if (reason != nullptr)
+    {
+        GMX_LOG(mdlog.warning)
+                .asParagraph()
+                .appendTextFormatted(
+                        "NOTE: GMX_PME_OVERLAP_THREADS is set, but PME is not overlapped with "
+                        "the short-range work, because %s.",
+                        reason);
+        return 0;
+    }
+
+    GMX_LOG(mdlog.info)
+            .asParagraph()
+            .appendTextFormatted(
+                    "Overlapping PME on %d OpenMP threads with the short-range work on %d threads",
+                    numThreads,
+                    numThreadsOnRank - numThreads);
+
+    return numThreads;
+}
+
+class CpuPmeOverlap::Impl
+{
+public:
+    Impl(int numPmeThreads, int numThreadsOnRank);
+    ~Impl();
+
+    //! Passes \p task to the helper thread
+    void launch(std::function<void()>&& task);
+
+    //! Waits for the task to finish, rethrows errors
+    void wait();
+
+    //! The loop executed by the helper thread
+    void run();
+
+    //! The number of OpenMP threads of the helper thread
+    const int numPmeThreads_;
+    //! The total number of OpenMP threads of the rank
+    const int numThreadsOnRank_;
+#if HAVE_SCHED_AFFINITY
+    //! The CPU sets for the helper thread team, empty when they could not be obtained
+    std::vector<cpu_set_t> cpuSets_;
+#endif
+    //! Private force buffer for the long-range forces
+    std::vector<RVec> force_;
+    //! The virial accumulated over the long-range work
+    matrix virial_ = { { 0 } };
+    //! Private energy data for the long-range work, only the reciprocal terms are used
+    gmx_enerdata_t enerd_;
+    //! Private flop counters for the long-range work
+    t_nrnb nrnb_;
+    //! The thread count of the default module outside the overlap region
+    int numDefaultThreads_ = 0;
+
+    //! The task to run, empty when there is no task
+    std::function<void()> task_;
+    //! Whether a task has been launched but not completed
+    bool busy_ = false;
+    //! Tells the helper thread to stop
+    bool stop_ = false;
+    //! An error that occurred on the helper thread
+    std::exception_ptr error_;
+    //! Protects all members above
+    std::mutex mutex_;
+    //! Signals launched and completed tasks
+    std::condition_variable condition_;
+    //! The helper thread
+    std::thread thread_;
+};
+
+CpuPmeOverlap::Impl::Impl(const int numPmeThreads, const int numThreadsOnRank) :
+    numPmeThreads_(numPmeThreads), numThreadsOnRank_(numThreadsOnRank), enerd_(1, nullptr)
+{
+    GMX_RELEASE_ASSERT(numPmeThreads > 0 && numPmeThreads < numThreadsOnRank,
+                       "Need fewer PME threads than threads on the rank");
+
+#if HAVE_SCHED_AFFINITY
+    /* Collect the CPU sets of the last threads of the main team, these
+     * threads are idle while the short-range work runs on the others.
+     */
+    cpuSets_.resize(numPmeThreads_);
+    std::vector<int> status(numPmeThreads_, 0);
+    const int        threadOffset = numThreadsOnRank_ - numPmeThreads_;
+#    pragma omp parallel num_threads(numThreadsOnRank_)
+    {
+        const int thread = gmx_omp_get_thread_num();
+        if (thread >= threadOffset)
+        {
+            status[thread - threadOffset] =
+                    sched_getaffinity(0, sizeof(cpu_set_t), &cpuSets_[thread - threadOffset]);
+        }
+    }
+    if (std::any_of(status.begin(), status.end(), [](int s) { return s != 0; }))
+    {
+        cpuSets_.clear();
+    }
+#endif
+
+    thread_ = std::thread(&CpuPmeOverlap::Impl::run, this);
+}
+
+CpuPmeOverlap::Impl::~Impl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void CpuPmeOverlap::Impl::launch(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        GMX_RELEASE_ASSERT(!busy_, "Can only launch when the previous task has completed");
+        task_ = std::move(task);
+        busy_ = true;
+    }
+    condition_.notify_all();
+}
+
+void CpuPmeOverlap::Impl::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return !busy_; });
+    if (error_)
+    {
+        std::exception_ptr error = error_;
+        error_                   = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void CpuPmeOverlap::Impl::run()
+{
+    /* The helper thread is an initial thread for OpenMP with its own team */
+    gmx_omp_set_num_threads(numPmeThreads_);
+
+#if HAVE_SCHED_AFFINITY
+    /* The helper thread inherited the affinity of the main thread, move the team
+     * to the cores of the main team threads that are idle during the overlap.
+     */
+    if (!cpuSets_.empty())
+    {
+#    pragma omp parallel num_threads(numPmeThreads_)
+        {
+            const int thread = gmx_omp_get_thread_num();
+            // Failure only affects performance, so we ignore the return value
+            sched_setaffinity(0, sizeof(cpu_set_t), &cpuSets_[thread]);
+        }
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this] { return task_ || stop_; });
+        if (!task_)
+        {
+            break;
+        }
+        std::function<void()> task = std::move(task_);
+        task_                      = nullptr;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        busy_  = false;
+        error_ = error;
+        condition_.notify_all();
+    }
+}
+
+CpuPmeOverlap::CpuPmeOverlap(const int numPmeThreads, const int numThreadsOnRank) :
+    impl_(std::make_unique<Impl>(numPmeThreads, numThreadsOnRank))
+{
+}
+
+CpuPmeOverlap::~CpuPmeOverlap() = default;
+
+void CpuPmeOverlap::launch(CpuPpLongRangeNonbondeds*     longRangeNonbondeds,
+                           gmx_pme_t*                    pmedata,
+                           const t_commrec*              cr,
+                           ArrayRef<const RVec>          coordinates,
+                           const int                     numForces,
+                           const matrix                  box,
+                           ArrayRef<const real>          lambda,
+                           ArrayRef<const RVec>          muTot,
+                           const StepWorkload&           stepWork,
+                           const DDBalanceRegionHandler& ddBalanceRegionHandler)
+{
+    Impl* impl = impl_.get();
+
+    /* Reallocation is rare, so we do this on the main thread */
+    impl->force_.resize(numForces);
+
+    /* The cycle counters are not thread safe, so the helper thread does not use them */
+    clear_nrnb(&impl->nrnb_);
+    longRangeNonbondeds->setCounters(&impl->nrnb_, nullptr);
+
+    /* Keep OpenMP regions on the main thread off the cores of the PME threads */
+    const int numShortRangeThreads = impl->numThreadsOnRank_ - impl->numPmeThreads_;
+    impl->numDefaultThreads_       = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+    gmx_omp_nthreads_set(ModuleMultiThread::Default,
+                         std::min(impl->numDefaultThreads_, numShortRangeThreads));
+
+    impl->enerd_.term[F_COUL_RECIP]                                   = 0;
+    impl->enerd_.term[F_LJ_RECIP]                                     = 0;
+    impl->enerd_.dvdl_lin[FreeEnergyPerturbationCouplingType::Coul] = 0;
+    impl->enerd_.dvdl_lin[FreeEnergyPerturbationCouplingType::Vdw]  = 0;
+
+    impl->launch([=, &stepWork, &ddBalanceRegionHandler]() {
+        const int numThreads = impl->numPmeThreads_;
+        RVec*     force      = impl->force_.data();
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int i = 0; i < numForces; i++)
+        {
+            clear_rvec(force[i]);
+        }
+
+        ForceWithVirial forceWithVirial(impl->force_, stepWork.computeVirial);
+        longRangeNonbondeds->calculate(pmedata,
+                                       cr,
+                                       coordinates,
+                                       &forceWithVirial,
+                                       &impl->enerd_,
+                                       box,
+                                       lambda,
+                                       muTot,
+                                       stepWork,
+                                       ddBalanceRegionHandler);
+        copy_mat(forceWithVirial.getVirial(), impl->virial_);
+    });
+}
+
+void CpuPmeOverlap::waitAndReduce(ForceWithVirial* forceWithVirial,
+                                  gmx_enerdata_t*  enerd,
+                                  t_nrnb*          nrnb,
+                                  gmx_wallcycle*   wcycle)
+{
+    wallcycle_start(wcycle, WallCycleCounter::PmeMesh);
+    impl_->wait();
+    wallcycle_stop(wcycle, WallCycleCounter::PmeMesh);
+    gmx_omp_nthreads_set(ModuleMultiThread::Default, impl_->numDefaultThreads_);
+
+    ArrayRef<RVec>       force     = forceWithVirial->force_;
+    ArrayRef<const RVec> pmeForce  = impl_->force_;
+    const int            numForces = pmeForce.ssize();
+    GMX_ASSERT(force.ssize() >= numForces, "The force buffer should be large enough");
+#pragma omp parallel for num_threads(impl_->numThreadsOnRank_) schedule(static)
+    for (int i = 0; i < numForces; i++)
+    {
+        rvec_inc(force[i], pmeForce[i]);
+    }
+    forceWithVirial->addVirialContribution(impl_->virial_);
+
+    enerd->term[F_COUL_RECIP] += impl_->enerd_.term[F_COUL_RECIP];
+    enerd->term[F_LJ_RECIP] += impl_->enerd_.term[F_LJ_RECIP];
+    enerd->dvdl_lin[FreeEnergyPerturbationCouplingType::Coul] +=
+            impl_->enerd_.dvdl_lin[FreeEnergyPerturbationCouplingType::Coul];
+    enerd->dvdl_lin[FreeEnergyPerturbationCouplingType::Vdw] +=
+            impl_->enerd_.dvdl_lin[FreeEnergyPerturbationCouplingType::Vdw];
+
+    for (int i = 0; i < eNRNB; i++)
+    {
+        nrnb->n[i] += impl_->nrnb_.n[i];
+    }
+}
+
+} // namespace gmx
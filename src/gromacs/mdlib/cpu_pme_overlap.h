@@ -0,0 +1,157 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::CpuPmeOverlap for running CPU PME concurrently with the short-range work.
+ *
+ * \inlibraryapi
+ * \ingroup module_mdlib
+ */
+#ifndef GMX_MDLIB_CPU_PME_OVERLAP_H
+#define GMX_MDLIB_CPU_PME_OVERLAP_H
+
+#include <memory>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+class CpuPpLongRangeNonbondeds;
+class DDBalanceRegionHandler;
+struct gmx_enerdata_t;
+struct gmx_pme_t;
+struct gmx_wallcycle;
+struct t_commrec;
+struct t_inputrec;
+struct t_nrnb;
+
+namespace gmx
+{
+class ForceWithVirial;
+class MDLogger;
+class SimulationWorkload;
+class StepWorkload;
+
+/*! \brief Returns the number of threads to run CPU PME on concurrently with the short-range work
+ *
+ * The count is taken from the GMX_PME_OVERLAP_THREADS environment variable.
+ * Returns 0, with a note in the log, when that is not set or when the setup
+ * does not support overlap: this requires a single rank with both PME and
+ * the non-bonded interactions on the CPU.
+ *
+ * \param[in] mdlog             Logger
+ * \param[in] cr                Communication record
+ * \param[in] ir                The input record
+ * \param[in] simulationWork    The simulation workload
+ * \param[in] numThreadsOnRank  The total number of OpenMP threads of this rank
+ */
+int cpuPmeOverlapNumThreads(const MDLogger&           mdlog,
+                            const t_commrec*          cr,
+                            const t_inputrec&         ir,
+                            const SimulationWorkload& simulationWork,
+                            int                       numThreadsOnRank);
+
+/*! \libinternal \brief Runs the CPU long-range non-bonded work on a separate set of threads
+ *
+ * Normally PME spread, FFT, solve and gather run after the non-bonded
+ * and listed forces, each using all OpenMP threads of the rank. With many
+ * threads the fork-join overhead and the poor scaling of the 3D FFT then
+ * dominate. This class owns a helper thread with its own OpenMP team of
+ * numPmeThreads threads, pinned to the cores of the last threads of the
+ * main team. While the main thread computes the short-range forces with
+ * the remaining threads, the helper thread computes the long-range forces,
+ * energies, virial and flop counts into private buffers. These are reduced
+ * into the normal outputs by waitAndReduce(). The helper thread does not
+ * use the cycle counters, as these are not thread safe. Instead the time
+ * the main thread waits for the long-range work is counted as PME mesh time.
+ *
+ * The caller is responsible for setting the number of threads of the PME,
+ * non-bonded and bonded modules such that PME and the short-range work
+ * together use numThreadsOnRank threads. Between launch() and
+ * waitAndReduce() the thread count of the default module is reduced
+ * to that of the short-range work, so regions on the main thread
+ * do not use the cores of the PME threads.
+ */
+class CpuPmeOverlap
+{
+public:
+    /*! \brief Starts the helper thread, should be called after the main thread team is pinned
+     *
+     * \param[in] numPmeThreads     The number of OpenMP threads for the long-range work
+     * \param[in] numThreadsOnRank  The total number of OpenMP threads of this rank
+     */
+    CpuPmeOverlap(int numPmeThreads, int numThreadsOnRank);
+
+    //! Stops the helper thread
+    ~CpuPmeOverlap();
+
+    /*! \brief Launches CpuPpLongRangeNonbondeds::calculate() on the helper thread
+     *
+     * All arguments except \p numForces are passed on to calculate() and should
+     * remain valid until waitAndReduce() is called. The forces are accumulated
+     * in a private buffer of \p numForces elements. Sets the counters of
+     * \p longRangeNonbondeds to the private counters of this object.
+     */
+    void launch(CpuPpLongRangeNonbondeds*     longRangeNonbondeds,
+                gmx_pme_t*                    pmedata,
+                const t_commrec*              cr,
+                ArrayRef<const RVec>          coordinates,
+                int                           numForces,
+                const matrix                  box,
+                ArrayRef<const real>          lambda,
+                ArrayRef<const RVec>          muTot,
+                const StepWorkload&           stepWork,
+                const DDBalanceRegionHandler& ddBalanceRegionHandler);
+
+    /*! \brief Waits for the launched work and adds its output to the force, energy and flop outputs
+     *
+     * The waiting time is counted as PME mesh time in \p wcycle.
+     *
+     * \throws any exception thrown on the helper thread.
+     */
+    void waitAndReduce(ForceWithVirial* forceWithVirial,
+                       gmx_enerdata_t*  enerd,
+                       t_nrnb*          nrnb,
+                       gmx_wallcycle*   wcycle);
+
+private:
+    class Impl;
+
+    //! Implementation object
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
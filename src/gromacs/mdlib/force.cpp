@@ -146,6 +146,12 @@ void CpuPpLongRangeNonbondeds::updateAfterPartition(const t_mdatoms& md)
     sigmaB_        = md.sigmaB;
 }
 
+void CpuPpLongRangeNonbondeds::setCounters(t_nrnb* nrnb, gmx_wallcycle* wcycle)
+{
+    nrnb_   = nrnb;
+    wcycle_ = wcycle;
+}
+
 void CpuPpLongRangeNonbondeds::calculate(gmx_pme_t*                     pmedata,
                                          const t_commrec*               commrec,
                                          gmx::ArrayRef<const RVec>      coordinates,
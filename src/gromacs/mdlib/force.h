@@ -164,6 +164,13 @@ public:
 
     void updateAfterPartition(const t_mdatoms& md);
 
+    /* \brief Sets the flop and cycle counters used by calculate()
+     *
+     * Used when calculate() runs concurrently with other work that uses
+     * the counters passed to the constructor. \p wcycle can be nullptr.
+     */
+    void setCounters(t_nrnb* nrnb, gmx_wallcycle* wcycle);
+
     /* Calculate CPU Ewald or PME-mesh forces when done on this rank and Ewald corrections, when used
      *
      * Note that Ewald dipole and net charge corrections are always computed here, independently
@@ -37,16 +37,27 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/energyoutput.h"
+#include "gromacs/mdlib/trajectorywriterthread.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/mdrunutility/multisim.h"
 #include "gromacs/mdtypes/awh_history.h"
@@ -63,10 +74,12 @@
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/baseversion.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/sysinfo.h"
 
 struct gmx_mdoutf
@@ -93,9 +106,167 @@ struct gmx_mdoutf
     const gmx::MDModulesNotifiers* mdModulesNotifiers;
     bool                           simulationsShareState;
     MPI_Comm                       mainRanksComm;
+
+    /* The frame indices of the XTC and TRR files, extended for each written frame when requested */
+    std::unique_ptr<gmx::TrajectoryFrameIndex> xtcFrameIndex;
+    std::unique_ptr<gmx::TrajectoryFrameIndex> trrFrameIndex;
+    /* Writes the trajectory frames on a separate thread, only on the main rank when requested */
+    std::unique_ptr<gmx::TrajectoryWriterThread> trajectoryWriter;
+    /* Whether each DD rank writes the coordinates and velocities of its home atoms
+     * to the checkpoint, instead of collecting them on the main rank; set on all ranks */
+    bool writeDistributedCheckpoint;
+    /* With AWH, every this many checkpoints a full reference checkpoint is written,
+     * the others only store the AWH data that changed; 0 when not used */
+    int fullCheckpointInterval;
+    /* The AWH reference for incremental checkpoints, only on the main rank */
+    std::unique_ptr<CheckpointAwhReference> awhReference;
+    /* The number of incremental checkpoints written since the reference */
+    int numIncrementalCheckpoints;
+    /* The reference before the current one, removed when no longer referred to */
+    std::filesystem::path previousAwhReferencePath;
 };
 
 
+/*! \brief Writes the output data of a step to the trajectory files
+ *
+ * \p x should be present with MDOF_X and MDOF_X_COMPRESSED, \p v with
+ * MDOF_V and \p f with MDOF_F.
+ */
+static void write_trajectory_frame(gmx_mdoutf_t of,
+                                   int          mdof_flags,
+                                   int          natoms,
+                                   int64_t      step,
+                                   double       t,
+                                   real         lambda,
+                                   const rvec*  box,
+                                   const rvec*  x,
+                                   const rvec*  v,
+                                   const rvec*  f)
+{
+    if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+    {
+        const rvec* xOut = (mdof_flags & MDOF_X) ? x : nullptr;
+        const rvec* vOut = (mdof_flags & MDOF_V) ? v : nullptr;
+        const rvec* fOut = (mdof_flags & MDOF_F) ? f : nullptr;
+
+        if (of->fp_trn)
+        {
+            gmx_trr_write_frame(of->fp_trn, step, t, lambda, box, natoms, xOut, vOut, fOut);
+            if (gmx_fio_flush(of->fp_trn) != 0)
+            {
+                GMX_THROW(gmx::FileIOError(
+                        "Cannot write trajectory; maybe you are out of disk space?"));
+            }
+            if (of->trrFrameIndex)
+            {
+                of->trrFrameIndex->appendFrame(
+                        step, static_cast<real>(t), natoms, gmx_fio_ftell(of->fp_trn));
+            }
+        }
+
+        /* If a TNG file is open for uncompressed coordinate output also write
+           velocities and forces to it. */
+        else if (of->tng)
+        {
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, xOut, vOut, fOut);
+        }
+        /* If only a TNG file is open for compressed coordinate output (no uncompressed
+           coordinate output) also write forces and velocities to it. */
+        else if (of->tng_low_prec)
+        {
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, xOut, vOut, fOut);
+        }
+    }
+    if (mdof_flags & MDOF_X_COMPRESSED)
+    {
+        const rvec* xxtc       = nullptr;
+        rvec*       xxtcSubset = nullptr;
+
+        if (of->natoms_x_compressed == of->natoms_global)
+        {
+            /* We are writing the positions of all of the atoms to
+               the compressed output */
+            xxtc = x;
+        }
+        else
+        {
+            /* We are writing the positions of only a subset of
+               the atoms to the compressed output, so we have to
+               make a copy of the subset of coordinates. */
+            int i, j;
+
+            snew(xxtcSubset, of->natoms_x_compressed);
+            for (i = 0, j = 0; (i < of->natoms_global); i++)
+            {
+                if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                {
+                    copy_rvec(x[i], xxtcSubset[j++]);
+                }
+            }
+            xxtc = xxtcSubset;
+        }
+        if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, box, xxtc, of->x_compression_precision)
+            == 0)
+        {
+            GMX_THROW(gmx::FileIOError(
+                    "XTC error. This indicates you are out of disk space, or a "
+                    "simulation with major instabilities resulting in coordinates "
+                    "that are NaN or too large to be represented in the XTC format."));
+        }
+        if (of->xtcFrameIndex)
+        {
+            of->xtcFrameIndex->appendFrame(
+                    step, static_cast<real>(t), of->natoms_x_compressed, gmx_fio_ftell(of->fp_xtc));
+        }
+        gmx_fwrite_tng(of->tng_low_prec,
+                       TRUE,
+                       step,
+                       t,
+                       lambda,
+                       box,
+                       of->natoms_x_compressed,
+                       xxtc,
+                       nullptr,
+                       nullptr);
+        sfree(xxtcSubset);
+    }
+    if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
+    {
+        if (of->tng)
+        {
+            real        lambdaOut = -1;
+            const rvec* boxOut    = nullptr;
+            if (mdof_flags & MDOF_BOX)
+            {
+                boxOut = box;
+            }
+            if (mdof_flags & MDOF_LAMBDA)
+            {
+                lambdaOut = lambda;
+            }
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambdaOut, boxOut, natoms, nullptr, nullptr, nullptr);
+        }
+    }
+    if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED)
+        && !(mdof_flags & (MDOF_X_COMPRESSED)))
+    {
+        if (of->tng_low_prec)
+        {
+            real        lambdaOut = -1;
+            const rvec* boxOut    = nullptr;
+            if (mdof_flags & MDOF_BOX_COMPRESSED)
+            {
+                boxOut = box;
+            }
+            if (mdof_flags & MDOF_LAMBDA_COMPRESSED)
+            {
+                lambdaOut = lambda;
+            }
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambdaOut, boxOut, natoms, nullptr, nullptr, nullptr);
+        }
+    }
+}
+
 gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
                          int                            nfile,
                          const t_filenm                 fnm[],
@@ -117,7 +288,7 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
     int          i;
     bool restartWithAppending = (startingBehavior == gmx::StartingBehavior::RestartWithAppending);
 
-    snew(of, 1);
+    of = new gmx_mdoutf();
 
     of->fp_trn       = nullptr;
     of->fp_ene       = nullptr;
@@ -143,6 +314,15 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         of->mainRanksComm = ms->mainRanksComm_;
     }
 
+    of->writeDistributedCheckpoint = (GMX_MPI && haveDDAtomOrdering(*cr) && cr->dd->nnodes > 1
+                                      && getenv("GMX_DISTRIBUTED_CHECKPOINT") != nullptr);
+    if (of->writeDistributedCheckpoint && fplog)
+    {
+        fprintf(fplog,
+                "Each domain will write the coordinates and velocities of its atoms to the "
+                "checkpoint file\n");
+    }
+
     if (MAIN(cr))
     {
         of->bKeepAndNumCPT = mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles;
@@ -155,7 +335,14 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
             filename = ftp2fn(efCOMPRESSED, nfile, fnm);
             switch (fn2ftp(filename))
             {
-                case efXTC: of->fp_xtc = open_xtc(filename, filemode); break;
+                case efXTC:
+                    of->fp_xtc = open_xtc(filename, filemode);
+                    if (gmx::TrajectoryFrameIndex::isRequested())
+                    {
+                        of->xtcFrameIndex = std::make_unique<gmx::TrajectoryFrameIndex>(
+                                gmx::TrajectoryFrameIndex::forAppending(filename));
+                    }
+                    break;
                 case efTNG:
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
                     if (filemode[0] == 'w')
@@ -183,6 +370,11 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
                     if (ir->nstxout != 0 || ir->nstxout_compressed == 0 || !of->tng_low_prec)
                     {
                         of->fp_trn = gmx_trr_open(filename, filemode);
+                        if (gmx::TrajectoryFrameIndex::isRequested())
+                        {
+                            of->trrFrameIndex = std::make_unique<gmx::TrajectoryFrameIndex>(
+                                    gmx::TrajectoryFrameIndex::forAppending(filename));
+                        }
                     }
                     break;
                 case efTNG:
@@ -202,6 +394,20 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         }
         of->fn_cpt = opt2fn("-cpo", nfile, fnm);
 
+        of->fullCheckpointInterval    = 0;
+        of->numIncrementalCheckpoints = 0;
+        if (const char* env = getenv("GMX_INCREMENTAL_CHECKPOINT"))
+        {
+            of->fullCheckpointInterval = std::max(std::atoi(env), 0);
+            if (ir->bDoAwh && of->fullCheckpointInterval > 1 && fplog)
+            {
+                fprintf(fplog,
+                        "Every %d checkpoints the full AWH history is written, the other "
+                        "checkpoints only store the AWH data that changed\n",
+                        of->fullCheckpointInterval);
+            }
+        }
+
         if ((ir->efep != FreeEnergyPerturbationType::No || ir->bSimTemp) && ir->fepvals->nstdhdl > 0
             && (ir->fepvals->separate_dhdl_file == SeparateDhdlFile::Yes) && EI_DYNAMICS(ir->eI))
         {
@@ -237,6 +443,29 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
         {
             snew(of->f_global, top_global.natoms);
         }
+
+        if (getenv("GMX_ASYNC_TRAJECTORY_OUTPUT") != nullptr
+            && (of->fp_trn || of->fp_xtc || of->tng || of->tng_low_prec))
+        {
+            of->trajectoryWriter = std::make_unique<gmx::TrajectoryWriterThread>(
+                    [of](const gmx::TrajectoryFrame& frame)
+                    {
+                        write_trajectory_frame(of,
+                                               frame.mdof_flags,
+                                               frame.natoms,
+                                               frame.step,
+                                               frame.t,
+                                               frame.lambda,
+                                               frame.box,
+                                               as_rvec_array(frame.x.data()),
+                                               as_rvec_array(frame.v.data()),
+                                               as_rvec_array(frame.f.data()));
+                    });
+            if (fplog)
+            {
+                fprintf(fplog, "Trajectory frames will be written on a separate thread\n");
+            }
+        }
     }
 
     if (bCiteTng)
@@ -247,6 +476,11 @@ gmx_mdoutf_t init_mdoutf(FILE*                          fplog,
     return of;
 }
 
+bool mdoutf_writes_distributed_checkpoint(gmx_mdoutf_t of)
+{
+    return of->writeDistributedCheckpoint;
+}
+
 ener_file_t mdoutf_get_fp_ene(gmx_mdoutf_t of)
 {
     return of->fp_ene;
@@ -274,29 +508,44 @@ static void mpiBarrierBeforeRename(const bool applyMpiBarrierBeforeRename, MPI_C
 #endif
     }
 }
+/*! \brief Writes the atom blocks of a checkpoint
+ *
+ * Called on the main rank with the temporary checkpoint file name and
+ * the file offsets of the blocks, after the rest of the checkpoint
+ * has been written.
+ */
+using WriteAtomBlocksFunction = std::function<void(const char*, gmx::ArrayRef<const int64_t>)>;
+
 /*! \brief Write a checkpoint to the filename
  *
  * Appends the _step<step>.cpt with bNumberAndKeep, otherwise moves
  * the previous checkpoint filename with suffix _prev.cpt.
+ * With \p atomBlockNumAtoms not empty, the coordinates and velocities
+ * are written in blocks by \p writeAtomBlocks. With \p awhReference,
+ * the AWH history is written relative to that reference.
+ * Returns the name of the written file.
  */
-static void write_checkpoint(const char*                     fn,
-                             gmx_bool                        bNumberAndKeep,
-                             FILE*                           fplog,
-                             const t_commrec*                cr,
-                             ivec                            domdecCells,
-                             int                             nppnodes,
-                             IntegrationAlgorithm            eIntegrator,
-                             int                             simulation_part,
-                             gmx_bool                        bExpanded,
-                             LambdaWeightCalculation         elamstats,
-                             int64_t                         step,
-                             double                          t,
-                             t_state*                        state,
-                             ObservablesHistory*             observablesHistory,
-                             const gmx::MDModulesNotifiers&  mdModulesNotifiers,
-                             gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
-                             bool                            applyMpiBarrierBeforeRename,
-                             MPI_Comm                        mpiBarrierCommunicator)
+static std::string write_checkpoint(const char*                     fn,
+                                    gmx_bool                        bNumberAndKeep,
+                                    FILE*                           fplog,
+                                    const t_commrec*                cr,
+                                    ivec                            domdecCells,
+                                    int                             nppnodes,
+                                    IntegrationAlgorithm            eIntegrator,
+                                    int                             simulation_part,
+                                    gmx_bool                        bExpanded,
+                                    LambdaWeightCalculation         elamstats,
+                                    int64_t                         step,
+                                    double                          t,
+                                    t_state*                        state,
+                                    ObservablesHistory*             observablesHistory,
+                                    const gmx::MDModulesNotifiers&  mdModulesNotifiers,
+                                    gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
+                                    bool                            applyMpiBarrierBeforeRename,
+                                    MPI_Comm                        mpiBarrierCommunicator,
+                                    gmx::ArrayRef<const int>        atomBlockNumAtoms,
+                                    const WriteAtomBlocksFunction&  writeAtomBlocks,
+                                    const CheckpointAwhReference*   awhReference)
 {
     t_fileio* fp;
     char*     fntemp; /* the temporary checkpoint file name */
@@ -390,15 +639,26 @@ static void write_checkpoint(const char*                     fn,
         copy_ivec(domdecCells, headerContents.dd_nc);
     }
 
-    write_checkpoint_data(fp,
-                          headerContents,
-                          bExpanded,
-                          elamstats,
-                          state,
-                          observablesHistory,
-                          mdModulesNotifiers,
-                          &outputfiles,
-                          modularSimulatorCheckpointData);
+    const std::vector<int64_t> atomBlockOffsets = write_checkpoint_data(fp,
+                                                                        headerContents,
+                                                                        bExpanded,
+                                                                        elamstats,
+                                                                        state,
+                                                                        observablesHistory,
+                                                                        mdModulesNotifiers,
+                                                                        &outputfiles,
+                                                                        modularSimulatorCheckpointData,
+                                                                        atomBlockNumAtoms,
+                                                                        awhReference);
+    if (!atomBlockOffsets.empty())
+    {
+        /* The blocks are written through other file handles */
+        if (gmx_fio_flush(fp) != 0)
+        {
+            gmx_file("Cannot write checkpoint; maybe you are out of disk space?");
+        }
+        writeAtomBlocks(fntemp, atomBlockOffsets);
+    }
 
     /* we really, REALLY, want to make sure to physically write the checkpoint,
        and all the files it depends on, out to disk. Because we've
@@ -481,6 +741,13 @@ static void write_checkpoint(const char*                     fn,
     }
 #endif /* GMX_NO_RENAME */
 
+    std::string writtenFileName = fntemp;
+#if !GMX_NO_RENAME
+    if (!bNumberAndKeep && !ret)
+    {
+        writtenFileName = fn;
+    }
+#endif
     sfree(fntemp);
 
 #if GMX_FAHCORE
@@ -499,43 +766,197 @@ static void write_checkpoint(const char*                     fn,
      */
     fcCheckpoint();
 #endif /* end GMX_FAHCORE block */
+
+    return writtenFileName;
 }
 
-void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
-                             FILE*                           fplog,
-                             const t_commrec*                cr,
-                             int64_t                         step,
-                             double                          t,
-                             t_state*                        state_global,
-                             ObservablesHistory*             observablesHistory,
-                             gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData)
+/*! \brief Makes the checkpoint \p checkpointFile the reference for incremental AWH checkpoints
+ *
+ * The file is copied to <checkpoint>_ref_step<step>.cpt, the incremental
+ * checkpoints store this unique name. Without numbered checkpoints, the
+ * reference before the previous one is removed, as neither the current
+ * nor the previous checkpoint refers to it. With numbered checkpoints all
+ * references are kept, since the kept checkpoints can refer to any of them.
+ */
+static void updateAwhReference(gmx_mdoutf_t           of,
+                               const std::string&     checkpointFile,
+                               int64_t                step,
+                               const gmx::AwhHistory& awhHistory)
+{
+    const std::filesystem::path checkpoint(of->fn_cpt);
+    std::filesystem::path       reference = checkpoint;
+    reference.replace_filename(gmx::formatString("%s_ref_step%" PRId64 "%s",
+                                                 checkpoint.stem().string().c_str(),
+                                                 step,
+                                                 checkpoint.extension().string().c_str()));
+
+    if (gmx_file_copy(checkpointFile, reference, FALSE) != 0)
+    {
+        /* Without reference we keep writing full checkpoints */
+        gmx_warning("Cannot copy checkpoint file %s to %s, writing full checkpoints",
+                    checkpointFile.c_str(),
+                    reference.string().c_str());
+        of->awhReference.reset();
+        return;
+    }
+
+    if (!of->bKeepAndNumCPT && !of->previousAwhReferencePath.empty()
+        && gmx_fexist(of->previousAwhReferencePath))
+    {
+        std::filesystem::remove(of->previousAwhReferencePath);
+    }
+    if (of->awhReference)
+    {
+        of->previousAwhReferencePath = checkpoint;
+        of->previousAwhReferencePath.replace_filename(of->awhReference->fileName);
+    }
+
+    of->awhReference             = std::make_unique<CheckpointAwhReference>();
+    of->awhReference->step       = step;
+    of->awhReference->fileName   = reference.filename().string();
+    of->awhReference->awhHistory = awhHistory;
+    of->numIncrementalCheckpoints = 0;
+}
+
+//! Writes the checkpoint, optionally with atom blocks, see write_checkpoint()
+static void writeCheckpointFile(gmx_mdoutf_t                    of,
+                                FILE*                           fplog,
+                                const t_commrec*                cr,
+                                int64_t                         step,
+                                double                          t,
+                                t_state*                        state_global,
+                                ObservablesHistory*             observablesHistory,
+                                gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
+                                gmx::ArrayRef<const int>        atomBlockNumAtoms,
+                                const WriteAtomBlocksFunction&  writeAtomBlocks)
 {
+    /* The checkpoint stores the output file positions, so all frames should be written */
+    if (of->trajectoryWriter)
+    {
+        of->trajectoryWriter->waitUntilWritten();
+    }
     fflush_tng(of->tng);
     fflush_tng(of->tng_low_prec);
+    /* With incremental checkpoints, the AWH history is written relative to the reference */
+    const bool haveAwhHistory =
+            (state_global->awhHistory != nullptr && !state_global->awhHistory->bias.empty());
+    const bool useIncrementalCheckpoints = (haveAwhHistory && of->fullCheckpointInterval > 1);
+    const bool writeIncremental =
+            (useIncrementalCheckpoints && of->awhReference
+             && of->numIncrementalCheckpoints < of->fullCheckpointInterval - 1);
     /* Write the checkpoint file.
      * When simulations share the state, an MPI barrier is applied before
      * renaming old and new checkpoint files to minimize the risk of
      * checkpoint files getting out of sync.
      */
     ivec one_ivec = { 1, 1, 1 };
-    write_checkpoint(of->fn_cpt,
-                     of->bKeepAndNumCPT,
-                     fplog,
-                     cr,
-                     haveDDAtomOrdering(*cr) ? cr->dd->numCells : one_ivec,
-                     haveDDAtomOrdering(*cr) ? cr->dd->nnodes : cr->nnodes,
-                     of->eIntegrator,
-                     of->simulation_part,
-                     of->bExpanded,
-                     of->elamstats,
-                     step,
-                     t,
-                     state_global,
-                     observablesHistory,
-                     *(of->mdModulesNotifiers),
-                     modularSimulatorCheckpointData,
-                     of->simulationsShareState,
-                     of->mainRanksComm);
+    const std::string checkpointFile =
+            write_checkpoint(of->fn_cpt,
+                             of->bKeepAndNumCPT,
+                             fplog,
+                             cr,
+                             haveDDAtomOrdering(*cr) ? cr->dd->numCells : one_ivec,
+                             haveDDAtomOrdering(*cr) ? cr->dd->nnodes : cr->nnodes,
+                             of->eIntegrator,
+                             of->simulation_part,
+                             of->bExpanded,
+                             of->elamstats,
+                             step,
+                             t,
+                             state_global,
+                             observablesHistory,
+                             *(of->mdModulesNotifiers),
+                             modularSimulatorCheckpointData,
+                             of->simulationsShareState,
+                             of->mainRanksComm,
+                             atomBlockNumAtoms,
+                             writeAtomBlocks,
+                             writeIncremental ? of->awhReference.get() : nullptr);
+
+    if (writeIncremental)
+    {
+        of->numIncrementalCheckpoints++;
+    }
+    else if (useIncrementalCheckpoints)
+    {
+        updateAwhReference(of, checkpointFile, step, *state_global->awhHistory);
+    }
+}
+
+void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
+                             FILE*                           fplog,
+                             const t_commrec*                cr,
+                             int64_t                         step,
+                             double                          t,
+                             t_state*                        state_global,
+                             ObservablesHistory*             observablesHistory,
+                             gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData)
+{
+    writeCheckpointFile(
+            of, fplog, cr, step, t, state_global, observablesHistory, modularSimulatorCheckpointData, {}, {});
+}
+
+/*! \brief Returns the number of home atoms of each DD rank on the main rank, empty on other ranks
+ *
+ * Must be called on all DD ranks.
+ */
+static std::vector<int> gatherNumHomeAtoms(const gmx_domdec_t& dd)
+{
+    std::vector<int> numHomeAtoms(DDMAIN(dd) ? dd.nnodes : 0);
+#if GMX_MPI
+    int localNumHomeAtoms = dd.numHomeAtoms;
+    MPI_Gather(
+            &localNumHomeAtoms, 1, MPI_INT, numHomeAtoms.data(), 1, MPI_INT, dd.mainrank, dd.mpi_comm_all);
+#else
+    GMX_UNUSED_VALUE(dd);
+#endif
+    return numHomeAtoms;
+}
+
+/*! \brief Writes the home atoms of this DD rank as an atom block of the checkpoint
+ *
+ * Must be called on all DD ranks. The file name \p fn and the block
+ * offsets \p blockOffsets, ordered by rank, are only used on the main rank.
+ * Returns after all ranks have written their block.
+ */
+static void writeLocalCheckpointAtomBlock(const gmx_domdec_t&          dd,
+                                          const t_state&               localState,
+                                          const char*                  fn,
+                                          gmx::ArrayRef<const int64_t> blockOffsets)
+{
+#if GMX_MPI
+    int fnLength = DDMAIN(dd) ? std::strlen(fn) + 1 : 0;
+    MPI_Bcast(&fnLength, 1, MPI_INT, dd.mainrank, dd.mpi_comm_all);
+    std::vector<char> fnBuffer(fnLength);
+    if (DDMAIN(dd))
+    {
+        std::strcpy(fnBuffer.data(), fn);
+    }
+    MPI_Bcast(fnBuffer.data(), fnLength, MPI_CHAR, dd.mainrank, dd.mpi_comm_all);
+    int64_t offset = 0;
+    MPI_Scatter(
+            blockOffsets.data(), 1, MPI_INT64_T, &offset, 1, MPI_INT64_T, dd.mainrank, dd.mpi_comm_all);
+
+    const int                      numAtoms = dd.numHomeAtoms;
+    gmx::ArrayRef<const gmx::RVec> v;
+    if (localState.hasEntry(StateEntry::V))
+    {
+        v = gmx::constArrayRefFromArray(localState.v.data(), numAtoms);
+    }
+    write_checkpoint_atom_block(fnBuffer.data(),
+                                offset,
+                                gmx::constArrayRefFromArray(dd.globalAtomGroupIndices.data(), numAtoms),
+                                gmx::constArrayRefFromArray(localState.x.data(), numAtoms),
+                                v);
+
+    /* The checkpoint can only be renamed after all blocks have been written */
+    MPI_Barrier(dd.mpi_comm_all);
+#else
+    GMX_UNUSED_VALUE(dd);
+    GMX_UNUSED_VALUE(localState);
+    GMX_UNUSED_VALUE(fn);
+    GMX_UNUSED_VALUE(blockOffsets);
+#endif
 }
 
 void mdoutf_write_to_trajectory_files(FILE*                           fplog,
@@ -553,14 +974,23 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
 {
     const rvec* f_global;
 
+    const bool writeDistributedCheckpoint = (mdof_flags & MDOF_CPT) && of->writeDistributedCheckpoint;
+    std::vector<int> atomBlockNumAtoms;
+
     if (haveDDAtomOrdering(*cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if ((mdof_flags & MDOF_CPT) && !writeDistributedCheckpoint)
         {
             dd_collect_state(cr->dd, state_local, state_global);
         }
         else
         {
+            if (writeDistributedCheckpoint)
+            {
+                /* The coordinates and velocities are written by each rank below */
+                dd_collect_state_global_entries(cr->dd, state_local, state_global);
+                atomBlockNumAtoms = gatherNumHomeAtoms(*cr->dd);
+            }
             if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED))
             {
                 auto globalXRef = MAIN(cr) ? state_global->x : gmx::ArrayRef<gmx::RVec>();
@@ -604,152 +1034,72 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
         f_global = as_rvec_array(f_local.data());
     }
 
+    if (writeDistributedCheckpoint && !MAIN(cr))
+    {
+        /* The main rank calls this while writing the checkpoint */
+        writeLocalCheckpointAtomBlock(*cr->dd, *state_local, nullptr, {});
+    }
+
     if (MAIN(cr))
     {
-        if (mdof_flags & MDOF_CPT)
+        if (writeDistributedCheckpoint)
         {
-            mdoutf_write_checkpoint(
-                    of, fplog, cr, step, t, state_global, observablesHistory, modularSimulatorCheckpointData);
+            writeCheckpointFile(of,
+                                fplog,
+                                cr,
+                                step,
+                                t,
+                                state_global,
+                                observablesHistory,
+                                modularSimulatorCheckpointData,
+                                atomBlockNumAtoms,
+                                [cr, state_local](const char* fn, gmx::ArrayRef<const int64_t> blockOffsets)
+                                { writeLocalCheckpointAtomBlock(*cr->dd, *state_local, fn, blockOffsets); });
         }
-
-        if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+        else if (mdof_flags & MDOF_CPT)
         {
-            const rvec* x = (mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr;
-            const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
-            const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
-
-            if (of->fp_trn)
-            {
-                gmx_trr_write_frame(of->fp_trn,
-                                    step,
-                                    t,
-                                    state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                                    state_local->box,
-                                    natoms,
-                                    x,
-                                    v,
-                                    f);
-                if (gmx_fio_flush(of->fp_trn) != 0)
-                {
-                    gmx_file("Cannot write trajectory; maybe you are out of disk space?");
-                }
-            }
-
-            /* If a TNG file is open for uncompressed coordinate output also write
-               velocities and forces to it. */
-            else if (of->tng)
-            {
-                gmx_fwrite_tng(of->tng,
-                               FALSE,
-                               step,
-                               t,
-                               state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                               state_local->box,
-                               natoms,
-                               x,
-                               v,
-                               f);
-            }
-            /* If only a TNG file is open for compressed coordinate output (no uncompressed
-               coordinate output) also write forces and velocities to it. */
-            else if (of->tng_low_prec)
-            {
-                gmx_fwrite_tng(of->tng_low_prec,
-                               FALSE,
-                               step,
-                               t,
-                               state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                               state_local->box,
-                               natoms,
-                               x,
-                               v,
-                               f);
-            }
+            mdoutf_write_checkpoint(
+                    of, fplog, cr, step, t, state_global, observablesHistory, modularSimulatorCheckpointData);
         }
-        if (mdof_flags & MDOF_X_COMPRESSED)
-        {
-            rvec* xxtc = nullptr;
 
-            if (of->natoms_x_compressed == of->natoms_global)
-            {
-                /* We are writing the positions of all of the atoms to
-                   the compressed output */
-                xxtc = state_global->x.rvec_array();
-            }
-            else
-            {
-                /* We are writing the positions of only a subset of
-                   the atoms to the compressed output, so we have to
-                   make a copy of the subset of coordinates. */
-                int i, j;
-
-                snew(xxtc, of->natoms_x_compressed);
-                auto x = makeArrayRef(state_global->x);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
-                {
-                    if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
-                    {
-                        copy_rvec(x[i], xxtc[j++]);
-                    }
-                }
-            }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc, of->x_compression_precision)
-                == 0)
-            {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
-            }
-            gmx_fwrite_tng(of->tng_low_prec,
-                           TRUE,
-                           step,
-                           t,
-                           state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
-                           state_local->box,
-                           of->natoms_x_compressed,
-                           xxtc,
-                           nullptr,
-                           nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
-            {
-                sfree(xxtc);
-            }
-        }
-        if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
+        if (of->trajectoryWriter)
         {
-            if (of->tng)
-            {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA)
+            /* Copy the data, so the output thread can write it while we continue */
+            gmx::TrajectoryFrame* frame = of->trajectoryWriter->getFreeFrame();
+            frame->mdof_flags      = mdof_flags;
+            frame->natoms          = natoms;
+            frame->step            = step;
+            frame->t               = t;
+            frame->lambda          = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
+            copy_mat(state_local->box, frame->box);
+            const auto copyIf =
+                    [](bool doCopy, const rvec* src, int n, std::vector<gmx::RVec>* dest) {
+                if (doCopy)
                 {
-                    lambda = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
+                    dest->assign(reinterpret_cast<const gmx::RVec*>(src),
+                                 reinterpret_cast<const gmx::RVec*>(src) + n);
                 }
-                gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, nullptr, nullptr, nullptr);
-            }
+            };
+            copyIf(mdof_flags & (MDOF_X | MDOF_X_COMPRESSED),
+                   state_global->x.rvec_array(),
+                   of->natoms_global,
+                   &frame->x);
+            copyIf(mdof_flags & MDOF_V, state_global->v.rvec_array(), natoms, &frame->v);
+            copyIf(mdof_flags & MDOF_F, f_global, natoms, &frame->f);
+            of->trajectoryWriter->submit(frame);
         }
-        if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED)
-            && !(mdof_flags & (MDOF_X_COMPRESSED)))
+        else
         {
-            if (of->tng_low_prec)
-            {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX_COMPRESSED)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA_COMPRESSED)
-                {
-                    lambda = state_local->lambda[FreeEnergyPerturbationCouplingType::Fep];
-                }
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, nullptr, nullptr, nullptr);
-            }
+            write_trajectory_frame(of,
+                                   mdof_flags,
+                                   natoms,
+                                   step,
+                                   t,
+                                   state_local->lambda[FreeEnergyPerturbationCouplingType::Fep],
+                                   state_local->box,
+                                   state_global->x.rvec_array(),
+                                   state_global->v.rvec_array(),
+                                   f_global);
         }
 
 #if GMX_FAHCORE
@@ -765,6 +1115,10 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
 
 void mdoutf_tng_close(gmx_mdoutf_t of)
 {
+    if (of->trajectoryWriter)
+    {
+        of->trajectoryWriter->waitUntilWritten();
+    }
     if (of->tng || of->tng_low_prec)
     {
         wallcycle_start(of->wcycle, WallCycleCounter::Traj);
@@ -776,6 +1130,12 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    /* Write the remaining frames and stop the output thread */
+    if (of->trajectoryWriter)
+    {
+        of->trajectoryWriter->waitUntilWritten();
+        of->trajectoryWriter.reset();
+    }
     if (of->fp_ene != nullptr)
     {
         done_ener_file(of->fp_ene);
@@ -788,6 +1148,19 @@ void done_mdoutf(gmx_mdoutf_t of)
     {
         gmx_trr_close(of->fp_trn);
     }
+    /* The frame indices were extended while writing, write them now the trajectories are closed */
+    for (gmx::TrajectoryFrameIndex* frameIndex :
+         { of->xtcFrameIndex.get(), of->trrFrameIndex.get() })
+    {
+        if (frameIndex != nullptr && !frameIndex->writeForAppendedFrames())
+        {
+            fprintf(stderr,
+                    "\nNOTE: Could not write the frame index %s\n",
+                    gmx::TrajectoryFrameIndex::sidecarFileName(frameIndex->trajectoryFile())
+                            .string()
+                            .c_str());
+        }
+    }
     if (of->fp_dhdl != nullptr)
     {
         gmx_fio_fclose(of->fp_dhdl);
@@ -801,7 +1174,7 @@ void done_mdoutf(gmx_mdoutf_t of)
     gmx_tng_close(&of->tng);
     gmx_tng_close(&of->tng_low_prec);
 
-    sfree(of);
+    delete of;
 }
 
 int mdoutf_get_tng_box_output_interval(gmx_mdoutf_t of)
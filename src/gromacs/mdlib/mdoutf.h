@@ -167,6 +167,14 @@ void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
                              ObservablesHistory*             observablesHistory,
                              gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData);
 
+/*! \brief Returns whether checkpoints are written with the coordinates and velocities
+ * written by each domain instead of collected on the main rank
+ *
+ * In that case the coordinates and velocities are not available in the
+ * global state on the main rank after writing a checkpoint.
+ */
+bool mdoutf_writes_distributed_checkpoint(gmx_mdoutf_t of);
+
 /*! \brief Get the output interval of box size of uncompressed TNG output.
  * Returns 0 if no uncompressed TNG file is open.
  */
@@ -72,6 +72,7 @@
 #include "gromacs/mdlib/calcmu.h"
 #include "gromacs/mdlib/calcvir.h"
 #include "gromacs/mdlib/constr.h"
+#include "gromacs/mdlib/cpu_pme_overlap.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
 #include "gromacs/mdlib/enerdata_utils.h"
 #include "gromacs/mdlib/force.h"
@@ -122,6 +123,7 @@
 #include "gromacs/utility/strconvert.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/sysinfo.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "gpuforcereduction.h"
 
@@ -146,12 +148,9 @@ static void sum_forces(ArrayRef<RVec> f, ArrayRef<const RVec> forceToAdd)
     GMX_ASSERT(f.size() >= forceToAdd.size(), "Accumulation buffer should be sufficiently large");
     const int end = forceToAdd.size();
 
-    int gmx_unused nt = gmx_omp_nthreads_get(ModuleMultiThread::Default);
-#pragma omp parallel for num_threads(nt) schedule(static)
-    for (int i = 0; i < end; i++)
-    {
-        rvec_inc(f[i], forceToAdd[i]);
-    }
+    const int nt       = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+    auto      addForce = [&](int i) { rvec_inc(f[i], forceToAdd[i]); };
+    gmx::parallelForOnThreads(nt, end, addForce);
 }
 
 static void calc_virial(int                              start,
@@ -471,11 +470,8 @@ static inline void clearRVecs(ArrayRef<RVec> v, const bool useOpenmpThreading)
     }
     else
     {
-#pragma omp parallel for num_threads(nth) schedule(static)
-        for (gmx::Index i = 0; i < v.ssize(); i++)
-        {
-            clear_rvec(v[i]);
-        }
+        auto clearElement = [&](gmx::Index i) { clear_rvec(v[i]); };
+        gmx::parallelForOnThreads(nth, v.ssize(), clearElement);
     }
 }
 
@@ -1120,14 +1116,13 @@ static void combineMtsForces(const int      numAtoms,
                              ArrayRef<RVec> forceMts,
                              const real     mtsFactor)
 {
-    const int gmx_unused numThreads = gmx_omp_nthreads_get(ModuleMultiThread::Default);
-#pragma omp parallel for num_threads(numThreads) schedule(static)
-    for (int i = 0; i < numAtoms; i++)
-    {
+    const int numThreads   = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+    auto      combineForce = [&](int i) {
         const RVec forceMtsLevel0Tmp = forceMtsLevel0[i];
         forceMtsLevel0[i] += forceMts[i];
         forceMts[i] = forceMtsLevel0Tmp + mtsFactor * forceMts[i];
-    }
+    };
+    gmx::parallelForOnThreads(numThreads, numAtoms, combineForce);
 }
 
 /*! \brief Setup for the local GPU force reduction:
@@ -1930,6 +1925,24 @@ void do_force(FILE*                               fplog,
 
     const bool useOrEmulateGpuNb = simulationWork.useGpuNonbonded || fr->nbv->emulateGpu();
 
+    /* With CPU PME overlap we launch the long-range work now on its own
+     * threads, it then runs concurrently with the short-range work below.
+     */
+    const bool overlapLongRangeNonbondeds = (fr->cpuPmeOverlap && stepWork.computeSlowForces);
+    if (overlapLongRangeNonbondeds)
+    {
+        fr->cpuPmeOverlap->launch(longRangeNonbondeds,
+                                  fr->pmedata,
+                                  cr,
+                                  x.unpaddedConstArrayRef(),
+                                  forceOutMtsLevel1->forceWithVirial().force_.ssize(),
+                                  box,
+                                  lambda,
+                                  dipoleData.muStateAB,
+                                  stepWork,
+                                  ddBalanceRegionHandler);
+    }
+
     if (!useOrEmulateGpuNb)
     {
         wallcycle_start_nocount(wcycle, WallCycleCounter::Force);
@@ -2068,7 +2081,11 @@ void do_force(FILE*                               fplog,
         }
     }
 
-    if (stepWork.computeSlowForces)
+    if (overlapLongRangeNonbondeds)
+    {
+        fr->cpuPmeOverlap->waitAndReduce(&forceOutMtsLevel1->forceWithVirial(), enerd, nrnb, wcycle);
+    }
+    else if (stepWork.computeSlowForces)
     {
         longRangeNonbondeds->calculate(fr->pmedata,
                                        cr,
@@ -45,7 +45,11 @@
 #include <gtest/gtest.h>
 
 #include "gromacs/math/functions.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/smalloc.h"
 
 #include "testutils/testasserts.h"
 
@@ -219,6 +223,73 @@ TEST_F(VerletBufferConstraintTest, EqualMasses)
             "before and after the location of the maximum value for the exact formula.");
 }
 
+//! Sets up a topology with a single molecule type of two oppositely charged free atoms
+void setupIonPairTopology(gmx_mtop_t* mtop, real mass, real charge)
+{
+    mtop->moltype.resize(1);
+    t_atoms& atoms = mtop->moltype[0].atoms;
+    init_atom(&atoms);
+    atoms.nr = 2;
+    snew(atoms.atom, atoms.nr);
+    for (int a = 0; a < atoms.nr; a++)
+    {
+        atoms.atom[a].m = mass;
+        atoms.atom[a].q = (a == 0 ? charge : -charge);
+    }
+
+    mtop->molblock.resize(1);
+    mtop->molblock[0].type = 0;
+    mtop->molblock[0].nmol = 100;
+    mtop->natoms           = atoms.nr * mtop->molblock[0].nmol;
+    mtop->finalize();
+}
+
+TEST(MtsLongRangeForceError, ScalesWithMtsFactorAndNotWithCharge)
+{
+    t_inputrec ir;
+    ir.eI          = IntegrationAlgorithm::MD;
+    ir.delta_t     = 0.002;
+    ir.coulombtype = CoulombInteractionType::Pme;
+    ir.rcoulomb    = 1.0;
+    ir.ewald_rtol  = 1e-5;
+    ir.epsilon_r   = 1;
+
+    const real density     = 100;
+    const real temperature = 300;
+
+    gmx_mtop_t mtop;
+    setupIonPairTopology(&mtop, 10, 1);
+
+    const auto error1 = mtsLongRangeForceError(mtop, density, ir, 1, temperature);
+    const auto error2 = mtsLongRangeForceError(mtop, density, ir, 2, temperature);
+    const auto error4 = mtsLongRangeForceError(mtop, density, ir, 4, temperature);
+
+    EXPECT_EQ(error1.rmsForceError, 0);
+    EXPECT_GT(error2.relativeForceError, 0);
+    EXPECT_LT(error2.relativeForceError, 1);
+
+    // The error is proportional to the RMS time difference over the MTS interval
+    const real ratio = std::sqrt((3 * 7) / (1 * 3.0));
+    EXPECT_REAL_EQ_TOL(ratio * error2.rmsForceError,
+                       error4.rmsForceError,
+                       test::relativeToleranceAsFloatingPoint(1, 1e-5));
+    EXPECT_REAL_EQ_TOL(ratio * error2.relativeForceError,
+                       error4.relativeForceError,
+                       test::relativeToleranceAsFloatingPoint(1, 1e-5));
+
+    // The relative error does not depend on the magnitude of the charges
+    gmx_mtop_t mtopScaledCharges;
+    setupIonPairTopology(&mtopScaledCharges, 10, 0.5);
+    const auto error2Scaled =
+            mtsLongRangeForceError(mtopScaledCharges, density, ir, 2, temperature);
+    EXPECT_REAL_EQ_TOL(0.25 * error2.rmsForceError,
+                       error2Scaled.rmsForceError,
+                       test::relativeToleranceAsFloatingPoint(1, 1e-5));
+    EXPECT_REAL_EQ_TOL(error2.relativeForceError,
+                       error2Scaled.relativeForceError,
+                       test::relativeToleranceAsFloatingPoint(1, 1e-5));
+}
+
 } // namespace
 
 } // namespace gmx
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::TrajectoryWriterThread
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/trajectorywriterthread.h"
+
+#include <cstdint>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/exceptions.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Fills a frame buffer for \p step and submits it to \p writer
+void submitFrame(TrajectoryWriterThread* writer, const int64_t step)
+{
+    TrajectoryFrame* frame = writer->getFreeFrame();
+    frame->step            = step;
+    frame->natoms          = 2;
+    frame->x.assign(2, { 1.0_real * step, 0.0_real, 0.0_real });
+    writer->submit(frame);
+}
+
+TEST(TrajectoryWriterThreadTest, WritesFramesInOrder)
+{
+    // Only accessed on the output thread until waitUntilWritten() returns
+    std::vector<int64_t> writtenSteps;
+    std::vector<real>    writtenCoordinates;
+
+    TrajectoryWriterThread writer([&](const TrajectoryFrame& frame) {
+        writtenSteps.push_back(frame.step);
+        writtenCoordinates.push_back(frame.x[1][XX]);
+    });
+
+    // More frames than buffers, so buffers are reused
+    const int numFrames = 10;
+    for (int step = 0; step < numFrames; step++)
+    {
+        submitFrame(&writer, step);
+    }
+    writer.waitUntilWritten();
+
+    ASSERT_EQ(writtenSteps.size(), numFrames);
+    for (int step = 0; step < numFrames; step++)
+    {
+        EXPECT_EQ(writtenSteps[step], step);
+        EXPECT_EQ(writtenCoordinates[step], step);
+    }
+}
+
+TEST(TrajectoryWriterThreadTest, ReportsWriteErrorOnMainThread)
+{
+    std::vector<int64_t>   writtenSteps;
+    TrajectoryWriterThread writer([&writtenSteps](const TrajectoryFrame& frame) {
+        if (frame.step == 1)
+        {
+            GMX_THROW(FileIOError("Cannot write trajectory"));
+        }
+        writtenSteps.push_back(frame.step);
+    });
+
+    submitFrame(&writer, 0);
+    submitFrame(&writer, 1);
+    EXPECT_THROW(writer.waitUntilWritten(), FileIOError);
+
+    // The error is reported once, after which the writer can still be used
+    submitFrame(&writer, 2);
+    EXPECT_NO_THROW(writer.waitUntilWritten());
+    EXPECT_EQ(writtenSteps, std::vector<int64_t>({ 0, 2 }));
+}
+
+TEST(TrajectoryWriterThreadTest, ReportsWriteErrorWhenGettingBuffer)
+{
+    TrajectoryWriterThread writer([](const TrajectoryFrame& /* frame */) {
+        GMX_THROW(FileIOError("Cannot write trajectory"));
+    });
+
+    // With two buffers, the third request has to wait for a written frame
+    // and then gets its error. The error can also be reported earlier.
+    auto submitThreeFrames = [&writer]() {
+        for (int step = 0; step < 3; step++)
+        {
+            submitFrame(&writer, step);
+        }
+    };
+    EXPECT_THROW(submitThreeFrames(), FileIOError);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
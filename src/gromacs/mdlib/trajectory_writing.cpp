@@ -36,6 +36,7 @@
 #include "trajectory_writing.h"
 
 #include "gromacs/commandline/filenm.h"
+#include "gromacs/domdec/collect.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/math/vec.h"
@@ -148,6 +149,24 @@ void do_md_trajectory_writing(FILE*                          fplog,
         // TODO: Remove duplication asap, make sure to keep in sync in the meantime.
         mdoutf_write_to_trajectory_files(
                 fplog, cr, outf, mdof_flags, top_global.natoms, step, t, state, state_global, observablesHistory, f, &checkpointDataHolder);
+        if (bLastStep && step_rel == ir->nsteps && bDoConfOut && !bRerunMD && bCPT
+            && haveDDAtomOrdering(*cr) && mdoutf_writes_distributed_checkpoint(outf))
+        {
+            /* Each rank wrote its own atoms to the checkpoint, collect x and v
+             * for confout when this was not done for trajectory output */
+            if (!(mdof_flags & (MDOF_X | MDOF_X_COMPRESSED)))
+            {
+                auto globalXRef = MAIN(cr) ? state_global->x : gmx::ArrayRef<gmx::RVec>();
+                dd_collect_vec(
+                        cr->dd, state->ddp_count, state->ddp_count_cg_gl, state->cg_gl, state->x, globalXRef);
+            }
+            if (!(mdof_flags & MDOF_V))
+            {
+                auto globalVRef = MAIN(cr) ? state_global->v : gmx::ArrayRef<gmx::RVec>();
+                dd_collect_vec(
+                        cr->dd, state->ddp_count, state->ddp_count_cg_gl, state->cg_gl, state->v, globalVRef);
+            }
+        }
         if (bLastStep && step_rel == ir->nsteps && bDoConfOut && MAIN(cr) && !bRerunMD)
         {
             // With box deformation we would have to correct the output velocities, which is tedious
@@ -174,8 +193,8 @@ void do_md_trajectory_writing(FILE*                          fplog,
             }
 
             /* x and v have been collected in mdoutf_write_to_trajectory_files,
-             * because a checkpoint file will always be written
-             * at the last step.
+             * or above with distributed checkpoints, because a checkpoint
+             * file will always be written at the last step.
              */
             fprintf(stderr, "\nWriting final coordinates.\n");
             if (makeMoleculesWholeInConfout)
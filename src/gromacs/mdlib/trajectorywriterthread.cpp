@@ -0,0 +1,145 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::TrajectoryWriterThread.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "trajectorywriterthread.h"
+
+#include <utility>
+
+namespace gmx
+{
+
+TrajectoryWriterThread::TrajectoryWriterThread(
+        std::function<void(const TrajectoryFrame&)> writeFrame) :
+    writeFrame_(std::move(writeFrame))
+{
+    for (auto& frame : frames_)
+    {
+        freeFrames_.push_back(&frame);
+    }
+    thread_ = std::thread(&TrajectoryWriterThread::run, this);
+}
+
+TrajectoryWriterThread::~TrajectoryWriterThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void TrajectoryWriterThread::rethrowError(std::unique_lock<std::mutex>* lock)
+{
+    if (error_)
+    {
+        std::exception_ptr error = error_;
+        error_                   = nullptr;
+        lock->unlock();
+        std::rethrow_exception(error);
+    }
+}
+
+TrajectoryFrame* TrajectoryWriterThread::getFreeFrame()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return !freeFrames_.empty() || error_; });
+    rethrowError(&lock);
+    TrajectoryFrame* frame = freeFrames_.back();
+    freeFrames_.pop_back();
+
+    return frame;
+}
+
+void TrajectoryWriterThread::submit(TrajectoryFrame* frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(frame);
+    }
+    condition_.notify_all();
+}
+
+void TrajectoryWriterThread::waitUntilWritten()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return (queue_.empty() && !busy_) || error_; });
+    rethrowError(&lock);
+}
+
+void TrajectoryWriterThread::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this] { return !queue_.empty() || stop_; });
+        if (queue_.empty())
+        {
+            /* We only stop after writing all queued frames */
+            break;
+        }
+        TrajectoryFrame* frame = queue_.front();
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        std::exception_ptr error;
+        try
+        {
+            writeFrame_(*frame);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        busy_ = false;
+        freeFrames_.push_back(frame);
+        if (error && !error_)
+        {
+            error_ = error;
+        }
+        condition_.notify_all();
+    }
+}
+
+} // namespace gmx
@@ -0,0 +1,151 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::TrajectoryWriterThread, which writes trajectory frames
+ * on a separate thread.
+ *
+ * \ingroup module_mdlib
+ */
+#ifndef GMX_MDLIB_TRAJECTORYWRITERTHREAD_H
+#define GMX_MDLIB_TRAJECTORYWRITERTHREAD_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+//! \libinternal \brief A copy of the output data of a step, to be written by the output thread
+struct TrajectoryFrame
+{
+    //! The MDOF flags for this step
+    int mdof_flags = 0;
+    //! The number of atoms in \p x, \p v and \p f
+    int natoms = 0;
+    //! The step
+    int64_t step = 0;
+    //! The time
+    double t = 0;
+    //! The FEP lambda value
+    real lambda = 0;
+    //! The box
+    matrix box = { { 0 } };
+    //! The global positions, with MDOF_X or MDOF_X_COMPRESSED
+    std::vector<RVec> x;
+    //! The global velocities, with MDOF_V
+    std::vector<RVec> v;
+    //! The global forces, with MDOF_F
+    std::vector<RVec> f;
+};
+
+/*! \libinternal \brief Writes trajectory frames on a separate thread
+ *
+ * The main rank copies the output data of a step to one of two frame
+ * buffers and continues with the simulation while the previous frame
+ * is compressed and written. Only when both buffers are still in use,
+ * the main rank waits. Frames are written in the order they are
+ * submitted. Errors on the output thread are reported to the main rank
+ * at the next submission or synchronization.
+ */
+class TrajectoryWriterThread
+{
+public:
+    /*! \brief Starts the output thread, \p writeFrame is called for each frame on that thread
+     *
+     * \p writeFrame should report errors by throwing, not by terminating
+     * the program, so the error can be passed to the main rank.
+     */
+    explicit TrajectoryWriterThread(std::function<void(const TrajectoryFrame&)> writeFrame);
+
+    //! Writes all pending frames and stops the output thread
+    ~TrajectoryWriterThread();
+
+    /*! \brief Returns a frame buffer to fill, waits until one is free
+     *
+     * \throws any exception thrown by writing an earlier frame.
+     */
+    TrajectoryFrame* getFreeFrame();
+
+    //! Queues \p frame, obtained with getFreeFrame(), for writing
+    void submit(TrajectoryFrame* frame);
+
+    /*! \brief Waits until all queued frames have been written
+     *
+     * \throws any exception thrown by writing an earlier frame.
+     */
+    void waitUntilWritten();
+
+private:
+    //! The loop executed by the output thread
+    void run();
+
+    //! Rethrows an error from the output thread, \p lock should hold mutex_
+    void rethrowError(std::unique_lock<std::mutex>* lock);
+
+    //! Writes a frame to file
+    std::function<void(const TrajectoryFrame&)> writeFrame_;
+    //! The two frame buffers
+    std::array<TrajectoryFrame, 2> frames_;
+    //! The frame buffers available for filling
+    std::vector<TrajectoryFrame*> freeFrames_;
+    //! The frames waiting to be written, in order
+    std::deque<TrajectoryFrame*> queue_;
+    //! Whether the output thread is writing a frame
+    bool busy_ = false;
+    //! Whether the output thread should stop
+    bool stop_ = false;
+    //! An error that occurred on the output thread
+    std::exception_ptr error_;
+    //! Protects all members above
+    std::mutex mutex_;
+    //! Signals changes in the queue and free buffers
+    std::condition_variable condition_;
+    //! The output thread
+    std::thread thread_;
+};
+
+} // namespace gmx
+
+#endif
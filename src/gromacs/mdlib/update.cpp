@@ -74,6 +74,7 @@
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/template_mp.h"
+#include "gromacs/utility/threadpool.h"
 
 using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
 
@@ -1600,9 +1601,7 @@ void Update::Impl::update_sd_second_half(const t_inputrec&                 input
 
         int nth = gmx_omp_nthreads_get(ModuleMultiThread::Update);
 
-#pragma omp parallel for num_threads(nth) schedule(static)
-        for (int th = 0; th < nth; th++)
-        {
+        auto updateThreadRange = [&](int th) {
             try
             {
                 int start_th, end_th;
@@ -1631,7 +1630,8 @@ void Update::Impl::update_sd_second_half(const t_inputrec&                 input
                         parrinelloRahmanM);
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-        }
+        };
+        gmx::parallelForOnThreads(nth, nth, updateThreadRange);
         inc_nrnb(nrnb, eNR_UPDATE, homenr);
         wallcycle_stop(wcycle, WallCycleCounter::Update);
 
@@ -1698,13 +1698,12 @@ void Update::Impl::finish_update(const t_inputrec&                   inputRecord
         /* We have no frozen atoms or fully frozen atoms which have not
          * been moved by the update, so we can simply copy all coordinates.
          */
-        int gmx_unused nth = gmx_omp_nthreads_get(ModuleMultiThread::Update);
-#pragma omp parallel for num_threads(nth) schedule(static)
-        for (int i = 0; i < homenr; i++)
-        {
+        const int nth            = gmx_omp_nthreads_get(ModuleMultiThread::Update);
+        auto      copyCoordinate = [&](int i) {
             // Trivial statement, does not throw
             x[i] = xp[i];
-        }
+        };
+        gmx::parallelForOnThreads(nth, homenr, copyCoordinate);
     }
 
     wallcycle_stop(wcycle, WallCycleCounter::Update);
@@ -1749,9 +1748,7 @@ void Update::Impl::update_coords(const t_inputrec&                 inputRecord,
     /* ############# START The update of velocities and positions ######### */
     int nth = gmx_omp_nthreads_get(ModuleMultiThread::Update);
 
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
+    auto updateThreadRange = [&](int th) {
         try
         {
             int start_th, end_th;
@@ -1884,7 +1881,8 @@ void Update::Impl::update_coords(const t_inputrec&                 inputRecord,
             }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-    }
+    };
+    gmx::parallelForOnThreads(nth, nth, updateThreadRange);
 }
 
 void Update::Impl::update_for_constraint_virial(const t_inputrec&         inputRecord,
@@ -1904,9 +1902,7 @@ void Update::Impl::update_for_constraint_virial(const t_inputrec&         inputR
 
     const int nth = gmx_omp_nthreads_get(ModuleMultiThread::Update);
 
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
+    auto updateThreadRange = [&](int th) {
         try
         {
             int start_th, end_th;
@@ -1921,5 +1917,6 @@ void Update::Impl::update_for_constraint_virial(const t_inputrec&         inputR
                     start_th, end_th, dt, x_rvec, xp_rvec, v_rvec, f_rvec, havePartiallyFrozenAtoms, invmass, invMassPerDim, ekind);
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-    }
+    };
+    gmx::parallelForOnThreads(nth, nth, updateThreadRange);
 }
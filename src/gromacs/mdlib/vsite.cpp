@@ -66,6 +66,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/threadpool.h"
 
 /* The strategy used here for assigning virtual sites to (thread-)tasks
  * is as follows:
@@ -1190,11 +1191,9 @@ static void construct_vsites(const ThreadingInfo*            threadingInfo,
     }
     else
     {
-#pragma omp parallel num_threads(threadingInfo->numThreads())
-        {
+        auto constructForThread = [&](int th) {
             try
             {
-                const int          th    = gmx_omp_get_thread_num();
                 const VsiteThread& tData = threadingInfo->threadData(th);
                 GMX_ASSERT(tData.rangeStart >= 0,
                            "The thread data should be initialized before calling construct_vsites");
@@ -1212,7 +1211,9 @@ static void construct_vsites(const ThreadingInfo*            threadingInfo,
                 }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-        }
+        };
+        parallelForOnThreads(
+                threadingInfo->numThreads(), threadingInfo->numThreads(), constructForThread);
         /* Now we can construct the vsites that might depend on other vsites */
         construct_vsites_thread<calculatePosition, calculateVelocity>(
                 x, v, ip, threadingInfo->threadDataNonLocalDependent().ilist, pbc_null);
@@ -2521,6 +2522,9 @@ void VirtualSitesHandler::spreadForces(ArrayRef<const RVec> x,
                                        const matrix         box,
                                        gmx_wallcycle*       wcycle)
 {
+    // Force spreading uses OpenMP
+    const ThreadPoolSpinSuspension threadPoolSpinSuspension;
+
     impl_->spreadForces(x, f, virialHandling, fshift, virial, nrnb, box, wcycle);
 }
 
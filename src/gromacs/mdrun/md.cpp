@@ -541,8 +541,17 @@ void gmx::LegacySimulator::do_md()
     pme_load_balancing_t* pme_loadbal = nullptr;
     if (bPMETune)
     {
-        pme_loadbal_init(
-                &pme_loadbal, cr_, mdLog_, *ir, state_->box, *fr_->ic, *fr_->nbv, fr_->pmedata, fr_->nbv->useGpu());
+        pme_loadbal_init(&pme_loadbal,
+                         cr_,
+                         mdLog_,
+                         *ir,
+                         state_->box,
+                         *fr_->ic,
+                         *fr_->nbv,
+                         fr_->pmedata,
+                         fr_->nbv->useGpu(),
+                         topGlobal_.natoms,
+                         fr_->deviceStreamManager ? &fr_->deviceStreamManager->deviceInfo() : nullptr);
     }
 
     if (!ir->bContinuation)
@@ -847,6 +856,13 @@ void gmx::LegacySimulator::do_md()
         logInitialMultisimStatus(ms_, cr_, mdLog_, simulationsShareState, ir->nsteps, ir->init_step);
     }
 
+    /* With incremental pair list updates the nbnxm module can decide to skip
+     * scheduled search steps. A changing box and GPU update require searching.
+     */
+    const bool mayReusePairlist = (!inputrecDynamicBox(ir) && !useGpuForUpdate);
+    // Whether we are using the pairlist beyond the search step it was scheduled for
+    bool pairlistIsReused = false;
+
     bool usedMdGpuGraphLastStep = false;
     /* and stop now if we should */
     bLastStep = (bLastStep || (ir->nsteps >= 0 && step_rel > ir->nsteps));
@@ -882,6 +898,7 @@ void gmx::LegacySimulator::do_md()
         }
 
         wallcycle_start(wallCycleCounters_, WallCycleCounter::Step);
+        wallcycle_set_step(wallCycleCounters_, step);
 
         bLastStep = (step_rel == ir->nsteps);
         t         = t0 + step * ir->delta_t;
@@ -972,6 +989,26 @@ void gmx::LegacySimulator::do_md()
             wallcycle_stop(wallCycleCounters_, WallCycleCounter::VsiteConstr);
         }
 
+        /* With incremental pair list updates the search can be skipped at
+         * a scheduled search step or be needed at another step. bNS keeps
+         * following the schedule, as checkpointing and stopping depend on it.
+         */
+        bool doPairSearch = bNS;
+        if (mayReusePairlist)
+        {
+            if (bNS && !bFirstStep && !bExchanged && !bNeedRepartition && !bPMETune)
+            {
+                doPairSearch = !fr_->nbv->canReusePairlist(
+                        step, ir->nstlist, makeConstArrayRef(state_->x));
+            }
+            else if (!bNS && pairlistIsReused)
+            {
+                /* Search when an atom moved too far for the kept list to be complete */
+                doPairSearch = !fr_->nbv->outerPairlistIsComplete(makeConstArrayRef(state_->x));
+            }
+            pairlistIsReused = !doPairSearch && (bNS || pairlistIsReused);
+        }
+
         if (bNS && !(bFirstStep && ir->bContinuation))
         {
             bMainState = FALSE;
@@ -1134,7 +1171,8 @@ void gmx::LegacySimulator::do_md()
         }
 
         const int shellfcFlags = force_flags | (mdrunOptions_.verbose ? GMX_FORCE_ENERGY : 0);
-        const int legacyForceFlags = ((shellfc) ? shellfcFlags : force_flags) | (bNS ? GMX_FORCE_NS : 0);
+        const int legacyForceFlags =
+                ((shellfc) ? shellfcFlags : force_flags) | (doPairSearch ? GMX_FORCE_NS : 0);
 
         runScheduleWork_->stepWork = setupStepWorkload(
                 legacyForceFlags, ir->mtsLevels, step, runScheduleWork_->domainWork, simulationWork);
@@ -1201,7 +1239,7 @@ void gmx::LegacySimulator::do_md()
                                     mdModulesNotifiers_,
                                     imdSession_,
                                     pullWork_,
-                                    bNS,
+                                    doPairSearch,
                                     top_,
                                     constr_,
                                     enerd_,
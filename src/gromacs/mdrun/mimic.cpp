@@ -432,6 +432,7 @@ void gmx::LegacySimulator::do_mimic()
     {
         isLastStep = (isLastStep || (ir->nsteps >= 0 && step_rel == ir->nsteps));
         wallcycle_start(wallCycleCounters_, WallCycleCounter::Step);
+        wallcycle_set_step(wallCycleCounters_, step);
 
         t = step;
 
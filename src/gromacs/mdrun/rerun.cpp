@@ -525,6 +525,7 @@ void gmx::LegacySimulator::do_rerun()
             step     = rerun_fr.step;
             step_rel = step - ir->init_step;
         }
+        wallcycle_set_step(wallCycleCounters_, step);
         if (rerun_fr.bTime)
         {
             t = rerun_fr.time;
@@ -94,6 +94,7 @@
 #include "gromacs/mdlib/boxdeformation.h"
 #include "gromacs/mdlib/broadcaststructs.h"
 #include "gromacs/mdlib/calc_verletbuf.h"
+#include "gromacs/mdlib/cpu_pme_overlap.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
 #include "gromacs/mdlib/enerdata_utils.h"
 #include "gromacs/mdlib/force.h"
@@ -175,6 +176,7 @@
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "isimulator.h"
 #include "membedholder.h"
@@ -1058,8 +1060,20 @@ int Mdrunner::mdrunner()
             // On non-main ranks, allocate the object that will receive data in the following call.
             inputrec = std::make_unique<t_inputrec>();
         }
-        init_parallel(
-                cr->mpiDefaultCommunicator, MAIN(cr), inputrec.get(), &mtop, partialDeserializedTpr.get());
+        if (getenv("GMX_TPR_READ_ON_ALL_RANKS") != nullptr)
+        {
+            /* Let the non-main ranks read the inputrec and topology directly
+             * from the shared tpr file, which avoids a large broadcast */
+            if (!isSimulationMainRank)
+            {
+                applyGlobalInputRecordAndTopology(*inputHolder_.get(), inputrec.get(), &mtop);
+            }
+        }
+        else
+        {
+            init_parallel(
+                    cr->mpiDefaultCommunicator, MAIN(cr), inputrec.get(), &mtop, partialDeserializedTpr.get());
+        }
     }
     GMX_RELEASE_ASSERT(inputrec != nullptr, "All ranks should have a valid inputrec now");
     partialDeserializedTpr.reset(nullptr);
@@ -1748,6 +1762,20 @@ int Mdrunner::mdrunner()
     checkHardwareOversubscription(
             numThreadsOnThisRank, cr->nodeid, *hwinfo_->hardwareTopology, physicalNodeComm, mdlog);
 
+    /* When requested, run CPU PME on a subset of the threads concurrently
+     * with the non-bonded and listed forces on the other threads.
+     * The module thread counts need to be set before the modules are initialized.
+     */
+    const int numPmeOverlapThreads = cpuPmeOverlapNumThreads(
+            mdlog, cr, *inputrec, runScheduleWork.simulationWork, numThreadsOnThisRank);
+    if (numPmeOverlapThreads > 0)
+    {
+        const int numShortRangeThreads = numThreadsOnThisRank - numPmeOverlapThreads;
+        gmx_omp_nthreads_set(ModuleMultiThread::Pme, numPmeOverlapThreads);
+        gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, numShortRangeThreads);
+        gmx_omp_nthreads_set(ModuleMultiThread::Bonded, numShortRangeThreads);
+    }
+
     // Enable Peer access between GPUs where available
     // Only for DD, only main PP rank needs to perform setup, and only if thread MPI plus
     // any of the GPU communication features are active.
@@ -1767,7 +1795,10 @@ int Mdrunner::mdrunner()
                         "future version.");
     }
     std::unique_ptr<gmx_wallcycle> wcycle =
-            wallcycle_init(fplog, mdrunOptions.timingOptions.resetStep, cr);
+            wallcycle_init(fplog,
+                           mdrunOptions.timingOptions.resetStep,
+                           cr,
+                           isMultiSim(ms) ? ms->simulationIndex_ : -1);
 
     if (PAR(cr))
     {
@@ -2098,6 +2129,30 @@ int Mdrunner::mdrunner()
                                 nullptr);
     }
 
+    if (numPmeOverlapThreads > 0)
+    {
+        /* Created after pinning, as the helper threads take over the pinning of main threads */
+        fr->cpuPmeOverlap = std::make_unique<CpuPmeOverlap>(numPmeOverlapThreads, numThreadsOnThisRank);
+    }
+
+    /* Optionally run the short parallel loops in the MD step on a persistent pool
+     * of spin-waiting threads instead of in OpenMP parallel regions. This is created
+     * after pinning, as the pool threads take over the pinning of the OpenMP threads.
+     */
+    std::unique_ptr<ThreadPool>            threadPool;
+    std::unique_ptr<ActiveThreadPoolScope> activeThreadPoolScope;
+    if (getenv("GMX_THREAD_POOL") != nullptr && numThreadsOnThisRank > 1)
+    {
+        threadPool            = std::make_unique<ThreadPool>(numThreadsOnThisRank);
+        activeThreadPoolScope = std::make_unique<ActiveThreadPoolScope>(threadPool.get());
+        GMX_LOG(mdlog.info)
+                .asParagraph()
+                .appendTextFormatted(
+                        "Using a pool of %d spin-waiting threads for the parallel loops in the "
+                        "MD step",
+                        numThreadsOnThisRank);
+    }
+
     if (EI_DYNAMICS(inputrec->eI))
     {
         /* Turn on signal handling on all nodes */
@@ -55,6 +55,13 @@ void applyGlobalSimulationState(const SimulationInput&      simulationInput,
             simulationInput.tprFilename_.c_str(), inputRecord, globalState, molecularTopology);
 }
 
+void applyGlobalInputRecordAndTopology(const SimulationInput& simulationInput,
+                                       t_inputrec*            inputRecord,
+                                       gmx_mtop_t*            molecularTopology)
+{
+    readTpxInputrecAndTopology(simulationInput.tprFilename_, inputRecord, molecularTopology);
+}
+
 void applyLocalState(const SimulationInput&         simulationInput,
                      t_fileio*                      logfio,
                      const t_commrec*               cr,
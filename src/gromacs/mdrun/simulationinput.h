@@ -116,6 +116,10 @@ void applyGlobalSimulationState(const SimulationInput&      simulationInput,
                                 t_state*                    globalState,
                                 t_inputrec*                 inputrec,
                                 gmx_mtop_t*                 globalTopology);
+//! Read only the inputrec and topology, for ranks that read the tpr file directly.
+void applyGlobalInputRecordAndTopology(const SimulationInput& simulationInput,
+                                       t_inputrec*            inputrec,
+                                       gmx_mtop_t*            globalTopology);
 // TODO: Implement the following, pending further discussion re #3374.
 std::unique_ptr<t_state> globalSimulationState(const SimulationInput&);
 void                     applyGlobalInputRecord(const SimulationInput&, t_inputrec*);
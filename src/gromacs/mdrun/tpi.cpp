@@ -48,6 +48,8 @@
 
 #include <algorithm>
 #include <array>
+#include <memory>
+#include <vector>
 
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/dlbtiming.h"
@@ -84,6 +86,7 @@
 #include "gromacs/mdtypes/mdrunoptions.h"
 #include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/mdtypes/state.h"
+#include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/random/threefry.h"
@@ -95,8 +98,10 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
@@ -159,15 +164,189 @@ static real reactionFieldExclusionCorrection(gmx::ArrayRef<const gmx::RVec> x,
     return ic.epsfac * energy;
 }
 
+//! Sets \p x_cavity to the cavity location, given by the last coordinate(s) of the frame
+static void computeCavityLocation(const t_trxframe& rerun_fr,
+                                  const int         nat_cavity,
+                                  const real*       mass_cavity,
+                                  rvec              x_cavity)
+{
+    if (nat_cavity == 1)
+    {
+        /* Copy the location of the cavity */
+        copy_rvec(rerun_fr.x[rerun_fr.natoms - 1], x_cavity);
+    }
+    else
+    {
+        /* Determine the center of mass of the last molecule */
+        clear_rvec(x_cavity);
+        real mass_tot = 0;
+        for (int i = 0; i < nat_cavity; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                x_cavity[d] += mass_cavity[i] * rerun_fr.x[rerun_fr.natoms - nat_cavity + i][d];
+            }
+            mass_tot += mass_cavity[i];
+        }
+        for (int d = 0; d < DIM; d++)
+        {
+            x_cavity[d] /= mass_tot;
+        }
+    }
+}
+
+/*! \brief Places the molecule to insert with a random orientation around \p x_init
+ *
+ * When \p displace is true, the molecule is displaced randomly within
+ * a sphere of radius \p drmax. The insertion location is returned in \p x_tp.
+ */
+static void placeInsertedMolecule(const rvec                          x_init,
+                                  const bool                          displace,
+                                  const real                          drmax,
+                                  const rvec*                         x_mol,
+                                  const int                           a_tp0,
+                                  const int                           a_tp1,
+                                  gmx::ThreeFry2x64<16>*              rng,
+                                  gmx::UniformRealDistribution<real>* dist,
+                                  gmx::ArrayRef<gmx::RVec>            x,
+                                  rvec                                x_tp)
+{
+    /* Add random displacement uniformly distributed in a sphere
+     * of radius rtpi. We don't need to do this is we generate
+     * a new center location every step.
+     */
+    if (displace)
+    {
+        /* Generate coordinates within |dx|=drmax of x_init */
+        rvec dx;
+        do
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                dx[d] = (2 * (*dist)(*rng) - 1) * drmax;
+            }
+        } while (norm2(dx) > drmax * drmax);
+        rvec_add(x_init, dx, x_tp);
+    }
+    else
+    {
+        copy_rvec(x_init, x_tp);
+    }
+
+    if (a_tp1 - a_tp0 == 1)
+    {
+        /* Insert a single atom, just copy the insertion location */
+        copy_rvec(x_tp, x[a_tp0]);
+    }
+    else
+    {
+        /* Copy the coordinates from the top file */
+        for (int i = a_tp0; i < a_tp1; i++)
+        {
+            copy_rvec(x_mol[i - a_tp0], x[i]);
+        }
+        /* Rotate the molecule randomly */
+        real angleX = 2 * M_PI * (*dist)(*rng);
+        /* Draw uniform random number for sin(angleY) instead of angleY itself in order to
+         * achieve the uniform distribution in the solid angles space. */
+        real angleY = std::asin(2 * (*dist)(*rng) - 1);
+        real angleZ = 2 * M_PI * (*dist)(*rng);
+        rotate_conf(
+                a_tp1 - a_tp0, as_rvec_array(x.data()) + a_tp0, nullptr, angleX, angleY, angleZ);
+        /* Shift to the insertion location */
+        for (int i = a_tp0; i < a_tp1; i++)
+        {
+            rvec_inc(x[i], x_tp);
+        }
+    }
+}
+
+//! The energy terms of the inserted molecule that are reported
+struct TpiEnergyTerms
+{
+    //! The number of energy groups
+    int ngid;
+    //! The energy group of the inserted molecule
+    int gid_tp;
+    //! Whether dispersion correction is used
+    bool bDispCorr;
+    //! Whether the inserted molecule has charges
+    bool bCharge;
+    //! Whether the reaction-field exclusion correction is reported
+    bool bRFExcl;
+    //! Whether there is a reciprocal space electrostatics contribution
+    bool haveReciprocal;
+};
+
+/*! \brief Adds the energy contributions of an insertion, weighted by \p embU, to \p sum_UgembU
+ *
+ * The order of the terms matches the legend of the TPI output file.
+ */
+static void accumulateWeightedEnergies(const TpiEnergyTerms&     terms,
+                                       const double              embU,
+                                       const real                epot,
+                                       gmx::ArrayRef<const real> vdwEnergies,
+                                       gmx::ArrayRef<const real> coulombEnergies,
+                                       const real                dispersionCorrectionEnergy,
+                                       const real                rfExclusionEnergy,
+                                       const real                reciprocalEnergy,
+                                       double*                   sum_UgembU)
+{
+    const int ngid = terms.ngid;
+    int       e    = 0;
+    sum_UgembU[e++] += epot * embU;
+    for (int i = 0; i < ngid; i++)
+    {
+        sum_UgembU[e++] += vdwEnergies[GID(i, terms.gid_tp, ngid)] * embU;
+    }
+    if (terms.bDispCorr)
+    {
+        sum_UgembU[e++] += dispersionCorrectionEnergy * embU;
+    }
+    if (terms.bCharge)
+    {
+        for (int i = 0; i < ngid; i++)
+        {
+            sum_UgembU[e++] += coulombEnergies[GID(i, terms.gid_tp, ngid)] * embU;
+        }
+        if (terms.bRFExcl)
+        {
+            sum_UgembU[e++] += rfExclusionEnergy * embU;
+        }
+        if (terms.haveReciprocal)
+        {
+            sum_UgembU[e++] += reciprocalEnergy * embU;
+        }
+    }
+}
+
+//! Work data for a thread computing insertions concurrently with other threads
+struct TpiThreadData
+{
+    //! Non-bonded setup with grids, pair list and atom data owned by this thread
+    std::unique_ptr<nonbonded_verlet_t> nbv;
+    //! The coordinates of the system and of our copy of the inserted molecule
+    std::vector<gmx::RVec> x;
+    //! Van der Waals energies for all energy-group pairs
+    std::vector<real> vdwEnergies;
+    //! Coulomb energies for all energy-group pairs
+    std::vector<real> coulombEnergies;
+    //! The sum of the Boltzmann factors over the insertions in the current frame
+    double sum_embU = 0;
+    //! The Boltzmann weighted energy terms summed over the insertions in the current frame
+    std::vector<double> sum_UgembU;
+    //! Histogram of the insertion energies over all frames
+    std::vector<double> bin;
+    //! Flop counters
+    t_nrnb nrnb;
+};
+
 namespace gmx
 {
 
 // TODO: Convert to use the nbnxm kernels by putting the system and the teset molecule on two separate search grids
 void LegacySimulator::do_tpi()
 {
-    GMX_RELEASE_ASSERT(gmx_omp_nthreads_get(ModuleMultiThread::Default) == 1,
-                       "TPI does not support OpenMP");
-
     gmx::ForceBuffers          f;
     real                       lambda, t, temp, beta, drmax, epot;
     double                     embU, sum_embU, *sum_UgembU, V, V_all, VembU_all;
@@ -177,7 +356,7 @@ void LegacySimulator::do_tpi()
     tensor                     force_vir, shake_vir, vir, pres;
     int                        a_tp0, a_tp1, ngid, gid_tp, nener, e;
     rvec*                      x_mol;
-    rvec                       mu_tot, x_init, dx;
+    rvec                       mu_tot, x_init;
     int                        nnodes, frame;
     int64_t                    frame_step_prev, frame_step;
     int64_t                    nsteps, stepblocksize = 0, step;
@@ -189,7 +368,7 @@ void LegacySimulator::do_tpi()
     double                     dbl, dump_ener;
     gmx_bool                   bCavity;
     int                        nat_cavity  = 0, d;
-    real *                     mass_cavity = nullptr, mass_tot;
+    real*                      mass_cavity = nullptr;
     int                        nbin;
     double                     invbinw, *bin, refvolshift, logV, bUlogV;
     gmx_bool                   bEnergyOutOfBounds;
@@ -478,6 +657,40 @@ void LegacySimulator::do_tpi()
     }
     snew(sum_UgembU, nener);
 
+    const TpiEnergyTerms energyTerms = { ngid,
+                                         gid_tp,
+                                         bDispCorr != 0,
+                                         bCharge != 0,
+                                         bRFExcl != 0,
+                                         usingFullElectrostatics(fr_->ic->eeltype) };
+
+    /* With multiple OpenMP threads, each thread computes whole blocks of
+     * insertions that share a pair list. To avoid synchronization, each
+     * thread uses its own non-bonded setup and copy of the coordinates.
+     */
+    const int                  numThreads = gmx_omp_nthreads_get(ModuleMultiThread::Default);
+    std::vector<TpiThreadData> threadData;
+    if (numThreads > 1)
+    {
+        GMX_RELEASE_ASSERT(inputRec_->efep == FreeEnergyPerturbationType::No
+                                   && fr_->ic->eeltype != CoulombInteractionType::Ewald
+                                   && inputRec_->nwall == 0,
+                           "Multi-threaded TPI does not support free-energy perturbation, "
+                           "plain Ewald or walls");
+
+        threadData.resize(numThreads);
+        for (TpiThreadData& threadWork : threadData)
+        {
+            threadWork.nbv = Nbnxm::init_nb_verlet_cpu_copy(*fr_->nbv, *inputRec_, *fr_);
+            nbnxn_atomdata_copy_shiftvec(false, fr_->shift_vec, &threadWork.nbv->nbat());
+            threadWork.x.resize(x.size());
+            threadWork.vdwEnergies.resize(ngid * ngid);
+            threadWork.coulombEnergies.resize(ngid * ngid);
+            threadWork.sum_UgembU.resize(nener);
+            threadWork.bin.resize(1);
+        }
+    }
+
     /* Copy the random seed set by the user */
     seed = inputRec_->ld_seed;
 
@@ -606,8 +819,20 @@ void LegacySimulator::do_tpi()
         /* Put all atoms except for the inserted ones on the grid */
         rvec vzero       = { 0, 0, 0 };
         rvec boxDiagonal = { box[XX][XX], box[YY][YY], box[ZZ][ZZ] };
-        fr_->nbv->putAtomsOnGrid(
-                box, 0, vzero, boxDiagonal, nullptr, { 0, a_tp0 }, -1, fr_->atomInfo, x, 0, nullptr);
+        if (threadData.empty())
+        {
+            fr_->nbv->putAtomsOnGrid(box,
+                                     0,
+                                     vzero,
+                                     boxDiagonal,
+                                     nullptr,
+                                     { 0, a_tp0 },
+                                     -1,
+                                     fr_->atomInfo,
+                                     x,
+                                     0,
+                                     nullptr);
+        }
 
         gmx_edsam* const ed = nullptr;
 
@@ -625,6 +850,290 @@ void LegacySimulator::do_tpi()
                 *inputRec_, *fr_, pullWork_, ed, *mdatoms, runScheduleWork_->simulationWork);
 
         step = cr_->nodeid * stepblocksize;
+        if (!threadData.empty())
+        {
+            /* Each thread computes whole blocks of insertions assigned to this rank */
+            runScheduleWork_->stepWork = setupStepWorkload(
+                    GMX_FORCE_NONBONDED | GMX_FORCE_ENERGY | GMX_FORCE_STATECHANGED,
+                    inputRec_->mtsLevels,
+                    frame_step,
+                    runScheduleWork_->domainWork,
+                    runScheduleWork_->simulationWork);
+            const StepWorkload& stepWork = runScheduleWork_->stepWork;
+
+            /* The PME grid potential of the system is the same for all insertions */
+            if (usingPme(fr_->ic->eeltype))
+            {
+                matrix pmeVirialQ, pmeVirialLJ;
+                real   pmeEnergyQ = 0, pmeEnergyLJ = 0, dvdlQ = 0, dvdlLJ = 0;
+
+                cr_->nnodes = 1;
+                wallcycle_start(wallCycleCounters_, WallCycleCounter::PmeMesh);
+                const int status = gmx_pme_do(
+                        fr_->pmedata,
+                        constArrayRefFromArray(x.data(), a_tp0),
+                        f.view().force(),
+                        mdatoms->chargeA,
+                        mdatoms->chargeB,
+                        mdatoms->sqrt_c6A,
+                        mdatoms->sqrt_c6B,
+                        mdatoms->sigmaA,
+                        mdatoms->sigmaB,
+                        box,
+                        cr_,
+                        0,
+                        0,
+                        nrnb_,
+                        wallCycleCounters_,
+                        pmeVirialQ,
+                        pmeVirialLJ,
+                        &pmeEnergyQ,
+                        &pmeEnergyLJ,
+                        stateGlobal_->lambda[FreeEnergyPerturbationCouplingType::Coul],
+                        stateGlobal_->lambda[FreeEnergyPerturbationCouplingType::Vdw],
+                        &dvdlQ,
+                        &dvdlLJ,
+                        stepWork);
+                wallcycle_stop(wallCycleCounters_, WallCycleCounter::PmeMesh);
+                cr_->nnodes = nnodes;
+                if (status != 0)
+                {
+                    gmx_fatal(FARGS, "Error %d in reciprocal PME routine", status);
+                }
+            }
+
+            const real dispersionCorrectionEnergy =
+                    fr_->dispersionCorrection
+                            ? fr_->dispersionCorrection->calculate(stateGlobal_->box, lambda).energy
+                            : 0;
+
+            if (bCavity)
+            {
+                computeCavityLocation(rerun_fr, nat_cavity, mass_cavity, x_init);
+            }
+
+            const int64_t numBlocks = (nsteps + stepblocksize - 1) / stepblocksize;
+
+#pragma omp parallel num_threads(numThreads)
+            {
+                try
+                {
+                    TpiThreadData&      threadWork = threadData[gmx_omp_get_thread_num()];
+                    nonbonded_verlet_t& nbv        = *threadWork.nbv;
+
+                    std::copy(x.begin(), x.end(), threadWork.x.begin());
+                    nbv.putAtomsOnGrid(box,
+                                       0,
+                                       vzero,
+                                       boxDiagonal,
+                                       nullptr,
+                                       { 0, a_tp0 },
+                                       -1,
+                                       fr_->atomInfo,
+                                       threadWork.x,
+                                       0,
+                                       nullptr);
+
+                    threadWork.sum_embU = 0;
+                    std::fill(threadWork.sum_UgembU.begin(), threadWork.sum_UgembU.end(), 0);
+
+                    gmx::ThreeFry2x64<16> threadRng(seed, gmx::RandomDomain::TestParticleInsertion);
+                    gmx::UniformRealDistribution<real> threadDist;
+                    rvec                               threadXInit;
+                    copy_rvec(x_init, threadXInit);
+                    bool havePairlist = false;
+
+                    std::fenv_t floatingPointEnvironment;
+                    std::feholdexcept(&floatingPointEnvironment);
+
+#pragma omp for schedule(dynamic)
+                    for (int64_t block = cr_->nodeid; block < numBlocks; block += nnodes)
+                    {
+                        const int64_t blockEnd = std::min((block + 1) * stepblocksize, nsteps);
+                        for (int64_t tpiStep = block * stepblocksize; tpiStep < blockEnd; tpiStep++)
+                        {
+                            /* Use the same random streams as the serial loop below */
+                            threadRng.restart(frame_step, tpiStep);
+                            threadDist.reset();
+
+                            const bool doPairSearch = bCavity ? !havePairlist
+                                                              : (tpiStep % inputRec_->nstlist == 0);
+                            if (doPairSearch)
+                            {
+                                if (!bCavity)
+                                {
+                                    for (int dim = 0; dim < DIM; dim++)
+                                    {
+                                        threadXInit[dim] = threadDist(threadRng) * box[dim][dim];
+                                    }
+                                }
+                                for (int a = a_tp0; a < a_tp1; a++)
+                                {
+                                    threadWork.x[a] = threadXInit;
+                                }
+
+                                nbv.putAtomsOnGrid(box,
+                                                   1,
+                                                   threadXInit,
+                                                   threadXInit,
+                                                   nullptr,
+                                                   { a_tp0, a_tp1 },
+                                                   -1,
+                                                   fr_->atomInfo,
+                                                   threadWork.x,
+                                                   0,
+                                                   nullptr);
+                                nbv.setAtomProperties(
+                                        mdatoms->typeA, mdatoms->chargeA, fr_->atomInfo);
+                                nbv.constructPairlist(InteractionLocality::Local,
+                                                      top_->excls,
+                                                      tpiStep,
+                                                      &threadWork.nrnb);
+
+                                havePairlist = true;
+                            }
+
+                            rvec x_tp;
+                            placeInsertedMolecule(threadXInit,
+                                                  bCavity || inputRec_->nstlist > 1,
+                                                  drmax,
+                                                  x_mol,
+                                                  a_tp0,
+                                                  a_tp1,
+                                                  &threadRng,
+                                                  &threadDist,
+                                                  threadWork.x,
+                                                  x_tp);
+
+                            /* Note: NonLocal refers to the inserted molecule */
+                            nbv.convertCoordinates(AtomLocality::NonLocal, threadWork.x);
+
+                            std::fill(threadWork.vdwEnergies.begin(),
+                                      threadWork.vdwEnergies.end(),
+                                      0);
+                            std::fill(threadWork.coulombEnergies.begin(),
+                                      threadWork.coulombEnergies.end(),
+                                      0);
+                            nbv.dispatchNonbondedKernel(InteractionLocality::Local,
+                                                        *fr_->ic,
+                                                        stepWork,
+                                                        enbvClearFYes,
+                                                        fr_->shift_vec,
+                                                        threadWork.vdwEnergies,
+                                                        threadWork.coulombEnergies,
+                                                        &threadWork.nrnb);
+
+                            real reciprocalEnergy = 0;
+                            if (usingPme(fr_->ic->eeltype))
+                            {
+                                /* Determine the PME grid energy of the test molecule
+                                 * with the PME grid potential of the other charges.
+                                 */
+                                const int numTpiAtoms = a_tp1 - a_tp0;
+                                reciprocalEnergy      = gmx_pme_calc_energy(
+                                        fr_->pmedata,
+                                        constArrayRefFromArray(threadWork.x.data() + a_tp0,
+                                                               numTpiAtoms),
+                                        mdatoms->chargeA.subArray(a_tp0, numTpiAtoms));
+                            }
+
+                            real insertionEnergy = reciprocalEnergy + dispersionCorrectionEnergy
+                                                   + rfExclusionEnergy;
+                            for (int pair = 0; pair < ngid * ngid; pair++)
+                            {
+                                insertionEnergy += threadWork.vdwEnergies[pair]
+                                                   + threadWork.coulombEnergies[pair];
+                            }
+
+                            /* See the serial loop below for the treatment of non-finite energies */
+                            double insertionEmbU = 0;
+                            if (std::isfinite(insertionEnergy))
+                            {
+                                insertionEmbU = exp(static_cast<double>(-beta * insertionEnergy));
+                                threadWork.sum_embU += insertionEmbU;
+                                accumulateWeightedEnergies(energyTerms,
+                                                           insertionEmbU,
+                                                           insertionEnergy,
+                                                           threadWork.vdwEnergies,
+                                                           threadWork.coulombEnergies,
+                                                           dispersionCorrectionEnergy,
+                                                           rfExclusionEnergy,
+                                                           reciprocalEnergy,
+                                                           threadWork.sum_UgembU.data());
+                            }
+
+                            if (insertionEmbU == 0 || beta * insertionEnergy > bU_bin_limit)
+                            {
+                                threadWork.bin[0]++;
+                            }
+                            else
+                            {
+                                const real bUlogVShifted =
+                                        beta * insertionEnergy - logV + refvolshift;
+                                const int binIndex =
+                                        std::max(0,
+                                                 gmx::roundToInt((bU_logV_bin_limit - bUlogVShifted)
+                                                                 * invbinw));
+                                if (binIndex >= gmx::ssize(threadWork.bin))
+                                {
+                                    threadWork.bin.resize(binIndex + 10, 0);
+                                }
+                                threadWork.bin[binIndex]++;
+                            }
+
+                            if (debug || (dump_pdb && insertionEnergy <= dump_ener))
+                            {
+#pragma omp critical
+                                {
+                                    if (debug)
+                                    {
+                                        fprintf(debug,
+                                                "TPI %7d %12.5e %12.5f %12.5f %12.5f\n",
+                                                static_cast<int>(tpiStep),
+                                                insertionEnergy,
+                                                x_tp[XX],
+                                                x_tp[YY],
+                                                x_tp[ZZ]);
+                                    }
+                                    if (dump_pdb && insertionEnergy <= dump_ener)
+                                    {
+                                        auto str = gmx::formatString(
+                                                "t%g_step%d.pdb", t, static_cast<int>(tpiStep));
+                                        auto str2 = gmx::formatString("t: %f step %d ener: %f",
+                                                                      t,
+                                                                      static_cast<int>(tpiStep),
+                                                                      insertionEnergy);
+                                        write_sto_conf_mtop(str.c_str(),
+                                                            str2.c_str(),
+                                                            topGlobal_,
+                                                            as_rvec_array(threadWork.x.data()),
+                                                            stateGlobal_->v.rvec_array(),
+                                                            inputRec_->pbcType,
+                                                            stateGlobal_->box);
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    std::feclearexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+                    std::feupdateenv(&floatingPointEnvironment);
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            }
+
+            for (const TpiThreadData& threadWork : threadData)
+            {
+                sum_embU += threadWork.sum_embU;
+                for (e = 0; e < nener; e++)
+                {
+                    sum_UgembU[e] += threadWork.sum_UgembU[e];
+                }
+            }
+
+            /* All insertions assigned to this rank are done, skip the serial loop below */
+            step = nsteps;
+        }
         while (step < nsteps)
         {
             /* Restart random engine using the frame and insertion step
@@ -658,30 +1167,7 @@ void LegacySimulator::do_tpi()
                  */
                 if (step == 0)
                 {
-                    if (nat_cavity == 1)
-                    {
-                        /* Copy the location of the cavity */
-                        copy_rvec(rerun_fr.x[rerun_fr.natoms - 1], x_init);
-                    }
-                    else
-                    {
-                        /* Determine the center of mass of the last molecule */
-                        clear_rvec(x_init);
-                        mass_tot = 0;
-                        for (i = 0; i < nat_cavity; i++)
-                        {
-                            for (d = 0; d < DIM; d++)
-                            {
-                                x_init[d] += mass_cavity[i]
-                                             * rerun_fr.x[rerun_fr.natoms - nat_cavity + i][d];
-                            }
-                            mass_tot += mass_cavity[i];
-                        }
-                        for (d = 0; d < DIM; d++)
-                        {
-                            x_init[d] /= mass_tot;
-                        }
-                    }
+                    computeCavityLocation(rerun_fr, nat_cavity, mass_cavity, x_init);
                 }
             }
 
@@ -704,53 +1190,17 @@ void LegacySimulator::do_tpi()
                 bNS = FALSE;
             }
 
-            /* Add random displacement uniformly distributed in a sphere
-             * of radius rtpi. We don't need to do this is we generate
-             * a new center location every step.
-             */
             rvec x_tp;
-            if (bCavity || inputRec_->nstlist > 1)
-            {
-                /* Generate coordinates within |dx|=drmax of x_init */
-                do
-                {
-                    for (d = 0; d < DIM; d++)
-                    {
-                        dx[d] = (2 * dist(rng) - 1) * drmax;
-                    }
-                } while (norm2(dx) > drmax * drmax);
-                rvec_add(x_init, dx, x_tp);
-            }
-            else
-            {
-                copy_rvec(x_init, x_tp);
-            }
-
-            if (a_tp1 - a_tp0 == 1)
-            {
-                /* Insert a single atom, just copy the insertion location */
-                copy_rvec(x_tp, x[a_tp0]);
-            }
-            else
-            {
-                /* Copy the coordinates from the top file */
-                for (i = a_tp0; i < a_tp1; i++)
-                {
-                    copy_rvec(x_mol[i - a_tp0], x[i]);
-                }
-                /* Rotate the molecule randomly */
-                real angleX = 2 * M_PI * dist(rng);
-                /* Draw uniform random number for sin(angleY) instead of angleY itself in order to
-                 * achieve the uniform distribution in the solid angles space. */
-                real angleY = std::asin(2 * dist(rng) - 1);
-                real angleZ = 2 * M_PI * dist(rng);
-                rotate_conf(a_tp1 - a_tp0, stateGlobal_->x.rvec_array() + a_tp0, nullptr, angleX, angleY, angleZ);
-                /* Shift to the insertion location */
-                for (i = a_tp0; i < a_tp1; i++)
-                {
-                    rvec_inc(x[i], x_tp);
-                }
-            }
+            placeInsertedMolecule(x_init,
+                                  bCavity || inputRec_->nstlist > 1,
+                                  drmax,
+                                  x_mol,
+                                  a_tp0,
+                                  a_tp1,
+                                  &rng,
+                                  &dist,
+                                  x,
+                                  x_tp);
 
             /* Note: NonLocal refers to the inserted molecule */
             fr_->nbv->convertCoordinates(AtomLocality::NonLocal, x);
@@ -821,9 +1271,11 @@ void LegacySimulator::do_tpi()
                 /* Calculate long range corrections to pressure and energy */
                 const DispersionCorrection::Correction correction =
                         fr_->dispersionCorrection->calculate(stateGlobal_->box, lambda);
-                /* figure out how to rearrange the next 4 lines MRS 8/4/2009 */
+                /* do_force adds the correction to the energy only on the main
+                 * rank, so we replace that contribution to avoid double counting.
+                 */
+                enerd_->term[F_EPOT] += correction.energy - enerd_->term[F_DISPCORR];
                 enerd_->term[F_DISPCORR] = correction.energy;
-                enerd_->term[F_EPOT] += correction.energy;
                 enerd_->term[F_PRES] += correction.pressure;
                 enerd_->term[F_DVDL] += correction.dvdl;
             }
@@ -875,48 +1327,18 @@ void LegacySimulator::do_tpi()
                 embU = exp(static_cast<double>(-beta * epot));
                 sum_embU += embU;
                 /* Determine the weighted energy contributions of each energy group */
-                e = 0;
-                sum_UgembU[e++] += epot * embU;
-                if (fr_->haveBuckingham)
-                {
-                    for (i = 0; i < ngid; i++)
-                    {
-                        sum_UgembU[e++] +=
-                                enerd_->grpp.energyGroupPairTerms[NonBondedEnergyTerms::BuckinghamSR]
-                                                                 [GID(i, gid_tp, ngid)]
-                                * embU;
-                    }
-                }
-                else
-                {
-                    for (i = 0; i < ngid; i++)
-                    {
-                        sum_UgembU[e++] +=
-                                enerd_->grpp.energyGroupPairTerms[NonBondedEnergyTerms::LJSR][GID(i, gid_tp, ngid)]
-                                * embU;
-                    }
-                }
-                if (bDispCorr)
-                {
-                    sum_UgembU[e++] += enerd_->term[F_DISPCORR] * embU;
-                }
-                if (bCharge)
-                {
-                    for (i = 0; i < ngid; i++)
-                    {
-                        sum_UgembU[e++] +=
-                                enerd_->grpp.energyGroupPairTerms[NonBondedEnergyTerms::CoulombSR][GID(i, gid_tp, ngid)]
-                                * embU;
-                    }
-                    if (bRFExcl)
-                    {
-                        sum_UgembU[e++] += rfExclusionEnergy * embU;
-                    }
-                    if (usingFullElectrostatics(fr_->ic->eeltype))
-                    {
-                        sum_UgembU[e++] += enerd_->term[F_COUL_RECIP] * embU;
-                    }
-                }
+                const NonBondedEnergyTerms vdwTerm = fr_->haveBuckingham
+                                                             ? NonBondedEnergyTerms::BuckinghamSR
+                                                             : NonBondedEnergyTerms::LJSR;
+                accumulateWeightedEnergies(energyTerms,
+                                           embU,
+                                           epot,
+                                           enerd_->grpp.energyGroupPairTerms[vdwTerm],
+                                           enerd_->grpp.energyGroupPairTerms[NonBondedEnergyTerms::CoulombSR],
+                                           enerd_->term[F_DISPCORR],
+                                           rfExclusionEnergy,
+                                           enerd_->term[F_COUL_RECIP],
+                                           sum_UgembU);
             }
 
             if (embU == 0 || beta * epot > bU_bin_limit)
@@ -1031,6 +1453,21 @@ void LegacySimulator::do_tpi()
         }
     }
 
+    /* Add the histograms and flop counts of the threads */
+    for (const TpiThreadData& threadWork : threadData)
+    {
+        realloc_bins(&bin, &nbin, std::max(nbin, static_cast<int>(threadWork.bin.size())));
+        for (size_t b = 0; b < threadWork.bin.size(); b++)
+        {
+            bin[b] += threadWork.bin[b];
+        }
+        for (int n = 0; n < eNRNB; n++)
+        {
+            nrnb_->n[n] += threadWork.nrnb.n[n];
+        }
+    }
+
+
     /* Write the Boltzmann factor histogram */
     if (PAR(cr_))
     {
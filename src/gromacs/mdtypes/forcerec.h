@@ -63,6 +63,7 @@ struct interaction_const_t;
 
 namespace gmx
 {
+class CpuPmeOverlap;
 class DeviceStreamManager;
 class ListedForcesGpu;
 class GpuForceReduction;
@@ -260,6 +261,9 @@ struct t_forcerec
     // The long range non-bonded forces
     std::unique_ptr<CpuPpLongRangeNonbondeds> longRangeNonbondeds;
 
+    // Runs the CPU long-range non-bonded forces concurrently with the short-range work, can be nullptr
+    std::unique_ptr<gmx::CpuPmeOverlap> cpuPmeOverlap;
+
     gmx::ForceProviders* forceProviders = nullptr;
 
     // The stateGpu object is created in runner, forcerec just keeps the copy of the pointer.
@@ -43,6 +43,7 @@
 #include "pmeloadbalancehelper.h"
 
 #include "gromacs/ewald/pme_load_balancing.h"
+#include "gromacs/gpu_utils/device_stream_manager.h"
 #include "gromacs/mdtypes/commrec.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/inputrec.h"
@@ -92,8 +93,17 @@ void PmeLoadBalanceHelper::setup()
     const auto* box = statePropagatorData_->constBox();
     GMX_RELEASE_ASSERT(box[0][0] != 0 && box[1][1] != 0 && box[2][2] != 0,
                        "PmeLoadBalanceHelper cannot be initialized with zero box.");
-    pme_loadbal_init(
-            &pme_loadbal_, cr_, mdlog_, *inputrec_, box, *fr_->ic, *fr_->nbv, fr_->pmedata, fr_->nbv->useGpu());
+    pme_loadbal_init(&pme_loadbal_,
+                     cr_,
+                     mdlog_,
+                     *inputrec_,
+                     box,
+                     *fr_->ic,
+                     *fr_->nbv,
+                     fr_->pmedata,
+                     fr_->nbv->useGpu(),
+                     statePropagatorData_->totalNumAtoms(),
+                     fr_->deviceStreamManager ? &fr_->deviceStreamManager->deviceInfo() : nullptr);
 }
 
 void PmeLoadBalanceHelper::run(gmx::Step step, gmx::Time gmx_unused time)
@@ -278,6 +278,7 @@ void ModularSimulatorAlgorithm::preStep(Step step, Time gmx_unused time, bool is
     stopHandler_->setSignal();
 
     wallcycle_start(wallCycle_, WallCycleCounter::Step);
+    wallcycle_set_step(wallCycle_, step);
 }
 
 void ModularSimulatorAlgorithm::postStep(Step step, Time gmx_unused time)
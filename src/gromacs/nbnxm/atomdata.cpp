@@ -57,6 +57,7 @@
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/strconvert.h"
 #include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "grid.h"
 #include "gridset.h"
@@ -133,6 +134,48 @@ static void copy_int_to_nbat_int(const int* a, int na, int na_round, const int*
     }
 }
 
+//! Copies coordinates to \p xnb in packs of \p packSize, filling up to \p na_round with \p farAway
+template<int packSize>
+static void copy_rvec_to_nbat_real_packed(const int*  a,
+                                          int         na,
+                                          int         na_round,
+                                          const rvec* x,
+                                          const real  farAway,
+                                          real*       xnb,
+                                          int         a0)
+{
+    int i = 0;
+    int j = atom_to_x_index<packSize>(a0);
+    int c = a0 & (packSize - 1);
+    for (; i < na; i++)
+    {
+        xnb[j + XX * packSize] = x[a[i]][XX];
+        xnb[j + YY * packSize] = x[a[i]][YY];
+        xnb[j + ZZ * packSize] = x[a[i]][ZZ];
+        j++;
+        c++;
+        if (c == packSize)
+        {
+            j += (DIM - 1) * packSize;
+            c = 0;
+        }
+    }
+    /* Complete the partially filled last cell with zeros */
+    for (; i < na_round; i++)
+    {
+        xnb[j + XX * packSize] = farAway;
+        xnb[j + YY * packSize] = farAway;
+        xnb[j + ZZ * packSize] = farAway;
+        j++;
+        c++;
+        if (c == packSize)
+        {
+            j += (DIM - 1) * packSize;
+            c = 0;
+        }
+    }
+}
+
 void copy_rvec_to_nbat_real(const int* a, int na, int na_round, const rvec* x, int nbatFormat, real* xnb, int a0)
 {
     /* We complete partially filled cells, can only be the last one in each
@@ -187,69 +230,15 @@ void copy_rvec_to_nbat_real(const int* a, int na, int na_round, const rvec* x, i
     }
     else if (nbatFormat == nbatX4)
     {
-        int i = 0;
-        int j = atom_to_x_index<c_packX4>(a0);
-        int c = a0 & (c_packX4 - 1);
-        for (; i < na; i++)
-        {
-            xnb[j + XX * c_packX4] = x[a[i]][XX];
-            xnb[j + YY * c_packX4] = x[a[i]][YY];
-            xnb[j + ZZ * c_packX4] = x[a[i]][ZZ];
-            j++;
-            c++;
-            if (c == c_packX4)
-            {
-                j += (DIM - 1) * c_packX4;
-                c = 0;
-            }
-        }
-        /* Complete the partially filled last cell with zeros */
-        for (; i < na_round; i++)
-        {
-            xnb[j + XX * c_packX4] = farAway;
-            xnb[j + YY * c_packX4] = farAway;
-            xnb[j + ZZ * c_packX4] = farAway;
-            j++;
-            c++;
-            if (c == c_packX4)
-            {
-                j += (DIM - 1) * c_packX4;
-                c = 0;
-            }
-        }
+        copy_rvec_to_nbat_real_packed<c_packX4>(a, na, na_round, x, farAway, xnb, a0);
     }
     else if (nbatFormat == nbatX8)
     {
-        int i = 0;
-        int j = atom_to_x_index<c_packX8>(a0);
-        int c = a0 & (c_packX8 - 1);
-        for (; i < na; i++)
-        {
-            xnb[j + XX * c_packX8] = x[a[i]][XX];
-            xnb[j + YY * c_packX8] = x[a[i]][YY];
-            xnb[j + ZZ * c_packX8] = x[a[i]][ZZ];
-            j++;
-            c++;
-            if (c == c_packX8)
-            {
-                j += (DIM - 1) * c_packX8;
-                c = 0;
-            }
-        }
-        /* Complete the partially filled last cell with zeros */
-        for (; i < na_round; i++)
-        {
-            xnb[j + XX * c_packX8] = farAway;
-            xnb[j + YY * c_packX8] = farAway;
-            xnb[j + ZZ * c_packX8] = farAway;
-            j++;
-            c++;
-            if (c == c_packX8)
-            {
-                j += (DIM - 1) * c_packX8;
-                c = 0;
-            }
-        }
+        copy_rvec_to_nbat_real_packed<c_packX8>(a, na, na_round, x, farAway, xnb, a0);
+    }
+    else if (nbatFormat == nbatX16)
+    {
+        copy_rvec_to_nbat_real_packed<c_packX16>(a, na, na_round, x, farAway, xnb, a0);
     }
     else
     {
@@ -367,8 +356,10 @@ nbnxn_atomdata_t::SimdMasks::SimdMasks()
      * real SIMD registers (together with a cast).
      * In single precision this means the real and integer SIMD registers
      * are of equal size.
+     * The 4x16 kernels use 64-bit masks which are split per i-atom,
+     * so they only need the first 16 filter bits.
      */
-    const int simd_excl_size = c_nbnxnCpuIClusterSize * simd_width;
+    const int simd_excl_size = std::min(c_nbnxnCpuIClusterSize * simd_width, 32);
 #    if GMX_DOUBLE && !GMX_SIMD_HAVE_INT32_LOGICAL
     exclusion_filter64.resize(simd_excl_size);
 #    else
@@ -616,6 +607,7 @@ nbnxn_atomdata_t::nbnxn_atomdata_t(gmx::PinningPolicy      pinningPolicy,
             {
                 case 4: XFormat = nbatX4; break;
                 case 8: XFormat = nbatX8; break;
+                case 16: XFormat = nbatX16; break;
                 default: gmx_incons("Unsupported packing width");
             }
         }
@@ -720,6 +712,13 @@ static void nbnxn_atomdata_set_ljcombparams(nbnxn_atomdata_t::Params* params,
                                                       numAtoms,
                                                       params->lj_comb.data() + atomOffset * 2);
                 }
+                else if (XFormat == nbatX16)
+                {
+                    copy_lj_to_nbat_lj_comb<c_packX16>(params->nbfp_comb,
+                                                       params->type.data() + atomOffset,
+                                                       numAtoms,
+                                                       params->lj_comb.data() + atomOffset * 2);
+                }
                 else if (XFormat == nbatXYZQ)
                 {
                     copy_lj_to_nbat_lj_comb<1>(params->nbfp_comb,
@@ -804,7 +803,7 @@ static void nbnxn_atomdata_mask_fep(nbnxn_atomdata_t* nbat, const Nbnxm::GridSet
     {
         const int nsubc = (grid.geometry().isSimple) ? 1 : c_gpuNumClusterPerCell;
 
-        const int c_offset = grid.firstAtomInColumn(0);
+        const int c_offset = grid.atomIndexBegin();
 
         /* Loop over all columns and copy and fill */
         for (int c = 0; c < grid.numCells() * nsubc; c++)
@@ -957,9 +956,7 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet&   gridSet,
     const auto gridRange = getGridRange(gridSet, locality);
 
     const int nth = gmx_omp_nthreads_get(ModuleMultiThread::Pairsearch);
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
+    auto copyXForThread = [&](int th) {
         try
         {
             for (int g : gridRange)
@@ -986,7 +983,8 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet&   gridSet,
             }
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-    }
+    };
+    gmx::parallelForOnThreads(nth, nth, copyXForThread);
 }
 
 /* Copies (and reorders) the coordinates to nbnxn_atomdata_t on the GPU*/
@@ -1012,88 +1010,6 @@ void nbnxn_atomdata_x_to_nbat_x_gpu(const Nbnxm::GridSet&   gridSet,
     }
 }
 
-static void nbnxn_atomdata_clear_reals(gmx::ArrayRef<real> dest, int i0, int i1)
-{
-    for (int i = i0; i < i1; i++)
-    {
-        dest[i] = 0;
-    }
-}
-
-gmx_unused static void nbnxn_atomdata_reduce_reals(real* gmx_restrict        dest,
-                                                   gmx_bool                  bDestSet,
-                                                   const real** gmx_restrict src,
-                                                   int                       nsrc,
-                                                   int                       i0,
-                                                   int                       i1)
-{
-    if (bDestSet)
-    {
-        /* The destination buffer contains data, add to it */
-        for (int i = i0; i < i1; i++)
-        {
-            for (int s = 0; s < nsrc; s++)
-            {
-                dest[i] += src[s][i];
-            }
-        }
-    }
-    else
-    {
-        /* The destination buffer is uninitialized, set it first */
-        for (int i = i0; i < i1; i++)
-        {
-            dest[i] = src[0][i];
-            for (int s = 1; s < nsrc; s++)
-            {
-                dest[i] += src[s][i];
-            }
-        }
-    }
-}
-
-gmx_unused static void nbnxn_atomdata_reduce_reals_simd(real gmx_unused* gmx_restrict dest,
-                                                        gmx_bool gmx_unused           bDestSet,
-                                                        const gmx_unused real** gmx_restrict src,
-                                                        int gmx_unused                       nsrc,
-                                                        int gmx_unused                       i0,
-                                                        int gmx_unused                       i1)
-{
-#if GMX_SIMD
-    /* The SIMD width here is actually independent of that in the kernels,
-     * but we use the same width for simplicity (usually optimal anyhow).
-     */
-    SimdReal dest_SSE, src_SSE;
-
-    if (bDestSet)
-    {
-        for (int i = i0; i < i1; i += GMX_SIMD_REAL_WIDTH)
-        {
-            dest_SSE = load<SimdReal>(dest + i);
-            for (int s = 0; s < nsrc; s++)
-            {
-                src_SSE  = load<SimdReal>(src[s] + i);
-                dest_SSE = dest_SSE + src_SSE;
-            }
-            store(dest + i, dest_SSE);
-        }
-    }
-    else
-    {
-        for (int i = i0; i < i1; i += GMX_SIMD_REAL_WIDTH)
-        {
-            dest_SSE = load<SimdReal>(src[0] + i);
-            for (int s = 1; s < nsrc; s++)
-            {
-                src_SSE  = load<SimdReal>(src[s] + i);
-                dest_SSE = dest_SSE + src_SSE;
-            }
-            store(dest + i, dest_SSE);
-        }
-    }
-#endif
-}
-
 /* Add part of the force array(s) from nbnxn_atomdata_t to f
  *
  * Note: Adding restrict to f makes this function 50% slower with gcc 7.3
@@ -1143,54 +1059,90 @@ static void nbnxn_atomdata_add_nbat_f_to_f_part(const Nbnxm::GridSet&          g
                 f[a][ZZ] += fnb[i + ZZ * c_packX8];
             }
             break;
+        case nbatX16:
+            for (int a = a0; a < a1; a++)
+            {
+                int i = atom_to_x_index<c_packX16>(cell[a]);
+
+                f[a][XX] += fnb[i + XX * c_packX16];
+                f[a][YY] += fnb[i + YY * c_packX16];
+                f[a][ZZ] += fnb[i + ZZ * c_packX16];
+            }
+            break;
         default: gmx_incons("Unsupported nbnxn_atomdata_t format");
     }
 }
 
-static void nbnxn_atomdata_add_nbat_f_to_f_reduce(nbnxn_atomdata_t* nbat, int nth)
+void nbnxn_atomdata_set_buffer_flag_sources(nbnxn_atomdata_t* nbat)
 {
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
+    gmx::ArrayRef<const gmx_bitmask_t> flags      = nbat->buffer_flags;
+    const int                          numOutputs = gmx::ssize(nbat->out);
+
+    nbat->bufferFlagSourceStart.resize(flags.size() + 1);
+    nbat->bufferFlagSources.clear();
+
+    nbat->bufferFlagSourceStart[0] = 0;
+    for (size_t b = 0; b < flags.size(); b++)
     {
-        try
+        for (int out = 0; out < numOutputs; out++)
         {
-            const real* fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
+            if (bitmask_is_set(flags[b], out))
+            {
+                nbat->bufferFlagSources.push_back(out);
+            }
+        }
+        nbat->bufferFlagSourceStart[b + 1] = gmx::ssize(nbat->bufferFlagSources);
+    }
+}
 
-            gmx::ArrayRef<const gmx_bitmask_t> flags = nbat->buffer_flags;
+/* Reduce the thread output force buffers of nbat and add the result to f
+ * for atoms a0 to a1.
+ *
+ * The reduction is fused with the reordering to the rvec layout, so there is
+ * no pass over an intermediate reduction buffer. Each flag block is only summed
+ * over the output buffers that have written to it. Most blocks are written
+ * by a single thread, so for most atoms this is a plain copy.
+ * With packSize=0 the output buffers use the nbatXYZ layout with stride fstride.
+ */
+template<int packSize>
+static void nbnxn_atomdata_reduce_nbat_f_to_f_part(const Nbnxm::GridSet&   gridSet,
+                                                   const nbnxn_atomdata_t& nbat,
+                                                   const int               a0,
+                                                   const int               a1,
+                                                   rvec*                   f)
+{
+    constexpr int componentStride = (packSize == 0 ? 1 : packSize);
 
-            /* Calculate the cell-block range for our thread */
-            const int b0 = (flags.size() * th) / nth;
-            const int b1 = (flags.size() * (th + 1)) / nth;
+    gmx::ArrayRef<const int> cell        = gridSet.cells();
+    const int*               sourceStart = nbat.bufferFlagSourceStart.data();
+    const int*               sources     = nbat.bufferFlagSources.data();
 
-            for (int b = b0; b < b1; b++)
-            {
-                const int i0 = b * NBNXN_BUFFERFLAG_SIZE * nbat->fstride;
-                const int i1 = (b + 1) * NBNXN_BUFFERFLAG_SIZE * nbat->fstride;
+    const real* fptr[NBNXN_BUFFERFLAG_MAX_THREADS];
+    for (gmx::Index out = 0; out < gmx::ssize(nbat.out); out++)
+    {
+        fptr[out] = nbat.out[out].f.data();
+    }
 
-                int nfptr = 0;
-                for (gmx::Index out = 1; out < gmx::ssize(nbat->out); out++)
-                {
-                    if (bitmask_is_set(flags[b], out))
-                    {
-                        fptr[nfptr++] = nbat->out[out].f.data();
-                    }
-                }
-                if (nfptr > 0)
-                {
-#if GMX_SIMD
-                    nbnxn_atomdata_reduce_reals_simd
-#else
-                    nbnxn_atomdata_reduce_reals
-#endif
-                            (nbat->out[0].f.data(), bitmask_is_set(flags[b], 0), fptr, nfptr, i0, i1);
-                }
-                else if (!bitmask_is_set(flags[b], 0))
-                {
-                    nbnxn_atomdata_clear_reals(nbat->out[0].f, i0, i1);
-                }
-            }
+    for (int a = a0; a < a1; a++)
+    {
+        const int c = cell[a];
+        const int b = c / NBNXN_BUFFERFLAG_SIZE;
+        const int i = (packSize == 0 ? c * nbat.fstride : atom_to_x_index<componentStride>(c));
+
+        real fx = 0;
+        real fy = 0;
+        real fz = 0;
+        for (int s = sourceStart[b]; s < sourceStart[b + 1]; s++)
+        {
+            const real* fnb = fptr[sources[s]];
+
+            fx += fnb[i + XX * componentStride];
+            fy += fnb[i + YY * componentStride];
+            fz += fnb[i + ZZ * componentStride];
         }
-        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        f[a][XX] += fx;
+        f[a][YY] += fy;
+        f[a][ZZ] += fz;
     }
 }
 
@@ -1239,15 +1191,44 @@ void reduceForces(nbnxn_atomdata_t* nbat, const gmx::AtomLocality locality, cons
         {
             gmx_incons("add_f_to_f called with nout>1 and locality!=eatAll");
         }
+        GMX_ASSERT(nbat->bufferFlagSourceStart.size() == nbat->buffer_flags.size() + 1,
+                   "The buffer flag sources should be set up after pair search");
 
-        /* Reduce the force thread output buffers into buffer 0, before adding
-         * them to the, differently ordered, "real" force buffer.
+        /* Reduce the force thread output buffers directly into the,
+         * differently ordered, "real" force buffer.
          */
-        nbnxn_atomdata_add_nbat_f_to_f_reduce(nbat, nth);
+        auto reduceForThread = [&](int th) {
+            try
+            {
+                const int a0 = *atomRange.begin() + ((th + 0) * atomRange.size()) / nth;
+                const int a1 = *atomRange.begin() + ((th + 1) * atomRange.size()) / nth;
+
+                switch (nbat->FFormat)
+                {
+                    case nbatXYZ:
+                    case nbatXYZQ:
+                        nbnxn_atomdata_reduce_nbat_f_to_f_part<0>(gridSet, *nbat, a0, a1, f);
+                        break;
+                    case nbatX4:
+                        nbnxn_atomdata_reduce_nbat_f_to_f_part<c_packX4>(gridSet, *nbat, a0, a1, f);
+                        break;
+                    case nbatX8:
+                        nbnxn_atomdata_reduce_nbat_f_to_f_part<c_packX8>(gridSet, *nbat, a0, a1, f);
+                        break;
+                    case nbatX16:
+                        nbnxn_atomdata_reduce_nbat_f_to_f_part<c_packX16>(gridSet, *nbat, a0, a1, f);
+                        break;
+                    default: gmx_incons("Unsupported nbnxn_atomdata_t format");
+                }
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        };
+        gmx::parallelForOnThreads(nth, nth, reduceForThread);
+
+        return;
     }
-#pragma omp parallel for num_threads(nth) schedule(static)
-    for (int th = 0; th < nth; th++)
-    {
+
+    auto addForThread = [&](int th) {
         try
         {
             nbnxn_atomdata_add_nbat_f_to_f_part(gridSet,
@@ -1258,7 +1239,8 @@ void reduceForces(nbnxn_atomdata_t* nbat, const gmx::AtomLocality locality, cons
                                                 f);
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-    }
+    };
+    gmx::parallelForOnThreads(nth, nth, addForThread);
 }
 
 void nbnxn_atomdata_add_nbat_fshift_to_fshift(const nbnxn_atomdata_t& nbat, gmx::ArrayRef<gmx::RVec> fshift)
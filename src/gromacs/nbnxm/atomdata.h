@@ -79,7 +79,8 @@ enum
     nbatXYZ,
     nbatXYZQ,
     nbatX4,
-    nbatX8
+    nbatX8,
+    nbatX16
 };
 
 //! Stride for coordinate/force arrays with xyz coordinate storage
@@ -90,10 +91,14 @@ static constexpr int STRIDE_XYZQ = 4;
 static constexpr int c_packX4 = 4;
 //! Size of packs of x, y or z with SIMD 8-grouped packed coordinates/forces
 static constexpr int c_packX8 = 8;
+//! Size of packs of x, y or z with SIMD 16-grouped packed coordinates/forces
+static constexpr int c_packX16 = 16;
 //! Stridefor a pack of 4 coordinates/forces
 static constexpr int STRIDE_P4 = DIM * c_packX4;
 //! Stridefor a pack of 8 coordinates/forces
 static constexpr int STRIDE_P8 = DIM * c_packX8;
+//! Stridefor a pack of 16 coordinates/forces
+static constexpr int STRIDE_P16 = DIM * c_packX16;
 
 //! Returns the index in a coordinate array corresponding to atom a
 template<int packSize>
@@ -306,6 +311,10 @@ public:
     bool bUseBufferFlags;
     //! Flags for buffer zeroing+reduc.
     std::vector<gmx_bitmask_t> buffer_flags;
+    //! Start index in bufferFlagSources for each flag block, size buffer_flags.size() + 1
+    std::vector<int> bufferFlagSourceStart;
+    //! The output buffers with their flag set, listed per flag block
+    std::vector<int> bufferFlagSources;
     //! \}
 };
 
@@ -366,6 +375,13 @@ void nbnxn_atomdata_x_to_nbat_x_gpu(const Nbnxm::GridSet&   gridSet,
                                     DeviceBuffer<gmx::RVec> d_x,
                                     GpuEventSynchronizer*   xReadyOnDevice);
 
+/*! \brief Lists, per flag block, the output buffers with the flag set in \p nbat->buffer_flags
+ *
+ * Should be called when the buffer flags have changed, i.e. after pair search.
+ * Used to only reduce each force block over the threads that write to it.
+ */
+void nbnxn_atomdata_set_buffer_flag_sources(nbnxn_atomdata_t* nbat);
+
 /*! \brief Add the computed forces to \p f, an internal reduction might be performed as well
  *
  * \param[in]  nbat        Atom data in NBNXM format.
@@ -44,24 +44,32 @@
 
 #include "bench_setup.h"
 
+#include <algorithm>
 #include <optional>
 
 #include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/paddedvector.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
 #include "gromacs/mdlib/force_flags.h"
 #include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/freeenergyparameters.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
 #include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/mdtypes/simulation_workload.h"
 #include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/nbnxm/gridset.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/nbnxm/pairlist_tuning.h"
 #include "gromacs/nbnxm/pairlistset.h"
 #include "gromacs/nbnxm/pairlistsets.h"
 #include "gromacs/nbnxm/pairsearch.h"
@@ -69,6 +77,7 @@
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/simd/simd.h"
 #include "gromacs/timing/cyclecounter.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/enumerationhelpers.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/logger.h"
@@ -174,15 +183,31 @@ static interaction_const_t setupInteractionConst(const KernelBenchOptions& optio
 }
 
 //! Sets up and returns a Nbnxm object for the given benchmark options and system
+//
+// For a production system, \p ir and \p mtop should be passed to set up
+// dynamic pruning and the combination rule as in a simulation,
+// otherwise they should be nullptr.
 static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const KernelBenchOptions& options,
-                                                                      const gmx::BenchmarkSystem& system)
+                                                                      const gmx::BenchmarkSystem& system,
+                                                                      const t_inputrec*          ir,
+                                                                      const gmx_mtop_t*          mtop,
+                                                                      const interaction_const_t& ic)
 {
     const auto pinPolicy  = (options.useGpu ? gmx::PinningPolicy::PinnedIfSupported
                                             : gmx::PinningPolicy::CannotBePinned);
     const int  numThreads = options.numThreads;
     // Note: the options and Nbnxm combination rule enums values should match,
-    //       the Nbnxm enum has "detect" as first entry, so we need to add 1
-    const int combinationRule = 1 + static_cast<int>(options.ljCombinationRule);
+    //       the Nbnxm enum has "detect" as first entry, so we need to add 1.
+    //       For a production system we choose the rule as mdrun does: detect it
+    //       for plain LJ cut-off and use the full parameter matrix otherwise.
+    int combinationRule = 1 + static_cast<int>(options.ljCombinationRule);
+    if (mtop)
+    {
+        const bool havePlainLJCutoff = (ic.vdw_modifier == InteractionModifiers::None
+                                        || ic.vdw_modifier == InteractionModifiers::PotShift);
+        combinationRule = (havePlainLJCutoff ? enbnxninitcombruleDETECT : enbnxninitcombruleNONE);
+    }
+    const bool haveFep = (system.numPerturbedAtoms > 0);
 
     auto messageWhenInvalid = checkKernelSetup(options);
     if (messageWhenInvalid)
@@ -191,15 +216,24 @@ static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const Kern
     }
     Nbnxm::KernelSetup kernelSetup = getKernelSetup(options);
 
-    PairlistParams pairlistParams(kernelSetup.kernelType, false, options.pairlistCutoff, false);
+    const real atomDensity = system.coordinates.size() / det(system.box);
 
-    GridSet gridSet(
-            PbcType::Xyz, false, nullptr, nullptr, pairlistParams.pairlistType, false, numThreads, pinPolicy);
+    PairlistParams pairlistParams(kernelSetup.kernelType, haveFep, options.pairlistCutoff, false);
+    if (ir && mtop)
+    {
+        setupDynamicPairlistPruning(gmx::MDLogger(), *ir, *mtop, atomDensity, ic, &pairlistParams);
+    }
 
-    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0);
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0, numThreads);
 
-    auto pairSearch = std::make_unique<PairSearch>(
-            PbcType::Xyz, false, nullptr, nullptr, pairlistParams.pairlistType, false, numThreads, pinPolicy);
+    auto pairSearch = std::make_unique<PairSearch>(PbcType::Xyz,
+                                                   false,
+                                                   nullptr,
+                                                   nullptr,
+                                                   pairlistParams.pairlistType,
+                                                   haveFep,
+                                                   numThreads,
+                                                   pinPolicy);
 
     auto atomData = std::make_unique<nbnxn_atomdata_t>(pinPolicy,
                                                        gmx::MDLogger(),
@@ -207,7 +241,7 @@ static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const Kern
                                                        combinationRule,
                                                        system.numAtomTypes,
                                                        system.nonbondedParameters,
-                                                       1,
+                                                       system.numEnergyGroups,
                                                        numThreads);
 
     // Put everything together
@@ -216,7 +250,7 @@ static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const Kern
 
     t_nrnb nrnb;
 
-    GMX_RELEASE_ASSERT(!TRICLINIC(system.box), "Only rectangular unit-cells are supported here");
+    // As in mdrun without domain decomposition, the grid spans the box diagonal
     const rvec lowerCorner = { 0, 0, 0 };
     const rvec upperCorner = { system.box[XX][XX], system.box[YY][YY], system.box[ZZ][ZZ] };
 
@@ -230,8 +264,6 @@ static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const Kern
         atomInfo = system.atomInfoAllVdw;
     }
 
-    const real atomDensity = system.coordinates.size() / det(system.box);
-
     nbv->putAtomsOnGrid(system.box,
                         0,
                         lowerCorner,
@@ -294,11 +326,12 @@ static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
             atomDensity * 4.0 / 3.0 * M_PI * std::pow(options.pairlistCutoff, 3);
     const real numUsefulPairs = system.coordinates.size() * 0.5 * (numPairsWithinCutoff + 1);
 
-    std::unique_ptr<nonbonded_verlet_t> nbv = setupNbnxmForBenchInstance(options, system);
-
     // We set the interaction cut-off to the pairlist cut-off
     interaction_const_t ic = setupInteractionConst(options);
 
+    std::unique_ptr<nonbonded_verlet_t> nbv =
+            setupNbnxmForBenchInstance(options, system, nullptr, nullptr, ic);
+
     t_nrnb nrnb = { 0 };
 
     gmx_enerdata_t enerd(1, nullptr);
@@ -455,23 +488,234 @@ static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
     }
 }
 
-void bench(const int sizeFactor, const KernelBenchOptions& options)
+//! The parts of the non-bonded work that are timed separately for a production system
+enum class BenchMarkPhase : int
 {
-    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
-    gmx_omp_nthreads_set(ModuleMultiThread::Pairsearch, options.numThreads);
-    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, options.numThreads);
+    GridSorting,
+    PairlistConstruction,
+    DynamicPruning,
+    Kernel,
+    FreeEnergyKernel,
+    ForceReduction,
+    Count
+};
+
+//! Sets up and runs the benchmark instance for a production system and prints the results
+//
+// Every iteration runs the full non-bonded work of a search step:
+// putting the atoms on the grid, constructing the pairlist, dynamic
+// pruning (when used with the setup in \p ir), the kernel, the
+// free-energy kernel (when there are perturbed atoms) and the
+// reduction of the forces. Each of these is timed separately.
+// When energies are computed, the Lennard-Jones and Coulomb energies
+// of the last iteration are reported.
+// When \p doWarmup is true runs the warmup iterations instead
+// of the normal ones and does not print any results.
+static void setupAndRunFullSystemInstance(const gmx::BenchmarkSystem& system,
+                                          const t_inputrec&           ir,
+                                          const gmx_mtop_t&           mtop,
+                                          const KernelBenchOptions&   options,
+                                          const bool                  doWarmup)
+{
+    // The net charge only affects the log output, which we do not write
+    interaction_const_t ic = init_interaction_const(nullptr, ir, mtop, false);
+    init_interaction_const_tables(nullptr, &ic, options.pairlistCutoff, ir.tabext);
 
-    const gmx::BenchmarkSystem system(sizeFactor, options.outputFile);
+    std::unique_ptr<nonbonded_verlet_t> nbv =
+            setupNbnxmForBenchInstance(options, system, &ir, &mtop, ic);
 
-    real minBoxSize = norm(system.box[XX]);
-    for (int dim = YY; dim < DIM; dim++)
+    const bool useDynamicPruning = nbv->pairlistSets().params().useDynamicPruning;
+    const bool haveFep           = (system.numPerturbedAtoms > 0);
+
+    t_nrnb nrnb = { 0 };
+
+    gmx_enerdata_t enerd(system.numEnergyGroups, nullptr);
+
+    gmx::StepWorkload stepWork;
+    stepWork.computeForces = true;
+    if (options.computeVirialAndEnergy)
+    {
+        stepWork.computeVirial = true;
+        stepWork.computeEnergy = true;
+    }
+
+    const rvec lowerCorner = { 0, 0, 0 };
+    const rvec upperCorner = { system.box[XX][XX], system.box[YY][YY], system.box[ZZ][ZZ] };
+    const real atomDensity = system.coordinates.size() / det(system.box);
+
+    // The free-energy kernel needs padded coordinate and force buffers
+    gmx::PaddedVector<gmx::RVec> coordinates(system.coordinates.size());
+    std::copy(system.coordinates.begin(), system.coordinates.end(), coordinates.begin());
+    gmx::PaddedVector<gmx::RVec> forces(system.coordinates.size());
+    std::vector<gmx::RVec>       shiftForces(gmx::c_numShiftVectors);
+    gmx::ForceWithShiftForces    forceWithShiftForces(
+            forces.arrayRefWithPadding(), stepWork.computeVirial, shiftForces);
+
+    gmx::EnumerationArray<FreeEnergyPerturbationCouplingType, real> lambdas = { 0 };
+    if (haveFep)
+    {
+        lambdas = gmx::currentLambdas(0, *ir.fepvals, ir.fepvals->init_fep_state);
+    }
+
+    gmx::EnumerationArray<BenchMarkPhase, gmx_cycles_t> cycles = { 0 };
+
+    const int numIterations = (doWarmup ? options.numWarmupIterations : options.numIterations);
+    for (int iter = 0; iter < numIterations; iter++)
+    {
+        // As in mdrun, the energies are accumulated from zero every step
+        enerd.grpp.clear();
+
+        gmx_cycles_t start = gmx_cycles_read();
+        gmx_cycles_t end;
+        nbv->putAtomsOnGrid(system.box,
+                            0,
+                            lowerCorner,
+                            upperCorner,
+                            nullptr,
+                            { 0, int(system.coordinates.size()) },
+                            atomDensity,
+                            system.atomInfoAllVdw,
+                            system.coordinates,
+                            0,
+                            nullptr);
+        nbv->setAtomProperties(system.atomTypes, system.charges, system.atomInfoAllVdw);
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::GridSorting] += end - start;
+        start = end;
+
+        nbv->constructPairlist(gmx::InteractionLocality::Local, system.excls, iter, &nrnb);
+        if (haveFep)
+        {
+            nbv->setupFepThreadedForceBuffer(system.coordinates.size());
+        }
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::PairlistConstruction] += end - start;
+        start = end;
+
+        if (useDynamicPruning)
+        {
+            nbv->dispatchPruneKernelCpu(gmx::InteractionLocality::Local, system.forceRec.shift_vec);
+        }
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::DynamicPruning] += end - start;
+        start = end;
+
+        nbv->dispatchNonbondedKernel(
+                gmx::InteractionLocality::Local,
+                ic,
+                stepWork,
+                enbvClearFYes,
+                system.forceRec.shift_vec,
+                enerd.grpp.energyGroupPairTerms[NonBondedEnergyTerms::LJSR],
+                enerd.grpp.energyGroupPairTerms[NonBondedEnergyTerms::CoulombSR],
+                &nrnb);
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::Kernel] += end - start;
+        start = end;
+
+        if (haveFep)
+        {
+            nbv->dispatchFreeEnergyKernels(coordinates.constArrayRefWithPadding(),
+                                           &forceWithShiftForces,
+                                           options.nbnxmSimd != BenchMarkKernels::SimdNo,
+                                           system.numAtomTypes,
+                                           ic,
+                                           system.forceRec.shift_vec,
+                                           system.nonbondedParameters,
+                                           {},
+                                           system.charges,
+                                           system.chargesB,
+                                           system.atomTypes,
+                                           system.atomTypesB,
+                                           lambdas,
+                                           &enerd,
+                                           stepWork,
+                                           &nrnb);
+        }
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::FreeEnergyKernel] += end - start;
+        start = end;
+
+        nbv->atomdata_add_nbat_f_to_f(gmx::AtomLocality::Local, forceWithShiftForces.force());
+        end = gmx_cycles_read();
+        cycles[BenchMarkPhase::ForceReduction] += end - start;
+    }
+
+    if (doWarmup)
+    {
+        return;
+    }
+
+    const gmx::EnumerationArray<BenchMarkKernels, std::string> kernelNames = {
+        "auto", "no", "4xM", "2xMM"
+    };
+
+    // Report per iteration in micro seconds or in mega cycles
+    const double scale = (options.reportTime ? gmx_cycles_calibrate(1.0) * 1.e6 : 1e-6)
+                         / std::max(numIterations, 1);
+    fprintf(stdout, "%-7s ", kernelNames[options.nbnxmSimd].c_str());
+    if (!options.outputFile.empty())
+    {
+        fprintf(system.csv,
+                "\"%zu\",\"%g\",\"%d\",\"%d\",\"%s\",\"%s\"",
+                system.coordinates.size(),
+                options.pairlistCutoff,
+                options.numThreads,
+                options.numIterations,
+                options.computeVirialAndEnergy ? "yes" : "no",
+                kernelNames[options.nbnxmSimd].c_str());
+    }
+    for (const gmx_cycles_t phaseCycles : cycles)
+    {
+        fprintf(stdout, " %10.4f", static_cast<double>(phaseCycles) * scale);
+        if (!options.outputFile.empty())
+        {
+            fprintf(system.csv, ",\"%.4f\"", static_cast<double>(phaseCycles) * scale);
+        }
+    }
+    if (options.computeVirialAndEnergy)
+    {
+        double energyLJ      = 0;
+        double energyCoulomb = 0;
+        for (int i = 0; i < enerd.grpp.nener; i++)
+        {
+            energyLJ += enerd.grpp.energyGroupPairTerms[NonBondedEnergyTerms::LJSR][i];
+            energyCoulomb += enerd.grpp.energyGroupPairTerms[NonBondedEnergyTerms::CoulombSR][i];
+        }
+        fprintf(stdout, " %13.6e %13.6e", energyLJ, energyCoulomb);
+        if (!options.outputFile.empty())
+        {
+            fprintf(system.csv, ",\"%.8e\",\"%.8e\"", energyLJ, energyCoulomb);
+        }
+    }
+    fprintf(stdout, "\n");
+    if (!options.outputFile.empty())
     {
-        minBoxSize = std::min(minBoxSize, norm(system.box[dim]));
+        fprintf(system.csv, "\n");
     }
-    if (options.pairlistCutoff > 0.5 * minBoxSize)
+}
+
+//! Checks that the cut-off fits in the box of \p system
+static void checkCutoffFitsInBox(const gmx::BenchmarkSystem& system,
+                                 const KernelBenchOptions&   options)
+{
+    // This also handles triclinic boxes, where the largest cut-off is
+    // limited by the distances between the box vectors
+    if (gmx::square(options.pairlistCutoff) > max_cutoff2(PbcType::Xyz, system.box))
     {
         gmx_fatal(FARGS, "The cut-off should be shorter than half the box size");
     }
+}
+
+void bench(const int sizeFactor, const KernelBenchOptions& options)
+{
+    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
+    gmx_omp_nthreads_set(ModuleMultiThread::Pairsearch, options.numThreads);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, options.numThreads);
+
+    const gmx::BenchmarkSystem system(sizeFactor, options.outputFile);
+
+    checkCutoffFitsInBox(system, options);
 
     std::vector<KernelBenchOptions> optionsList;
     if (options.doAll)
@@ -571,4 +815,80 @@ void bench(const int sizeFactor, const KernelBenchOptions& options)
     }
 }
 
+void bench(const t_inputrec&              ir,
+           const gmx_mtop_t&              mtop,
+           gmx::ArrayRef<const gmx::RVec> coordinates,
+           const matrix                   box,
+           const KernelBenchOptions&      options)
+{
+    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
+    gmx_omp_nthreads_set(ModuleMultiThread::Pairsearch, options.numThreads);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, options.numThreads);
+
+    if (ir.pbcType != PbcType::Xyz)
+    {
+        gmx_fatal(FARGS, "Only full periodic boundary conditions are supported by the benchmark");
+    }
+
+    const bool haveFep = (ir.efep != FreeEnergyPerturbationType::No);
+    const gmx::BenchmarkSystem system(mtop, coordinates, box, haveFep, options.outputFile);
+
+    checkCutoffFitsInBox(system, options);
+
+    // The Coulomb type, combination rule and LJ treatment of the clusters
+    // are determined by the system, so we only expand the SIMD setups
+    std::vector<KernelBenchOptions> optionsList;
+    expandSimdOptionAndPushBack(options, &optionsList);
+
+#if GMX_SIMD
+    if (options.nbnxmSimd != BenchMarkKernels::SimdNo)
+    {
+        fprintf(stdout, "SIMD width:           %d\n", GMX_SIMD_REAL_WIDTH);
+    }
+#endif
+    fprintf(stdout, "System size:          %zu atoms\n", system.coordinates.size());
+    fprintf(stdout, "Energy groups:        %d\n", system.numEnergyGroups);
+    fprintf(stdout, "Perturbed atoms:      %d\n", system.numPerturbedAtoms);
+    fprintf(stdout,
+            "Coulomb:              %s\n",
+            options.coulombType == BenchMarkCoulomb::Pme ? "Ewald" : "RF");
+    fprintf(stdout,
+            "Van der Waals:        %s, %s\n",
+            enumValueToString(ir.vdwtype),
+            enumValueToString(ir.vdw_modifier));
+    fprintf(stdout, "Pair-list cut-off:    %g nm\n", options.pairlistCutoff);
+    fprintf(stdout, "Number of threads:    %d\n", options.numThreads);
+    fprintf(stdout, "Number of iterations: %d\n", options.numIterations);
+    fprintf(stdout, "Compute energies:     %s\n", options.computeVirialAndEnergy ? "yes" : "no");
+    printf("\n");
+
+    if (options.numWarmupIterations > 0)
+    {
+        setupAndRunFullSystemInstance(system, ir, mtop, optionsList[0], true);
+    }
+
+    fprintf(stdout,
+            "SIMD    %s per iteration\n"
+            "              grid   pairlist      prune     kernel        fep     reduce%s\n",
+            options.reportTime ? "usec" : "Mcycles",
+            options.computeVirialAndEnergy ? "       LJ (SR)  Coulomb (SR)" : "");
+    if (!options.outputFile.empty())
+    {
+        fprintf(system.csv,
+                "\"atoms\",\"pairlist cut-off\",\"threads\",\"iter\",\"compute energy\",\"SIMD\","
+                "\"grid\",\"pairlist\",\"prune\",\"kernel\",\"fep\",\"reduce\"%s\n",
+                options.computeVirialAndEnergy ? ",\"LJ (SR)\",\"Coulomb (SR)\"" : "");
+    }
+
+    for (const auto& optionsInstance : optionsList)
+    {
+        setupAndRunFullSystemInstance(system, ir, mtop, optionsInstance, false);
+    }
+
+    if (!options.outputFile.empty())
+    {
+        fclose(system.csv);
+    }
+}
+
 } // namespace Nbnxm
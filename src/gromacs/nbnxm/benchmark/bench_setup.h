@@ -47,8 +47,13 @@
 
 #include <string>
 
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/real.h"
 
+struct gmx_mtop_t;
+struct t_inputrec;
+
 namespace Nbnxm
 {
 
@@ -133,6 +138,32 @@ struct KernelBenchOptions
  */
 void bench(int sizeFactor, const KernelBenchOptions& options);
 
+/*! \brief
+ * Sets up and runs Nbnxm benchmarks for a production system
+ *
+ * The atom types, charges, exclusions, energy groups and perturbed atoms
+ * are taken from \p mtop and the interaction setup, cut-offs and dynamic
+ * pruning setup from \p ir. The caller should check that the interaction
+ * types are supported and set the Coulomb type and pairlist cut-off in
+ * \p options to match \p ir. Interactions of perturbed atoms are computed
+ * by the free-energy kernel at the initial lambda state, as in mdrun.
+ * Every iteration puts the atoms on the grid, constructs and prunes
+ * the pairlist, runs the kernels and reduces the forces, and the time
+ * spent in each of these is reported separately. When energies are
+ * computed, the total Lennard-Jones and Coulomb energies are reported.
+ *
+ * \param[in] ir           The input record of the simulation.
+ * \param[in] mtop         The global topology.
+ * \param[in] coordinates  The coordinates of all atoms.
+ * \param[in] box          The simulation box.
+ * \param[in] options      How the benchmark will be run.
+ */
+void bench(const t_inputrec&              ir,
+           const gmx_mtop_t&              mtop,
+           gmx::ArrayRef<const gmx::RVec> coordinates,
+           const matrix                   box,
+           const KernelBenchOptions&      options);
+
 } // namespace Nbnxm
 
 #endif
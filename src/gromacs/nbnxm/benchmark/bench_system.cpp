@@ -44,16 +44,21 @@
 
 #include "bench_system.h"
 
+#include <algorithm>
 #include <numeric>
 #include <vector>
 
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/dispersioncorrection.h"
+#include "gromacs/mdlib/forcerec.h"
 #include "gromacs/mdtypes/atominfo.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/mtop_atomloops.h"
+#include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/fatalerror.h"
 
 #include "bench_coords.h"
@@ -208,4 +213,81 @@ BenchmarkSystem::BenchmarkSystem(const int multiplicationFactor, const std::stri
     }
 }
 
+BenchmarkSystem::BenchmarkSystem(const gmx_mtop_t&         mtop,
+                                 ArrayRef<const gmx::RVec> inputCoordinates,
+                                 const matrix              inputBox,
+                                 const bool                haveFep,
+                                 const std::string&        outputFile)
+{
+    GMX_RELEASE_ASSERT(gmx::ssize(inputCoordinates) == mtop.natoms,
+                       "Need coordinates for all atoms in the topology");
+
+    numAtomTypes        = mtop.ffparams.atnr;
+    nonbondedParameters = makeNonBondedParameterLists(numAtomTypes, mtop.ffparams.iparams, false);
+    numEnergyGroups =
+            std::max<int>(1, mtop.groups.groups[SimulationAtomGroupType::EnergyOutput].size());
+
+    copy_mat(inputBox, box);
+    coordinates.assign(inputCoordinates.begin(), inputCoordinates.end());
+    put_atoms_in_box(PbcType::Xyz, box, coordinates);
+
+    // As in the MD setup, an atom type uses Van der Waals when it has any non-zero parameter
+    std::vector<bool> atomTypeUsesVdw(numAtomTypes, false);
+    for (int ai = 0; ai < numAtomTypes; ai++)
+    {
+        for (int aj = 0; aj < numAtomTypes; aj++)
+        {
+            atomTypeUsesVdw[ai] = atomTypeUsesVdw[ai]
+                                  || C6(nonbondedParameters, numAtomTypes, ai, aj) != 0
+                                  || C12(nonbondedParameters, numAtomTypes, ai, aj) != 0;
+        }
+    }
+
+    atomTypes.resize(mtop.natoms);
+    charges.resize(mtop.natoms);
+    atomTypesB.resize(mtop.natoms);
+    chargesB.resize(mtop.natoms);
+    atomInfoAllVdw.resize(mtop.natoms);
+    for (const AtomProxy atomP : AtomRange(mtop))
+    {
+        const t_atom& atom = atomP.atom();
+        const int     a    = atomP.globalAtomNumber();
+
+        atomTypes[a]  = atom.type;
+        charges[a]    = atom.q;
+        atomTypesB[a] = atom.typeB;
+        chargesB[a]   = atom.qB;
+
+        int64_t& atomInfo = atomInfoAllVdw[a];
+        atomInfo = getGroupType(mtop.groups, SimulationAtomGroupType::EnergyOutput, a);
+        if (atomTypeUsesVdw[atom.type] || atomTypeUsesVdw[atom.typeB])
+        {
+            atomInfo |= gmx::sc_atomInfo_HasVdw;
+        }
+        if (atom.q != 0 || atom.qB != 0)
+        {
+            atomInfo |= gmx::sc_atomInfo_HasCharge;
+        }
+        if (haveFep && PERTURBED(atom))
+        {
+            atomInfo |= gmx::sc_atomInfo_FreeEnergyPerturbation;
+            numPerturbedAtoms++;
+        }
+    }
+    atomInfoOxygenVdw = atomInfoAllVdw;
+
+    gmx_localtop_t localTopology(mtop.ffparams);
+    gmx_mtop_generate_local_top(mtop, &localTopology, false);
+    excls = std::move(localTopology.excls);
+
+    forceRec.ntype = numAtomTypes;
+    forceRec.nbfp  = nonbondedParameters;
+    forceRec.shift_vec.resize(gmx::c_numShiftVectors);
+    calc_shifts(box, forceRec.shift_vec);
+    if (!outputFile.empty())
+    {
+        csv = fopen(outputFile.c_str(), "w+");
+    }
+}
+
 } // namespace gmx
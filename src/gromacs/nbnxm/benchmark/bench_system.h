@@ -48,9 +48,12 @@
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/listoflists.h"
 #include "gromacs/utility/smalloc.h"
 
+struct gmx_mtop_t;
+
 namespace gmx
 {
 
@@ -68,17 +71,46 @@ struct BenchmarkSystem
      */
     BenchmarkSystem(int multiplicationFactor, const std::string& outputFile);
 
+    /*! \brief Constructor
+     *
+     * Sets up the benchmark system from a production topology, so that
+     * the atom types, charges, exclusions, energy groups and perturbed
+     * atoms match those of the simulation.
+     *
+     * \param[in] mtop         The global topology
+     * \param[in] coordinates  The coordinates of all atoms in \p mtop
+     * \param[in] inputBox     The simulation box
+     * \param[in] haveFep      Whether free-energy perturbation is used
+     * \param[in] outputFile   The name of the csv file to write benchmark results
+     */
+    BenchmarkSystem(const gmx_mtop_t&         mtop,
+                    ArrayRef<const gmx::RVec> coordinates,
+                    const matrix              inputBox,
+                    bool                      haveFep,
+                    const std::string&        outputFile);
+
     //! Number of different atom types in test system.
     int numAtomTypes;
+    //! Number of energy groups
+    int numEnergyGroups = 1;
+    //! Number of perturbed atoms, their interactions are computed by the free-energy kernel
+    int numPerturbedAtoms = 0;
     //! Storage for parameters for short range interactions.
     std::vector<real> nonbondedParameters;
     //! Storage for atom type parameters.
     std::vector<int> atomTypes;
     //! Storage for atom partial charges.
     std::vector<real> charges;
+    //! Storage for the B-state atom types, only set up for a production topology
+    std::vector<int> atomTypesB;
+    //! Storage for the B-state atom partial charges, only set up for a production topology
+    std::vector<real> chargesB;
     //! Atom info where all atoms are marked to have Van der Waals interactions
     std::vector<int64_t> atomInfoAllVdw;
-    //! Atom info where only oxygen atoms are marked to have Van der Waals interactions
+    /*! \brief Atom info where only oxygen atoms are marked to have Van der Waals interactions
+     *
+     * Equal to atomInfoAllVdw for a production topology.
+     */
     std::vector<int64_t> atomInfoOxygenVdw;
     //! Information about exclusions.
     ListOfLists<int> excls;
@@ -89,7 +121,7 @@ struct BenchmarkSystem
     //! Forcerec with only the entries used in the benchmark set
     t_forcerec forceRec;
     //! csv output file
-    FILE* csv;
+    FILE* csv = nullptr;
 };
 
 } // namespace gmx
@@ -87,6 +87,14 @@ static inline ClusterDistanceKernelType getClusterDistanceKernelType(const Pairl
         return ClusterDistanceKernelType::CpuSimd_2xMM;
 #else
         GMX_RELEASE_ASSERT(false, "Expect 4-wide or 8-wide SIMD with 4x4 list and nbat SIMD layout");
+#endif
+    }
+    else if (pairlistType == PairlistType::Simple4x16)
+    {
+#if GMX_SIMD && GMX_SIMD_REAL_WIDTH == 16
+        return ClusterDistanceKernelType::CpuSimd_4xM;
+#else
+        GMX_RELEASE_ASSERT(false, "Expect 16-wide SIMD with 4x16 list and nbat SIMD layout");
 #endif
     }
     else
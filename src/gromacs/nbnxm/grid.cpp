@@ -46,9 +46,11 @@
 #include "grid.h"
 
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <numeric>
 
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
@@ -77,10 +79,78 @@ Grid::Geometry::Geometry(const PairlistType pairlistType) :
 }
 
 Grid::Grid(const PairlistType pairlistType, const bool& haveFep) :
-    geometry_(pairlistType), haveFep_(haveFep)
+    geometry_(pairlistType),
+    useHilbertColumnOrder_(geometry_.isSimple && getenv("GMX_NBNXN_HILBERT_ORDER") != nullptr),
+    haveFep_(haveFep)
 {
 }
 
+/*! \brief Returns the distance along a Hilbert curve covering a 2^log2Size square of point (x,y)
+ *
+ * The curve starts at (0,0) and consecutive distances are always nearest neighbours.
+ */
+static int64_t hilbertCurveDistance(const int log2Size, int x, int y)
+{
+    const int size = 1 << log2Size;
+
+    int64_t distance = 0;
+    for (int s = size / 2; s > 0; s /= 2)
+    {
+        const int rx = (x & s) > 0 ? 1 : 0;
+        const int ry = (y & s) > 0 ? 1 : 0;
+        distance += static_cast<int64_t>(s) * s * ((3 * rx) ^ ry);
+        /* Rotate the quadrant so the sub-curve starts and ends at the right corners */
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = size - 1 - x;
+                y = size - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+
+    return distance;
+}
+
+void Grid::setHilbertColumnOrder()
+{
+    const int numCellsX = dimensions_.numCells[XX];
+    const int numCellsY = dimensions_.numCells[YY];
+
+    /* The order only depends on the grid dimensions, which often do not change */
+    if (numCellsX == hilbertOrderNumCells_[XX] && numCellsY == hilbertOrderNumCells_[YY])
+    {
+        return;
+    }
+    hilbertOrderNumCells_ = { numCellsX, numCellsY };
+
+    int log2Size = 0;
+    while ((1 << log2Size) < std::max(numCellsX, numCellsY))
+    {
+        log2Size++;
+    }
+
+    /* Rank numColumns() is used for the particles moved by DD and maps to itself */
+    rankToColumn_.resize(numColumns() + 1);
+    std::iota(rankToColumn_.begin(), rankToColumn_.end(), 0);
+    std::vector<int64_t> distance(numColumns());
+    for (int cxy = 0; cxy < numColumns(); cxy++)
+    {
+        distance[cxy] = hilbertCurveDistance(log2Size, cxy / numCellsY, cxy % numCellsY);
+    }
+    std::sort(rankToColumn_.begin(), rankToColumn_.end() - 1, [&distance](int c0, int c1) {
+        return distance[c0] < distance[c1];
+    });
+
+    columnToRank_.resize(numColumns() + 1);
+    for (int rank = 0; rank < numColumns() + 1; rank++)
+    {
+        columnToRank_[rankToColumn_[rank]] = rank;
+    }
+}
+
 /*! \brief Returns the atom density (> 0) of a rectangular grid */
 static real gridAtomDensity(int numAtoms, const rvec lowerCorner, const rvec upperCorner)
 {
@@ -218,6 +288,11 @@ void Grid::setDimensions(const int          ddZone,
     changePinningPolicy(&cxy_na_, pinningPolicy);
     changePinningPolicy(&cxy_ind_, pinningPolicy);
 
+    if (useHilbertColumnOrder_)
+    {
+        setHilbertColumnOrder();
+    }
+
     /* Worst case scenario of 1 atom in each last cell */
     const int maxNumCells = getMaxNumCells(geometry_, numAtoms, numColumns());
 
@@ -493,50 +568,24 @@ static void calc_bounding_box(int na, int stride, const real* x, BoundingBox* bb
     bb->upper.z = R2F_U(zh);
 }
 
-/*! \brief Computes the bounding box for na packed coordinates, bb order xyz0 */
-static void calc_bounding_box_x_x4(int na, const real* x, BoundingBox* bb)
-{
-    real xl = x[XX * c_packX4];
-    real xh = x[XX * c_packX4];
-    real yl = x[YY * c_packX4];
-    real yh = x[YY * c_packX4];
-    real zl = x[ZZ * c_packX4];
-    real zh = x[ZZ * c_packX4];
-    for (int j = 1; j < na; j++)
-    {
-        xl = std::min(xl, x[j + XX * c_packX4]);
-        xh = std::max(xh, x[j + XX * c_packX4]);
-        yl = std::min(yl, x[j + YY * c_packX4]);
-        yh = std::max(yh, x[j + YY * c_packX4]);
-        zl = std::min(zl, x[j + ZZ * c_packX4]);
-        zh = std::max(zh, x[j + ZZ * c_packX4]);
-    }
-    /* Note: possible double to float conversion here */
-    bb->lower.x = R2F_D(xl);
-    bb->lower.y = R2F_D(yl);
-    bb->lower.z = R2F_D(zl);
-    bb->upper.x = R2F_U(xh);
-    bb->upper.y = R2F_U(yh);
-    bb->upper.z = R2F_U(zh);
-}
-
-/*! \brief Computes the bounding box for na coordinates, bb order xyz0 */
-static void calc_bounding_box_x_x8(int na, const real* x, BoundingBox* bb)
+/*! \brief Computes the bounding box for na coordinates packed in groups of \p packSize, bb order xyz0 */
+template<int packSize>
+static void calc_bounding_box_x_packed(int na, const real* x, BoundingBox* bb)
 {
-    real xl = x[XX * c_packX8];
-    real xh = x[XX * c_packX8];
-    real yl = x[YY * c_packX8];
-    real yh = x[YY * c_packX8];
-    real zl = x[ZZ * c_packX8];
-    real zh = x[ZZ * c_packX8];
+    real xl = x[XX * packSize];
+    real xh = x[XX * packSize];
+    real yl = x[YY * packSize];
+    real yh = x[YY * packSize];
+    real zl = x[ZZ * packSize];
+    real zh = x[ZZ * packSize];
     for (int j = 1; j < na; j++)
     {
-        xl = std::min(xl, x[j + XX * c_packX8]);
-        xh = std::max(xh, x[j + XX * c_packX8]);
-        yl = std::min(yl, x[j + YY * c_packX8]);
-        yh = std::max(yh, x[j + YY * c_packX8]);
-        zl = std::min(zl, x[j + ZZ * c_packX8]);
-        zh = std::max(zh, x[j + ZZ * c_packX8]);
+        xl = std::min(xl, x[j + XX * packSize]);
+        xh = std::max(xh, x[j + XX * packSize]);
+        yl = std::min(yl, x[j + YY * packSize]);
+        yh = std::max(yh, x[j + YY * packSize]);
+        zl = std::min(zl, x[j + ZZ * packSize]);
+        zh = std::max(zh, x[j + ZZ * packSize]);
     }
     /* Note: possible double to float conversion here */
     bb->lower.x = R2F_D(xl);
@@ -553,11 +602,11 @@ gmx_unused static void calc_bounding_box_x_x4_halves(int na, const real* x, Boun
     // TODO: During SIMDv2 transition only some archs use namespace (remove when done)
     using namespace gmx;
 
-    calc_bounding_box_x_x4(std::min(na, 2), x, bbj);
+    calc_bounding_box_x_packed<c_packX4>(std::min(na, 2), x, bbj);
 
     if (na > 2)
     {
-        calc_bounding_box_x_x4(std::min(na - 2, 2), x + (c_packX4 >> 1), bbj + 1);
+        calc_bounding_box_x_packed<c_packX4>(std::min(na - 2, 2), x + (c_packX4 >> 1), bbj + 1);
     }
     else
     {
@@ -662,41 +711,45 @@ static void calc_bounding_box_xxxx_simd4(int na, const float* x, BoundingBox* bb
 #endif /* NBNXN_SEARCH_SIMD4_FLOAT_X_BB */
 
 
-/*! \brief Combines pairs of consecutive bounding boxes */
-static void combine_bounding_box_pairs(const Grid&                      grid,
-                                       gmx::ArrayRef<const BoundingBox> bb,
-                                       gmx::ArrayRef<BoundingBox>       bbj)
+/*! \brief Combines groups of \p numToCombine consecutive i-cluster bounding boxes into j-cluster bounding boxes */
+static void combine_bounding_boxes(const Grid&                      grid,
+                                   const int                        numToCombine,
+                                   gmx::ArrayRef<const BoundingBox> bb,
+                                   gmx::ArrayRef<BoundingBox>       bbj)
 {
     // TODO: During SIMDv2 transition only some archs use namespace (remove when done)
     using namespace gmx;
 
     for (int i = 0; i < grid.numColumns(); i++)
     {
-        /* Starting bb in a column is expected to be 2-aligned */
-        const int sc2 = grid.firstCellInColumn(i) >> 1;
-        /* For odd numbers skip the last bb here */
-        const int nc2 = (grid.numAtomsInColumn(i) + 3) >> (2 + 1);
-        for (int c2 = sc2; c2 < sc2 + nc2; c2++)
+        /* Starting bb in a column is expected to be numToCombine-aligned */
+        const int firstCell = grid.firstCellInColumn(i);
+        const int numCells  = (grid.numAtomsInColumn(i) + c_nbnxnCpuIClusterSize - 1)
+                             / c_nbnxnCpuIClusterSize;
+        for (int c = firstCell; c < firstCell + numCells; c += numToCombine)
         {
+            /* The last j-cluster in a column can contain fewer i-cluster bounding boxes */
+            const int numInJCluster = std::min(numToCombine, firstCell + numCells - c);
+            const int cj            = c / numToCombine;
 #if NBNXN_SEARCH_BB_SIMD4
-            Simd4Float min_S, max_S;
-
-            min_S = min(load4(bb[c2 * 2 + 0].lower.ptr()), load4(bb[c2 * 2 + 1].lower.ptr()));
-            max_S = max(load4(bb[c2 * 2 + 0].upper.ptr()), load4(bb[c2 * 2 + 1].upper.ptr()));
-            store4(bbj[c2].lower.ptr(), min_S);
-            store4(bbj[c2].upper.ptr(), max_S);
+            Simd4Float min_S = load4(bb[c].lower.ptr());
+            Simd4Float max_S = load4(bb[c].upper.ptr());
+            for (int k = 1; k < numInJCluster; k++)
+            {
+                min_S = min(min_S, load4(bb[c + k].lower.ptr()));
+                max_S = max(max_S, load4(bb[c + k].upper.ptr()));
+            }
+            store4(bbj[cj].lower.ptr(), min_S);
+            store4(bbj[cj].upper.ptr(), max_S);
 #else
-            bbj[c2].lower = BoundingBox::Corner::min(bb[c2 * 2 + 0].lower, bb[c2 * 2 + 1].lower);
-            bbj[c2].upper = BoundingBox::Corner::max(bb[c2 * 2 + 0].upper, bb[c2 * 2 + 1].upper);
+            bbj[cj] = bb[c];
+            for (int k = 1; k < numInJCluster; k++)
+            {
+                bbj[cj].lower = BoundingBox::Corner::min(bbj[cj].lower, bb[c + k].lower);
+                bbj[cj].upper = BoundingBox::Corner::max(bbj[cj].upper, bb[c + k].upper);
+            }
 #endif
         }
-        if (((grid.numAtomsInColumn(i) + 3) >> 2) & 1)
-        {
-            /* The bb count in this column is odd: duplicate the last bb */
-            int c2        = sc2 + nc2;
-            bbj[c2].lower = bb[c2 * 2].lower;
-            bbj[c2].upper = bb[c2 * 2].upper;
-        }
     }
 }
 
@@ -950,7 +1003,8 @@ void Grid::fillCell(GridSetData*                   gridSetData,
         else
 #endif
         {
-            calc_bounding_box_x_x4(numAtoms, nbat->x().data() + atom_to_x_index<c_packX4>(atomStart), bb_ptr);
+            calc_bounding_box_x_packed<c_packX4>(
+                    numAtoms, nbat->x().data() + atom_to_x_index<c_packX4>(atomStart), bb_ptr);
         }
     }
     else if (nbat->XFormat == nbatX8)
@@ -959,7 +1013,17 @@ void Grid::fillCell(GridSetData*                   gridSetData,
         size_t       offset = atomToCluster(atomStart - cellOffset_ * geometry_.numAtomsICluster);
         BoundingBox* bb_ptr = bb_.data() + offset;
 
-        calc_bounding_box_x_x8(numAtoms, nbat->x().data() + atom_to_x_index<c_packX8>(atomStart), bb_ptr);
+        calc_bounding_box_x_packed<c_packX8>(
+                numAtoms, nbat->x().data() + atom_to_x_index<c_packX8>(atomStart), bb_ptr);
+    }
+    else if (nbat->XFormat == nbatX16)
+    {
+        /* Store the bounding boxes as xyz.xyz. */
+        size_t       offset = atomToCluster(atomStart - cellOffset_ * geometry_.numAtomsICluster);
+        BoundingBox* bb_ptr = bb_.data() + offset;
+
+        calc_bounding_box_x_packed<c_packX16>(
+                numAtoms, nbat->x().data() + atom_to_x_index<c_packX16>(atomStart), bb_ptr);
     }
 #if NBNXN_BBXXXX
     else if (!geometry_.isSimple)
@@ -1045,10 +1109,11 @@ void Grid::sortColumnsCpuGeometry(GridSetData*                   gridSetData,
     const int numAtomsPerCell = geometry_.numAtomsPerCell;
 
     /* Sort the atoms within each x,y column in 3 dimensions */
-    for (int cxy : columnRange)
+    for (int rank : columnRange)
     {
+        const int cxy        = columnAtRank(rank);
         const int numAtoms   = numAtomsInColumn(cxy);
-        const int numCellsZ  = cxy_ind_[cxy + 1] - cxy_ind_[cxy];
+        const int numCellsZ  = numCellsInColumn(cxy);
         const int atomOffset = firstAtomInColumn(cxy);
 
         /* Sort the atoms within each x,y column on z coordinate */
@@ -1390,8 +1455,10 @@ void Grid::setCellIndices(int                            ddZone,
     int ncz_max = 0;
     int ncz     = 0;
     cxy_ind_[0] = 0;
-    for (int i = 0; i < numColumns() + 1; i++)
+    for (int rank = 0; rank < numColumns() + 1; rank++)
     {
+        const int i = columnAtRank(rank);
+
         /* We set ncz_max at the beginning of the loop iso at the end
          * to skip i=grid->ncx*grid->numCells[YY] which are moved particles
          * that do not need to be ordered on the grid.
@@ -1406,12 +1473,13 @@ void Grid::setCellIndices(int                            ddZone,
             cxy_na_i += gridWork[thread].numAtomsPerColumn[i];
         }
         ncz = (cxy_na_i + numAtomsPerCell - 1) / numAtomsPerCell;
-        if (nbat->XFormat == nbatX8)
+        if (geometry_.isSimple && geometry_.numAtomsJCluster > geometry_.numAtomsICluster)
         {
-            /* Make the number of cell a multiple of 2 */
-            ncz = (ncz + 1) & ~1;
+            /* Make the number of cells a multiple of the number of i-clusters per j-cluster */
+            const int numCellsPerJCluster = geometry_.numAtomsJCluster / geometry_.numAtomsICluster;
+            ncz = ((ncz + numCellsPerJCluster - 1) / numCellsPerJCluster) * numCellsPerJCluster;
         }
-        cxy_ind_[i + 1] = cxy_ind_[i] + ncz;
+        cxy_ind_[rank + 1] = cxy_ind_[rank] + ncz;
         /* Clear cxy_na_, so we can reuse the array below */
         cxy_na_[i] = 0;
     }
@@ -1439,7 +1507,7 @@ void Grid::setCellIndices(int                            ddZone,
             {
                 for (int cx = 0; cx < dimensions_.numCells[XX]; cx++)
                 {
-                    fprintf(debug, " %2d", cxy_ind_[i + 1] - cxy_ind_[i]);
+                    fprintf(debug, " %2d", numCellsInColumn(i));
                     i++;
                 }
                 fprintf(debug, "\n");
@@ -1503,9 +1571,10 @@ void Grid::setCellIndices(int                            ddZone,
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
 
-    if (geometry_.isSimple && nbat->XFormat == nbatX8)
+    if (geometry_.isSimple && geometry_.numAtomsJCluster > geometry_.numAtomsICluster)
     {
-        combine_bounding_box_pairs(*this, bb_, bbj_);
+        combine_bounding_boxes(
+                *this, geometry_.numAtomsJCluster / geometry_.numAtomsICluster, bb_, bbj_);
     }
 
     if (!geometry_.isSimple)
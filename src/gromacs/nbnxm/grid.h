@@ -52,6 +52,7 @@
 #ifndef GMX_NBNXM_GRID_H
 #define GMX_NBNXM_GRID_H
 
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -175,6 +176,12 @@ namespace Nbnxm
  * to grid cells, individual atoms can be geometrically outside the cell
  * and grid that they have been assigned to (as determined by the center
  * or geometry of the atom group they belong to).
+ *
+ * The columns are normally stored in memory in row-major order. With a CPU
+ * geometry they can instead be stored along a Hilbert curve over x/y,
+ * selected by the environment variable GMX_NBNXN_HILBERT_ORDER. Then also
+ * consecutive columns in memory are spatial neighbours, which improves
+ * cache locality of the search and the kernels.
  */
 class Grid
 {
@@ -247,19 +254,40 @@ public:
     //! Returns the end of the source atom range mapped to this grid
     int srcAtomEnd() const { return srcAtomEnd_; }
 
+    /*! \brief Returns whether the columns are stored in memory in row-major order
+     *
+     * With row-major order, column index cx*numCells[YY]+cy is also the position
+     * of the column in memory. Otherwise the columns are ordered along a
+     * space-filling curve, see columnRank().
+     */
+    bool columnsAreRowMajor() const { return columnToRank_.empty(); }
+
+    /*! \brief Returns the position in memory of the column with index \p columnIndex
+     *
+     * The index numColumns(), used for particles moved by DD, always maps to itself.
+     */
+    int columnRank(int columnIndex) const
+    {
+        return columnToRank_.empty() ? columnIndex : columnToRank_[columnIndex];
+    }
+
+    //! Returns the index of the column stored at position \p rank in memory
+    int columnAtRank(int rank) const { return rankToColumn_.empty() ? rank : rankToColumn_[rank]; }
+
     //! Returns the first cell index in the grid, starting at 0 in this grid
-    int firstCellInColumn(int columnIndex) const { return cxy_ind_[columnIndex]; }
+    int firstCellInColumn(int columnIndex) const { return cxy_ind_[columnRank(columnIndex)]; }
 
     //! Returns the number of cells in the column
     int numCellsInColumn(int columnIndex) const
     {
-        return cxy_ind_[columnIndex + 1LL] - cxy_ind_[columnIndex];
+        const int rank = columnRank(columnIndex);
+        return cxy_ind_[rank + 1LL] - cxy_ind_[rank];
     }
 
     //! Returns the index of the first atom in the column
     int firstAtomInColumn(int columnIndex) const
     {
-        return (cellOffset_ + cxy_ind_[columnIndex]) * geometry_.numAtomsPerCell;
+        return (cellOffset_ + firstCellInColumn(columnIndex)) * geometry_.numAtomsPerCell;
     }
 
     //! Returns the number of real atoms in the column
@@ -270,6 +298,8 @@ public:
      * \todo Needs a useful name. */
     gmx::ArrayRef<const int> cxy_na() const { return cxy_na_; }
     /*! \brief Returns a view of the grid-local cell index for each grid column
+     *
+     * Note that this is indexed by columnRank(), not by column index.
      *
      * \todo Needs a useful name. */
     gmx::ArrayRef<const int> cxy_ind() const { return cxy_ind_; }
@@ -283,6 +313,9 @@ public:
         return numCellsInColumn(columnIndex) * geometry_.numAtomsPerCell;
     }
 
+    //! Returns the start of the atom index range on the grid
+    int atomIndexBegin() const { return cellOffset_ * geometry_.numAtomsPerCell; }
+
     //! Returns the end of the atom index range on the grid, including padding
     int atomIndexEnd() const { return (cellOffset_ + numCellsTotal_) * geometry_.numAtomsPerCell; }
 
@@ -376,6 +409,9 @@ public:
                                   gmx::ArrayRef<int>             cxy_na);
 
 private:
+    //! Sets the column order in memory along a Hilbert curve over the x/y column indices
+    void setHilbertColumnOrder();
+
     /*! \brief Fill a pair search cell with atoms
      *
      * Potentially sorts atoms and sets the interaction flags.
@@ -388,7 +424,7 @@ private:
                   gmx::ArrayRef<const gmx::RVec> x,
                   BoundingBox gmx_unused* bb_work_aligned);
 
-    //! Spatially sort the atoms within the given column range, for CPU geometry
+    //! Spatially sort the atoms within the given range of column ranks, for CPU geometry
     void sortColumnsCpuGeometry(GridSetData*                   gridSetData,
                                 int                            dd_zone,
                                 gmx::ArrayRef<const int64_t>   atomInfo,
@@ -429,11 +465,20 @@ private:
      *
      * \todo Needs a useful name. */
     gmx::HostVector<int> cxy_na_;
-    /*! \brief The grid-local cell index for each grid column
+    /*! \brief The grid-local cell index for each grid column, indexed by column rank
      *
      * \todo Needs a useful name. */
     gmx::HostVector<int> cxy_ind_;
 
+    //! Whether to store the columns along a Hilbert curve, only used with CPU geometry
+    bool useHilbertColumnOrder_;
+    //! Memory position for each column index, empty with row-major order
+    std::vector<int> columnToRank_;
+    //! Column index for each memory position, empty with row-major order
+    std::vector<int> rankToColumn_;
+    //! The numbers of columns along x and y that the Hilbert column order was computed for
+    std::array<int, 2> hilbertOrderNumCells_ = { -1, -1 };
+
     //! The number of cluster for each cell
     std::vector<int> numClusters_;
 
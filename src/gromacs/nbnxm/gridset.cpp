@@ -117,9 +117,11 @@ void GridSet::setLocalAtomOrder()
     /* Set the atom order for the home cell (index 0) */
     const Nbnxm::Grid& grid = grids_[0];
 
+    /* Loop over the columns in memory order, so the local atom order follows the grid */
     int atomIndex = 0;
-    for (int cxy = 0; cxy < grid.numColumns(); cxy++)
+    for (int rank = 0; rank < grid.numColumns(); rank++)
     {
+        const int cxy       = grid.columnAtRank(rank);
         const int numAtoms  = grid.numAtomsInColumn(cxy);
         int       cellIndex = grid.firstCellInColumn(cxy) * grid.geometry().numAtomsPerCell;
         for (int i = 0; i < numAtoms; i++)
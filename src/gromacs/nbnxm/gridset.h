@@ -147,7 +147,7 @@ public:
     gmx::ArrayRef<const int> getLocalAtomorder() const
     {
         /* Return the atom order for the home cell (index 0) */
-        const int numIndices = grids_[0].atomIndexEnd() - grids_[0].firstAtomInColumn(0);
+        const int numIndices = grids_[0].atomIndexEnd() - grids_[0].atomIndexBegin();
 
         return gmx::constArrayRefFromArray(atomIndices().data(), numIndices);
     }
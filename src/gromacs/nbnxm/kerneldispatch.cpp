@@ -58,6 +58,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "kernel_common.h"
 #include "nbnxm_gpu.h"
@@ -267,13 +268,11 @@ static void nbnxn_kernel_cpu(const PairlistSet&             pairlistSet,
 
     const auto* shiftVecPointer = as_rvec_array(shiftVectors.data());
 
-    int gmx_unused nthreads = gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded);
+    const int nthreads = gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded);
     wallcycle_sub_start(wcycle, WallCycleSubCounter::NonbondedClear);
-#pragma omp parallel for schedule(static) num_threads(nthreads)
-    for (gmx::Index nb = 0; nb < pairlists.ssize(); nb++)
-    {
+    auto computeList = [&](gmx::Index nb) {
         // Presently, the kernels do not call C++ code that can throw,
-        // so no need for a try/catch pair in this OpenMP region.
+        // so no need for a try/catch pair in this parallel region.
         nbnxn_atomdata_output_t* out = &nbat->out[nb];
 
         if (clearF == enbvClearFYes)
@@ -381,11 +380,15 @@ static void nbnxn_kernel_cpu(const PairlistSet&             pairlistSet,
                     case 8:
                         reduceGroupEnergySimdBuffers<8>(nbatParams.nenergrp, nbatParams.neg_2log, out);
                         break;
+                    case 16:
+                        reduceGroupEnergySimdBuffers<16>(nbatParams.nenergrp, nbatParams.neg_2log, out);
+                        break;
                     default: GMX_RELEASE_ASSERT(false, "Unsupported j-unroll size");
                 }
             }
         }
-    }
+    };
+    gmx::parallelForOnThreads(nthreads, pairlists.ssize(), computeList);
     wallcycle_sub_stop(wcycle, WallCycleSubCounter::NonbondedKernel);
 
     if (stepWork.computeEnergy)
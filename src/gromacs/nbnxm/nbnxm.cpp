@@ -44,10 +44,17 @@
 
 #include "nbnxm.h"
 
+#include <cmath>
+
+#include <algorithm>
+
 #include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/utility/message_string_collector.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "nbnxm_gpu.h"
 #include "pairlistsets.h"
@@ -67,6 +74,9 @@ void nonbonded_verlet_t::putAtomsOnGrid(const matrix                   box,
                                         int                            numAtomsMoved,
                                         const int*                     move)
 {
+    // Gridding uses OpenMP
+    const gmx::ThreadPoolSpinSuspension threadPoolSpinSuspension;
+
     pairSearch_->putOnGrid(box,
                            gridIndex,
                            lowerCorner,
@@ -79,6 +89,69 @@ void nonbonded_verlet_t::putAtomsOnGrid(const matrix                   box,
                            numAtomsMoved,
                            move,
                            nbat_.get());
+
+    if (pairlistSets_->params().useIncrementalUpdates && gridIndex == 0)
+    {
+        xAtLastSearch_.assign(x.begin() + *atomRange.begin(), x.begin() + *atomRange.end());
+    }
+}
+
+real nonbonded_verlet_t::maxDisplacementSinceSearch(gmx::ArrayRef<const gmx::RVec> x) const
+{
+    GMX_RELEASE_ASSERT(x.ssize() >= gmx::ssize(xAtLastSearch_),
+                       "The number of atoms should not decrease without a search");
+
+    real maxDisplacement2 = 0;
+#ifndef _MSC_VER // Visual Studio has no support for reduction(max)
+    const int gmx_unused nthreads = gmx_omp_nthreads_get(ModuleMultiThread::Pairsearch);
+#    pragma omp parallel for reduction(max : maxDisplacement2) num_threads(nthreads) schedule(static)
+#endif
+    for (int i = 0; i < gmx::ssize(xAtLastSearch_); i++)
+    {
+        maxDisplacement2 = std::max(maxDisplacement2, gmx::norm2(x[i] - xAtLastSearch_[i]));
+    }
+
+    return std::sqrt(maxDisplacement2);
+}
+
+bool nonbonded_verlet_t::outerPairlistIsComplete(gmx::ArrayRef<const gmx::RVec> x) const
+{
+    if (!pairlistSets_->params().useIncrementalUpdates)
+    {
+        return false;
+    }
+
+    const PairlistParams& params = pairlistSets_->params();
+
+    return 2 * maxDisplacementSinceSearch(x) <= params.rlistOuter - params.rlistInner;
+}
+
+bool nonbonded_verlet_t::canReusePairlist(const int64_t                  step,
+                                          const int                      nstlist,
+                                          gmx::ArrayRef<const gmx::RVec> x) const
+{
+    if (!pairlistSets_->params().useIncrementalUpdates)
+    {
+        return false;
+    }
+
+    const int numStepsWithPairlist = pairlistSets_->numStepsWithPairlist(step);
+    if (numStepsWithPairlist <= 0)
+    {
+        return false;
+    }
+
+    /* Only keep the list when it is likely to remain complete till the next
+     * scheduled search, otherwise we would soon need an extra search.
+     * Completeness is checked every step with outerPairlistIsComplete().
+     */
+    const real extrapolationFactor =
+            static_cast<real>(numStepsWithPairlist + nstlist) / numStepsWithPairlist;
+    const real maxDisplacementAtNextSearch = maxDisplacementSinceSearch(x) * extrapolationFactor;
+
+    const PairlistParams& params = pairlistSets_->params();
+
+    return 2 * maxDisplacementAtNextSearch <= params.rlistOuter - params.rlistInner;
 }
 
 /* Calls nbnxn_put_on_grid for all non-local domains */
@@ -125,7 +198,7 @@ gmx::ArrayRef<const int> nonbonded_verlet_t::getLocalAtomOrder() const
     /* Return the atom order for the home cell (index 0) */
     const Nbnxm::Grid& grid = pairSearch_->gridSet().grid(0);
 
-    const int numIndices = grid.atomIndexEnd() - grid.firstAtomInColumn(0);
+    const int numIndices = grid.atomIndexEnd() - grid.atomIndexBegin();
 
     return gmx::constArrayRefFromArray(pairSearch_->gridSet().atomIndices().data(), numIndices);
 }
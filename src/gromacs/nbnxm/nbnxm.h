@@ -110,6 +110,7 @@
 #define GMX_NBNXM_NBNXM_H
 
 #include <memory>
+#include <vector>
 
 #include "gromacs/gpu_utils/devicebuffer_datatype.h"
 #include "gromacs/math/vectypes.h"
@@ -359,6 +360,31 @@ public:
     //! Returns the index position of the atoms on the search grid
     gmx::ArrayRef<const int> getGridIndices() const;
 
+    /*! \brief Returns whether the current pairlist can be used for the next \p nstlist steps
+     *
+     * Can only return true with incremental pairlist updates, see PairlistParams.
+     * The list is reused when the maximum displacement up to \p step,
+     * linearly extrapolated over the next \p nstlist steps, is within the bound
+     * given for outerPairlistIsComplete(). This is only an estimate, so the caller
+     * should check outerPairlistIsComplete() every step while the list is reused.
+     * The caller should skip the search and treat \p step as a normal step.
+     *
+     * \param[in] step     The current MD step, a scheduled search step
+     * \param[in] nstlist  The number of steps till the next scheduled search step
+     * \param[in] x        The coordinates of the home atoms
+     */
+    bool canReusePairlist(int64_t step, int nstlist, gmx::ArrayRef<const gmx::RVec> x) const;
+
+    /*! \brief Returns whether the outer list contains all pairs within the inner list cut-off
+     *
+     * This is the case when no atom moved more than (rlistOuter - rlistInner)/2
+     * since the list was constructed. Always returns false without incremental
+     * pairlist updates, as then the displacements are not tracked.
+     *
+     * \param[in] x  The coordinates of the home atoms
+     */
+    bool outerPairlistIsComplete(gmx::ArrayRef<const gmx::RVec> x) const;
+
     /*! \brief Constructs the pairlist for the given locality
      *
      * When there are no non-self exclusions, \p exclusions can be empty.
@@ -484,6 +510,9 @@ public:
     //! Returns a reference to the nbnxn_atomdata_t object
     nbnxn_atomdata_t& nbat() { return *nbat_; }
 
+    //! Returns a const reference to the nbnxn_atomdata_t object
+    const nbnxn_atomdata_t& nbat() const { return *nbat_; }
+
     //! Returns a pointer to the NbnxmGpu object, can return nullptr
     const NbnxmGpu* gpuNbv() const { return gpuNbv_; }
 
@@ -512,6 +541,12 @@ private:
 
     //! GPU Nbnxm data, only used with a physical GPU (TODO: use unique_ptr)
     NbnxmGpu* gpuNbv_;
+
+    //! Returns the maximum displacement of the home atoms since the last search
+    real maxDisplacementSinceSearch(gmx::ArrayRef<const gmx::RVec> x) const;
+
+    //! The home atom coordinates at the last search, only stored with incremental list updates
+    std::vector<gmx::RVec> xAtLastSearch_;
 };
 
 namespace Nbnxm
@@ -531,6 +566,17 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
                                                    matrix                         box,
                                                    gmx_wallcycle*                 wcycle);
 
+/*! \brief Creates a CPU Nbnxm object with the same setup as \p nbv
+ *
+ * The new object has its own grids, pair lists and atom data, so it
+ * can be used concurrently with \p nbv from a different thread, as is
+ * done for test-particle insertion. Free-energy perturbation and GPUs
+ * are not supported. No wall-cycle counting is done by the new object.
+ */
+std::unique_ptr<nonbonded_verlet_t> init_nb_verlet_cpu_copy(const nonbonded_verlet_t& nbv,
+                                                            const t_inputrec&         inputrec,
+                                                            const t_forcerec&         forcerec);
+
 } // namespace Nbnxm
 
 /*! \brief As nbnxn_put_on_grid, but for the non-local atoms
@@ -161,6 +161,13 @@ static KernelSetup pick_nbnxn_kernel_cpu(const t_inputrec gmx_unused& inputrec,
             /* One 256-bit FMA per cycle makes 2xNN faster */
             kernelSetup.kernelType = KernelType::Cpu4xN_Simd_2xNN;
         }
+
+#if GMX_SIMD_REAL_WIDTH == 16
+        /* The 4x16 kernels are only compiled on request. They compute many
+         * more zero interactions than 2x(8+8), so they are not the default.
+         */
+        kernelSetup.kernelType = KernelType::Cpu4xN_Simd_2xNN;
+#endif
     }
 
     if (getenv("GMX_NBNXN_SIMD_4XN") != nullptr)
@@ -304,14 +311,15 @@ static KernelSetup pick_nbnxn_kernel(const gmx::MDLogger&     mdlog,
 
 PairlistSets::PairlistSets(const PairlistParams& pairlistParams,
                            const bool            haveMultipleDomains,
-                           const int             minimumIlistCountForGpuBalancing) :
+                           const int             minimumIlistCountForGpuBalancing,
+                           const int             numLists) :
     params_(pairlistParams), minimumIlistCountForGpuBalancing_(minimumIlistCountForGpuBalancing)
 {
-    localSet_ = std::make_unique<PairlistSet>(params_);
+    localSet_ = std::make_unique<PairlistSet>(params_, numLists);
 
     if (haveMultipleDomains)
     {
-        nonlocalSet_ = std::make_unique<PairlistSet>(params_);
+        nonlocalSet_ = std::make_unique<PairlistSet>(params_, numLists);
     }
 }
 
@@ -428,6 +436,34 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
 
     setupDynamicPairlistPruning(mdlog, inputrec, mtop, effectiveAtomDensity, *forcerec.ic, &pairlistParams);
 
+    if (getenv("GMX_NBNXN_INCREMENTAL_PAIRLIST") != nullptr)
+    {
+        /* Reusing the outer list requires a CPU list that is pruned dynamically
+         * and atoms that are not redistributed or put in the box at search steps.
+         */
+        pairlistParams.useIncrementalUpdates =
+                (nonbondedResource == NonbondedResource::Cpu && !haveDDAtomOrdering(*commrec)
+                 && EI_DYNAMICS(inputrec.eI) && pairlistParams.useDynamicPruning);
+        if (pairlistParams.useIncrementalUpdates)
+        {
+            GMX_LOG(mdlog.info)
+                    .asParagraph()
+                    .appendText(
+                            "Using incremental pair list updates: the outer pair list is kept "
+                            "at search steps when no atom moved more than half the pruning "
+                            "buffer");
+        }
+        else
+        {
+            GMX_LOG(mdlog.warning)
+                    .asParagraph()
+                    .appendText(
+                            "GMX_NBNXN_INCREMENTAL_PAIRLIST is set, but incremental pair list "
+                            "updates require dynamics with CPU non-bonded interactions, dynamic "
+                            "pruning and no domain decomposition, ignoring");
+        }
+    }
+
     if (EI_DYNAMICS(inputrec.eI))
     {
         printNbnxmPressureError(mdlog, inputrec, mtop, effectiveAtomDensity, pairlistParams);
@@ -483,8 +519,10 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
         minimumIlistCountForGpuBalancing = getMinimumIlistCountForGpuBalancing(gpu_nbv);
     }
 
-    auto pairlistSets = std::make_unique<PairlistSets>(
-            pairlistParams, haveMultipleDomains, minimumIlistCountForGpuBalancing);
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams,
+                                                       haveMultipleDomains,
+                                                       minimumIlistCountForGpuBalancing,
+                                                       gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded));
 
     auto pairSearch = std::make_unique<PairSearch>(
             inputrec.pbcType,
@@ -512,6 +550,42 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
                                                 wcycle);
 }
 
+std::unique_ptr<nonbonded_verlet_t> init_nb_verlet_cpu_copy(const nonbonded_verlet_t& nbv,
+                                                            const t_inputrec&         inputrec,
+                                                            const t_forcerec&         forcerec)
+{
+    GMX_RELEASE_ASSERT(!nbv.useGpu() && !nbv.emulateGpu(), "Only CPU setups can be copied");
+
+    const Nbnxm::KernelSetup& kernelSetup    = nbv.kernelSetup();
+    const PairlistParams&     pairlistParams = nbv.pairlistSets().params();
+
+    GMX_RELEASE_ASSERT(!pairlistParams.haveFep_, "Copying setups with perturbed atoms is not supported");
+
+    auto nbat = std::make_unique<nbnxn_atomdata_t>(gmx::PinningPolicy::CannotBePinned,
+                                                   gmx::MDLogger(),
+                                                   kernelSetup.kernelType,
+                                                   getENbnxnInitCombRule(forcerec),
+                                                   forcerec.ntype,
+                                                   forcerec.nbfp,
+                                                   nbv.nbat().params().nenergrp,
+                                                   1);
+
+    /* The copy is intended for use by a single thread, so we use a single list */
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0, 1);
+
+    auto pairSearch = std::make_unique<PairSearch>(inputrec.pbcType,
+                                                   EI_TPI(inputrec.eI),
+                                                   nullptr,
+                                                   nullptr,
+                                                   pairlistParams.pairlistType,
+                                                   false,
+                                                   gmx_omp_nthreads_get(ModuleMultiThread::Pairsearch),
+                                                   gmx::PinningPolicy::CannotBePinned);
+
+    return std::make_unique<nonbonded_verlet_t>(
+            std::move(pairlistSets), std::move(pairSearch), std::move(nbat), kernelSetup, nullptr, nullptr, nullptr);
+}
+
 } // namespace Nbnxm
 
 nonbonded_verlet_t::nonbonded_verlet_t(std::unique_ptr<PairlistSets>     pairlistSets,
@@ -61,9 +61,10 @@ enum class KernelLayout
 //! List of supported ratios for j-cluster size versus i-cluster sizes
 enum class KernelLayoutClusterRatio
 {
-    JSizeEqualsISize,   //!< j-cluster size = i-cluster size
-    JSizeIsDoubleISize, //!< j-cluster size = 2 * i-cluster size
-    JSizeIsHalfISize    //!< j-cluster size = i-cluster size / 2
+    JSizeEqualsISize,      //!< j-cluster size = i-cluster size
+    JSizeIsDoubleISize,    //!< j-cluster size = 2 * i-cluster size
+    JSizeIsQuadrupleISize, //!< j-cluster size = 4 * i-cluster size
+    JSizeIsHalfISize       //!< j-cluster size = i-cluster size / 2
 };
 
 #if GMX_SIMD
@@ -72,7 +73,7 @@ enum class KernelLayoutClusterRatio
  *
  * \tparam kernelLayout The kernel layout, supports r4xM and r2xMM, asserted at compile time
  *
- * Note that currently only cluster ratios 0.5, 1 and 2 are supported. This is checked
+ * Note that currently only cluster ratios 0.5, 1, 2 and 4 are supported. This is checked
  * at compile time.
  */
 template<KernelLayout kernelLayout>
@@ -91,6 +92,10 @@ static constexpr KernelLayoutClusterRatio kernelLayoutClusterRatio()
     {
         return KernelLayoutClusterRatio::JSizeIsDoubleISize;
     }
+    else if constexpr (jClusterSize == 4 * iClusterSize)
+    {
+        return KernelLayoutClusterRatio::JSizeIsQuadrupleISize;
+    }
     else if constexpr (2 * jClusterSize == iClusterSize)
     {
         return KernelLayoutClusterRatio::JSizeIsHalfISize;
@@ -104,12 +109,15 @@ static constexpr KernelLayoutClusterRatio kernelLayoutClusterRatio()
  * Currently the 2xNN SIMD kernels only make sense with:
  *  8-way SIMD: 4x4 setup, performance wise only useful on CPUs without FMA or on AMD Zen1
  * 16-way SIMD: 4x8 setup, used in single precision with 512 bit wide SIMD
+ * The 4xM kernels with 16-way SIMD, i.e. 4x16, are only compiled on request with
+ * GMX_NBNXM_SIMD_4X16, as they need 64-bit cluster-pair interaction masks.
  */
 #if GMX_SIMD && GMX_USE_SIMD_KERNELS
 #    define GMX_HAVE_NBNXM_SIMD_2XMM \
         ((GMX_SIMD_REAL_WIDTH == 8 || GMX_SIMD_REAL_WIDTH == 16) && GMX_SIMD_HAVE_HSIMD_UTIL_REAL)
-#    define GMX_HAVE_NBNXM_SIMD_4XM \
-        (GMX_SIMD_REAL_WIDTH == 2 || GMX_SIMD_REAL_WIDTH == 4 || GMX_SIMD_REAL_WIDTH == 8)
+#    define GMX_HAVE_NBNXM_SIMD_4XM                                                         \
+        (GMX_SIMD_REAL_WIDTH == 2 || GMX_SIMD_REAL_WIDTH == 4 || GMX_SIMD_REAL_WIDTH == 8 \
+         || (GMX_SIMD_REAL_WIDTH == 16 && GMX_NBNXM_SIMD_4X16))
 #else
 #    define GMX_HAVE_NBNXM_SIMD_2XMM 0
 #    define GMX_HAVE_NBNXM_SIMD_4XM 0
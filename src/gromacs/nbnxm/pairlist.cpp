@@ -65,6 +65,7 @@
 #include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/listoflists.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/threadpool.h"
 
 #include "boundingboxes.h"
 #include "clusterdistancekerneltype.h"
@@ -136,8 +137,9 @@ template<int jClusterSize, int jSubClusterIndex>
 static inline int cjFromCi(int ci)
 {
     static_assert(jClusterSize == c_nbnxnCpuIClusterSize / 2 || jClusterSize == c_nbnxnCpuIClusterSize
-                          || jClusterSize == c_nbnxnCpuIClusterSize * 2,
-                  "Only j-cluster sizes 2, 4 and 8 are currently implemented");
+                          || jClusterSize == c_nbnxnCpuIClusterSize * 2
+                          || jClusterSize == c_nbnxnCpuIClusterSize * 4,
+                  "Only j-cluster sizes 2, 4, 8 and 16 are currently implemented");
 
     static_assert(jSubClusterIndex == 0 || jSubClusterIndex == 1,
                   "Only sub-cluster indices 0 and 1 are supported");
@@ -157,10 +159,14 @@ static inline int cjFromCi(int ci)
     {
         return ci;
     }
-    else
+    else if (jClusterSize == c_nbnxnCpuIClusterSize * 2)
     {
         return ci >> 1;
     }
+    else
+    {
+        return ci >> 2;
+    }
 }
 
 /*! \brief Returns the j-cluster index given the i-cluster index.
@@ -185,19 +191,25 @@ static inline int xIndexFromCi(int ci)
     constexpr int clusterSize = jClusterSize<layout>();
 
     static_assert(clusterSize == c_nbnxnCpuIClusterSize / 2 || clusterSize == c_nbnxnCpuIClusterSize
-                          || clusterSize == c_nbnxnCpuIClusterSize * 2,
-                  "Only j-cluster sizes 2, 4 and 8 are currently implemented");
+                          || clusterSize == c_nbnxnCpuIClusterSize * 2
+                          || clusterSize == c_nbnxnCpuIClusterSize * 4,
+                  "Only j-cluster sizes 2, 4, 8 and 16 are currently implemented");
 
     if (clusterSize <= c_nbnxnCpuIClusterSize)
     {
         /* Coordinates are stored packed in groups of 4 */
         return ci * STRIDE_P4;
     }
-    else
+    else if (clusterSize == c_nbnxnCpuIClusterSize * 2)
     {
         /* Coordinates packed in 8, i-cluster size is half the packing width */
         return (ci >> 1) * STRIDE_P8 + (ci & 1) * (c_packX8 >> 1);
     }
+    else
+    {
+        /* Coordinates packed in 16, i-cluster size is a quarter of the packing width */
+        return (ci >> 2) * STRIDE_P16 + (ci & 3) * (c_packX16 >> 2);
+    }
 }
 
 /* Returns the nbnxn coordinate data index given the j-cluster index */
@@ -207,8 +219,9 @@ static inline int xIndexFromCj(int cj)
     constexpr int clusterSize = jClusterSize<layout>();
 
     static_assert(clusterSize == c_nbnxnCpuIClusterSize / 2 || clusterSize == c_nbnxnCpuIClusterSize
-                          || clusterSize == c_nbnxnCpuIClusterSize * 2,
-                  "Only j-cluster sizes 2, 4 and 8 are currently implemented");
+                          || clusterSize == c_nbnxnCpuIClusterSize * 2
+                          || clusterSize == c_nbnxnCpuIClusterSize * 4,
+                  "Only j-cluster sizes 2, 4, 8 and 16 are currently implemented");
 
     if (clusterSize == c_nbnxnCpuIClusterSize / 2)
     {
@@ -220,11 +233,16 @@ static inline int xIndexFromCj(int cj)
         /* Coordinates are stored packed in groups of 4 */
         return cj * STRIDE_P4;
     }
-    else
+    else if (clusterSize == c_nbnxnCpuIClusterSize * 2)
     {
         /* Coordinates are stored packed in groups of 8 */
         return cj * STRIDE_P8;
     }
+    else
+    {
+        /* Coordinates are stored packed in groups of 16 */
+        return cj * STRIDE_P16;
+    }
 }
 #endif // GMX_SIMD_HAVE_REAL
 
@@ -683,13 +701,12 @@ NbnxnPairlistGpu::NbnxnPairlistGpu(gmx::PinningPolicy pinningPolicy) :
 }
 
 // TODO: Move to pairlistset.cpp
-PairlistSet::PairlistSet(const PairlistParams& pairlistParams) :
+PairlistSet::PairlistSet(const PairlistParams& pairlistParams, const int numLists) :
     params_(pairlistParams),
     combineLists_(sc_isGpuPairListType[pairlistParams.pairlistType]), // Currently GPU lists are always combined
     isCpuType_(!sc_isGpuPairListType[pairlistParams.pairlistType])
 {
-
-    const int numLists = gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded);
+    GMX_RELEASE_ASSERT(numLists >= 1, "Need at least one list");
 
     if (!combineLists_ && numLists > NBNXN_BUFFERFLAG_MAX_THREADS)
     {
@@ -938,13 +955,13 @@ static void setSelfAndNewtonExclusionsGpu(NbnxnPairlistGpu* nbl,
 }
 
 /* Returns a diagonal or off-diagonal interaction mask for plain C lists */
-static unsigned int get_imask(gmx_bool rdiag, int ci, int cj)
+static ClusterPairInteractionMask get_imask(gmx_bool rdiag, int ci, int cj)
 {
     return (rdiag && ci == cj ? NBNXN_INTERACTION_MASK_DIAG : NBNXN_INTERACTION_MASK_ALL);
 }
 
 /* Returns a diagonal or off-diagonal interaction mask for cj-size=2 */
-gmx_unused static unsigned int get_imask_simd_j2(gmx_bool rdiag, int ci, int cj)
+gmx_unused static ClusterPairInteractionMask get_imask_simd_j2(gmx_bool rdiag, int ci, int cj)
 {
     return (rdiag && ci * 2 == cj ? NBNXN_INTERACTION_MASK_DIAG_J2_0
                                   : (rdiag && ci * 2 + 1 == cj ? NBNXN_INTERACTION_MASK_DIAG_J2_1
@@ -952,19 +969,38 @@ gmx_unused static unsigned int get_imask_simd_j2(gmx_bool rdiag, int ci, int cj)
 }
 
 /* Returns a diagonal or off-diagonal interaction mask for cj-size=4 */
-gmx_unused static unsigned int get_imask_simd_j4(gmx_bool rdiag, int ci, int cj)
+gmx_unused static ClusterPairInteractionMask get_imask_simd_j4(gmx_bool rdiag, int ci, int cj)
 {
     return (rdiag && ci == cj ? NBNXN_INTERACTION_MASK_DIAG : NBNXN_INTERACTION_MASK_ALL);
 }
 
 /* Returns a diagonal or off-diagonal interaction mask for cj-size=8 */
-gmx_unused static unsigned int get_imask_simd_j8(gmx_bool rdiag, int ci, int cj)
+gmx_unused static ClusterPairInteractionMask get_imask_simd_j8(gmx_bool rdiag, int ci, int cj)
 {
     return (rdiag && ci == cj * 2 ? NBNXN_INTERACTION_MASK_DIAG_J8_0
                                   : (rdiag && ci == cj * 2 + 1 ? NBNXN_INTERACTION_MASK_DIAG_J8_1
                                                                : NBNXN_INTERACTION_MASK_ALL));
 }
 
+#if GMX_NBNXM_SIMD_4X16
+/* Returns a diagonal or off-diagonal interaction mask for cj-size=16 */
+gmx_unused static ClusterPairInteractionMask get_imask_simd_j16(gmx_bool rdiag, int ci, int cj)
+{
+    if (rdiag && ci >= cj * 4 && ci < cj * 4 + 4)
+    {
+        switch (ci - cj * 4)
+        {
+            case 0: return NBNXN_INTERACTION_MASK_DIAG_J16_0;
+            case 1: return NBNXN_INTERACTION_MASK_DIAG_J16_1;
+            case 2: return NBNXN_INTERACTION_MASK_DIAG_J16_2;
+            default: return NBNXN_INTERACTION_MASK_DIAG_J16_3;
+        }
+    }
+
+    return NBNXN_INTERACTION_MASK_ALL;
+}
+#endif
+
 #if GMX_SIMD
 #    if GMX_SIMD_REAL_WIDTH == 2
 #        define get_imask_simd_4xn get_imask_simd_j2
@@ -977,6 +1013,9 @@ gmx_unused static unsigned int get_imask_simd_j8(gmx_bool rdiag, int ci, int cj)
 #        define get_imask_simd_2xnn get_imask_simd_j4
 #    endif
 #    if GMX_SIMD_REAL_WIDTH == 16
+#        if GMX_NBNXM_SIMD_4X16
+#            define get_imask_simd_4xn get_imask_simd_j16
+#        endif
 #        define get_imask_simd_2xnn get_imask_simd_j8
 #    endif
 #endif
@@ -1427,7 +1466,8 @@ static void setExclusionsForIEntry(const Nbnxm::GridSet&   gridSet,
                          */
                         const int innerJ = jIndex - (jCluster << na_cj_2log);
 
-                        nbl->cj.excl(index) &= ~(1U << ((i << na_cj_2log) + innerJ));
+                        nbl->cj.excl(index) &=
+                                ~(ClusterPairInteractionMask(1) << ((i << na_cj_2log) + innerJ));
                     }
                 }
             }
@@ -1469,6 +1509,15 @@ static gmx::RVec getCoordinate(const nbnxn_atomdata_t& nbat, const int a)
             x[ZZ] = nbat.x()[i + ZZ * c_packX8];
             break;
         }
+        case nbatX16:
+        {
+            const int i = atom_to_x_index<c_packX16>(a);
+
+            x[XX] = nbat.x()[i + XX * c_packX16];
+            x[YY] = nbat.x()[i + YY * c_packX16];
+            x[ZZ] = nbat.x()[i + ZZ * c_packX16];
+            break;
+        }
         default: GMX_ASSERT(false, "Unsupported nbnxn_atomdata_t format");
     }
 
@@ -1667,15 +1716,18 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                 }
                 else
                 {
-                    const int cjr = cja - (jGrid.cellOffset() >> 1);
-                    /* Combine two ci fep masks/energrp */
-                    fep_cj = jGrid.fepBits(cjr * 2)
-                             + (jGrid.fepBits(cjr * 2 + 1) << jGrid.geometry().numAtomsICluster);
-                    if (ngid > 1)
+                    /* Combine two or four ci fep masks/energrp */
+                    const int ratio = numAtomsJCluster / jGrid.geometry().numAtomsICluster;
+                    const int cjr   = cja - jGrid.cellOffset() / ratio;
+                    for (int k = 0; k < ratio; k++)
                     {
-                        gid_cj = nbatParams.energrp[cja * 2]
-                                 + (nbatParams.energrp[cja * 2 + 1]
-                                    << (jGrid.geometry().numAtomsICluster * egp_shift));
+                        fep_cj += jGrid.fepBits(cjr * ratio + k)
+                                  << (k * jGrid.geometry().numAtomsICluster);
+                        if (ngid > 1)
+                        {
+                            gid_cj += nbatParams.energrp[cja * ratio + k]
+                                      << (k * jGrid.geometry().numAtomsICluster * egp_shift);
+                        }
                     }
                 }
 
@@ -1715,8 +1767,8 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
 
                                 /* Add it to the FEP list */
                                 nlist->jjnr[nlist->nrj] = aj;
-                                const int pairIsIncluded =
-                                        ((nbl->cj.excl(cj_ind) >> (i * nbl->na_cj + j)) & 1);
+                                const int pairIsIncluded = static_cast<int>(
+                                        (nbl->cj.excl(cj_ind) >> (i * nbl->na_cj + j)) & 1);
                                 nlist->excl_fep[nlist->nrj] = pairIsIncluded;
                                 nlist->nrj++;
                                 /* Count excluded pairs within rlist */
@@ -1730,7 +1782,8 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                                  * but we need to avoid 0/0, as perturbed atoms
                                  * can be on top of each other.
                                  */
-                                nbl->cj.excl(cj_ind) &= ~(1U << (i * nbl->na_cj + j));
+                                nbl->cj.excl(cj_ind) &=
+                                        ~(ClusterPairInteractionMask(1) << (i * nbl->na_cj + j));
                             }
                         }
                     }
@@ -2651,7 +2704,10 @@ static void print_nblist_ci_cj(FILE* fp, const NbnxnPairlistCpu& nbl)
 
         for (int j = ciEntry.cj_ind_start; j < ciEntry.cj_ind_end; j++)
         {
-            fprintf(fp, "  cj %5d  imask %x\n", nbl.cj.cj(j), nbl.cj.excl(j));
+            fprintf(fp,
+                    "  cj %5d  imask %llx\n",
+                    nbl.cj.cj(j),
+                    static_cast<unsigned long long>(nbl.cj.excl(j)));
         }
     }
 }
@@ -2761,8 +2817,22 @@ static void combine_nblists(gmx::ArrayRef<const NbnxnPairlistGpu> nbls, NbnxnPai
     }
 }
 
-static void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
-                              gmx::ArrayRef<PairsearchWork>            work)
+//! The SIMD width the free-energy kernel processes the pairs of an i-entry with
+#if GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_INT32_ARITHMETICS
+static constexpr int c_fepKernelPairWidth = GMX_SIMD_REAL_WIDTH;
+#else
+static constexpr int c_fepKernelPairWidth = 1;
+#endif
+
+int fepIEntryCost(const int nrj)
+{
+    const int numIterations = (nrj + c_fepKernelPairWidth - 1) / c_fepKernelPairWidth;
+
+    return (numIterations + 1) * c_fepKernelPairWidth;
+}
+
+void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
+                       gmx::ArrayRef<PairsearchWork>            work)
 {
     const int numLists = fepLists.ssize();
 
@@ -2772,17 +2842,20 @@ static void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
         return;
     }
 
-    /* Count the total i-lists and pairs */
-    int nri_tot = 0;
-    int nrj_tot = 0;
+    /* Count the total i-lists, pairs and cost */
+    int     nri_tot  = 0;
+    int     nrj_tot  = 0;
+    int64_t cost_tot = 0;
     for (const auto& list : fepLists)
     {
         nri_tot += list->nri;
         nrj_tot += list->nrj;
+        for (int i = 0; i < list->nri; i++)
+        {
+            cost_tot += fepIEntryCost(list->jindex[i + 1] - list->jindex[i]);
+        }
     }
 
-    const int nrj_target = (nrj_tot + numLists - 1) / numLists;
-
     GMX_ASSERT(gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded) == numLists,
                "We should have as many work objects as FEP lists");
 
@@ -2813,23 +2886,30 @@ static void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
 
-    /* Loop over the source lists and assign and copy i-entries */
-    int       th_dest = 0;
-    t_nblist* nbld    = work[th_dest].nbl_fep.get();
+    /* Loop over the source lists and assign and copy i-entries.
+     * The source lists are traversed in order, so each destination list
+     * gets a contiguous, and thus spatially local, range of i-entries.
+     * We cut at the cumulative cost boundaries th*cost_tot/numLists,
+     * so rounding errors do not accumulate in the last list.
+     */
+    int       th_dest      = 0;
+    t_nblist* nbld         = work[th_dest].nbl_fep.get();
+    int64_t   costAssigned = 0;
     for (int th = 0; th < numLists; th++)
     {
         const t_nblist* nbls = fepLists[th].get();
 
         for (int i = 0; i < nbls->nri; i++)
         {
-            /* The number of pairs in this i-entry */
-            const int nrj = nbls->jindex[i + 1] - nbls->jindex[i];
+            /* The cost of this i-entry */
+            const int cost = fepIEntryCost(nbls->jindex[i + 1] - nbls->jindex[i]);
 
             /* Decide if list th_dest is too large and we should procede
              * to the next destination list.
              */
-            if (th_dest + 1 < numLists && nbld->nrj > 0
-                && nbld->nrj + nrj - nrj_target > nrj_target - nbld->nrj)
+            const int64_t costEnd = ((th_dest + 1) * cost_tot) / numLists;
+            if (th_dest + 1 < numLists && nbld->nri > 0
+                && costAssigned + cost - costEnd > costEnd - costAssigned)
             {
                 th_dest++;
                 nbld = work[th_dest].nbl_fep.get();
@@ -2847,6 +2927,7 @@ static void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
             }
             nbld->nri++;
             nbld->jindex[nbld->nri] = nbld->nrj;
+            costAssigned += cost;
         }
     }
 
@@ -2880,19 +2961,52 @@ static gmx_bool next_ci(const Grid& grid, int nth, int ci_block, int* ci_x, int*
         return FALSE;
     }
 
-    while (*ci >= grid.firstCellInColumn(*ci_x * grid.dimensions().numCells[YY] + *ci_y + 1))
+    const int numCellsY = grid.dimensions().numCells[YY];
+    if (grid.columnsAreRowMajor())
     {
-        *ci_y += 1;
-        if (*ci_y == grid.dimensions().numCells[YY])
+        while (*ci >= grid.firstCellInColumn(*ci_x * numCellsY + *ci_y + 1))
         {
-            *ci_x += 1;
-            *ci_y = 0;
+            *ci_y += 1;
+            if (*ci_y == numCellsY)
+            {
+                *ci_x += 1;
+                *ci_y = 0;
+            }
+        }
+    }
+    else
+    {
+        /* Walk the columns in memory order */
+        int rank = grid.columnRank(*ci_x * numCellsY + *ci_y);
+        while (*ci >= grid.firstCellInColumn(grid.columnAtRank(rank + 1)))
+        {
+            rank++;
         }
+        const int column = grid.columnAtRank(rank);
+        *ci_x            = column / numCellsY;
+        *ci_y            = column % numCellsY;
     }
 
     return TRUE;
 }
 
+/* Sorts the j-clusters of the last i-entry on index, as required for looking up
+ * exclusions, when the grid columns are not stored in row-major order
+ */
+static void sortJClustersInLastIEntry(NbnxnPairlistCpu* nbl)
+{
+    const nbnxn_ci_t& currentCi = nbl->ci.back();
+    std::sort(nbl->cj.list_.begin() + currentCi.cj_ind_start,
+              nbl->cj.list_.begin() + currentCi.cj_ind_end,
+              [](const nbnxn_cj_t& cj0, const nbnxn_cj_t& cj1) { return cj0.cj < cj1.cj; });
+}
+
+/* Hilbert column order is only used with CPU lists, so we should never get here */
+static void sortJClustersInLastIEntry(NbnxnPairlistGpu gmx_unused* nbl)
+{
+    GMX_ASSERT(false, "GPU grids always use row-major column order");
+}
+
 /* Returns the distance^2 for which we put cell pairs in the list
  * without checking atom pair distances. This is usually < rlist^2.
  */
@@ -3285,8 +3399,11 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
      */
     int ci_b = -1;
     int ci   = th * ci_block - 1;
-    int ci_x = 0;
-    int ci_y = 0;
+    int ci_x = iGrid.columnAtRank(0) / iGridDims.numCells[YY];
+    int ci_y = iGrid.columnAtRank(0) % iGridDims.numCells[YY];
+
+    /* With row-major column order we can skip half of the columns geometrically */
+    const bool columnsAreRowMajor = jGrid.columnsAreRowMajor();
     while (next_ci(iGrid, nth, ci_block, &ci_x, &ci_y, &ci_b, &ci))
     {
         if (bSimple && flags_i[ci] == 0)
@@ -3312,7 +3429,8 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
             }
         }
 
-        int ci_xy = ci_x * iGridDims.numCells[YY] + ci_y;
+        int       ci_xy   = ci_x * iGridDims.numCells[YY] + ci_y;
+        const int ci_rank = iGrid.columnRank(ci_xy);
 
         /* Loop over shift vectors in three dimensions */
         for (int tz = -shp[ZZ]; tz <= shp[ZZ]; tz++)
@@ -3406,7 +3524,8 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
 
                     addNewIEntry(nbl, cell0_i + ci, shift, flags_i[ci]);
 
-                    if ((!c_pbcShiftBackward || excludeSubDiagonal) && cxf < ci_x)
+                    if ((!c_pbcShiftBackward || excludeSubDiagonal) && columnsAreRowMajor
+                        && cxf < ci_x)
                     {
                         /* Leave the pairs with i > j.
                          * x is the major index, so skip half of it.
@@ -3443,17 +3562,26 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
                         /* When true, leave the pairs with i > j.
                          * Skip half of y when i and j have the same x.
                          */
-                        const bool skipHalfY = (isIntraGridList && cx == 0
+                        const bool skipHalfY = (isIntraGridList && cx == 0 && columnsAreRowMajor
                                                 && (!c_pbcShiftBackward || shift == gmx::c_centralShiftIndex)
                                                 && cyf < ci_y);
                         const int  cyf_x     = skipHalfY ? ci_y : cyf;
 
                         for (int cy = cyf_x; cy <= cyl; cy++)
                         {
-                            const int columnStart =
-                                    jGrid.firstCellInColumn(cx * jGridDims.numCells[YY] + cy);
-                            const int columnEnd =
-                                    jGrid.firstCellInColumn(cx * jGridDims.numCells[YY] + cy + 1);
+                            const int cj_xy = cx * jGridDims.numCells[YY] + cy;
+
+                            /* Without row-major order, columns stored before
+                             * the i-column only have cells with cj < ci.
+                             */
+                            if (!columnsAreRowMajor && excludeSubDiagonal
+                                && jGrid.columnRank(cj_xy) < ci_rank)
+                            {
+                                continue;
+                            }
+
+                            const int columnStart = jGrid.firstCellInColumn(cj_xy);
+                            const int columnEnd   = columnStart + jGrid.numCellsInColumn(cj_xy);
 
                             const real cy_real = cy;
                             real       d2zxy   = d2zx;
@@ -3591,6 +3719,11 @@ static void nbnxn_make_pairlist_part(const Nbnxm::GridSet&   gridSet,
                         }
                     }
 
+                    if (!columnsAreRowMajor)
+                    {
+                        sortJClustersInLastIEntry(nbl);
+                    }
+
                     if (!exclusions.empty())
                     {
                         /* Set the exclusions for this ci list */
@@ -4224,6 +4357,7 @@ void PairlistSet::constructPairlists(gmx::InteractionLocality      locality,
     if (nbat->bUseBufferFlags)
     {
         reduce_buffer_flags(searchWork, numLists, nbat->buffer_flags);
+        nbnxn_atomdata_set_buffer_flag_sources(nbat);
     }
 
     if (gridSet.haveFep())
@@ -4355,6 +4489,9 @@ void nonbonded_verlet_t::constructPairlist(const InteractionLocality iLocality,
                                            int64_t                   step,
                                            t_nrnb*                   nrnb) const
 {
+    // The pair search uses OpenMP
+    const gmx::ThreadPoolSpinSuspension threadPoolSpinSuspension;
+
     pairlistSets_->construct(iLocality, pairSearch_.get(), nbat_.get(), exclusions, step, nrnb);
 
     if (useGpu())
@@ -35,7 +35,10 @@
 #ifndef GMX_NBNXM_PAIRLIST_H
 #define GMX_NBNXM_PAIRLIST_H
 
+#include "config.h"
+
 #include <cstddef>
+#include <cstdint>
 
 #include <memory>
 #include <vector>
@@ -43,6 +46,7 @@
 #include "gromacs/gpu_utils/hostallocator.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/locality.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/defaultinitializationallocator.h"
 #include "gromacs/utility/enumerationhelpers.h"
@@ -52,6 +56,7 @@
 
 struct NbnxnPairlistCpuWork;
 struct NbnxnPairlistGpuWork;
+struct PairsearchWork;
 struct t_nblist;
 
 
@@ -76,6 +81,16 @@ typedef struct
     int dummy[16];
 } gmx_cache_protect_t;
 
+/*! \brief The type for storing the atom-pair interaction bits of a CPU cluster pair
+ *
+ * 4x16 cluster pairs need 64 bits, all other CPU cluster pair sizes fit in 32 bits.
+ */
+#if GMX_NBNXM_SIMD_4X16
+using ClusterPairInteractionMask = std::uint64_t;
+#else
+using ClusterPairInteractionMask = unsigned int;
+#endif
+
 /*! \brief This is the actual cluster-pair list j-entry.
  *
  * cj is the j-cluster.
@@ -89,7 +104,7 @@ struct nbnxn_cj_t
     //! The j-cluster
     int cj;
     //! The exclusion (interaction) bits
-    unsigned int excl;
+    ClusterPairInteractionMask excl;
 };
 
 //! Simple j-cluster list
@@ -101,9 +116,9 @@ public:
     //! Return the j-cluster index for \c index from the pack list
     int cj(int index) const { return list_[index].cj; }
     //! Return the exclusion mask for \c index
-    const unsigned int& excl(int index) const { return list_[index].excl; }
+    const ClusterPairInteractionMask& excl(int index) const { return list_[index].excl; }
     //! Return the exclusion mask for \c index
-    unsigned int& excl(int index) { return list_[index].excl; }
+    ClusterPairInteractionMask& excl(int index) { return list_[index].excl; }
     //! Return the size of the list (not the number of packed elements)
     gmx::Index size() const noexcept { return list_.size(); }
     //! Return whether the list is empty
@@ -138,7 +153,7 @@ public:
 //! \{
 // TODO: Rename according to convention when moving into Nbnxn namespace
 //! All interaction mask is the same for all kernels
-constexpr unsigned int NBNXN_INTERACTION_MASK_ALL = 0xffffffffU;
+constexpr ClusterPairInteractionMask NBNXN_INTERACTION_MASK_ALL = ~ClusterPairInteractionMask(0);
 //! 4x4 kernel diagonal mask
 constexpr unsigned int NBNXN_INTERACTION_MASK_DIAG = 0x08ceU;
 //! 4x2 kernel diagonal masks
@@ -151,6 +166,13 @@ constexpr unsigned int NBNXN_INTERACTION_MASK_DIAG_J2_1 = 0x002fU;
 constexpr unsigned int NBNXN_INTERACTION_MASK_DIAG_J8_0 = 0xf0f8fcfeU;
 constexpr unsigned int NBNXN_INTERACTION_MASK_DIAG_J8_1 = 0x0080c0e0U;
 //! \}
+//! 4x16 kernel diagonal masks
+//! \{
+constexpr std::uint64_t NBNXN_INTERACTION_MASK_DIAG_J16_0 = 0xfff0fff8fffcfffeULL;
+constexpr std::uint64_t NBNXN_INTERACTION_MASK_DIAG_J16_1 = 0xff00ff80ffc0ffe0ULL;
+constexpr std::uint64_t NBNXN_INTERACTION_MASK_DIAG_J16_2 = 0xf000f800fc00fe00ULL;
+constexpr std::uint64_t NBNXN_INTERACTION_MASK_DIAG_J16_3 = 0x00008000c000e000ULL;
+//! \}
 //! \}
 
 /*! \brief Lower limit for square interaction distances in nonbonded kernels.
@@ -273,7 +295,7 @@ struct nbnxn_excl_t
     {
         for (unsigned int& pairEntry : pair)
         {
-            pairEntry = NBNXN_INTERACTION_MASK_ALL;
+            pairEntry = static_cast<unsigned int>(NBNXN_INTERACTION_MASK_ALL);
         }
     }
     MSVC_DIAGNOSTIC_RESET
@@ -356,4 +378,27 @@ struct NbnxnPairlistGpu
     gmx_cache_protect_t cp1;
 };
 
+/*! \brief Returns the estimated cost, in units of pair interactions, of an i-entry
+ * with \p nrj pairs in the free-energy kernel.
+ *
+ * The kernel processes the pairs of each i-entry in SIMD iterations, so a
+ * partially filled last iteration costs as much as a full one. On top of that
+ * comes the fixed cost of loading the i-atom and reducing its (shift-)force,
+ * which we estimate as one iteration. This matters because a non-perturbed
+ * i-atom only has the few perturbed j-atoms in its entry. Balancing on the
+ * number of pairs alone assigns too little work to the threads that cover
+ * the surroundings of a cluster of perturbed atoms, such as a ligand.
+ */
+int fepIEntryCost(int nrj);
+
+/*! \brief Redistributes the i-entries of \p fepLists such that each list has about equal cost
+ *
+ * The cost of i-entries is estimated with fepIEntryCost(). The i-entries keep
+ * their order, so each list gets a contiguous range of them. The free-energy
+ * lists in \p work are used as temporary storage and there should be as many
+ * as there are lists and threads for ModuleMultiThread::Nonbonded.
+ */
+void balance_fep_lists(gmx::ArrayRef<std::unique_ptr<t_nblist>> fepLists,
+                       gmx::ArrayRef<PairsearchWork>            work);
+
 #endif
@@ -62,7 +62,8 @@ PairlistParams::PairlistParams(const Nbnxm::KernelType kernelType,
     mtsFactor(1),
     nstlistPrune(-1),
     numRollingPruningParts(1),
-    lifetime(-1)
+    lifetime(-1),
+    useIncrementalUpdates(false)
 {
     if (!Nbnxm::kernelTypeUsesSimplePairlist(kernelType))
     {
@@ -75,6 +76,7 @@ PairlistParams::PairlistParams(const Nbnxm::KernelType kernelType,
             case 2: pairlistType = PairlistType::Simple4x2; break;
             case 4: pairlistType = PairlistType::Simple4x4; break;
             case 8: pairlistType = PairlistType::Simple4x8; break;
+            case 16: pairlistType = PairlistType::Simple4x16; break;
             default: GMX_RELEASE_ASSERT(false, "Kernel type does not have a pairlist type");
         }
     }
@@ -103,21 +103,23 @@ enum class PairlistType : int
     Simple4x2,
     Simple4x4,
     Simple4x8,
+    Simple4x16,
     HierarchicalNxN,
     Count
 };
 
 //! Gives the i-cluster size for each pairlist type
 static constexpr gmx::EnumerationArray<PairlistType, int> IClusterSizePerListType = {
-    { c_nbnxnCpuIClusterSize, c_nbnxnCpuIClusterSize, c_nbnxnCpuIClusterSize, c_nbnxnGpuClusterSize }
+    { c_nbnxnCpuIClusterSize, c_nbnxnCpuIClusterSize, c_nbnxnCpuIClusterSize, c_nbnxnCpuIClusterSize,
+      c_nbnxnGpuClusterSize }
 };
 //! Gives the j-cluster size for each pairlist type
 static constexpr gmx::EnumerationArray<PairlistType, int> JClusterSizePerListType = {
-    { 2, 4, 8, c_nbnxnGpuClusterSize }
+    { 2, 4, 8, 16, c_nbnxnGpuClusterSize }
 };
 //! True if given pairlist type is used on GPU, false if on CPU.
 static constexpr gmx::EnumerationArray<PairlistType, bool> sc_isGpuPairListType = {
-    { false, false, false, true }
+    { false, false, false, false, true }
 };
 
 /*! \internal
@@ -151,6 +153,8 @@ struct PairlistParams
     int numRollingPruningParts;
     //! Lifetime in steps of the pair-list
     int lifetime;
+    //! Whether the outer list can be reused beyond its lifetime when atoms moved little
+    bool useIncrementalUpdates;
 };
 
 #endif
@@ -80,8 +80,8 @@ class GridSet;
 class PairlistSet
 {
 public:
-    //! Constructor: initializes the pairlist set as empty
-    PairlistSet(const PairlistParams& listParams);
+    //! Constructor: initializes the pairlist set as empty, with \p numLists lists
+    PairlistSet(const PairlistParams& listParams, int numLists);
 
     ~PairlistSet();
 
@@ -68,10 +68,18 @@ class ListOfLists;
 class PairlistSets
 {
 public:
-    //! Constructor
+    /*! \brief Constructor
+     *
+     * \param[in] pairlistParams                    The pairlist parameters
+     * \param[in] haveMultipleDomains               Whether a non-local set is needed
+     * \param[in] minimumIlistCountForGpuBalancing  Minimum i-list count for GPU balancing
+     * \param[in] numLists                          The number of lists per set, each list is
+     *                                              constructed and used by a single thread
+     */
     PairlistSets(const PairlistParams& pairlistParams,
                  bool                  haveMultipleDomains,
-                 int                   minimumIlistCountForGpuBalancing);
+                 int                   minimumIlistCountForGpuBalancing,
+                 int                   numLists);
 
     //! Construct the pairlist set for the given locality
     void construct(gmx::InteractionLocality     iLocality,
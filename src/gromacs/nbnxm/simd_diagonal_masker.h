@@ -59,10 +59,20 @@ namespace gmx
 template<int, KernelLayout, KernelLayoutClusterRatio>
 class DiagonalMasker;
 
+//! Returns the number of diagonal mask arrays needed for the cluster ratio
+static constexpr int numDiagonalMasks(const KernelLayoutClusterRatio clusterRatio)
+{
+    switch (clusterRatio)
+    {
+        case KernelLayoutClusterRatio::JSizeEqualsISize: return 1;
+        case KernelLayoutClusterRatio::JSizeIsQuadrupleISize: return 4;
+        default: return 2;
+    }
+}
+
 //! Returns the diagonal filter masks
 template<int nR, KernelLayout kernelLayout>
-inline std::array<std::array<SimdBool, nR>,
-                  kernelLayoutClusterRatio<kernelLayout>() == KernelLayoutClusterRatio::JSizeEqualsISize ? 1 : 2>
+inline std::array<std::array<SimdBool, nR>, numDiagonalMasks(kernelLayoutClusterRatio<kernelLayout>())>
 generateDiagonalMasks(const nbnxn_atomdata_t::SimdMasks& simdMasks)
 {
     constexpr KernelLayoutClusterRatio clusterRatio = kernelLayoutClusterRatio<kernelLayout>();
@@ -76,7 +86,7 @@ generateDiagonalMasks(const nbnxn_atomdata_t::SimdMasks& simdMasks)
     const SimdReal iIndexIncrement(kernelLayout == KernelLayout::r4xM ? 1 : 2);
     const SimdReal zero(0.0_real);
     /* Generate all the diagonal masks as comparison results */
-    std::array<std::array<SimdBool, nR>, clusterRatio == KernelLayoutClusterRatio::JSizeEqualsISize ? 1 : 2> diagonalMaskVV;
+    std::array<std::array<SimdBool, nR>, numDiagonalMasks(clusterRatio)> diagonalMaskVV;
     for (int i = 0; i < nR; i++)
     {
         diagonalMaskVV[0][i] = (zero < diagonalJMinusI);
@@ -90,10 +100,14 @@ generateDiagonalMasks(const nbnxn_atomdata_t::SimdMasks& simdMasks)
             /* Load j-i for the second half of the j-cluster */
             diagonalJMinusI = load<SimdReal>(simdMasks.diagonal_4xn_j_minus_i.data() + nR / 2);
         }
-        for (int i = 0; i < nR; i++)
+        /* With larger j-clusters we continue with the next i-cluster in the j-cluster */
+        for (int m = 1; m < numDiagonalMasks(clusterRatio); m++)
         {
-            diagonalMaskVV[1][i] = (zero < diagonalJMinusI);
-            diagonalJMinusI      = diagonalJMinusI - iIndexIncrement;
+            for (int i = 0; i < nR; i++)
+            {
+                diagonalMaskVV[m][i] = (zero < diagonalJMinusI);
+                diagonalJMinusI      = diagonalJMinusI - iIndexIncrement;
+            }
         }
     }
     // NOLINTNEXTLINE(readability-misleading-indentation) remove when clang-tidy-13 is required
@@ -155,6 +169,32 @@ private:
     const std::array<std::array<SimdBool, nR>, 2> diagonalMaskVV_;
 };
 
+//! Specialized masker for JSizeIsQuadrupleISize
+template<int nR, KernelLayout kernelLayout>
+class DiagonalMasker<nR, kernelLayout, KernelLayoutClusterRatio::JSizeIsQuadrupleISize>
+{
+public:
+    inline DiagonalMasker(const nbnxn_atomdata_t::SimdMasks& simdMasks) :
+        diagonalMaskVV_(generateDiagonalMasks<nR, kernelLayout>(simdMasks))
+    {
+    }
+
+    //! Sets (sub-)diagonal entries in \p boolV to false when the cluster pair in on the diagonal
+    inline void maskArray(const int iClusterIndex, const int jClusterIndex, std::array<SimdBool, nR>& boolV) const
+    {
+        const int iClusterInJCluster = iClusterIndex - jClusterIndex * 4;
+        if (iClusterInJCluster >= 0 && iClusterInJCluster < 4)
+        {
+            boolV = genBoolArr<nR>(
+                    [&](int i) { return boolV[i] && diagonalMaskVV_[iClusterInJCluster][i]; });
+        }
+    }
+
+private:
+    //! The diagonal mask array for j-cluster index * 4 + 0/1/2/3 = i-cluster index
+    const std::array<std::array<SimdBool, nR>, 4> diagonalMaskVV_;
+};
+
 //! Specialized masker for JSizeIsHalfISize
 template<int nR, KernelLayout kernelLayout>
 class DiagonalMasker<nR, kernelLayout, KernelLayoutClusterRatio::JSizeIsHalfISize>
@@ -91,6 +91,64 @@ namespace gmx
 //! Whether we calculate shift forces, always true, because it's cheap anyhow
 static constexpr bool sc_calculateShiftForces = true;
 
+#if GMX_NBNXM_DOUBLE_ACCUMULATION && !GMX_DOUBLE && GMX_SIMD_HAVE_DOUBLE \
+        && GMX_SIMD_FLOAT_WIDTH == 2 * GMX_SIMD_DOUBLE_WIDTH
+/*! \brief Whether the i-atom force sums per i-entry and the energy totals are accumulated in double
+ *
+ * Everything else, including the energy-group pair energies, uses single precision.
+ */
+#    define GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE 1
+
+/*! \internal
+ * \brief Accumulates single precision SIMD values in double precision
+ *
+ * This is used in mixed-precision accumulation mode, where the pair
+ * interactions are computed in single precision, but the sums over
+ * all j-clusters for an i-cluster are computed in double precision.
+ */
+class SimdAccumulator
+{
+public:
+    //! Default constructor, leaves the contents uninitialized
+    SimdAccumulator() = default;
+
+    //! Constructs a zero accumulator, used as SimdAccumulator acc = setZero()
+    SimdAccumulator(SimdSetZeroProxy gmx_unused zero) : low_(setZero()), high_(setZero()) {}
+
+    //! Returns the sum of the accumulator and \p value
+    SimdAccumulator operator+(SimdFloat value) const
+    {
+        SimdDouble low;
+        SimdDouble high;
+        cvtF2DD(value, &low, &high);
+
+        return SimdAccumulator(low_ + low, high_ + high);
+    }
+
+    //! Returns the accumulated values rounded to single precision
+    SimdFloat toSimdReal() const { return cvtDD2F(low_, high_); }
+
+    //! Returns the sum over all elements
+    double sum() const { return reduce(low_ + high_); }
+
+private:
+    //! Constructs an accumulator from its two halves
+    SimdAccumulator(SimdDouble low, SimdDouble high) : low_(low), high_(high) {}
+
+    //! The first half of the elements
+    SimdDouble low_;
+    //! The second half of the elements
+    SimdDouble high_;
+};
+#else
+//! Whether the i-atom force sums per i-entry and the energy totals are accumulated in double
+#    define GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE 0
+
+//! Without mixed-precision accumulation we accumulate in SimdReal
+using SimdAccumulator = SimdReal;
+
+#endif
+
 /*! \brief The actual NBNxM SIMD kernel
  *
  * \tparam kernelLayout    The kernel layout: either 2xMM or 4xM
@@ -203,12 +261,16 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
     SimdBitMask exclusionFilterV[nR];
     for (int i = 0; i < nR; i++)
     {
+        /* With split masks, the mask bits for each i are shifted to bit 0 */
+        const int filterOffset =
+                (c_splitInteractionMasks<kernelLayout> ? 0
+                                                       : i * c_numJClustersPerSimdRegister * c_jClusterSize);
 #if GMX_SIMD_HAVE_INT32_LOGICAL
-        exclusionFilterV[i] = load<SimdBitMask>(reinterpret_cast<const int*>(
-                exclusion_filter + i * c_numJClustersPerSimdRegister * c_jClusterSize));
+        exclusionFilterV[i] =
+                load<SimdBitMask>(reinterpret_cast<const int*>(exclusion_filter + filterOffset));
 #else
-        exclusionFilterV[i] = load<SimdBitMask>(reinterpret_cast<const real*>(
-                exclusion_filter + i * c_numJClustersPerSimdRegister * c_jClusterSize));
+        exclusionFilterV[i] =
+                load<SimdBitMask>(reinterpret_cast<const real*>(exclusion_filter + filterOffset));
 #endif
     }
 
@@ -270,6 +332,12 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
 
     const nbnxn_cj_t* l_cj = nbl->cj.list_.data();
 
+#if GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE
+    /* The energies summed over all i-entries, added to the output at the end */
+    double vCoulombSum = 0;
+    double vVdwSum     = 0;
+#endif
+
     for (const nbnxn_ci_t& ciEntry : nbl->ci)
     {
         const int ish    = (ciEntry.shift & NBNXN_CI_SHIFT);
@@ -295,10 +363,15 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
         }
         else
         {
-            sci  = (ci >> 1) * c_stride;
-            scix = sci * DIM + (ci & 1) * (c_stride >> 1);
-            sci2 = sci * 2 + (ci & 1) * (c_stride >> 1);
-            sci += (ci & 1) * (c_stride >> 1);
+            /* Several i-clusters share one packing stride */
+            constexpr int c_iClustersPerStride = c_stride / c_iClusterSize;
+
+            const int iOffset = (ci % c_iClustersPerStride) * c_iClusterSize;
+
+            sci  = (ci / c_iClustersPerStride) * c_stride;
+            scix = sci * DIM + iOffset;
+            sci2 = sci * 2 + iOffset;
+            sci += iOffset;
         }
 
         /* We have 5 LJ/C combinations, but use only three inner loops,
@@ -431,8 +504,8 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
             }
         }
 
-        SimdReal Vvdwtot_S;
-        SimdReal vctot_S;
+        SimdAccumulator Vvdwtot_S;
+        SimdAccumulator vctot_S;
         if constexpr (calculateEnergies)
         {
             /* Zero the potential energy for this list */
@@ -441,18 +514,15 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
         }
 
         /* Declare and clear i atom forces */
-        auto forceIXV = genArr<nR>([&](int gmx_unused i) {
-            SimdReal tmp = setZero();
-            return tmp;
-        });
-        auto forceIYV = genArr<nR>([&](int gmx_unused i) {
-            SimdReal tmp = setZero();
-            return tmp;
-        });
-        auto forceIZV = genArr<nR>([&](int gmx_unused i) {
-            SimdReal tmp = setZero();
-            return tmp;
-        });
+        std::array<SimdAccumulator, nR> forceIXV;
+        std::array<SimdAccumulator, nR> forceIYV;
+        std::array<SimdAccumulator, nR> forceIZV;
+        for (int i = 0; i < nR; i++)
+        {
+            forceIXV[i] = setZero();
+            forceIYV[i] = setZero();
+            forceIZV[i] = setZero();
+        }
 
 
         int cjind = cjind0;
@@ -522,20 +592,29 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
             }
         }
         /* Add accumulated i-forces to the force array */
+#if GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE
+        const auto fIXV = genArr<nR>([&](int i) { return forceIXV[i].toSimdReal(); });
+        const auto fIYV = genArr<nR>([&](int i) { return forceIYV[i].toSimdReal(); });
+        const auto fIZV = genArr<nR>([&](int i) { return forceIZV[i].toSimdReal(); });
+#else
+        const auto& fIXV = forceIXV;
+        const auto& fIYV = forceIYV;
+        const auto& fIZV = forceIZV;
+#endif
         real fShiftX;
         real fShiftY;
         real fShiftZ;
         if constexpr (c_numJClustersPerSimdRegister == 1)
         {
-            fShiftX = reduceIncr4ReturnSum(f + scix, forceIXV[0], forceIXV[1], forceIXV[2], forceIXV[3]);
-            fShiftY = reduceIncr4ReturnSum(f + sciy, forceIYV[0], forceIYV[1], forceIYV[2], forceIYV[3]);
-            fShiftZ = reduceIncr4ReturnSum(f + sciz, forceIZV[0], forceIZV[1], forceIZV[2], forceIZV[3]);
+            fShiftX = reduceIncr4ReturnSum(f + scix, fIXV[0], fIXV[1], fIXV[2], fIXV[3]);
+            fShiftY = reduceIncr4ReturnSum(f + sciy, fIYV[0], fIYV[1], fIYV[2], fIYV[3]);
+            fShiftZ = reduceIncr4ReturnSum(f + sciz, fIZV[0], fIZV[1], fIZV[2], fIZV[3]);
         }
         else
         {
-            fShiftX = reduceIncr4ReturnSumHsimd(f + scix, forceIXV[0], forceIXV[1]);
-            fShiftY = reduceIncr4ReturnSumHsimd(f + sciy, forceIYV[0], forceIYV[1]);
-            fShiftZ = reduceIncr4ReturnSumHsimd(f + sciz, forceIZV[0], forceIZV[1]);
+            fShiftX = reduceIncr4ReturnSumHsimd(f + scix, fIXV[0], fIXV[1]);
+            fShiftY = reduceIncr4ReturnSumHsimd(f + sciy, fIYV[0], fIYV[1]);
+            fShiftZ = reduceIncr4ReturnSumHsimd(f + sciz, fIZV[0], fIZV[1]);
         }
 
         if constexpr (sc_calculateShiftForces)
@@ -547,17 +626,34 @@ void nbnxmKernelSimd(const NbnxnPairlistCpu*    nbl,
 
         if constexpr (calculateEnergies)
         {
+#if GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE
+            if (do_coul)
+            {
+                vCoulombSum += vctot_S.sum();
+            }
+
+            vVdwSum += Vvdwtot_S.sum();
+#else
             if (do_coul)
             {
                 *Vc += reduce(vctot_S);
             }
 
             *Vvdw += reduce(Vvdwtot_S);
+#endif
         }
 
         /* Outer loop uses 6 flops/iteration */
     }
 
+#if GMX_NBNXM_SIMD_ACCUMULATE_IN_DOUBLE
+    if constexpr (calculateEnergies)
+    {
+        *Vc += vCoulombSum;
+        *Vvdw += vVdwSum;
+    }
+#endif
+
 #ifdef COUNT_PAIRS
     printf("atom pairs %d\n", npair);
 #endif
@@ -72,7 +72,7 @@
 
     /* Interaction (non-exclusion) mask of all 1's or 0's */
     const auto interactV = loadSimdPairInteractionMasks<c_needToCheckExclusions, kernelLayout>(
-            static_cast<int>(l_cj[cjind].excl), exclusionFilterV);
+            l_cj[cjind].excl, exclusionFilterV);
 
     /* load j atom coordinates */
     SimdReal jx_S = loadJAtomData<kernelLayout>(x, ajx);
@@ -429,9 +429,12 @@
     const auto tzV = genArr<nR>([&](int i) { return fScalarV[i] * dzV[i]; });
 
     /* Increment i atom force */
-    forceIXV = genArr<nR>([&](int i) { return forceIXV[i] + txV[i]; });
-    forceIYV = genArr<nR>([&](int i) { return forceIYV[i] + tyV[i]; });
-    forceIZV = genArr<nR>([&](int i) { return forceIZV[i] + tzV[i]; });
+    for (int i = 0; i < nR; i++)
+    {
+        forceIXV[i] = forceIXV[i] + txV[i];
+        forceIYV[i] = forceIYV[i] + tyV[i];
+        forceIZV[i] = forceIZV[i] + tzV[i];
+    }
 
     /* Decrement j atom force */
     if constexpr (kernelLayout == KernelLayout::r4xM)
@@ -49,12 +49,14 @@
 #include "gromacs/simd/simd.h"
 #include "gromacs/utility/real.h"
 
+#include "pairlist.h"
+
 namespace gmx
 {
 
 /*! \brief Returns the j-cluster index for the given i-cluster index
  *
- * \tparam clusterRatio  The ratio of cluster size, supported are 0.5,1,2, checked at compile time
+ * \tparam clusterRatio  The ratio of cluster size, supported are 0.5,1,2,4, checked at compile time
  * \param  iCluster      The index of the i-cluster
  * \returns the j-cluster index corresponding to \p iCluster
  */
@@ -69,6 +71,10 @@ static inline int cjFromCi(const int iCluster)
     {
         return (iCluster >> 1);
     }
+    else if constexpr (clusterRatio == KernelLayoutClusterRatio::JSizeIsQuadrupleISize)
+    {
+        return (iCluster >> 2);
+    }
     else if constexpr (clusterRatio == KernelLayoutClusterRatio::JSizeIsHalfISize)
     {
         return (iCluster << 1);
@@ -109,6 +115,15 @@ inline std::enable_if_t<kernelLayout == KernelLayout::r2xMM, SimdReal> loadJAtom
     return loadDuplicateHsimd(ptr + offset);
 }
 
+/*! \brief Whether the interaction mask of a cluster pair does not fit in 32 bits
+ *
+ * This is the case for the 4x16 layout. The mask is then split over the i-atoms
+ * and the bits for each i-atom are shifted to the lowest bits before filtering.
+ */
+template<KernelLayout kernelLayout>
+static constexpr bool c_splitInteractionMasks =
+        (kernelLayout == KernelLayout::r4xM && c_nbnxnCpuIClusterSize * GMX_SIMD_REAL_WIDTH > 32);
+
 #if GMX_SIMD_HAVE_INT32_LOGICAL
 //! Define SimdBitMask as an integer SIMD register
 typedef SimdInt32 SimdBitMask;
@@ -120,7 +135,7 @@ typedef SimdReal SimdBitMask;
 //! Loads no interaction masks, returns an empty array
 template<bool loadMasks, KernelLayout kernelLayout>
 inline std::enable_if_t<!loadMasks, std::array<SimdBool, 0>>
-loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
+loadSimdPairInteractionMasks(const ClusterPairInteractionMask excl, SimdBitMask* filterBitMasksV)
 {
     return std::array<SimdBool, 0>{};
 
@@ -131,18 +146,30 @@ loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
 //! Loads interaction masks for a cluster pair for 4xM kernel layout
 template<bool loadMasks, KernelLayout kernelLayout>
 inline std::enable_if_t<loadMasks && kernelLayout == KernelLayout::r4xM, std::array<SimdBool, c_nbnxnCpuIClusterSize>>
-loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
+loadSimdPairInteractionMasks(const ClusterPairInteractionMask excl, SimdBitMask* filterBitMasksV)
 {
     using namespace gmx;
 
     std::array<SimdBool, c_nbnxnCpuIClusterSize> interactionMasksV;
 
 #if GMX_SIMD_HAVE_INT32_LOGICAL
-    /* Load integer interaction mask */
-    SimdInt32 mask_pr_S(excl);
-    for (int i = 0; i < c_nbnxnCpuIClusterSize; i++)
+    if constexpr (c_splitInteractionMasks<kernelLayout>)
     {
-        interactionMasksV[i] = cvtIB2B(testBits(mask_pr_S & filterBitMasksV[i]));
+        /* Load the integer interaction mask per i-atom */
+        for (int i = 0; i < c_nbnxnCpuIClusterSize; i++)
+        {
+            SimdInt32 mask_pr_S(static_cast<int>(excl >> (i * GMX_SIMD_REAL_WIDTH)));
+            interactionMasksV[i] = cvtIB2B(testBits(mask_pr_S & filterBitMasksV[i]));
+        }
+    }
+    else
+    {
+        /* Load integer interaction mask */
+        SimdInt32 mask_pr_S(static_cast<int>(excl));
+        for (int i = 0; i < c_nbnxnCpuIClusterSize; i++)
+        {
+            interactionMasksV[i] = cvtIB2B(testBits(mask_pr_S & filterBitMasksV[i]));
+        }
     }
 
 #elif GMX_SIMD_HAVE_LOGICAL
@@ -159,6 +186,9 @@ loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
     conv.i = excl;
     SimdReal mask_pr_S(conv.r);
 
+    static_assert(!c_splitInteractionMasks<kernelLayout>,
+                  "Split interaction masks require GMX_SIMD_HAVE_INT32_LOGICAL");
+
     for (int i = 0; i < c_nbnxnCpuIClusterSize; i++)
     {
         interactionMasksV[i] = testBits(mask_pr_S & filterBitMasksV[i]);
@@ -177,14 +207,14 @@ loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
 //! Loads interaction masks for a cluster pair for 2xMM kernel layout
 template<bool loadMasks, KernelLayout kernelLayout>
 inline std::enable_if_t<loadMasks && kernelLayout == KernelLayout::r2xMM, std::array<SimdBool, c_nbnxnCpuIClusterSize / 2>>
-loadSimdPairInteractionMasks(const int excl, SimdBitMask* filterBitMasksV)
+loadSimdPairInteractionMasks(const ClusterPairInteractionMask excl, SimdBitMask* filterBitMasksV)
 {
     using namespace gmx;
 
     std::array<SimdBool, c_nbnxnCpuIClusterSize / 2> interactionMasksV;
 
 #if GMX_SIMD_HAVE_INT32_LOGICAL
-    SimdInt32 mask_pr_S(excl);
+    SimdInt32 mask_pr_S(static_cast<int>(excl));
     for (int i = 0; i < c_nbnxnCpuIClusterSize / 2; i++)
     {
         interactionMasksV[i] = cvtIB2B(testBits(mask_pr_S & filterBitMasksV[i]));
@@ -127,7 +127,11 @@ void nbnxmSimdPruneKernel(NbnxnPairlistCpu*              nbl,
         }
         else
         {
-            scix = (ci >> 1) * c_stride * DIM + (ci & 1) * (c_stride >> 1);
+            /* Several i-clusters share one packing stride */
+            constexpr int c_iClustersPerStride = c_stride / c_iClusterSize;
+
+            scix = (ci / c_iClustersPerStride) * c_stride * DIM
+                   + (ci % c_iClustersPerStride) * c_iClusterSize;
         }
 
         /* Load i atom data */
@@ -120,7 +120,7 @@ diagonalPairlist(const Nbnxm::KernelType kernelType, const int numAtoms)
                       nullptr,
                       nbat.get());
 
-    std::unique_ptr<PairlistSet> pairlistSet = std::make_unique<PairlistSet>(pairlistParams);
+    std::unique_ptr<PairlistSet> pairlistSet = std::make_unique<PairlistSet>(pairlistParams, 1);
 
     std::vector<PairsearchWork> searchWork(1);
 
@@ -180,7 +180,7 @@ TEST_P(CpuListDiagonalExclusionsTest, CheckMask)
         for (int cjIndex = iEntry.cj_ind_start; cjIndex < iEntry.cj_ind_end; cjIndex++)
         {
             const int          jCluster = pairlist().cj.list_[cjIndex].cj;
-            const unsigned int excl     = pairlist().cj.list_[cjIndex].excl;
+            const auto         excl     = pairlist().cj.list_[cjIndex].excl;
 
             for (int iIndex = 0; iIndex < iClusterSize_; iIndex++)
             {
@@ -190,13 +190,42 @@ TEST_P(CpuListDiagonalExclusionsTest, CheckMask)
                 {
                     const int jAtom = jCluster * jClusterSize_ + jIndex;
 
-                    EXPECT_EQ((excl >> (iIndex * jClusterSize_ + jIndex)) & 1, (jAtom > iAtom ? 1 : 0));
+                    EXPECT_EQ(static_cast<int>((excl >> (iIndex * jClusterSize_ + jIndex)) & 1),
+                              (jAtom > iAtom ? 1 : 0));
                 }
             }
         }
     }
 }
 
+#if GMX_HAVE_NBNXM_SIMD_4XM && GMX_SIMD_REAL_WIDTH == 16
+// Checks that the 4x16 layout stores interaction bits above bit 31 for the last i-atoms
+TEST(CpuList4x16DiagonalExclusionsTest, UsesUpperHalfOfMask)
+{
+    const Nbnxm::KernelType kernelType = Nbnxm::KernelType::Cpu4xN_Simd_4xN;
+
+    const PairlistParams pairlistParams(kernelType, false, 1, false);
+
+    ASSERT_EQ(4, IClusterSizePerListType[pairlistParams.pairlistType]);
+    ASSERT_EQ(16, JClusterSizePerListType[pairlistParams.pairlistType]);
+
+    const auto listSet = diagonalPairlist(kernelType, 16);
+
+    const NbnxnPairlistCpu& pairlist = listSet.second->cpuLists()[0];
+
+    ASSERT_EQ(4, pairlist.ci.size());
+    ASSERT_EQ(4, pairlist.cj.size());
+
+    for (const auto& iEntry : pairlist.ci)
+    {
+        // The last i-atom of i-cluster ci interacts with the j-atoms with index above 4*ci + 3
+        const ClusterPairInteractionMask excl = pairlist.cj.list_[iEntry.cj_ind_start].excl;
+        EXPECT_EQ((0xFFFFU << (4 * iEntry.ci + 4)) & 0xFFFFU,
+                  static_cast<unsigned int>(excl >> 48));
+    }
+}
+#endif
+
 const auto testKernelTypes = ::testing::Values(Nbnxm::KernelType::Cpu4x4_PlainC
 #if GMX_HAVE_NBNXM_SIMD_4XM
                                                ,
@@ -0,0 +1,170 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the load balancing of the free-energy pairlists over threads.
+ *
+ * \ingroup module_nbnxm
+ */
+
+#include "gmxpre.h"
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/nbnxm/pairlist.h"
+#include "gromacs/nbnxm/pairsearch.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! Appends an i-entry for atom \p iAtom with \p numPairs perturbed pairs to \p list
+void addIEntry(t_nblist* list, const int iAtom, const int numPairs)
+{
+    if (list->jindex.empty())
+    {
+        list->jindex.push_back(0);
+    }
+    list->iinr.push_back(iAtom);
+    list->gid.push_back(0);
+    list->shift.push_back(0);
+    for (int j = 0; j < numPairs; j++)
+    {
+        list->jjnr.push_back(iAtom + 1 + j);
+        list->excl_fep.push_back(1);
+    }
+    list->nri++;
+    list->nrj += numPairs;
+    list->jindex.push_back(list->nrj);
+    list->maxnri = list->nri;
+    list->maxnrj = list->nrj;
+}
+
+//! Returns the estimated kernel cost of all i-entries in \p list
+int64_t listCost(const t_nblist& list)
+{
+    int64_t cost = 0;
+    for (int i = 0; i < list.nri; i++)
+    {
+        cost += fepIEntryCost(list.jindex[i + 1] - list.jindex[i]);
+    }
+    return cost;
+}
+
+TEST(FepIEntryCostTest, CountsPartialIterationsAndIEntryOverhead)
+{
+    // An empty i-entry only has the fixed cost, which is one SIMD iteration
+    const int pairWidth = fepIEntryCost(0);
+    ASSERT_GE(pairWidth, 1);
+
+    EXPECT_EQ(2 * pairWidth, fepIEntryCost(1));
+    EXPECT_EQ(2 * pairWidth, fepIEntryCost(pairWidth));
+    EXPECT_EQ(3 * pairWidth, fepIEntryCost(pairWidth + 1));
+    EXPECT_EQ(11 * pairWidth, fepIEntryCost(10 * pairWidth));
+}
+
+TEST(BalanceFepListsTest, BalancesEstimatedCostInsteadOfPairs)
+{
+    constexpr int c_numLists           = 2;
+    constexpr int c_numLargeEntries    = 4;
+    constexpr int c_numSinglePairs     = 40;
+    constexpr int c_largeEntryNumPairs = 40;
+
+    /* Mimic a ligand: the first list has the i-entries of the perturbed atoms
+     * with many pairs each, the second list has the i-entries of the
+     * surrounding non-perturbed atoms with a single perturbed pair each.
+     */
+    std::vector<std::unique_ptr<t_nblist>> fepLists;
+    for (int th = 0; th < c_numLists; th++)
+    {
+        fepLists.push_back(std::make_unique<t_nblist>());
+    }
+    std::vector<int> iAtoms;
+    for (int i = 0; i < c_numLargeEntries; i++)
+    {
+        addIEntry(fepLists[0].get(), i, c_largeEntryNumPairs);
+        iAtoms.push_back(i);
+    }
+    for (int i = 0; i < c_numSinglePairs; i++)
+    {
+        addIEntry(fepLists[1].get(), 100 + i, 1);
+        iAtoms.push_back(100 + i);
+    }
+    const int64_t totalCost     = listCost(*fepLists[0]) + listCost(*fepLists[1]);
+    const int     maxIEntryCost = fepIEntryCost(c_largeEntryNumPairs);
+
+    std::vector<PairsearchWork> work(c_numLists);
+
+    const int numNonbondedThreads = gmx_omp_nthreads_get(ModuleMultiThread::Nonbonded);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, c_numLists);
+    balance_fep_lists(fepLists, work);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, numNonbondedThreads);
+
+    // All i-entries should be kept, in order
+    std::vector<int> balancedIAtoms;
+    int              numPairs = 0;
+    for (const auto& list : fepLists)
+    {
+        balancedIAtoms.insert(
+                balancedIAtoms.end(), list->iinr.begin(), list->iinr.begin() + list->nri);
+        numPairs += list->nrj;
+    }
+    EXPECT_EQ(iAtoms, balancedIAtoms);
+    EXPECT_EQ(c_numLargeEntries * c_largeEntryNumPairs + c_numSinglePairs, numPairs);
+
+    // Each list should be within one i-entry of an equal share of the cost
+    for (int th = 0; th < c_numLists; th++)
+    {
+        SCOPED_TRACE(formatString("List %d", th));
+        EXPECT_NEAR(totalCost / c_numLists, listCost(*fepLists[th]), maxIEntryCost);
+    }
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
@@ -0,0 +1,413 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief Tests that storing grid columns along a Hilbert curve does not change interactions.
+ *
+ * \ingroup module_nbnxm
+ */
+
+#include "gmxpre.h"
+
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/atominfo.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/nbnxm/atomdata.h"
+#include "gromacs/nbnxm/kernel_common.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/nbnxm/pairlist.h"
+#include "gromacs/nbnxm/pairlistparams.h"
+#include "gromacs/nbnxm/pairlistset.h"
+#include "gromacs/nbnxm/pairlistsets.h"
+#include "gromacs/nbnxm/pairsearch.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/listoflists.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testasserts.h"
+
+#include "spc27_coords.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! The pairlist radius
+constexpr real c_rlist = 0.9;
+//! The interaction cut-off
+constexpr real c_cutoff = 0.9;
+//! The number of copies of the spc27 box along x and y
+constexpr int c_numCopies = 3;
+
+//! Water system with spc27 copied along x and y, so the grid has enough columns
+struct WaterSystem
+{
+    WaterSystem()
+    {
+        copy_mat(spc27Box, box);
+        box[XX][XX] *= c_numCopies;
+        box[YY][YY] *= c_numCopies;
+
+        for (int cx = 0; cx < c_numCopies; cx++)
+        {
+            for (int cy = 0; cy < c_numCopies; cy++)
+            {
+                for (const RVec& x : spc27Coordinates)
+                {
+                    coordinates.push_back(
+                            x + RVec(cx * spc27Box[XX][XX], cy * spc27Box[YY][YY], 0.0_real));
+                }
+            }
+        }
+        put_atoms_in_box(PbcType::Xyz, box, coordinates);
+
+        // Only the oxygens have LJ
+        nonbondedParameters = { 0.0026173456, 2.634129e-06, 0, 0, 0, 0, 0, 0 };
+
+        const int numAtoms = coordinates.size();
+        for (int a = 0; a < numAtoms; a++)
+        {
+            const bool isOxygen = (a % 3 == 0);
+            atomTypes.push_back(isOxygen ? 0 : 1);
+            charges.push_back(isOxygen ? -0.82 : 0.41);
+            atomInfo.push_back(sc_atomInfo_HasCharge | (isOxygen ? sc_atomInfo_HasVdw : 0));
+            excls.pushBackListOfSize(3);
+            std::iota(excls.back().begin(), excls.back().end(), a - (a % 3));
+        }
+    }
+
+    //! The periodic box
+    matrix box;
+    //! The coordinates, all in the box
+    std::vector<RVec> coordinates;
+    //! The LJ C6 and C12 parameters for all type pairs
+    std::vector<real> nonbondedParameters;
+    //! The atom types
+    std::vector<int> atomTypes;
+    //! The atom charges
+    std::vector<real> charges;
+    //! The atom info flags
+    std::vector<int64_t> atomInfo;
+    //! The exclusions, within each water molecule
+    ListOfLists<int> excls;
+};
+
+//! Returns a Nbnxm object with a pairlist for \p system, using Hilbert column order when requested
+std::unique_ptr<nonbonded_verlet_t> setupNbnxm(const Nbnxm::KernelType kernelType,
+                                               const WaterSystem&      system,
+                                               const bool              useHilbertOrder)
+{
+    gmx_omp_nthreads_set(ModuleMultiThread::Pairsearch, 1);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, 1);
+
+    Nbnxm::KernelSetup kernelSetup;
+    kernelSetup.kernelType         = kernelType;
+    kernelSetup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Table;
+
+    PairlistParams pairlistParams(kernelType, false, c_rlist, false);
+
+    // The grid reads the environment variable on construction
+    const char* hilbertOrderEnvironmentVariable = "GMX_NBNXN_HILBERT_ORDER";
+    if (useHilbertOrder)
+    {
+        gmxSetenv(hilbertOrderEnvironmentVariable, "1", 1);
+    }
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0, 1);
+    auto pairSearch   = std::make_unique<PairSearch>(PbcType::Xyz,
+                                                   false,
+                                                   nullptr,
+                                                   nullptr,
+                                                   pairlistParams.pairlistType,
+                                                   false,
+                                                   1,
+                                                   PinningPolicy::CannotBePinned);
+    gmxUnsetenv(hilbertOrderEnvironmentVariable);
+
+    auto atomData = std::make_unique<nbnxn_atomdata_t>(PinningPolicy::CannotBePinned,
+                                                       MDLogger(),
+                                                       kernelType,
+                                                       enbnxninitcombruleNONE,
+                                                       2,
+                                                       system.nonbondedParameters,
+                                                       1,
+                                                       1);
+
+    auto nbv = std::make_unique<nonbonded_verlet_t>(std::move(pairlistSets),
+                                                    std::move(pairSearch),
+                                                    std::move(atomData),
+                                                    kernelSetup,
+                                                    nullptr);
+
+    const rvec lowerCorner = { 0, 0, 0 };
+    const rvec upperCorner = { system.box[XX][XX], system.box[YY][YY], system.box[ZZ][ZZ] };
+
+    const int numAtoms = system.coordinates.size();
+    nbv->putAtomsOnGrid(system.box,
+                        0,
+                        lowerCorner,
+                        upperCorner,
+                        nullptr,
+                        { 0, numAtoms },
+                        numAtoms / det(system.box),
+                        system.atomInfo,
+                        system.coordinates,
+                        0,
+                        nullptr);
+
+    nbv->constructPairlist(InteractionLocality::Local, system.excls, 0, nullptr);
+
+    nbv->setAtomProperties(system.atomTypes, system.charges, system.atomInfo);
+
+    return nbv;
+}
+
+/*! \brief Returns the atom pairs within the pairlist radius that are present in the list
+ *
+ * The pairlist can contain cluster pairs with atom pairs beyond the radius,
+ * which cluster pairs these are depends on the search order, so those are
+ * not returned. Each pair is stored once with the lowest atom index first.
+ */
+std::set<std::pair<int, int>> atomPairsInPairlist(const nonbonded_verlet_t& nbv,
+                                                  const WaterSystem&        system)
+{
+    const ArrayRef<const int> atomOrder = nbv.getLocalAtomOrder();
+
+    t_pbc pbc;
+    set_pbc(&pbc, PbcType::Xyz, system.box);
+
+    std::set<std::pair<int, int>> atomPairs;
+    for (const NbnxnPairlistCpu& list :
+         nbv.pairlistSets().pairlistSet(InteractionLocality::Local).cpuLists())
+    {
+        for (const nbnxn_ci_t& ciEntry : list.ci)
+        {
+            for (int cjIndex = ciEntry.cj_ind_start; cjIndex < ciEntry.cj_ind_end; cjIndex++)
+            {
+                const int cj = list.cj.cj(cjIndex);
+                for (int i = ciEntry.ci * list.na_ci; i < (ciEntry.ci + 1) * list.na_ci; i++)
+                {
+                    for (int j = cj * list.na_cj; j < (cj + 1) * list.na_cj; j++)
+                    {
+                        const int a0 = atomOrder[i];
+                        const int a1 = atomOrder[j];
+                        if (a0 < 0 || a1 < 0 || a0 == a1)
+                        {
+                            continue;
+                        }
+                        rvec dx;
+                        pbc_dx_aiuc(&pbc, system.coordinates[a0], system.coordinates[a1], dx);
+                        if (norm2(dx) < c_rlist * c_rlist)
+                        {
+                            atomPairs.insert({ std::min(a0, a1), std::max(a0, a1) });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return atomPairs;
+}
+
+//! Returns all atom pairs within the pairlist radius, with the lowest atom index first
+std::set<std::pair<int, int>> allAtomPairsWithinRlist(const WaterSystem& system)
+{
+    t_pbc pbc;
+    set_pbc(&pbc, PbcType::Xyz, system.box);
+
+    std::set<std::pair<int, int>> atomPairs;
+    for (int a0 = 0; a0 < ssize(system.coordinates); a0++)
+    {
+        for (int a1 = a0 + 1; a1 < ssize(system.coordinates); a1++)
+        {
+            rvec dx;
+            pbc_dx_aiuc(&pbc, system.coordinates[a0], system.coordinates[a1], dx);
+            if (norm2(dx) < c_rlist * c_rlist)
+            {
+                atomPairs.insert({ a0, a1 });
+            }
+        }
+    }
+
+    return atomPairs;
+}
+
+//! Returns the interaction constants for reaction-field and plain LJ
+interaction_const_t setupInteractionConst()
+{
+    t_inputrec ir;
+    ir.vdwtype          = VanDerWaalsType::Cut;
+    ir.vdw_modifier     = InteractionModifiers::PotShift;
+    ir.rvdw             = c_cutoff;
+    ir.coulombtype      = CoulombInteractionType::RF;
+    ir.coulomb_modifier = InteractionModifiers::PotShift;
+    ir.rcoulomb         = c_cutoff;
+    ir.epsilon_r        = 1;
+    ir.epsilon_rf       = 0;
+
+    gmx_mtop_t mtop;
+    mtop.ffparams.reppow = 12;
+    mtop.ffparams.functype.resize(1);
+    mtop.ffparams.functype[0] = F_LJ;
+
+    interaction_const_t ic = init_interaction_const(nullptr, ir, mtop, false);
+    init_interaction_const_tables(nullptr, &ic, c_rlist, 0);
+
+    return ic;
+}
+
+//! Returns the forces, in the original atom order, and energies for the pairlist in \p nbv
+std::vector<RVec> computeForces(nonbonded_verlet_t*        nbv,
+                                const interaction_const_t& ic,
+                                const WaterSystem&         system,
+                                real*                      vVdw,
+                                real*                      vCoulomb)
+{
+    std::vector<RVec> shiftVecs(c_numShiftVectors);
+    calc_shifts(system.box, shiftVecs);
+
+    nbv->convertCoordinates(AtomLocality::Local, system.coordinates);
+
+    StepWorkload stepWork;
+    stepWork.computeForces = true;
+    stepWork.computeEnergy = true;
+
+    std::vector<real> vVdwGroups(1);
+    std::vector<real> vCoulombGroups(1);
+    nbv->dispatchNonbondedKernel(InteractionLocality::Local,
+                                 ic,
+                                 stepWork,
+                                 enbvClearFYes,
+                                 shiftVecs,
+                                 vVdwGroups,
+                                 vCoulombGroups,
+                                 nullptr);
+
+    std::vector<RVec> forces(system.coordinates.size(), { 0.0_real, 0.0_real, 0.0_real });
+    nbv->atomdata_add_nbat_f_to_f(AtomLocality::All, forces);
+
+    *vVdw     = vVdwGroups[0];
+    *vCoulomb = vCoulombGroups[0];
+
+    return forces;
+}
+
+//! Returns the kernel types to test
+std::vector<Nbnxm::KernelType> kernelTypesToTest()
+{
+    std::vector<Nbnxm::KernelType> kernelTypes = { Nbnxm::KernelType::Cpu4x4_PlainC };
+#if GMX_HAVE_NBNXM_SIMD_4XM
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_4xN);
+#endif
+#if GMX_HAVE_NBNXM_SIMD_2XMM
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_2xNN);
+#endif
+
+    return kernelTypes;
+}
+
+TEST(HilbertColumnOrder, GivesSamePairlistAndForces)
+{
+    const WaterSystem         system;
+    const interaction_const_t ic = setupInteractionConst();
+
+    for (const auto kernelType : kernelTypesToTest())
+    {
+        SCOPED_TRACE(formatString("Kernel type %s", lookup_kernel_name(kernelType)));
+
+        auto nbvRowMajor = setupNbnxm(kernelType, system, false);
+        auto nbvHilbert  = setupNbnxm(kernelType, system, true);
+
+        // Check that the test actually changes the atom order
+        const ArrayRef<const int> atomOrderRowMajor = nbvRowMajor->getLocalAtomOrder();
+        const ArrayRef<const int> atomOrderHilbert  = nbvHilbert->getLocalAtomOrder();
+        ASSERT_FALSE(std::equal(atomOrderRowMajor.begin(),
+                                atomOrderRowMajor.end(),
+                                atomOrderHilbert.begin(),
+                                atomOrderHilbert.end()));
+
+        // Both lists should contain all pairs within the pairlist radius
+        const auto atomPairsWithinRlist = allAtomPairsWithinRlist(system);
+        EXPECT_TRUE(atomPairsInPairlist(*nbvRowMajor, system) == atomPairsWithinRlist);
+        EXPECT_TRUE(atomPairsInPairlist(*nbvHilbert, system) == atomPairsWithinRlist);
+
+        real              vVdwRowMajor, vCoulombRowMajor;
+        std::vector<RVec> forcesRowMajor =
+                computeForces(nbvRowMajor.get(), ic, system, &vVdwRowMajor, &vCoulombRowMajor);
+
+        real              vVdwHilbert, vCoulombHilbert;
+        std::vector<RVec> forcesHilbert =
+                computeForces(nbvHilbert.get(), ic, system, &vVdwHilbert, &vCoulombHilbert);
+
+        // The only difference is the summation order
+        const FloatingPointTolerance tolerance(relativeToleranceAsUlp(1000.0, 50));
+        EXPECT_REAL_EQ_TOL(vVdwRowMajor, vVdwHilbert, tolerance);
+        EXPECT_REAL_EQ_TOL(vCoulombRowMajor, vCoulombHilbert, tolerance);
+        for (int a = 0; a < ssize(forcesRowMajor); a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(forcesRowMajor[a][d], forcesHilbert[a][d], tolerance);
+            }
+        }
+    }
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
@@ -55,6 +55,7 @@
 #include "gmxpre.h"
 
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "gromacs/ewald/ewald_utils.h"
@@ -325,7 +326,7 @@ std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const KernelOptio
     Nbnxm::GridSet gridSet(
             PbcType::Xyz, false, nullptr, nullptr, pairlistParams.pairlistType, false, numThreads, pinPolicy);
 
-    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0);
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0, numThreads);
 
     auto pairSearch = std::make_unique<PairSearch>(
             PbcType::Xyz, false, nullptr, nullptr, pairlistParams.pairlistType, false, numThreads, pinPolicy);
@@ -767,6 +768,77 @@ public:
     }
 };
 
+namespace
+{
+
+//! Returns the total LJ and Coulomb energies computed with the kernel type set in \p options
+std::pair<real, real> computeTotalEnergies(const KernelOptions& options, const TestSystem& system)
+{
+    std::unique_ptr<nonbonded_verlet_t> nbv = setupNbnxmForBenchInstance(options, system);
+
+    const interaction_const_t ic = setupInteractionConst(options);
+
+    std::vector<RVec> shiftVecs(c_numShiftVectors);
+    calc_shifts(system.box, shiftVecs);
+
+    StepWorkload stepWork;
+    stepWork.computeForces = true;
+    stepWork.computeEnergy = true;
+
+    // Use the non-energy-group kernel
+    nbv->nbat().paramsDeprecated().nenergrp = 1;
+    nbv->nbat().out[0].Vvdw.resize(1);
+    nbv->nbat().out[0].Vc.resize(1);
+
+    std::vector<real> vVdw(square(c_numEnergyGroups));
+    std::vector<real> vCoulomb(square(c_numEnergyGroups));
+    nbv->dispatchNonbondedKernel(
+            InteractionLocality::Local, ic, stepWork, enbvClearFYes, shiftVecs, vVdw, vCoulomb, nullptr);
+
+    return { vVdw[0], vCoulomb[0] };
+}
+
+} // namespace
+
+/* The plain-C kernel always accumulates in the default precision. With
+ * GMX_NBNXM_DOUBLE_ACCUMULATION the SIMD kernels accumulate the sums per
+ * i-entry and the energy totals in double precision, so this test then checks
+ * that these agree with the default path within the tolerances used above.
+ */
+TEST(NbnxmKernelAccumulationTest, SimdEnergiesMatchPlainCKernel)
+{
+    const TestSystem system(LJCombinationRule::Geometric);
+
+    KernelOptions options;
+    options.coulombType                    = CoulombKernelType::ReactionField;
+    options.kernelSetup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Table;
+
+    options.kernelSetup.kernelType         = Nbnxm::KernelType::Cpu4x4_PlainC;
+    const std::pair<real, real> reference = computeTotalEnergies(options, system);
+
+    const int  simdAccuracyBits = (GMX_DOUBLE ? std::min(GMX_SIMD_ACCURACY_BITS_DOUBLE, 44)
+                                              : std::min(GMX_SIMD_ACCURACY_BITS_SINGLE, 22));
+    const real tolerance        = 1000 * std::pow(0.5_real, simdAccuracyBits) * 50;
+
+    std::vector<Nbnxm::KernelType> simdKernelTypes;
+#if GMX_HAVE_NBNXM_SIMD_4XM
+    simdKernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_4xN);
+#endif
+#if GMX_HAVE_NBNXM_SIMD_2XMM
+    simdKernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_2xNN);
+#endif
+    for (const Nbnxm::KernelType kernelType : simdKernelTypes)
+    {
+        SCOPED_TRACE(formatString("Kernel type %s", lookup_kernel_name(kernelType)));
+
+        options.kernelSetup.kernelType = kernelType;
+        const std::pair<real, real> energies = computeTotalEnergies(options, system);
+
+        EXPECT_REAL_EQ_TOL(reference.first, energies.first, absoluteTolerance(tolerance));
+        EXPECT_REAL_EQ_TOL(reference.second, energies.second, absoluteTolerance(10 * tolerance));
+    }
+}
+
 #if GENERATE_REFERENCE_DATA
 // The plain-C kernels only support tabulated Ewald.
 // To get high accuracy in the reference data, we use SIMD kernels.
@@ -0,0 +1,353 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief Tests for reusing the outer pairlist with incremental pairlist updates.
+ *
+ * \ingroup module_nbnxm
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/atominfo.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/nbnxm/atomdata.h"
+#include "gromacs/nbnxm/kernel_common.h"
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/nbnxm_simd.h"
+#include "gromacs/nbnxm/pairlistparams.h"
+#include "gromacs/nbnxm/pairlistset.h"
+#include "gromacs/nbnxm/pairlistsets.h"
+#include "gromacs/nbnxm/pairsearch.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/listoflists.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+#include "spc27_coords.h"
+
+namespace gmx
+{
+
+namespace test
+{
+
+namespace
+{
+
+//! The outer pairlist radius
+constexpr real c_rlistOuter = 0.9;
+//! The inner pairlist radius
+constexpr real c_rlistInner = 0.8;
+//! The interaction cut-off
+constexpr real c_cutoff = 0.75;
+//! The number of steps between scheduled searches
+constexpr int c_nstlist = 10;
+
+//! Water system with the atom properties needed by the Nbnxm module
+struct WaterSystem
+{
+    WaterSystem()
+    {
+        // Only the oxygens have LJ
+        nonbondedParameters = { 0.0026173456, 2.634129e-06, 0, 0, 0, 0, 0, 0 };
+
+        const int numAtoms = spc27Coordinates.size();
+        for (int a = 0; a < numAtoms; a++)
+        {
+            const bool isOxygen = (a % 3 == 0);
+            atomTypes.push_back(isOxygen ? 0 : 1);
+            charges.push_back(isOxygen ? -0.82 : 0.41);
+            atomInfo.push_back(sc_atomInfo_HasCharge | (isOxygen ? sc_atomInfo_HasVdw : 0));
+            excls.pushBackListOfSize(3);
+            std::iota(excls.back().begin(), excls.back().end(), a - (a % 3));
+        }
+    }
+
+    //! The LJ C6 and C12 parameters for all type pairs
+    std::vector<real> nonbondedParameters;
+    //! The atom types
+    std::vector<int> atomTypes;
+    //! The atom charges
+    std::vector<real> charges;
+    //! The atom info flags
+    std::vector<int64_t> atomInfo;
+    //! The exclusions, within each water molecule
+    ListOfLists<int> excls;
+};
+
+//! Returns a Nbnxm object with a dynamically pruned pairlist constructed at step 0 for \p x
+std::unique_ptr<nonbonded_verlet_t> setupNbnxm(const Nbnxm::KernelType kernelType,
+                                               const WaterSystem&      system,
+                                               ArrayRef<const RVec>    x)
+{
+    gmx_omp_nthreads_set(ModuleMultiThread::Pairsearch, 1);
+    gmx_omp_nthreads_set(ModuleMultiThread::Nonbonded, 1);
+
+    Nbnxm::KernelSetup kernelSetup;
+    kernelSetup.kernelType         = kernelType;
+    kernelSetup.ewaldExclusionType = Nbnxm::EwaldExclusionType::Table;
+
+    PairlistParams pairlistParams(kernelType, false, c_rlistOuter, false);
+    pairlistParams.rlistInner            = c_rlistInner;
+    pairlistParams.useDynamicPruning     = true;
+    pairlistParams.nstlistPrune          = 2;
+    pairlistParams.lifetime              = c_nstlist - 1;
+    pairlistParams.useIncrementalUpdates = true;
+
+    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0, 1);
+    auto pairSearch   = std::make_unique<PairSearch>(PbcType::Xyz,
+                                                   false,
+                                                   nullptr,
+                                                   nullptr,
+                                                   pairlistParams.pairlistType,
+                                                   false,
+                                                   1,
+                                                   PinningPolicy::CannotBePinned);
+    auto atomData = std::make_unique<nbnxn_atomdata_t>(PinningPolicy::CannotBePinned,
+                                                       MDLogger(),
+                                                       kernelType,
+                                                       enbnxninitcombruleNONE,
+                                                       2,
+                                                       system.nonbondedParameters,
+                                                       1,
+                                                       1);
+
+    auto nbv = std::make_unique<nonbonded_verlet_t>(std::move(pairlistSets),
+                                                    std::move(pairSearch),
+                                                    std::move(atomData),
+                                                    kernelSetup,
+                                                    nullptr);
+
+    const rvec lowerCorner = { 0, 0, 0 };
+    const rvec upperCorner = { spc27Box[XX][XX], spc27Box[YY][YY], spc27Box[ZZ][ZZ] };
+
+    nbv->putAtomsOnGrid(spc27Box,
+                        0,
+                        lowerCorner,
+                        upperCorner,
+                        nullptr,
+                        { 0, int(x.size()) },
+                        x.size() / det(spc27Box),
+                        system.atomInfo,
+                        x,
+                        0,
+                        nullptr);
+
+    nbv->constructPairlist(InteractionLocality::Local, system.excls, 0, nullptr);
+
+    nbv->setAtomProperties(system.atomTypes, system.charges, system.atomInfo);
+
+    return nbv;
+}
+
+//! Returns the interaction constants for reaction-field and plain LJ
+interaction_const_t setupInteractionConst()
+{
+    t_inputrec ir;
+    ir.vdwtype          = VanDerWaalsType::Cut;
+    ir.vdw_modifier     = InteractionModifiers::PotShift;
+    ir.rvdw             = c_cutoff;
+    ir.coulombtype      = CoulombInteractionType::RF;
+    ir.coulomb_modifier = InteractionModifiers::PotShift;
+    ir.rcoulomb         = c_cutoff;
+    ir.epsilon_r        = 1;
+    ir.epsilon_rf       = 0;
+
+    gmx_mtop_t mtop;
+    mtop.ffparams.reppow = 12;
+    mtop.ffparams.functype.resize(1);
+    mtop.ffparams.functype[0] = F_LJ;
+
+    interaction_const_t ic = init_interaction_const(nullptr, ir, mtop, false);
+    init_interaction_const_tables(nullptr, &ic, c_rlistOuter, 0);
+
+    return ic;
+}
+
+//! Prunes the outer list with coordinates \p x and returns the forces and energies
+std::vector<RVec> pruneAndComputeForces(nonbonded_verlet_t*        nbv,
+                                        const interaction_const_t& ic,
+                                        ArrayRef<const RVec>       x,
+                                        real*                      vVdw,
+                                        real*                      vCoulomb)
+{
+    std::vector<RVec> shiftVecs(c_numShiftVectors);
+    calc_shifts(spc27Box, shiftVecs);
+
+    nbv->convertCoordinates(AtomLocality::Local, x);
+    nbv->dispatchPruneKernelCpu(InteractionLocality::Local, shiftVecs);
+
+    StepWorkload stepWork;
+    stepWork.computeForces = true;
+    stepWork.computeEnergy = true;
+
+    std::vector<real> vVdwGroups(1);
+    std::vector<real> vCoulombGroups(1);
+    nbv->dispatchNonbondedKernel(InteractionLocality::Local,
+                                 ic,
+                                 stepWork,
+                                 enbvClearFYes,
+                                 shiftVecs,
+                                 vVdwGroups,
+                                 vCoulombGroups,
+                                 nullptr);
+
+    std::vector<RVec> forces(x.size(), { 0.0_real, 0.0_real, 0.0_real });
+    nbv->atomdata_add_nbat_f_to_f(AtomLocality::All, forces);
+
+    *vVdw     = vVdwGroups[0];
+    *vCoulomb = vCoulombGroups[0];
+
+    return forces;
+}
+
+//! Returns the kernel types to test
+std::vector<Nbnxm::KernelType> kernelTypesToTest()
+{
+    std::vector<Nbnxm::KernelType> kernelTypes = { Nbnxm::KernelType::Cpu4x4_PlainC };
+#if GMX_HAVE_NBNXM_SIMD_4XM
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_4xN);
+#endif
+#if GMX_HAVE_NBNXM_SIMD_2XMM
+    kernelTypes.push_back(Nbnxm::KernelType::Cpu4xN_Simd_2xNN);
+#endif
+
+    return kernelTypes;
+}
+
+//! Returns \p x with each atom displaced by at most \p maxDisplacement
+std::vector<RVec> displacedCoordinates(ArrayRef<const RVec> x, const real maxDisplacement)
+{
+    std::vector<RVec> xDisplaced(x.begin(), x.end());
+    const real        scale = maxDisplacement / std::sqrt(3.0_real);
+    for (int a = 0; a < ssize(xDisplaced); a++)
+    {
+        xDisplaced[a] += scale * RVec(std::sin(a), std::cos(2 * a), std::sin(3 * a));
+    }
+
+    return xDisplaced;
+}
+
+TEST(PairlistReuse, ReusedListGivesSameForcesAsNewList)
+{
+    const WaterSystem         system;
+    const interaction_const_t ic = setupInteractionConst();
+
+    std::vector<RVec> x0 = spc27Coordinates;
+    put_atoms_in_box(PbcType::Xyz, spc27Box, x0);
+
+    // Displacements within half the difference of the list radii
+    const std::vector<RVec> x1 = displacedCoordinates(x0, 0.02);
+
+    for (const auto kernelType : kernelTypesToTest())
+    {
+        SCOPED_TRACE(formatString("Kernel type %s", lookup_kernel_name(kernelType)));
+
+        auto nbvReused = setupNbnxm(kernelType, system, x0);
+
+        EXPECT_TRUE(nbvReused->outerPairlistIsComplete(x1));
+        EXPECT_TRUE(nbvReused->canReusePairlist(c_nstlist, c_nstlist, x1));
+
+        real              vVdwReused, vCoulombReused;
+        std::vector<RVec> forcesReused =
+                pruneAndComputeForces(nbvReused.get(), ic, x1, &vVdwReused, &vCoulombReused);
+
+        // A new list needs atoms in the box, this does not affect the forces
+        std::vector<RVec> x1InBox = x1;
+        put_atoms_in_box(PbcType::Xyz, spc27Box, x1InBox);
+
+        auto nbvNew = setupNbnxm(kernelType, system, x1InBox);
+
+        real              vVdwNew, vCoulombNew;
+        std::vector<RVec> forcesNew =
+                pruneAndComputeForces(nbvNew.get(), ic, x1InBox, &vVdwNew, &vCoulombNew);
+
+        // The only difference is the summation order
+        const FloatingPointTolerance tolerance(relativeToleranceAsUlp(1000.0, 50));
+        EXPECT_REAL_EQ_TOL(vVdwNew, vVdwReused, tolerance);
+        EXPECT_REAL_EQ_TOL(vCoulombNew, vCoulombReused, tolerance);
+        for (int a = 0; a < ssize(forcesNew); a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(forcesNew[a][d], forcesReused[a][d], tolerance);
+            }
+        }
+    }
+}
+
+TEST(PairlistReuse, LargeDisplacementRequiresSearch)
+{
+    const WaterSystem system;
+
+    std::vector<RVec> x0 = spc27Coordinates;
+    put_atoms_in_box(PbcType::Xyz, spc27Box, x0);
+
+    auto nbv = setupNbnxm(Nbnxm::KernelType::Cpu4x4_PlainC, system, x0);
+
+    // Atoms moved less than the bound now, but are expected to exceed it
+    // before the next scheduled search
+    const std::vector<RVec> xSlow = displacedCoordinates(x0, 0.03);
+    EXPECT_TRUE(nbv->outerPairlistIsComplete(xSlow));
+    EXPECT_FALSE(nbv->canReusePairlist(c_nstlist, c_nstlist, xSlow));
+
+    // A single fast atom that moved beyond half the buffer invalidates the list
+    std::vector<RVec> xFast = x0;
+    xFast[4][XX] += 0.51 * (c_rlistOuter - c_rlistInner);
+    EXPECT_FALSE(nbv->outerPairlistIsComplete(xFast));
+    EXPECT_FALSE(nbv->canReusePairlist(c_nstlist, c_nstlist, xFast));
+}
+
+} // namespace
+
+} // namespace test
+
+} // namespace gmx
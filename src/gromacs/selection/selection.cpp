@@ -42,6 +42,7 @@
 
 #include "gromacs/selection/selection.h"
 
+#include <algorithm>
 #include <string>
 
 #include "gromacs/selection/nbsearch.h"
@@ -256,6 +257,22 @@ void SelectionData::restoreOriginalPositions(const gmx_mtop_t* top)
     }
 }
 
+
+void SelectionData::copyPostCompilationState(const SelectionData& rhs)
+{
+    initCoveredFraction(rhs.coveredFractionType_);
+
+    gmx_ana_indexmap_t&       m    = rawPositions_.m;
+    const gmx_ana_indexmap_t& rhsm = rhs.rawPositions_.m;
+    GMX_RELEASE_ASSERT(m.b.nr == rhsm.b.nr, "Copied selection does not match the original");
+    // Before the first evaluation, the mapped IDs equal the original IDs.
+    std::copy(rhsm.orgid, rhsm.orgid + rhsm.b.nr, m.orgid);
+    if (m.mapid != m.orgid)
+    {
+        std::copy(rhsm.orgid, rhsm.orgid + rhsm.b.nr, m.mapid);
+    }
+}
+
 } // namespace internal
 
 /********************************************************************
@@ -561,6 +561,17 @@ SelectionCollection::SelectionCollection(const SelectionCollection& rhs) :
     if (rhs.impl_->sc_.mempool != nullptr)
     {
         compile();
+        // Callers may have adjusted the compiled selections, e.g., by setting
+        // original IDs for the positions, which needs to be reflected in the copy.
+        for (size_t i = 0; i < rhs.impl_->sc_.sel.size(); i++)
+        {
+            impl_->sc_.sel[i]->copyPostCompilationState(*rhs.impl_->sc_.sel[i]);
+        }
+    }
+
+    for (const auto& selection : rhs.impl_->sc_.sel)
+    {
+        impl_->sourceSelections_.push_back(selection.get());
     }
 }
 
@@ -935,6 +946,28 @@ std::optional<Selection> SelectionCollection::selection(std::string_view selName
 }
 
 
+std::optional<Selection> SelectionCollection::correspondingSelection(const Selection& selection) const
+{
+    const auto& selections = impl_->sc_.sel;
+    for (const auto& sel : selections)
+    {
+        if (Selection(sel.get()) == selection)
+        {
+            return selection;
+        }
+    }
+    const auto& sources = impl_->sourceSelections_;
+    for (size_t i = 0; i < sources.size() && i < selections.size(); ++i)
+    {
+        if (Selection(sources[i]) == selection)
+        {
+            return Selection(selections[i].get());
+        }
+    }
+    return std::nullopt;
+}
+
+
 void SelectionCollection::printTree(FILE* fp, bool bValues) const
 {
     SelectionTreeElementPointer sel = impl_->sc_.root;
@@ -192,6 +192,14 @@ public:
     bool bExternalGroupsSet_;
     //! External index groups (can be NULL).
     gmx_ana_indexgrps_t* grps_;
+    /*! \brief
+     * Selections in the collection this one was copied from.
+     *
+     * Used to map selections from the source collection to the
+     * corresponding copies.  The pointers are only compared, never
+     * dereferenced.  Empty if the collection was not copied.
+     */
+    std::vector<gmx::internal::SelectionData*> sourceSelections_;
 };
 
 /*! \internal
@@ -870,12 +870,22 @@ void checkAndUpdateRequestedNumOpenmpThreads(gmx_hw_opt_t*         hw_opt,
 {
     if (EI_TPI(inputrec.eI))
     {
-        if (hw_opt->nthreads_omp > 1)
+        /* TPI uses OpenMP threads to compute different insertions concurrently.
+         * Since this scales equally well as MPI, we only use OpenMP on request.
+         */
+        if (hw_opt->nthreads_omp > 1
+            && (inputrec.efep != FreeEnergyPerturbationType::No
+                || inputrec.coulombtype == CoulombInteractionType::Ewald || inputrec.nwall > 0))
         {
             gmx_fatal(FARGS,
-                      "You requested OpenMP parallelization, which is not supported with TPI.");
+                      "You requested OpenMP parallelization, which is not supported with TPI "
+                      "in combination with free-energy perturbation, plain Ewald "
+                      "electrostatics or walls.");
+        }
+        if (hw_opt->nthreads_omp <= 0)
+        {
+            hw_opt->nthreads_omp = 1;
         }
-        hw_opt->nthreads_omp = 1;
     }
 
     if (GMX_THREAD_MPI)
@@ -317,6 +317,17 @@ struct wallcc_t
     gmx_cycles_t start;
 };
 
+//! A single timed region recorded when exporting a wallcycle trace
+struct WallcycleTraceEvent
+{
+    //! Counter index, sub-counters are offset by sc_numWallCycleCounters
+    int counter;
+    //! Cycle count when the region was opened
+    gmx_cycles_t start;
+    //! Cycle count when the region was closed
+    gmx_cycles_t stop;
+};
+
 struct gmx_wallcycle
 {
     /*! \brief Methods used when debugging wallcycle counting
@@ -331,6 +342,10 @@ struct gmx_wallcycle
     //! \}
 
 public:
+    gmx_wallcycle();
+    //! Flushes and closes the trace output, when present
+    ~gmx_wallcycle();
+
     //! Storage for wallcycle counters
     gmx::EnumerationArray<WallCycleCounter, wallcc_t> wcc;
     //! The step count at which counter reset will happen
@@ -372,13 +387,93 @@ public:
     //! Whether this rank is the main rank of the simulation
     bool isMainRank = false;
     //! \}
+
+    //! Used when exporting a trace of all counter regions, see wallcycle_enable_trace()
+    //! \{
+    //! The trace output file, nullptr when tracing is not active
+    FILE* traceFile = nullptr;
+    //! File name prefix of the trace and summary output
+    std::string traceFilePrefix;
+    //! Regions recorded since the last flush
+    std::vector<WallcycleTraceEvent> traceEvents;
+    //! The rank which is written as process id into the trace
+    int traceRank = 0;
+    //! Cycle count at the start of tracing, trace time stamps are relative to this
+    gmx_cycles_t traceCycleStart = 0;
+    //! Wall time in seconds at the start of tracing, used for cycle calibration
+    double traceTimeStart = 0;
+    //! The MD step set by wallcycle_set_step(), recorded with each Step region
+    int64_t traceStep = 0;
+    //! The steps of the Step regions in \p traceEvents, in order
+    std::vector<int64_t> traceSteps;
+    //! Number of events written to the trace file so far
+    int64_t traceNumEventsWritten = 0;
+    //! Number of counters that are started and not yet stopped
+    int traceNumOpenCounters = 0;
+    //! Number of sub-counters that are started and not yet stopped
+    int traceNumOpenSubCounters = 0;
+    //! The outermost open counter, valid when \p traceNumOpenCounters > 0
+    WallCycleCounter traceOuterCounter = WallCycleCounter::Run;
+    //! \}
 };
 
 //! Returns if cycle counting is supported
 bool wallcycle_have_counter();
 
-//! Returns the wall cycle structure.
-std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE* fplog, int resetstep, const t_commrec* cr);
+/*! \brief Returns the wall cycle structure.
+ *
+ * \p simulationIndex is the index of the simulation in a multi-simulation,
+ * used to give trace files unique names, and -1 otherwise.
+ */
+std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE*             fplog,
+                                              int               resetstep,
+                                              const t_commrec*  cr,
+                                              int               simulationIndex = -1);
+
+/*! \brief Enables export of every counter and sub-counter region to a trace file
+ *
+ * The regions are buffered and periodically written in the Chrome trace event
+ * format to \p filePrefix.rank<rank>.json, which can be loaded in
+ * chrome://tracing or Perfetto. Each step appears as a "Step" region, so load
+ * imbalance, output stalls and DLB oscillations show up as outliers. The MD
+ * step of each "Step" region is the one set with wallcycle_set_step(). When
+ * the cycle accounting is printed on a rank with tracing enabled, a JSON summary
+ * of the table is also written to \p filePrefix.summary.json.
+ * Tracing is enabled by wallcycle_init() when GMX_WALLCYCLE_TRACE is set.
+ */
+void wallcycle_enable_trace(gmx_wallcycle* wc, const std::string& filePrefix, int rank);
+
+//! Writes the buffered trace events to the trace file
+void wallcycle_flush_trace(gmx_wallcycle* wc);
+
+/*! \brief Writes the buffered trace events when the buffer is full and no region is being timed
+ *
+ * Only the outermost counter, normally Run, may be open. The time spent writing
+ * is excluded from that counter, so tracing does not change the cycle accounting.
+ */
+void wallcycle_flush_trace_if_full(gmx_wallcycle* wc);
+
+//! Sets the MD step that is recorded with the Step region in the trace
+inline void wallcycle_set_step(gmx_wallcycle* wc, int64_t step)
+{
+    if (wc != nullptr)
+    {
+        wc->traceStep = step;
+    }
+}
+
+//! Buffers a region for the trace
+inline void wallcycle_trace_region(gmx_wallcycle* wc,
+                                   int            counter,
+                                   gmx_cycles_t   start,
+                                   gmx_cycles_t   stop)
+{
+    wc->traceEvents.push_back({ counter, start, stop });
+    if (counter == static_cast<int>(WallCycleCounter::Step))
+    {
+        wc->traceSteps.push_back(wc->traceStep);
+    }
+}
 
 //! Adds custom barrier for wallcycle counting.
 void wallcycleBarrier(gmx_wallcycle* wc);
@@ -421,6 +516,14 @@ inline void wallcycle_start(gmx_wallcycle* wc, WallCycleCounter ewc)
     }
     gmx_cycles_t cycle = gmx_cycles_read();
     wc->wcc[ewc].start = cycle;
+    if (wc->traceFile != nullptr)
+    {
+        if (wc->traceNumOpenCounters == 0)
+        {
+            wc->traceOuterCounter = ewc;
+        }
+        wc->traceNumOpenCounters++;
+    }
     if (!wc->wcc_all.empty())
     {
         wc->wc_depth++;
@@ -500,6 +603,12 @@ inline double wallcycle_stop(gmx_wallcycle* wc, WallCycleCounter ewc)
             wallcycle_all_start(wc, ewc, cycle);
         }
     }
+    if (wc->traceFile != nullptr)
+    {
+        wallcycle_trace_region(wc, static_cast<int>(ewc), cycle - last, cycle);
+        wc->traceNumOpenCounters--;
+        wallcycle_flush_trace_if_full(wc);
+    }
 
     return last;
 }
@@ -539,6 +648,10 @@ inline void wallcycle_sub_start(gmx_wallcycle* wc, WallCycleSubCounter ewcs)
         if (wc != nullptr)
         {
             wc->wcsc[ewcs].start = gmx_cycles_read();
+            if (wc->traceFile != nullptr)
+            {
+                wc->traceNumOpenSubCounters++;
+            }
         }
     }
 }
@@ -565,8 +678,15 @@ inline void wallcycle_sub_stop(gmx_wallcycle* wc, WallCycleSubCounter ewcs)
 
         if (wc != nullptr)
         {
-            wc->wcsc[ewcs].c += gmx_cycles_read() - wc->wcsc[ewcs].start;
+            const gmx_cycles_t cycle = gmx_cycles_read();
+            wc->wcsc[ewcs].c += cycle - wc->wcsc[ewcs].start;
             wc->wcsc[ewcs].n++;
+            if (wc->traceFile != nullptr)
+            {
+                const int counter = sc_numWallCycleCounters + static_cast<int>(ewcs);
+                wallcycle_trace_region(wc, counter, wc->wcsc[ewcs].start, cycle);
+                wc->traceNumOpenSubCounters--;
+            }
         }
     }
 }
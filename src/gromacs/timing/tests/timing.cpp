@@ -41,14 +41,19 @@
 #include "gmxpre.h"
 
 #include <chrono>
+#include <filesystem>
 #include <memory>
+#include <string>
 #include <thread>
 
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/timing/wallcycle.h"
+#include "gromacs/utility/textreader.h"
 
 #include "testutils/refdata.h"
+#include "testutils/setenv.h"
 #include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
 
 namespace gmx
 {
@@ -173,6 +178,83 @@ TEST_F(TimingTest, RunWallCycleSub)
     }
 }
 
+//! Test whether the trace export writes every step region with its MD step
+TEST_F(TimingTest, TraceContainsAllSteps)
+{
+    TestFileManager   fileManager;
+    const std::string prefix = fileManager.getTemporaryFilePath("wallcycle").string();
+
+    wallcycle_enable_trace(wcycle.get(), prefix, 0);
+    const int64_t firstStep = 1000;
+    const int     numSteps  = 3;
+    for (int64_t step = firstStep; step < firstStep + numSteps; step++)
+    {
+        wallcycle_start(wcycle.get(), WallCycleCounter::Step);
+        wallcycle_set_step(wcycle.get(), step);
+        wallcycle_start(wcycle.get(), WallCycleCounter::Force);
+        sleepForMilliseconds(delayInMilliseconds);
+        wallcycle_stop(wcycle.get(), WallCycleCounter::Force);
+        wallcycle_stop(wcycle.get(), WallCycleCounter::Step);
+    }
+    // Destroying the wallcycle object flushes and closes the trace
+    wcycle.reset();
+
+    const std::string trace = TextReader::readFileToString(prefix + ".rank0.json");
+    EXPECT_EQ(trace.front(), '[');
+    EXPECT_EQ(trace.substr(trace.size() - 2), "]\n");
+    for (int64_t step = firstStep; step < firstStep + numSteps; step++)
+    {
+        EXPECT_NE(trace.find("\"step\":" + std::to_string(step) + "}"), std::string::npos);
+    }
+    EXPECT_EQ(trace.find("\"step\":0}"), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"Force\""), std::string::npos);
+}
+
+//! Test that the trace is only written when no region other than the outermost is timed
+TEST_F(TimingTest, TraceIsWrittenOutsideTimedRegions)
+{
+    TestFileManager   fileManager;
+    const std::string prefix = fileManager.getTemporaryFilePath("wallcycle").string();
+
+    wallcycle_enable_trace(wcycle.get(), prefix, 0);
+    // More regions than fit in the trace buffer, all within one step
+    const size_t numRegions = 20000;
+    wallcycle_start(wcycle.get(), WallCycleCounter::Run);
+    wallcycle_start(wcycle.get(), WallCycleCounter::Step);
+    for (size_t i = 0; i < numRegions; i++)
+    {
+        wallcycle_start(wcycle.get(), WallCycleCounter::Force);
+        wallcycle_stop(wcycle.get(), WallCycleCounter::Force);
+    }
+    EXPECT_EQ(numRegions, wcycle->traceEvents.size());
+    wallcycle_stop(wcycle.get(), WallCycleCounter::Step);
+    EXPECT_TRUE(wcycle->traceEvents.empty());
+    wallcycle_stop(wcycle.get(), WallCycleCounter::Run);
+    EXPECT_EQ(1U, wcycle->traceEvents.size());
+}
+
+//! Test that simulations in a multi-simulation write separate trace files
+TEST(TimingTraceTest, MultiSimTraceFileNameContainsSimulationIndex)
+{
+    TestFileManager   fileManager;
+    const std::string prefix = fileManager.getTemporaryFilePath("wallcycle").string();
+    const std::string traceFileName = prefix + ".sim2.rank0.json";
+    // Let the file manager remove the trace file
+    fileManager.getTemporaryFilePath("wallcycle.sim2.rank0.json");
+
+    gmxSetenv("GMX_WALLCYCLE_TRACE", prefix.c_str(), 1);
+    auto wcycle = wallcycle_init(nullptr, 0, nullptr, 2);
+    gmxUnsetenv("GMX_WALLCYCLE_TRACE");
+    if (!wcycle)
+    {
+        GTEST_SKIP() << "Cycle counting is not supported";
+    }
+    wcycle.reset();
+
+    EXPECT_TRUE(std::filesystem::exists(traceFileName));
+    EXPECT_FALSE(std::filesystem::exists(prefix + ".rank0.json"));
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
@@ -37,6 +37,7 @@
 
 #include "config.h"
 
+#include <cinttypes>
 #include <cstdlib>
 
 #include <array>
@@ -49,10 +50,12 @@
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/timing/gpu_timing.h"
 #include "gromacs/timing/wallcyclereporting.h"
+#include "gromacs/timing/walltime_accounting.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/enumerationhelpers.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/logger.h"
@@ -93,7 +96,10 @@ bool wallcycle_have_counter()
     return gmx_cycles_have_counter();
 }
 
-std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE* fplog, int resetstep, const t_commrec* cr)
+std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE*            fplog,
+                                              int              resetstep,
+                                              const t_commrec* cr,
+                                              int              simulationIndex)
 {
     std::unique_ptr<gmx_wallcycle> wc;
 
@@ -120,6 +126,23 @@ std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE* fplog, int resetstep, const
     }
 #endif
 
+    if (const char* tracePrefix = getenv("GMX_WALLCYCLE_TRACE"))
+    {
+        std::string prefix = (tracePrefix[0] != '\0') ? tracePrefix : "wallcycle";
+        if (simulationIndex >= 0)
+        {
+            // Ranks of different simulations should not write to the same files
+            prefix += gmx::formatString(".sim%d", simulationIndex);
+        }
+        if (fplog)
+        {
+            fprintf(fplog,
+                    "\nWill write a trace of all cycle counter regions to %s.rank*.json\n\n",
+                    prefix.c_str());
+        }
+        wallcycle_enable_trace(wc.get(), prefix, cr != nullptr ? cr->rankInDefaultCommunicator : 0);
+    }
+
     if (getenv("GMX_CYCLE_ALL") != nullptr)
     {
         if (fplog)
@@ -156,6 +179,122 @@ std::unique_ptr<gmx_wallcycle> wallcycle_init(FILE* fplog, int resetstep, const
 #    endif
 #endif
 
+gmx_wallcycle::gmx_wallcycle() = default;
+
+gmx_wallcycle::~gmx_wallcycle()
+{
+    if (traceFile != nullptr)
+    {
+        wallcycle_flush_trace(this);
+        fprintf(traceFile, "\n]\n");
+        gmx_ffclose(traceFile);
+    }
+}
+
+void wallcycle_enable_trace(gmx_wallcycle* wc, const std::string& filePrefix, int rank)
+{
+    if (wc == nullptr || wc->traceFile != nullptr)
+    {
+        return;
+    }
+
+    const std::string fileName = gmx::formatString("%s.rank%d.json", filePrefix.c_str(), rank);
+
+    wc->traceFile       = gmx_ffopen(fileName, "w");
+    wc->traceFilePrefix = filePrefix;
+    wc->traceRank       = rank;
+    wc->traceCycleStart = gmx_cycles_read();
+    wc->traceTimeStart  = gmx_gettime();
+
+    /* Name the process and the two tracks, sub-counters get their own track
+     * as their regions do not necessarily nest within the main counters. */
+    fprintf(wc->traceFile,
+            "[\n"
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Rank %d\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+            "\"args\":{\"name\":\"Counters\"}},\n"
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":1,"
+            "\"args\":{\"name\":\"Sub-counters\"}}",
+            rank,
+            rank,
+            rank,
+            rank);
+    wc->traceNumEventsWritten = 3;
+}
+
+void wallcycle_flush_trace(gmx_wallcycle* wc)
+{
+    if (wc == nullptr || wc->traceFile == nullptr)
+    {
+        return;
+    }
+
+    /* Calibrate the cycle counter against the wall clock over all the time
+     * traced so far, so the conversion gets more accurate during the run. */
+    const gmx_cycles_t cyclesElapsed        = gmx_cycles_read() - wc->traceCycleStart;
+    const double       secondsElapsed       = gmx_gettime() - wc->traceTimeStart;
+    double             microsecondsPerCycle = 1;
+    if (secondsElapsed > 0 && cyclesElapsed > 0)
+    {
+        microsecondsPerCycle = 1e6 * secondsElapsed / static_cast<double>(cyclesElapsed);
+    }
+    const double cycleStart = static_cast<double>(wc->traceCycleStart);
+
+    size_t stepIndex = 0;
+    for (const WallcycleTraceEvent& event : wc->traceEvents)
+    {
+        const bool  isSubCounter = (event.counter >= sc_numWallCycleCounters);
+        const char* name =
+                isSubCounter ? enumValuetoString(static_cast<WallCycleSubCounter>(
+                                       event.counter - sc_numWallCycleCounters))
+                             : enumValuetoString(static_cast<WallCycleCounter>(event.counter));
+        fprintf(wc->traceFile,
+                "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                wc->traceNumEventsWritten > 0 ? ",\n" : "",
+                name,
+                wc->traceRank,
+                isSubCounter ? 1 : 0,
+                (static_cast<double>(event.start) - cycleStart) * microsecondsPerCycle,
+                static_cast<double>(event.stop - event.start) * microsecondsPerCycle);
+        if (event.counter == static_cast<int>(WallCycleCounter::Step))
+        {
+            GMX_ASSERT(stepIndex < wc->traceSteps.size(), "Each Step region should have a step");
+            fprintf(wc->traceFile, ",\"args\":{\"step\":%" PRId64 "}", wc->traceSteps[stepIndex]);
+            stepIndex++;
+        }
+        fprintf(wc->traceFile, "}");
+        wc->traceNumEventsWritten++;
+    }
+    wc->traceEvents.clear();
+    wc->traceSteps.clear();
+    fflush(wc->traceFile);
+}
+
+void wallcycle_flush_trace_if_full(gmx_wallcycle* wc)
+{
+    // Number of buffered regions that triggers writing to file
+    constexpr size_t c_traceFlushSize = 16384;
+    /* When regions do not balance, e.g. a counter that is never stopped,
+     * we might never get to an outer level, so then we flush anyhow. */
+    constexpr size_t c_traceFlushSizeMax = 16 * c_traceFlushSize;
+
+    const bool outsideTimedRegions =
+            (wc->traceNumOpenCounters <= 1 && wc->traceNumOpenSubCounters == 0);
+    if (!(wc->traceEvents.size() >= c_traceFlushSize && outsideTimedRegions)
+        && wc->traceEvents.size() < c_traceFlushSizeMax)
+    {
+        return;
+    }
+
+    const gmx_cycles_t flushStart = gmx_cycles_read();
+    wallcycle_flush_trace(wc);
+    if (wc->traceNumOpenCounters == 1)
+    {
+        // Exclude the time spent writing from the outer counter
+        wc->wcc[wc->traceOuterCounter].start += gmx_cycles_read() - flushStart;
+    }
+}
+
 void gmx_wallcycle::checkStart(WallCycleCounter ewc)
 {
     // NOLINTNEXTLINE(readability-misleading-indentation)
@@ -580,6 +719,91 @@ print_cycles(FILE* fplog, double c2t, const char* name, int nnodes, int nthreads
     }
 }
 
+/*! \brief Writes a machine-readable copy of the cycle accounting table
+ *
+ * Contains the same counters, with the same conversion to wall time, as
+ * printed by print_cycles() in wallcycle_print().
+ */
+static void writeCycleSummaryJson(const std::string&     fileName,
+                                  const gmx_wallcycle*   wc,
+                                  const WallcycleCounts& cyc_sum,
+                                  int                    npp,
+                                  int                    npme,
+                                  int                    nth_pp,
+                                  int                    nth_pme,
+                                  double                 realtime,
+                                  double                 c2t_pp,
+                                  double                 c2t_pme,
+                                  double                 tot)
+{
+    FILE* fp = gmx_ffopen(fileName, "w");
+
+    bool haveEntry  = false;
+    auto writeEntry = [fp, tot, &haveEntry](const char* name,
+                                            int         nranks,
+                                            int         nthreads,
+                                            int         ncalls,
+                                            double      c2t,
+                                            double      c_sum) {
+        if (c_sum <= 0)
+        {
+            return;
+        }
+        fprintf(fp,
+                "%s\n    {\"name\": \"%s\", \"ranks\": %d, \"threads\": %d, \"calls\": %d, "
+                "\"wallTimeSeconds\": %.6f, \"gigaCycles\": %.6f, \"percent\": %.3f}",
+                haveEntry ? "," : "",
+                name,
+                nranks,
+                nthreads,
+                ncalls,
+                c_sum * c2t,
+                c_sum * 1e-9,
+                100 * c_sum / tot);
+        haveEntry = true;
+    };
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"ppRanks\": %d,\n  \"ppThreadsPerRank\": %d,\n", npp, nth_pp);
+    fprintf(fp, "  \"pmeRanks\": %d,\n  \"pmeThreadsPerRank\": %d,\n", npme, nth_pme);
+    fprintf(fp, "  \"wallTimeSeconds\": %.6f,\n  \"gigaCycles\": %.6f,\n", realtime, tot * 1e-9);
+    fprintf(fp, "  \"counters\": [");
+    for (auto key : keysOf(wc->wcc))
+    {
+        if (key < WallCycleCounter::Domdec || (is_pme_subcounter(key) && wc->wcc[key].n == 0))
+        {
+            continue;
+        }
+        const bool onPmeRanks = (npme > 0 && is_pme_counter(key));
+        writeEntry(enumValuetoString(key),
+                   onPmeRanks ? npme : npp,
+                   onPmeRanks ? nth_pme : nth_pp,
+                   wc->wcc[key].n,
+                   onPmeRanks ? c2t_pme : c2t_pp,
+                   cyc_sum[static_cast<int>(key)]);
+    }
+    fprintf(fp, "\n  ],\n");
+
+    haveEntry = false;
+    fprintf(fp, "  \"subCounters\": [");
+    // NOLINTNEXTLINE(readability-misleading-indentation)
+    if constexpr (sc_useCycleSubcounters)
+    {
+        for (auto key : keysOf(wc->wcsc))
+        {
+            writeEntry(enumValuetoString(key),
+                       npp,
+                       nth_pp,
+                       wc->wcsc[key].n,
+                       c2t_pp,
+                       cyc_sum[sc_numWallCycleCounters + static_cast<int>(key)]);
+        }
+    }
+    fprintf(fp, "\n  ]\n}\n");
+
+    gmx_ffclose(fp);
+}
+
 static void print_gputimes(FILE* fplog, const char* name, int n, double t, double tot_t)
 {
     char num[11];
@@ -855,6 +1079,21 @@ void wallcycle_print(FILE*                            fplog,
         fprintf(fplog, "%s\n", hline);
     }
 
+    if (!wc->traceFilePrefix.empty())
+    {
+        writeCycleSummaryJson(wc->traceFilePrefix + ".summary.json",
+                              wc,
+                              cyc_sum,
+                              npp,
+                              npme,
+                              nth_pp,
+                              nth_pme,
+                              realtime,
+                              c2t_pp,
+                              npme > 0 ? c2t_pme : c2t_pp,
+                              tot);
+    }
+
     /* print GPU timing summary */
     double tot_gpu = 0.0;
     if (gpu_pme_t)
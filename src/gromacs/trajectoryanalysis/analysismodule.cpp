@@ -43,10 +43,12 @@
 #include "gromacs/trajectoryanalysis/analysismodule.h"
 
 #include <map>
+#include <optional>
 #include <utility>
 
 #include "gromacs/analysisdata/analysisdata.h"
 #include "gromacs/selection/selection.h"
+#include "gromacs/selection/selectioncollection.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
 
@@ -181,14 +183,14 @@ AnalysisDataHandle TrajectoryAnalysisModuleData::dataHandle(const AnalysisData&
 }
 
 
-Selection TrajectoryAnalysisModuleData::parallelSelection(const Selection& selection)
+Selection TrajectoryAnalysisModuleData::parallelSelection(const Selection& selection) const
 {
-    // TODO: Implement properly.
-    return selection;
+    const std::optional<Selection> localSelection = impl_->selections_.correspondingSelection(selection);
+    return localSelection.has_value() ? *localSelection : selection;
 }
 
 
-SelectionList TrajectoryAnalysisModuleData::parallelSelections(const SelectionList& selections)
+SelectionList TrajectoryAnalysisModuleData::parallelSelections(const SelectionList& selections) const
 {
     // TODO: Consider an implementation that does not allocate memory every time.
     SelectionList newSelections;
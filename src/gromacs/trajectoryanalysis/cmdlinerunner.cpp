@@ -42,6 +42,12 @@
 
 #include "gromacs/trajectoryanalysis/cmdlinerunner.h"
 
+#include <cstring>
+
+#include <array>
+#include <exception>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
@@ -54,7 +60,12 @@
 #include "gromacs/trajectoryanalysis/analysismodule.h"
 #include "gromacs/trajectoryanalysis/analysissettings.h"
 #include "gromacs/trajectoryanalysis/topologyinformation.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/filestream.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/smalloc.h"
 
 #include "runnercommon.h"
 
@@ -64,6 +75,76 @@ namespace gmx
 namespace
 {
 
+//! Number of frames per thread in a batch for frame-parallel analysis.
+constexpr int c_frameBatchSizePerThread = 4;
+
+/*! \brief
+ * Copies a trajectory frame, reusing the memory already allocated in \p dest.
+ *
+ * The atoms structure is not copied, only the pointer to it.
+ */
+void copyTrajectoryFrame(const t_trxframe& src, t_trxframe* dest)
+{
+    rvec* x     = dest->x;
+    rvec* v     = dest->v;
+    rvec* f     = dest->f;
+    int*  index = dest->index;
+    *dest       = src;
+    const int natoms = src.natoms;
+    if (src.bX && src.x != nullptr)
+    {
+        srenew(x, natoms);
+        std::memcpy(x, src.x, natoms * sizeof(*x));
+    }
+    if (src.bV && src.v != nullptr)
+    {
+        srenew(v, natoms);
+        std::memcpy(v, src.v, natoms * sizeof(*v));
+    }
+    if (src.bF && src.f != nullptr)
+    {
+        srenew(f, natoms);
+        std::memcpy(f, src.f, natoms * sizeof(*f));
+    }
+    if (src.bIndex && src.index != nullptr)
+    {
+        srenew(index, natoms);
+        std::memcpy(index, src.index, natoms * sizeof(*index));
+    }
+    dest->x     = x;
+    dest->v     = v;
+    dest->f     = f;
+    dest->index = index;
+}
+
+/*! \brief
+ * Owns copies of a batch of trajectory frames for frame-parallel analysis.
+ */
+class TrajectoryFrameBatch
+{
+public:
+    //! Creates a batch with room for \p size frames.
+    explicit TrajectoryFrameBatch(int size) : frames_(size) {}
+    ~TrajectoryFrameBatch()
+    {
+        for (t_trxframe& frame : frames_)
+        {
+            sfree(frame.x);
+            sfree(frame.v);
+            sfree(frame.f);
+            sfree(frame.index);
+        }
+    }
+
+    //! Returns the frames in the batch.
+    ArrayRef<t_trxframe> frames() { return frames_; }
+
+private:
+    std::vector<t_trxframe> frames_;
+
+    GMX_DISALLOW_COPY_AND_ASSIGN(TrajectoryFrameBatch);
+};
+
 /********************************************************************
  * RunnerModule
  */
@@ -81,10 +162,33 @@ public:
     void optionsFinished() override;
     int  run() override;
 
+    //! Analyzes all frames one at a time, returning the number of frames.
+    int analyzeFramesSerial();
+    /*! \brief
+     * Analyzes all frames using \p threadCount threads, returning the number of frames.
+     *
+     * Frames are processed in batches.  While the frames of one batch are
+     * analyzed concurrently, one thread reads the next batch.  Each thread
+     * evaluates its own copy of the selections and uses its own
+     * TrajectoryAnalysisModuleData.  The frames are finished in order after
+     * each batch, which is where the analysis data storage merges the
+     * out-of-order frames.
+     */
+    int analyzeFramesParallel(int threadCount);
+    /*! \brief
+     * Copies frames from the trajectory into \p batch, starting from the current frame.
+     *
+     * \returns The number of frames in the batch; zero if there are no more
+     *     frames.
+     */
+    int readFrameBatch(ArrayRef<t_trxframe> batch);
+
     TrajectoryAnalysisModulePointer module_;
     TrajectoryAnalysisSettings      settings_;
     TrajectoryAnalysisRunnerCommon  common_;
     SelectionCollection             selections_;
+    //! Whether the trajectory has a frame that has not yet been analyzed.
+    bool hasFrame_ = true;
 };
 
 void RunnerModule::initOptions(IOptionsContainer* options, ICommandLineOptionsModuleSettings* settings)
@@ -121,6 +225,31 @@ int RunnerModule::run()
     common_.initFrameIndexGroup();
     module_->initAfterFirstFrame(settings_, common_.frame());
 
+    const int threadCount = common_.hasTrajectory() ? common_.frameThreadCount() : 1;
+    const int nframes = (threadCount > 1) ? analyzeFramesParallel(threadCount) : analyzeFramesSerial();
+
+    if (common_.hasTrajectory())
+    {
+        fprintf(stderr, "Analyzed %d frames, last time %.3f\n", nframes, common_.frame().time);
+    }
+    else
+    {
+        fprintf(stderr, "Analyzed topology coordinates\n");
+    }
+
+    // Restore the maximal groups for dynamic selections.
+    selections_.evaluateFinal(nframes);
+
+    module_->finishAnalysis(nframes);
+    module_->writeOutput();
+
+    return 0;
+}
+
+int RunnerModule::analyzeFramesSerial()
+{
+    const TopologyInformation& topology = common_.topologyInformation();
+
     t_pbc  pbc;
     t_pbc* ppbc = settings_.hasPBC() ? &pbc : nullptr;
 
@@ -149,22 +278,115 @@ int RunnerModule::run()
     }
     pdata.reset();
 
-    if (common_.hasTrajectory())
+    return nframes;
+}
+
+int RunnerModule::readFrameBatch(ArrayRef<t_trxframe> batch)
+{
+    int count = 0;
+    while (count < batch.ssize() && hasFrame_)
     {
-        fprintf(stderr, "Analyzed %d frames, last time %.3f\n", nframes, common_.frame().time);
+        common_.initFrame();
+        copyTrajectoryFrame(common_.frame(), &batch[count]);
+        ++count;
+        hasFrame_ = common_.readNextFrame();
     }
-    else
+    return count;
+}
+
+int RunnerModule::analyzeFramesParallel(int threadCount)
+{
+    const TopologyInformation& topology = common_.topologyInformation();
+    const bool                 bPBC     = settings_.hasPBC();
+    const int                  batchSize = c_frameBatchSizePerThread * threadCount;
+
+    // All frames in a batch may be in progress at the same time.
+    AnalysisDataParallelOptions                      dataOptions(batchSize);
+    std::vector<SelectionCollection>                 threadSelections(threadCount, selections_);
+    std::vector<TrajectoryAnalysisModuleDataPointer> threadData;
+    threadData.reserve(threadCount);
+    for (const SelectionCollection& selections : threadSelections)
     {
-        fprintf(stderr, "Analyzed topology coordinates\n");
+        threadData.push_back(module_->startFrames(dataOptions, selections));
     }
+    std::vector<t_pbc>              threadPbc(threadCount);
+    std::vector<std::exception_ptr> threadExceptions(threadCount);
 
-    // Restore the maximal groups for dynamic selections.
-    selections_.evaluateFinal(nframes);
+    // One batch is analyzed while the next one is read.
+    TrajectoryFrameBatch                  firstBatch(batchSize);
+    TrajectoryFrameBatch                  secondBatch(batchSize);
+    std::array<TrajectoryFrameBatch*, 2> batches = { &firstBatch, &secondBatch };
 
-    module_->finishAnalysis(nframes);
-    module_->writeOutput();
+    int nframes    = 0;
+    int current    = 0;
+    hasFrame_      = true;
+    int frameCount = readFrameBatch(batches[current]->frames());
+    while (frameCount > 0)
+    {
+        ArrayRef<t_trxframe> currentBatch = batches[current]->frames();
+        ArrayRef<t_trxframe> nextBatch    = batches[1 - current]->frames();
+        int                  nextCount    = 0;
+#pragma omp parallel num_threads(threadCount)
+        {
+            const int thread = gmx_omp_get_thread_num();
+#pragma omp single nowait
+            {
+                try
+                {
+                    nextCount = readFrameBatch(nextBatch);
+                }
+                catch (...)
+                {
+                    threadExceptions[thread] = std::current_exception();
+                }
+            }
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < frameCount; ++i)
+            {
+                try
+                {
+                    t_trxframe& frame = currentBatch[i];
+                    t_pbc*      ppbc  = bPBC ? &threadPbc[thread] : nullptr;
+                    if (ppbc != nullptr)
+                    {
+                        set_pbc(ppbc, topology.pbcType(), frame.box);
+                    }
+                    threadSelections[thread].evaluate(&frame, ppbc);
+                    module_->analyzeFrame(nframes + i, frame, ppbc, threadData[thread].get());
+                }
+                catch (...)
+                {
+                    threadExceptions[thread] = std::current_exception();
+                }
+            }
+        }
+        for (const std::exception_ptr& exception : threadExceptions)
+        {
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+        for (int i = 0; i < frameCount; ++i)
+        {
+            module_->finishFrameSerial(nframes + i);
+        }
+        nframes += frameCount;
+        frameCount = nextCount;
+        current    = 1 - current;
+    }
 
-    return 0;
+    for (const TrajectoryAnalysisModuleDataPointer& pdata : threadData)
+    {
+        module_->finishFrames(pdata.get());
+        if (pdata != nullptr)
+        {
+            pdata->finish();
+        }
+    }
+    threadData.clear();
+
+    return nframes;
 }
 
 } // namespace
@@ -46,6 +46,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <set>
 #include <unordered_set>
 #include <utility>
@@ -132,21 +133,41 @@ public:
     void addData(int frnr, const std::vector<HBond>& data);
     /*! \brief
      * Function that returns frame information from storage.
+     *
+     * Frames may have been added out of order if they were analyzed in
+     * parallel; sortData() restores the order.
      */
     const std::vector<HbondStorageFrame>& getData() const;
+    /*! \brief
+     * Function that sorts the stored frames by frame number.
+     */
+    void sortData();
 
 private:
     /*! \brief
      * Vector that contains information from different frames.
      */
     std::vector<HbondStorageFrame> data_;
+    /*! \brief
+     * Protects data_ when frames are analyzed in parallel.
+     */
+    std::mutex dataMutex_;
 };
 
 void HbondStorage::addData(int frnr, const std::vector<HBond>& data)
 {
+    std::lock_guard<std::mutex> lock(dataMutex_);
     data_.emplace_back(frnr, data);
 }
 
+void HbondStorage::sortData()
+{
+    std::sort(data_.begin(),
+              data_.end(),
+              [](const HbondStorageFrame& a, const HbondStorageFrame& b)
+              { return a.frameNumber_ < b.frameNumber_; });
+}
+
 const std::vector<HbondStorageFrame>& HbondStorage::getData() const
 {
     return data_;
@@ -368,6 +389,7 @@ void Hbond::initOptions(IOptionsContainer* options, TrajectoryAnalysisSettings*
     settings->setHelpText(desc);
 
     settings->setFlag(TrajectoryAnalysisSettings::efRequireTop);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 }
 
 void Hbond::optionsFinished(TrajectoryAnalysisSettings* /* settings */)
@@ -852,6 +874,7 @@ void Hbond::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryA
 
 void Hbond::finishAnalysis(int /*nframes*/)
 {
+    storage_.sortData();
     if (!fnmHbdistOut_.empty())
     {
         AbstractAverageHistogram& averageHistogramDist = histogramModuleDist_->averager();
@@ -65,6 +65,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
@@ -124,6 +125,8 @@ public:
     bool        bStartTimeSet_;
     bool        bEndTimeSet_;
     bool        bDeltaTimeSet_;
+    //! Number of threads for frame-parallel analysis (0 means all available).
+    int threadCount_;
 
     bool bTrajOpen_;
     //! The current frame, or \p NULL if no frame loaded yet.
@@ -143,6 +146,7 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings* settings)
     bStartTimeSet_(false),
     bEndTimeSet_(false),
     bDeltaTimeSet_(false),
+    threadCount_(1),
     bTrajOpen_(false),
     fr(nullptr),
     gpbc_(nullptr),
@@ -383,6 +387,11 @@ void TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer* options, Tim
                         .store(&settings.impl_->bPBC)
                         .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt").store(&impl_->threadCount_).description(
+                "Number of threads to analyze frames in parallel (0 is all available)"));
+    }
 }
 
 
@@ -399,6 +408,11 @@ void TrajectoryAnalysisRunnerCommon::optionsFinished()
                 InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->threadCount_ < 0)
+    {
+        GMX_THROW(InvalidInputError("The number of threads (-nt) cannot be negative"));
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
@@ -465,6 +479,17 @@ bool TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 }
 
 
+int TrajectoryAnalysisRunnerCommon::frameThreadCount() const
+{
+    if (!impl_->settings_.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        return 1;
+    }
+    const int maxThreadCount = gmx_omp_get_max_threads();
+    return impl_->threadCount_ == 0 ? maxThreadCount : std::min(impl_->threadCount_, maxThreadCount);
+}
+
+
 const TopologyInformation& TrajectoryAnalysisRunnerCommon::topologyInformation() const
 {
     return impl_->topInfo_;
@@ -119,6 +119,12 @@ public:
 
     //! Returns true if input data comes from a trajectory.
     bool hasTrajectory() const;
+    /*! \brief
+     * Returns the number of threads to use for analyzing frames.
+     *
+     * Is one unless the analysis module allows frame-parallel analysis.
+     */
+    int frameThreadCount() const;
     //! Returns the topology information object.
     const TopologyInformation& topologyInformation() const;
     //! Returns the currently loaded frame.
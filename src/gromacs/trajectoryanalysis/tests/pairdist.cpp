@@ -52,10 +52,25 @@
 
 #include "gromacs/trajectoryanalysis/modules/pairdist.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/trajectoryanalysis/cmdlinerunner.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
 #include "testutils/cmdlinetest.h"
 #include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
 #include "testutils/textblockmatchers.h"
 
 #include "moduletest.h"
@@ -169,4 +184,81 @@ TEST_F(PairDistanceModuleTest, CoordinateSelectionIsNotOverwrittenWithExplicitGr
     runTest(CommandLine(cmdline));
 }
 
+/********************************************************************
+ * Tests for frame-parallel execution of gmx::analysismodules::PairDistance.
+ */
+
+//! Test fixture for comparing frame-parallel and serial pairdist output.
+class PairDistanceFrameParallelTest : public gmx::test::CommandLineTestBase
+{
+public:
+    //! Number of frames in the generated trajectory, several per thread and batch
+    static constexpr int c_numFrames = 50;
+    //! Number of atoms in simple.gro
+    static constexpr int c_numAtoms = 15;
+
+    //! Writes a trajectory with random coordinates for the atoms in simple.gro
+    PairDistanceFrameParallelTest() :
+        trajectoryFile_(fileManager().getTemporaryFilePath("frames.xtc").string())
+    {
+        gmx::DefaultRandomEngine           rng(1234);
+        gmx::UniformRealDistribution<real> dist(0.0, 10.0);
+        const matrix                       box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+        t_fileio*                          fio = open_xtc(trajectoryFile_, "w");
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            std::vector<gmx::RVec> x(c_numAtoms);
+            for (auto& atom : x)
+            {
+                atom = { dist(rng), dist(rng), dist(rng) };
+            }
+            write_xtc(fio, c_numAtoms, frame, frame, box, as_rvec_array(x.data()), 1000);
+        }
+        close_xtc(fio);
+    }
+
+    //! Runs pairdist over the trajectory using \p threadCount threads, returns the -o output.
+    std::string runWithThreads(int threadCount)
+    {
+        const char* const cmdline[] = { "pairdist", "-ref",         "resnr 1",
+                                        "-sel",     "resnr 2 to 5", "-selgrouping",
+                                        "res",      "-xvg",         "none" };
+        CommandLine       args(cmdline);
+        args.addOption("-s", gmx::test::TestFileManager::getInputFilePath("simple.gro").string());
+        args.addOption("-f", trajectoryFile_);
+        const std::string outputFile =
+                fileManager()
+                        .getTemporaryFilePath(gmx::formatString("nt%d.xvg", threadCount))
+                        .string();
+        args.addOption("-o", outputFile);
+        args.addOption("-nt", threadCount);
+        EXPECT_EQ(0,
+                  gmx::test::CommandLineTestHelper::runModuleDirect(
+                          gmx::TrajectoryAnalysisCommandLineRunner::createModule(
+                                  gmx::analysismodules::PairDistanceInfo::create()),
+                          &args));
+        return gmx::TextReader::readFileToString(outputFile);
+    }
+
+private:
+    //! The generated trajectory
+    std::string trajectoryFile_;
+};
+
+TEST_F(PairDistanceFrameParallelTest, ThreadedOutputMatchesSerial)
+{
+    // Make more than one thread available also on single-core hosts
+    const int maxThreadCount = gmx_omp_get_max_threads();
+    gmx_omp_set_num_threads(std::max(maxThreadCount, 3));
+    const std::string serialOutput = runWithThreads(1);
+    for (int threadCount : { 2, 3 })
+    {
+        SCOPED_TRACE(gmx::formatString("%d threads", threadCount));
+        EXPECT_EQ(serialOutput, runWithThreads(threadCount));
+    }
+    gmx_omp_set_num_threads(maxThreadCount);
+    // Check that all frames were analyzed, the output has one line per frame
+    EXPECT_EQ(c_numFrames, std::count(serialOutput.begin(), serialOutput.end(), '\n'));
+}
+
 } // namespace
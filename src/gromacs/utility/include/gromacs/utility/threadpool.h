@@ -0,0 +1,217 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::ThreadPool, a persistent pool of spin-waiting worker threads.
+ *
+ * Code that runs short parallel loops many times per MD step can use
+ * parallelForOnThreads(), which runs the loop on the thread pool active
+ * for the calling thread when there is one, and otherwise in an OpenMP
+ * parallel region. Launching work on the pool avoids the fork-join and
+ * barrier overhead of OpenMP parallel regions, which dominates the cost
+ * of such loops when there are few atoms per thread.
+ *
+ * The pool does not provide barriers, so parallel regions that need
+ * synchronization between threads should still use OpenMP. Such code
+ * should hold a ThreadPoolSpinSuspension, so the idle pool workers do not
+ * spin on the cores that the OpenMP threads use.
+ *
+ * \inlibraryapi
+ * \ingroup module_utility
+ */
+#ifndef GMX_UTILITY_THREADPOOL_H
+#define GMX_UTILITY_THREADPOOL_H
+
+#include <algorithm>
+#include <memory>
+
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/classhelpers.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Persistent pool of worker threads that spin-wait for tasks.
+ *
+ * The thread that calls run() executes task 0 and the worker threads
+ * execute the other tasks. After completing a task, the workers spin for
+ * a short time waiting for the next launch before they block, so that
+ * consecutive launches within an MD step have little overhead.
+ *
+ * At construction, each worker thread takes over the CPU affinity of
+ * the OpenMP thread with the same thread index, so the pool uses the same
+ * cores as the OpenMP team of the constructing thread.
+ */
+class ThreadPool
+{
+public:
+    /*! \brief Constructor
+     *
+     * \param[in] numThreads  The number of threads, including the thread calling run()
+     */
+    explicit ThreadPool(int numThreads);
+
+    ~ThreadPool();
+
+    //! Returns the number of threads, including the thread calling run()
+    int numThreads() const;
+
+    /*! \brief Makes idle workers block instead of spin-wait, until resumeSpinning() is called
+     *
+     * Calls can be nested, spinning resumes when each call has been matched.
+     */
+    void suspendSpinning();
+
+    //! Undoes one call to suspendSpinning()
+    void resumeSpinning();
+
+    /*! \brief Runs \p task(t) for t=0,...,numTasks-1 in parallel and waits for completion
+     *
+     * Task t runs on thread t of the pool. When one or more tasks throw,
+     * the exception of the task with the lowest index is rethrown after
+     * all tasks have completed.
+     *
+     * \param[in] numTasks  The number of tasks, should not be larger than numThreads()
+     * \param[in] task      Callable with signature void(int)
+     */
+    template<typename Task>
+    void run(const int numTasks, const Task& task)
+    {
+        runTasks(
+                numTasks,
+                [](const void* taskPtr, int t) { (*static_cast<const Task*>(taskPtr))(t); },
+                &task);
+    }
+
+private:
+    //! Type-erased task, called with the task object and the task index
+    using TaskFunction = void (*)(const void*, int);
+
+    //! Type-erased implementation of run()
+    void runTasks(int numTasks, TaskFunction taskFunction, const void* task);
+
+    class Impl;
+
+    //! Implementation object
+    std::unique_ptr<Impl> impl_;
+};
+
+//! Returns the thread pool active for the calling thread, nullptr when there is none
+ThreadPool* activeThreadPool();
+
+/*! \libinternal \brief
+ * Makes a thread pool active for the calling thread during the lifetime of this object
+ *
+ * Note that each thread-MPI rank has its own main thread and thus its own active pool.
+ */
+class ActiveThreadPoolScope
+{
+public:
+    //! Activates \p threadPool for the calling thread
+    explicit ActiveThreadPoolScope(ThreadPool* threadPool);
+
+    //! Restores the previously active thread pool
+    ~ActiveThreadPoolScope();
+
+    GMX_DISALLOW_COPY_MOVE_AND_ASSIGN(ActiveThreadPoolScope);
+
+private:
+    //! The thread pool that was active before
+    ThreadPool* previousThreadPool_;
+};
+
+/*! \libinternal \brief
+ * Suspends spinning of the idle workers of the thread pool active for the calling thread
+ * during the lifetime of this object
+ *
+ * Code that runs OpenMP parallel regions while a pool is active should hold
+ * this, as the OpenMP threads run on the same cores as the pool workers.
+ * Does nothing when no pool is active.
+ */
+class ThreadPoolSpinSuspension
+{
+public:
+    //! Suspends spinning of the active thread pool, when there is one
+    ThreadPoolSpinSuspension();
+
+    //! Resumes spinning
+    ~ThreadPoolSpinSuspension();
+
+    GMX_DISALLOW_COPY_MOVE_AND_ASSIGN(ThreadPoolSpinSuspension);
+
+private:
+    //! The thread pool that was active at construction
+    ThreadPool* threadPool_;
+};
+
+/*! \brief Runs \p body(i) for i=0,...,numIterations-1 in parallel on \p numThreads threads
+ *
+ * The iterations are distributed statically over the threads in contiguous
+ * blocks, with iteration 0 on the calling thread. When a thread pool is active
+ * for the calling thread and it has at least \p numThreads threads, the loop
+ * runs on that pool, otherwise in an OpenMP parallel region.
+ *
+ * As with OpenMP, \p body should not throw; catch exceptions inside \p body.
+ */
+template<typename Body>
+void parallelForOnThreads(const int numThreads, const Index numIterations, const Body& body)
+{
+    ThreadPool* threadPool = activeThreadPool();
+    if (threadPool != nullptr && numThreads > 1 && numThreads <= threadPool->numThreads())
+    {
+        const int numTasks = static_cast<int>(std::min(Index(numThreads), numIterations));
+        auto      runBlock = [numTasks, numIterations, &body](const int task) {
+            const Index begin = (numIterations * task) / numTasks;
+            const Index end   = (numIterations * (task + 1)) / numTasks;
+            for (Index i = begin; i < end; i++)
+            {
+                body(i);
+            }
+        };
+        threadPool->run(numTasks, runBlock);
+    }
+    else
+    {
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (Index i = 0; i < numIterations; i++)
+        {
+            body(i);
+        }
+    }
+}
+
+} // namespace gmx
+
+#endif
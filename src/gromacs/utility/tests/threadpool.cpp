@@ -0,0 +1,136 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for gmx::ThreadPool and gmx::parallelForOnThreads()
+ *
+ * \ingroup module_utility
+ */
+#include "gmxpre.h"
+
+#include "gromacs/utility/threadpool.h"
+
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace gmx
+{
+
+namespace
+{
+
+TEST(ThreadPoolTest, RunsAllTasks)
+{
+    ThreadPool threadPool(4);
+    EXPECT_EQ(threadPool.numThreads(), 4);
+
+    // Launch many times to exercise both the spinning and the blocking workers
+    for (int numTasks = 0; numTasks <= 4; numTasks++)
+    {
+        for (int launch = 0; launch < 100; launch++)
+        {
+            std::vector<int> count(4, 0);
+            threadPool.run(numTasks, [&count](int t) { count[t]++; });
+            for (int t = 0; t < 4; t++)
+            {
+                EXPECT_EQ(count[t], t < numTasks ? 1 : 0);
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolTest, RethrowsTaskException)
+{
+    ThreadPool threadPool(3);
+    auto       throwingTask = [](int t) {
+        if (t == 2)
+        {
+            throw std::runtime_error("task failed");
+        }
+    };
+    EXPECT_THROW(threadPool.run(3, throwingTask), std::runtime_error);
+
+    // The pool should still be usable after an exception
+    std::vector<int> count(3, 0);
+    threadPool.run(3, [&count](int t) { count[t]++; });
+    EXPECT_EQ(std::accumulate(count.begin(), count.end(), 0), 3);
+}
+
+TEST(ThreadPoolTest, RunsTasksWithSpinningSuspended)
+{
+    ThreadPool            threadPool(3);
+    ActiveThreadPoolScope scope(&threadPool);
+
+    // The workers now block between launches, which should not affect the results
+    for (int launch = 0; launch < 100; launch++)
+    {
+        const ThreadPoolSpinSuspension outerSuspension;
+        const ThreadPoolSpinSuspension innerSuspension;
+
+        std::vector<int> count(3, 0);
+        threadPool.run(3, [&count](int t) { count[t]++; });
+        EXPECT_EQ(std::accumulate(count.begin(), count.end(), 0), 3);
+    }
+
+    // Spinning resumes after the suspensions have been released
+    std::vector<int> count(3, 0);
+    threadPool.run(3, [&count](int t) { count[t]++; });
+    EXPECT_EQ(std::accumulate(count.begin(), count.end(), 0), 3);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversAllIterations)
+{
+    const int numIterations = 1001;
+
+    for (bool usePool : { false, true })
+    {
+        ThreadPool            threadPool(3);
+        ActiveThreadPoolScope scope(usePool ? &threadPool : nullptr);
+        EXPECT_EQ(activeThreadPool(), usePool ? &threadPool : nullptr);
+
+        std::vector<int> count(numIterations, 0);
+        parallelForOnThreads(3, numIterations, [&count](Index i) { count[i]++; });
+        for (int i = 0; i < numIterations; i++)
+        {
+            EXPECT_EQ(count[i], 1);
+        }
+    }
+    EXPECT_EQ(activeThreadPool(), nullptr);
+}
+
+} // namespace
+
+} // namespace gmx
@@ -0,0 +1,357 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright 2026- The GROMACS Authors
+ * and the project initiators Erik Lindahl, Berk Hess and David van der Spoel.
+ * Consult the AUTHORS/COPYING files and https://www.gromacs.org for details.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * https://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at https://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out https://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::ThreadPool.
+ *
+ * \ingroup module_utility
+ */
+#include "gmxpre.h"
+
+#include "gromacs/utility/threadpool.h"
+
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if HAVE_SCHED_AFFINITY
+#    include <sched.h>
+#endif
+#if GMX_TARGET_X86
+#    include <immintrin.h>
+#endif
+
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+/*! \brief The number of spin iterations of idle workers before they block
+ *
+ * With a pause instruction per iteration this corresponds to roughly 0.1 to 1 ms,
+ * which covers the gaps between consecutive launches within an MD step.
+ */
+constexpr int c_numSpinIterations = 10000;
+
+//! The unit of the launch count in ThreadPool::Impl::launch_
+constexpr int64_t c_launchCountUnit = int64_t(1) << 32;
+
+//! Hint to the CPU that we are in a spin-wait loop
+inline void spinPause()
+{
+#if GMX_TARGET_X86
+    _mm_pause();
+#endif
+}
+
+//! The thread pool active for this thread
+thread_local ThreadPool* s_activeThreadPool = nullptr;
+
+} // namespace
+
+class ThreadPool::Impl
+{
+public:
+    explicit Impl(int numThreads);
+
+    ~Impl();
+
+    //! Runs the tasks, see ThreadPool::run()
+    void runTasks(int numTasks, TaskFunction taskFunction, const void* task);
+
+    //! The number of unmatched calls to ThreadPool::suspendSpinning()
+    std::atomic<int> numSpinSuspensions_ = 0;
+
+    //! The number of threads, including the calling thread
+    const int numThreads_;
+
+private:
+    //! The main loop of worker thread \p thread
+    void workerLoop(int thread);
+
+    //! Runs task \p t and stores a possible exception
+    void runTask(int t);
+
+    //! The function that runs a task, set before each launch
+    TaskFunction taskFunction_ = nullptr;
+    //! The task object passed to taskFunction_
+    const void* task_ = nullptr;
+    //! Exceptions thrown by the tasks, one per thread
+    std::vector<std::exception_ptr> errors_;
+#if HAVE_SCHED_AFFINITY
+    //! The CPU sets of the OpenMP threads, empty when they could not be obtained
+    std::vector<cpu_set_t> cpuSets_;
+#endif
+
+    /*! \brief The launch count times 2^32 plus the number of tasks of the last launch
+     *
+     * Workers wait for this to change. Storing both in one atomic ensures that
+     * a worker that was late to wake up never executes a task twice.
+     */
+    std::atomic<int64_t> launch_ = 0;
+    //! The number of tasks that have not completed yet
+    std::atomic<int> numTasksRemaining_ = 0;
+    //! The number of workers blocked on condition_
+    std::atomic<int> numWorkersBlocked_ = 0;
+    //! Tells the workers to exit
+    std::atomic<bool> stop_ = false;
+    //! Mutex for blocking idle workers
+    std::mutex mutex_;
+    //! Wakes up blocked workers
+    std::condition_variable condition_;
+    //! The worker threads
+    std::vector<std::thread> workers_;
+};
+
+ThreadPool::Impl::Impl(const int numThreads) : numThreads_(numThreads), errors_(numThreads)
+{
+    GMX_RELEASE_ASSERT(numThreads >= 1, "Need at least one thread");
+
+#if HAVE_SCHED_AFFINITY
+    /* Collect the CPU sets of the OpenMP threads, so the workers can use the same cores */
+    cpuSets_.resize(numThreads_);
+    std::vector<int> status(numThreads_, 0);
+#    pragma omp parallel num_threads(numThreads_)
+    {
+        const int thread = gmx_omp_get_thread_num();
+        status[thread]   = sched_getaffinity(0, sizeof(cpu_set_t), &cpuSets_[thread]);
+    }
+    if (std::any_of(status.begin(), status.end(), [](int s) { return s != 0; }))
+    {
+        cpuSets_.clear();
+    }
+#endif
+
+    workers_.reserve(numThreads_ - 1);
+    for (int thread = 1; thread < numThreads_; thread++)
+    {
+        workers_.emplace_back(&ThreadPool::Impl::workerLoop, this, thread);
+    }
+}
+
+ThreadPool::Impl::~Impl()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true);
+        launch_.fetch_add(c_launchCountUnit);
+    }
+    condition_.notify_all();
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Impl::runTask(const int t)
+{
+    try
+    {
+        taskFunction_(task_, t);
+    }
+    catch (...)
+    {
+        errors_[t] = std::current_exception();
+    }
+}
+
+void ThreadPool::Impl::workerLoop(const int thread)
+{
+#if HAVE_SCHED_AFFINITY
+    if (!cpuSets_.empty())
+    {
+        // Failure only affects performance, so we ignore the return value
+        sched_setaffinity(0, sizeof(cpu_set_t), &cpuSets_[thread]);
+    }
+#endif
+
+    int64_t lastLaunch = 0;
+    while (true)
+    {
+        /* Spin-wait for the next launch, then block. Block directly while
+         * spinning is suspended, as other threads then need the cores.
+         */
+        int64_t launch = launch_.load(std::memory_order_acquire);
+        for (int i = 0; i < c_numSpinIterations && launch == lastLaunch
+                        && numSpinSuspensions_.load(std::memory_order_relaxed) == 0;
+             i++)
+        {
+            spinPause();
+            launch = launch_.load(std::memory_order_acquire);
+        }
+        if (launch == lastLaunch)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            numWorkersBlocked_.fetch_add(1);
+            condition_.wait(lock, [&] { return launch_.load() != lastLaunch; });
+            numWorkersBlocked_.fetch_sub(1);
+            launch = launch_.load();
+        }
+        lastLaunch = launch;
+
+        if (stop_.load())
+        {
+            break;
+        }
+
+        const int numTasks = static_cast<int>(launch % c_launchCountUnit);
+        if (thread < numTasks)
+        {
+            runTask(thread);
+            numTasksRemaining_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+void ThreadPool::Impl::runTasks(const int numTasks, TaskFunction taskFunction, const void* task)
+{
+    GMX_ASSERT(numTasks <= numThreads_, "Cannot have more tasks than threads");
+
+    if (numTasks <= 0)
+    {
+        return;
+    }
+
+    taskFunction_ = taskFunction;
+    task_         = task;
+    numTasksRemaining_.store(numTasks - 1, std::memory_order_relaxed);
+    /* The sequentially consistent store orders the launch with respect to
+     * the increment of numWorkersBlocked_ by workers about to block.
+     */
+    const int64_t launchCount = launch_.load(std::memory_order_relaxed) / c_launchCountUnit;
+    launch_.store((launchCount + 1) * c_launchCountUnit + numTasks);
+    if (numWorkersBlocked_.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        condition_.notify_all();
+    }
+
+    runTask(0);
+
+    /* Spin-wait for the workers, yield when this takes long, as we might be
+     * sharing cores with the workers
+     */
+    for (int i = 0; numTasksRemaining_.load(std::memory_order_acquire) > 0; i++)
+    {
+        if (i < c_numSpinIterations)
+        {
+            spinPause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    for (int t = 0; t < numTasks; t++)
+    {
+        if (errors_[t])
+        {
+            std::exception_ptr error = errors_[t];
+            std::fill(errors_.begin(), errors_.begin() + numTasks, nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+ThreadPool::ThreadPool(const int numThreads) : impl_(std::make_unique<Impl>(numThreads)) {}
+
+ThreadPool::~ThreadPool() = default;
+
+int ThreadPool::numThreads() const
+{
+    return impl_->numThreads_;
+}
+
+void ThreadPool::runTasks(const int numTasks, TaskFunction taskFunction, const void* task)
+{
+    impl_->runTasks(numTasks, taskFunction, task);
+}
+
+void ThreadPool::suspendSpinning()
+{
+    impl_->numSpinSuspensions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadPool::resumeSpinning()
+{
+    impl_->numSpinSuspensions_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+ThreadPool* activeThreadPool()
+{
+    return s_activeThreadPool;
+}
+
+ActiveThreadPoolScope::ActiveThreadPoolScope(ThreadPool* threadPool) :
+    previousThreadPool_(s_activeThreadPool)
+{
+    s_activeThreadPool = threadPool;
+}
+
+ActiveThreadPoolScope::~ActiveThreadPoolScope()
+{
+    s_activeThreadPool = previousThreadPool_;
+}
+
+ThreadPoolSpinSuspension::ThreadPoolSpinSuspension() : threadPool_(s_activeThreadPool)
+{
+    if (threadPool_ != nullptr)
+    {
+        threadPool_->suspendSpinning();
+    }
+}
+
+ThreadPoolSpinSuspension::~ThreadPoolSpinSuspension()
+{
+    if (threadPool_ != nullptr)
+    {
+        threadPool_->resumeSpinning();
+    }
+}
+
+} // namespace gmx
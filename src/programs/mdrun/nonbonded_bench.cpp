@@ -42,17 +42,25 @@
 
 #include "nonbonded_bench.h"
 
+#include <string>
 #include <vector>
 
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
 #include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/fileio/tpxio.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/state.h"
 #include "gromacs/nbnxm/benchmark/bench_setup.h"
 #include "gromacs/options/basicoptions.h"
 #include "gromacs/options/filenameoption.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/selection/selectionoptionbehavior.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/enumerationhelpers.h"
+#include "gromacs/utility/fatalerror.h"
 
 namespace gmx
 {
@@ -74,6 +82,7 @@ public:
 
 private:
     int                       sizeFactor_ = 1;
+    std::string               runInputFile_;
     Nbnxm::KernelBenchOptions benchmarkOptions_;
 };
 
@@ -151,7 +160,24 @@ void NonbondedBenchmark::initOptions(IOptionsContainer* options, ICommandLineOpt
         "In the MD engine, any clusters where at most half of the atoms",
         "have LJ interactions will automatically use this kernel.",
         "And finally, the [TT]-energy[tt] option selects the computation",
-        "of energies, which are usually only needed infrequently."
+        "of energies, which are usually only needed infrequently.[PAR]",
+        "Instead of the water box, a production system can be benchmarked",
+        "by passing its run input file with [TT]-s[tt]. The atom types,",
+        "charges, exclusions, energy groups and perturbed atoms are then",
+        "those of the simulation, and the Coulomb and Lennard-Jones",
+        "treatment, cut-offs and dynamic pruning setup are taken from the",
+        "run input file, so options [TT]-size[tt], [TT]-coulomb[tt],",
+        "[TT]-combrule[tt], [TT]-halflj[tt], [TT]-cutoff[tt] and [TT]-all[tt]",
+        "are ignored. LJ-PME and other treatments the kernels do not",
+        "support result in an error. Interactions of perturbed atoms are",
+        "computed by the free-energy kernel at the initial lambda state,",
+        "as in mdrun.",
+        "Every iteration then performs all non-bonded work of a pair search",
+        "step and the time spent in grid sorting, pairlist construction,",
+        "dynamic pruning, the kernel, the free-energy kernel and the force",
+        "reduction is reported separately per iteration. With",
+        "[TT]-energy[tt] the total Lennard-Jones and Coulomb energies",
+        "are reported as well."
     };
 
     settings->setHelpText(desc);
@@ -166,6 +192,11 @@ void NonbondedBenchmark::initOptions(IOptionsContainer* options, ICommandLineOpt
         { "ewald", "reaction-field" }
     };
 
+    options->addOption(FileNameOption("s")
+                               .filetype(OptionFileType::RunInput)
+                               .inputFile()
+                               .store(&runInputFile_)
+                               .description("Run input file with a production system to benchmark"));
     options->addOption(
             IntegerOption("size").store(&sizeFactor_).description("The system size is 3000 atoms times this value"));
     options->addOption(
@@ -226,7 +257,50 @@ void NonbondedBenchmark::optionsFinished()
 
 int NonbondedBenchmark::run()
 {
-    Nbnxm::bench(sizeFactor_, benchmarkOptions_);
+    if (runInputFile_.empty())
+    {
+        Nbnxm::bench(sizeFactor_, benchmarkOptions_);
+
+        return 0;
+    }
+
+    t_inputrec ir;
+    t_state    state;
+    gmx_mtop_t mtop;
+    read_tpx_state(runInputFile_, &ir, &state, &mtop);
+
+    if (ir.cutoff_scheme != CutoffScheme::Verlet)
+    {
+        gmx_fatal(FARGS, "The run input file should use the Verlet cut-off scheme");
+    }
+    if (usingPmeOrEwald(ir.coulombtype))
+    {
+        benchmarkOptions_.coulombType = Nbnxm::BenchMarkCoulomb::Pme;
+    }
+    else if (usingRF(ir.coulombtype) || ir.coulombtype == CoulombInteractionType::Cut)
+    {
+        benchmarkOptions_.coulombType = Nbnxm::BenchMarkCoulomb::ReactionField;
+    }
+    else
+    {
+        gmx_fatal(FARGS,
+                  "Coulomb type %s is not supported by the benchmark",
+                  enumValueToString(ir.coulombtype));
+    }
+    // The kernels support Lennard-Jones with a cut-off and all modifiers
+    // apart from the exact cut-off, which is only used with the group scheme
+    if (ir.vdwtype != VanDerWaalsType::Cut || ir.vdw_modifier == InteractionModifiers::ExactCutoff
+        || mtop.ffparams.functype[0] == F_BHAM)
+    {
+        gmx_fatal(FARGS,
+                  "Van der Waals type %s with modifier %s%s is not supported by the benchmark",
+                  enumValueToString(ir.vdwtype),
+                  enumValueToString(ir.vdw_modifier),
+                  mtop.ffparams.functype[0] == F_BHAM ? " and Buckingham interactions" : "");
+    }
+    benchmarkOptions_.pairlistCutoff = ir.rlist;
+
+    Nbnxm::bench(ir, mtop, state.x, state.box, benchmarkOptions_);
 
     return 0;
 }
@@ -42,12 +42,20 @@
 
 #include "programs/mdrun/nonbonded_bench.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gromacs/trajectory/energyframe.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textreader.h"
 
 #include "testutils/refdata.h"
 #include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/tprfilegenerator.h"
 
+#include "energyreader.h"
 #include "moduletest.h"
 
 namespace gmx
@@ -67,6 +75,95 @@ TEST(NonbondedBenchTest, BasicEndToEndTest)
                       &gmx::NonbondedBenchmarkInfo::create, &cmdline));
 }
 
+TEST(NonbondedBenchTest, RunInputFileEndToEndTest)
+{
+    TprAndFileManager tprFileHandle("lysozyme");
+    const char* const command[] = { "nonbonded-benchmark" };
+    CommandLine       cmdline(command);
+    cmdline.addOption("-s", tprFileHandle.tprName());
+    cmdline.addOption("-iter", 1);
+    EXPECT_EQ(0,
+              gmx::test::CommandLineTestHelper::runModuleFactory(
+                      &gmx::NonbondedBenchmarkInfo::create, &cmdline));
+}
+
+//! Test fixture for benchmarking a run input file, which also runs mdrun for reference
+using NonbondedBenchRunInputFileTest = MdrunTestFixture;
+
+TEST_F(NonbondedBenchRunInputFileTest, EnergiesMatchMdrun)
+{
+    // This system has a triclinic box, uses force-switched Lennard-Jones
+    // and has perturbed atoms at lambda=0.5, so all code paths that
+    // differ from the water box benchmark are covered.
+    // We use continuation to avoid constraining the initial coordinates,
+    // so mdrun computes the energies at the coordinates in the tpr file.
+    const std::string simulationName = "freeenergy/coulandvdwintramol/";
+    runner_.topFileName_ =
+            TestFileManager::getInputFilePath(simulationName + "topol.top").u8string();
+    runner_.groFileName_ =
+            TestFileManager::getInputFilePath(simulationName + "conf.gro").u8string();
+    const std::string mdpContents = TextReader::readFileToString(
+            TestFileManager::getInputFilePath(simulationName + "grompp.mdp"));
+    runner_.useStringAsMdpFile(
+            replaceAll(mdpContents, "continuation             = no", "continuation = yes"));
+    // The mdp file uses the Berendsen thermostat, which generates a warning
+    runner_.setMaxWarn(1);
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    runner_.nsteps_ = 0;
+    ASSERT_EQ(0, runner_.callMdrun());
+    auto energyReader =
+            openEnergyFileToReadTerms(runner_.edrFileName_, { "LJ (SR)", "Coulomb (SR)" });
+    ASSERT_TRUE(energyReader->readNextFrame());
+    const EnergyFrame mdrunEnergies = energyReader->frame();
+
+    const std::string csvFileName = fileManager_.getTemporaryFilePath("bench.csv").u8string();
+    const char* const command[]   = { "nonbonded-benchmark" };
+    CommandLine       cmdline(command);
+    cmdline.addOption("-s", runner_.tprFileName_);
+    cmdline.addOption("-nt", getNumberOfTestOpenMPThreads());
+    cmdline.addOption("-iter", 1);
+    cmdline.addOption("-energy");
+    cmdline.addOption("-o", csvFileName);
+    ASSERT_EQ(0,
+              gmx::test::CommandLineTestHelper::runModuleFactory(
+                      &gmx::NonbondedBenchmarkInfo::create, &cmdline));
+
+    // The csv file has a header line and one line per SIMD setup,
+    // with the energies in the last two columns
+    TextReader reader(csvFileName);
+    reader.setTrimTrailingWhiteSpace(true);
+    std::string line;
+    ASSERT_TRUE(reader.readLine(&line));
+    const std::vector<std::string> header = splitDelimitedString(line, ',');
+    ASSERT_GE(header.size(), 2);
+    EXPECT_EQ("\"LJ (SR)\"", header[header.size() - 2]);
+    EXPECT_EQ("\"Coulomb (SR)\"", header[header.size() - 1]);
+    int numKernelSetups = 0;
+    while (reader.readLine(&line))
+    {
+        std::vector<std::string> values = splitDelimitedString(line, ',');
+        ASSERT_EQ(header.size(), values.size());
+        for (std::string& value : values)
+        {
+            value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+        }
+        SCOPED_TRACE("Comparing the energies of the benchmark with SIMD setup " + values[5]);
+        // The summation order differs, so we can not expect exact agreement
+        for (int term = 0; term < 2; term++)
+        {
+            const std::string& name      = header[header.size() - 2 + term];
+            const real         reference = mdrunEnergies.at(name.substr(1, name.size() - 2));
+            EXPECT_REAL_EQ_TOL(reference,
+                               std::stod(values[values.size() - 2 + term]),
+                               relativeToleranceAsFloatingPoint(reference, 1e-5))
+                    << name;
+        }
+        numKernelSetups++;
+    }
+    EXPECT_GT(numKernelSetups, 0);
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
@@ -43,6 +43,8 @@
  */
 #include "gmxpre.h"
 
+#include "config.h"
+
 #include <map>
 #include <mutex>
 #include <string>
@@ -52,6 +54,7 @@
 
 #include "gromacs/ewald/pme.h"
 #include "gromacs/hardware/hw_info.h"
+#include "gromacs/topology/ifunc.h"
 #include "gromacs/trajectory/energyframe.h"
 #include "gromacs/utility/basenetwork.h"
 #include "gromacs/utility/cstringutil.h"
@@ -62,9 +65,11 @@
 
 #include "testutils/mpitest.h"
 #include "testutils/refdata.h"
+#include "testutils/setenv.h"
 
 #include "energyreader.h"
 #include "moduletest.h"
+#include "simulatorcomparison.h"
 
 namespace gmx
 {
@@ -432,6 +437,75 @@ const auto c_reproducesEnergies = ::testing::ValuesIn(std::vector<PmeTestParamet
 
 INSTANTIATE_TEST_SUITE_P(ReproducesEnergies, PmeTest, c_reproducesEnergies, nameOfTest);
 
+//! Test fixture for running CPU PME concurrently with the short-range work
+using PmeOverlapTest = MdrunTestFixture;
+
+TEST_F(PmeOverlapTest, GivesSameEnergiesAndForcesAsSequentialPme)
+{
+    if (!GMX_OPENMP || getNumberOfTestMpiRanks() > 1 || getNumberOfTestOpenMPThreads() < 2)
+    {
+        GTEST_SKIP() << "PME overlap requires a single rank with multiple OpenMP threads";
+    }
+
+    runner_.useTopGroAndNdxFromDatabase("spc-and-methanol");
+    runner_.useStringAsMdpFile(
+            "coulombtype   = PME\n"
+            "nsteps        = 0\n"
+            "nstcalcenergy = 1\n"
+            "nstenergy     = 1\n"
+            "nstfout       = 1\n"
+            "pme-order     = 4\n");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    const std::string sequentialEdrFileName =
+            fileManager_.getTemporaryFilePath("sequential.edr").u8string();
+    const std::string sequentialTrrFileName =
+            fileManager_.getTemporaryFilePath("sequential.trr").u8string();
+    const std::string overlapEdrFileName =
+            fileManager_.getTemporaryFilePath("overlap.edr").u8string();
+    const std::string overlapTrrFileName =
+            fileManager_.getTemporaryFilePath("overlap.trr").u8string();
+
+    const std::string overlapEnvironmentVariable = "GMX_PME_OVERLAP_THREADS";
+    GMX_RELEASE_ASSERT(getenv(overlapEnvironmentVariable.c_str()) == nullptr,
+                       "The PME overlap should be off for the reference run");
+    CommandLine commandLine(splitString("-notunepme -npme 0 -pme cpu"));
+
+    runner_.edrFileName_                     = sequentialEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = sequentialTrrFileName;
+    ASSERT_EQ(0, runner_.callMdrun(commandLine));
+
+    gmxSetenv(overlapEnvironmentVariable.c_str(), "1", 1);
+    runner_.edrFileName_                     = overlapEdrFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = overlapTrrFileName;
+    const int overlapExitCode                = runner_.callMdrun(commandLine);
+    gmxUnsetenv(overlapEnvironmentVariable.c_str());
+    ASSERT_EQ(0, overlapExitCode);
+
+    // PME runs with fewer threads with overlap, which changes the summation order
+    const auto           energyTolerance = relativeToleranceAsPrecisionDependentFloatingPoint(
+            1.0, 1e-5, 1e-10);
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_COUL_RECIP].longname, energyTolerance },
+            { interaction_function[F_EPOT].longname, energyTolerance },
+            { interaction_function[F_PRES].longname, energyTolerance },
+    } };
+    compareEnergies(sequentialEdrFileName, overlapEdrFileName, energyTermsToCompare);
+
+    const TrajectoryFrameMatchSettings trajectoryMatchSettings{ true,
+                                                                true,
+                                                                true,
+                                                                ComparisonConditions::NoComparison,
+                                                                ComparisonConditions::NoComparison,
+                                                                ComparisonConditions::MustCompare,
+                                                                MaxNumFrames::compareAllFrames() };
+    compareTrajectories(
+            sequentialTrrFileName,
+            overlapTrrFileName,
+            TrajectoryComparison{ trajectoryMatchSettings,
+                                  TrajectoryComparison::s_defaultTrajectoryTolerances });
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
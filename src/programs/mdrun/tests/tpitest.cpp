@@ -42,6 +42,12 @@
  */
 #include "gmxpre.h"
 
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textreader.h"
 
@@ -141,6 +147,118 @@ TEST_P(TpiTest, ReproducesOutput)
 
 INSTANTIATE_TEST_SUITE_P(Simple, TpiTest, ::testing::Values(1993, 2994));
 
+/*! \brief Returns the value following \p pattern in the TPI part of the log file \p logFileName
+ */
+double readTpiLogValue(const std::string& logFileName, const std::string& pattern)
+{
+    const std::string logFileContents = TextReader::readFileToString(logFileName);
+    const std::string tpiOutputs =
+            logFileContents.substr(logFileContents.find("Started Test Particle Insertion"));
+    const auto startIndex = tpiOutputs.find(pattern);
+    GMX_RELEASE_ASSERT(startIndex != std::string::npos, "The TPI log output should contain pattern");
+    return std::stod(tpiOutputs.substr(startIndex + pattern.size()));
+}
+
+/*! \brief Returns the values in the column of TPI output file \p fileName
+ * with a legend containing \p legendPattern
+ */
+std::vector<double> readTpiOutputColumn(const std::string& fileName, const std::string& legendPattern)
+{
+    TextReader          reader(fileName);
+    std::string         line;
+    int                 column = -1;
+    std::vector<double> values;
+    while (reader.readLine(&line))
+    {
+        if (line.rfind("@ s", 0) == 0 && line.find(" legend ") != std::string::npos
+            && line.find(legendPattern) != std::string::npos)
+        {
+            // Column 0 contains the time, set s is in column s+1
+            column = std::stoi(line.substr(3)) + 1;
+        }
+        else if (!line.empty() && line[0] != '#' && line[0] != '@')
+        {
+            GMX_RELEASE_ASSERT(column >= 0, "The legend pattern should be present");
+            std::istringstream stream(line);
+            double             value = 0;
+            for (int c = 0; c <= column; c++)
+            {
+                stream >> value;
+            }
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+//! Test fixture for TPI with dispersion correction
+using TpiDispersionCorrectionTest = MdrunTestFixture;
+
+/* The dispersion correction adds the same energy to every insertion in a frame,
+ * so it should shift the chemical potential by exactly that energy.
+ */
+TEST_F(TpiDispersionCorrectionTest, ShiftsChemicalPotentialByCorrection)
+{
+    const std::string mdpTemplate = R"(
+        integrator               = tpi
+        ld-seed                  = 1993
+        rtpi                     = 0.2
+        nstlog                   = 0
+        nstenergy                = 0
+        cutoff-scheme            = Verlet
+        nstlist                  = 10
+        rlist                    = 0.9
+        coulombtype              = reaction-field
+        rcoulomb                 = 0.9
+        epsilon-r                = 1
+        epsilon-rf               = 0
+        vdw-type                 = cut-off
+        vdw-modifier             = none
+        rvdw                     = 0.9
+        DispCorr                 = %s
+        Tcoupl                   = no
+        tc-grps                  = System
+        tau_t                    = 0.5
+        ref_t                    = 298
+        nsteps                   = 200
+    )";
+
+    runner_.useTopGroAndNdxFromDatabase("spc216_with_methane");
+    runner_.ndxFileName_ = "";
+    const auto rerunFileName = gmx::test::TestFileManager::getInputFilePath("spc216.gro");
+
+    std::vector<double> mu;
+    std::string         tpiFileName;
+    for (const char* dispCorr : { "no", "EnerPres" })
+    {
+        runner_.useStringAsMdpFile(formatString(mdpTemplate.c_str(), dispCorr));
+        ASSERT_EQ(0, runner_.callGrompp());
+
+        runner_.logFileName_ =
+                fileManager_.getTemporaryFilePath(formatString("%s.log", dispCorr)).u8string();
+        tpiFileName = fileManager_.getTemporaryFilePath(formatString("%s.xvg", dispCorr)).u8string();
+        CommandLine commandLine;
+        commandLine.append("-rerun");
+        commandLine.append(rerunFileName.u8string());
+        commandLine.addOption("-tpi", tpiFileName);
+        ASSERT_EQ(0, runner_.callMdrun(commandLine));
+
+        mu.push_back(readTpiLogValue(runner_.logFileName_, "<mu> ="));
+    }
+
+    // The run with dispersion correction reports the Boltzmann-weighted correction
+    // per frame; dividing by the average Boltzmann factor gives the correction itself
+    const std::vector<double> weightedCorrection = readTpiOutputColumn(tpiFileName, "disp c");
+    const std::vector<double> boltzmannFactor    = readTpiOutputColumn(tpiFileName, "f. <e");
+    ASSERT_EQ(1, weightedCorrection.size()) << "The rerun trajectory should contain one frame";
+    ASSERT_EQ(1, boltzmannFactor.size());
+    const double correction = weightedCorrection[0] / boltzmannFactor[0];
+    EXPECT_LT(correction, 0) << "The dispersion correction should be attractive";
+
+    // The log file reports <mu> with 6 significant digits
+    EXPECT_NEAR(mu[0] + correction, mu[1], 1e-4 * std::abs(mu[1]));
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx